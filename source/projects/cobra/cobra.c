@@ -44,6 +44,9 @@ typedef struct cobra
     void *c_outlet;
     void *c_outlet2;
 
+    t_atom *c_atoms;            /*!< reusable atom buffer for dict output */
+    long c_atoms_size;          /*!< allocated size of atom buffer */
+
 } t_cobra;
 
 // prototypes
@@ -67,6 +70,8 @@ t_max_err cobra_handle_long_output(t_cobra* x, PyObject* plong);
 t_max_err cobra_handle_string_output(t_cobra* x, PyObject* pstring);
 t_max_err cobra_handle_list_output(t_cobra* x, PyObject* plist);
 t_max_err cobra_handle_dict_output(t_cobra* x, PyObject* pdict);
+t_max_err cobra_dict_to_atoms(t_cobra* x, PyObject* pdict,
+                              const char* prefix, long* n);
 t_max_err cobra_handle_output(t_cobra* x, PyObject* pval);
 t_max_err cobra_import(t_cobra* x, t_symbol* s);
 t_max_err cobra_defer(t_cobra* x, t_symbol* s, long argc, t_atom* argv);
@@ -119,6 +124,8 @@ void *cobra_new(t_symbol *s, long argc, t_atom *argv)
     x->c_name = symbol_unique();
     x->c_pythonpath = gensym("");
     x->c_func = NULL;
+    x->c_atoms = NULL;
+    x->c_atoms_size = 0;
  
     if (attrstart && argv)
         time_setvalue(x->c_timeobj, NULL, 1, argv);
@@ -176,6 +183,8 @@ void cobra_free(t_cobra *x)
     freeobject((t_object *)x->c_clock);
 
     Py_XDECREF(x->c_globals);
+    if (x->c_atoms)
+        sysmem_freeptr(x->c_atoms);
     // python objects cleanup
     py_global_obj_count--;
     if (py_global_obj_count == 0) {
@@ -480,63 +489,135 @@ error:
 }
 
 
-t_max_err cobra_handle_dict_output(t_cobra* x, PyObject* pdict)
+static t_max_err cobra_dict_append(t_cobra* x, PyObject* item, long* n)
 {
-    PyObject* pfun_co = NULL;
-    PyObject* pfun = NULL;
-    PyObject* pval = NULL;
+    if (*n + 1 > x->c_atoms_size) {
+        long size = x->c_atoms_size ? x->c_atoms_size * 2 : PY_MAX_ATOMS;
+        t_atom* atoms = (t_atom*)sysmem_resizeptr(x->c_atoms,
+                                                  size * sizeof(t_atom));
+        if (atoms == NULL) {
+            PyErr_NoMemory();
+            return MAX_ERR_OUT_OF_MEM;
+        }
+        x->c_atoms = atoms;
+        x->c_atoms_size = size;
+    }
 
-    if (pdict == NULL) {
-        goto error;
+    if (PyLong_Check(item)) {
+        long long_item = PyLong_AsLong(item);
+        if (long_item == -1 && PyErr_Occurred())
+            return MAX_ERR_GENERIC;
+        atom_setlong(x->c_atoms + (*n)++, long_item);
+    } else if (PyFloat_Check(item)) {
+        atom_setfloat(x->c_atoms + (*n)++, PyFloat_AS_DOUBLE(item));
+    } else if (PyUnicode_Check(item)) {
+        const char* unicode_item = PyUnicode_AsUTF8(item);
+        if (unicode_item == NULL)
+            return MAX_ERR_GENERIC;
+        atom_setsym(x->c_atoms + (*n)++, gensym(unicode_item));
+    } else {
+        error("cobra: skipped a '%s' value in dict output",
+              Py_TYPE(item)->tp_name);
     }
+    return MAX_ERR_NONE;
+}
 
-    if (PyDict_Check(pdict)) {
 
-        pfun_co = PyRun_String("def __py_maxmsp_out_dict(arg):\n"
-                               "\tres = []\n"
-                               "\tfor k,v in arg.items():\n"
-                               "\t\tres.append(k)\n"
-                               "\t\tres.append(':')\n"
-                               "\t\tif type(v) in [list, set, tuple]:\n"
-                               "\t\t\tfor i in v:\n"
-                               "\t\t\t\tres.append(i)\n"
-                               "\t\telse:\n"
-                               "\t\t\tres.append(v)\n"
-                               "\treturn res\n",
-                               Py_single_input, x->c_globals, x->c_globals);
-
-        if (pfun_co == NULL) {
-            error("out_dict function code object is NULL");
-            goto error;
-        }
+t_max_err cobra_dict_to_atoms(t_cobra* x, PyObject* pdict,
+                              const char* prefix, long* n)
+{
+    PyObject* key = NULL;
+    PyObject* value = NULL;
+    PyObject* path = NULL;
+    Py_ssize_t pos = 0;
+    t_max_err err = MAX_ERR_NONE;
+
+    PyObject* colon = PyUnicode_InternFromString(":");
+    if (colon == NULL)
+        return MAX_ERR_GENERIC;
 
-        pfun = PyDict_GetItemString(x->c_globals, "__py_maxmsp_out_dict");
-        if (pfun == NULL) {
-            error("retrieving out_dict func from globals failed");
-            goto error;
+    while (err == MAX_ERR_NONE && PyDict_Next(pdict, &pos, &key, &value)) {
+        if (prefix != NULL || PyDict_Check(value)) {
+            path = prefix ? PyUnicode_FromFormat("%s::%S", prefix, key)
+                          : PyObject_Str(key);
+            if (path == NULL) {
+                err = MAX_ERR_GENERIC;
+                break;
+            }
         }
 
-        pval = PyObject_CallFunctionObjArgs(pfun, pdict, NULL);
-        if (pval == NULL) {
-            error("out_dict call failed to retrieve result");
-            goto error;
+        if (PyDict_Check(value)) {
+            const char* cpath = PyUnicode_AsUTF8(path);
+            if (cpath == NULL || Py_EnterRecursiveCall(" in dict output")) {
+                err = MAX_ERR_GENERIC;
+            } else {
+                err = cobra_dict_to_atoms(x, value, cpath, n);
+                Py_LeaveRecursiveCall();
+            }
+            Py_CLEAR(path);
+            continue;
         }
 
-        if (PyList_Check(pval)) {           // expecting a python list
-            cobra_handle_list_output(x, pval); // this decrefs pval
-            Py_XDECREF(pfun_co);
-   
-            return MAX_ERR_NONE;
+        err = cobra_dict_append(x, path ? path : key, n);
+        Py_CLEAR(path);
+        if (err != MAX_ERR_NONE)
+            break;
+        if ((err = cobra_dict_append(x, colon, n)) != MAX_ERR_NONE)
+            break;
+
+        if (PyList_Check(value) || PyTuple_Check(value)) {
+            Py_ssize_t size = PySequence_Fast_GET_SIZE(value);
+            PyObject** items = PySequence_Fast_ITEMS(value);
+            for (Py_ssize_t i = 0; i < size && err == MAX_ERR_NONE; i++)
+                err = cobra_dict_append(x, items[i], n);
+        } else if (PyAnySet_Check(value)) {
+            PyObject* iter = PyObject_GetIter(value);
+            PyObject* item = NULL;
+            if (iter == NULL) {
+                err = MAX_ERR_GENERIC;
+                break;
+            }
+            while (err == MAX_ERR_NONE && (item = PyIter_Next(iter))) {
+                err = cobra_dict_append(x, item, n);
+                Py_DECREF(item);
+            }
+            Py_DECREF(iter);
+            if (PyErr_Occurred())
+                err = MAX_ERR_GENERIC;
         } else {
-            error("expected list output got something else");
+            err = cobra_dict_append(x, value, n);
+        }
+    }
+    Py_DECREF(colon);
+    return err;
+}
+
+
+t_max_err cobra_handle_dict_output(t_cobra* x, PyObject* pdict)
+{
+    long n = 0;
+
+    if (pdict == NULL) {
+        goto error;
+    }
+
+    if (PyDict_Check(pdict)) {
+        if (cobra_dict_to_atoms(x, pdict, NULL, &n) != MAX_ERR_NONE) {
             goto error;
         }
+        if (n == 0) {
+            error("cannot convert py dict of length 0 to atoms");
+            goto error;
+        }
+        outlet_list(x->c_outlet, NULL, n, x->c_atoms);
     }
 
+    Py_XDECREF(pdict);
+    return MAX_ERR_NONE;
+
 error:
     cobra_handle_error(x, "cobra_handle_dict_output failed");
-    Py_XDECREF(pfun_co);
-    Py_XDECREF(pval);
+    Py_XDECREF(pdict);
     // fail bang
     return MAX_ERR_GENERIC;
 }
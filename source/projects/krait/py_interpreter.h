@@ -59,6 +59,7 @@ namespace pyjs
 // constants
 
 #define PY_MAX_ELEMS 1024
+#define PY_MAX_ATOMS 128
 #define PY_LOG_LEVEL DEBUG
 
 // ---------------------------------------------------------------------------
@@ -87,6 +88,8 @@ class PythonInterpreter
         t_symbol* p_source_path;    //!< full path to python file to execfile
         log_level p_log_level;      //!< object-level log level (error, info, debug)
         PyObject* p_globals;        //!< per object 'globals' python namespace
+        t_atom* p_atoms;            //!< reusable atom buffer for dict output
+        long p_atoms_size;          //!< allocated size of atom buffer
 
     public:
         PythonInterpreter();
@@ -117,6 +120,8 @@ class PythonInterpreter
         t_max_err handle_string_output(void* outlet, PyObject* pval);
         t_max_err handle_list_output(void* outlet, PyObject* pval);
         t_max_err handle_dict_output(void* outlet, PyObject* pval);
+        t_max_err dict_to_atoms(PyObject* pdict, const char* prefix, long* n);
+        t_max_err append_to_atoms(PyObject* item, long* n);
         t_max_err handle_output(void* outlet, PyObject* pval);
 
         // core message method helpers
@@ -176,6 +181,8 @@ PythonInterpreter::PythonInterpreter()
     this->p_source_name = gensym("");
     this->p_source_path = gensym("");
     this->p_log_level = log_level::PY_LOG_LEVEL;
+    this->p_atoms = NULL;
+    this->p_atoms_size = 0;
 
     // python init
 
@@ -201,6 +208,8 @@ PythonInterpreter::PythonInterpreter()
 PythonInterpreter::~PythonInterpreter()
 {
     Py_XDECREF(this->p_globals);
+    if (this->p_atoms)
+        sysmem_freeptr(this->p_atoms);
     Py_FinalizeEx();
 }
 
@@ -858,6 +867,126 @@ error:
     return MAX_ERR_GENERIC;
 }
 
+/**
+ * @brief Append a python int, float or str to the atom buffer
+ *
+ * @param item python object (other types are skipped with an error)
+ * @param n current number of atoms in buffer (incremented)
+ * @return t_max_err error code
+ */
+t_max_err PythonInterpreter::append_to_atoms(PyObject* item, long* n)
+{
+    if (*n + 1 > this->p_atoms_size) {
+        long size = this->p_atoms_size ? this->p_atoms_size * 2 : PY_MAX_ATOMS;
+        t_atom* atoms = (t_atom*)sysmem_resizeptr(this->p_atoms,
+                                                  size * sizeof(t_atom));
+        if (atoms == NULL) {
+            PyErr_NoMemory();
+            return MAX_ERR_OUT_OF_MEM;
+        }
+        this->p_atoms = atoms;
+        this->p_atoms_size = size;
+    }
+
+    if (PyLong_Check(item)) {
+        long long_item = PyLong_AsLong(item);
+        if (long_item == -1 && PyErr_Occurred())
+            return MAX_ERR_GENERIC;
+        atom_setlong(this->p_atoms + (*n)++, long_item);
+    } else if (PyFloat_Check(item)) {
+        atom_setfloat(this->p_atoms + (*n)++, PyFloat_AS_DOUBLE(item));
+    } else if (PyUnicode_Check(item)) {
+        const char* unicode_item = PyUnicode_AsUTF8(item);
+        if (unicode_item == NULL)
+            return MAX_ERR_GENERIC;
+        atom_setsym(this->p_atoms + (*n)++, gensym(unicode_item));
+    } else {
+        this->log_error((char*)"skipped a '%s' value in dict output",
+                        Py_TYPE(item)->tp_name);
+    }
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Flatten python dict into the atom buffer as `key : values ...`
+ *
+ * @param pdict python dict
+ * @param prefix key path of a nested dict or NULL at top-level
+ * @param n number of atoms written (incremented)
+ * @return t_max_err error code
+ *
+ * List, tuple and set values are expanded, and dict values are flattened
+ * recursively with `key::subkey` paths, as `py` does with `@nested 1`.
+ */
+t_max_err PythonInterpreter::dict_to_atoms(PyObject* pdict, const char* prefix,
+                                           long* n)
+{
+    PyObject* key = NULL;
+    PyObject* value = NULL;
+    PyObject* path = NULL;
+    Py_ssize_t pos = 0;
+    t_max_err err = MAX_ERR_NONE;
+
+    PyObject* colon = PyUnicode_InternFromString(":");
+    if (colon == NULL)
+        return MAX_ERR_GENERIC;
+
+    while (err == MAX_ERR_NONE && PyDict_Next(pdict, &pos, &key, &value)) {
+        if (prefix != NULL || PyDict_Check(value)) {
+            path = prefix ? PyUnicode_FromFormat("%s::%S", prefix, key)
+                          : PyObject_Str(key);
+            if (path == NULL) {
+                err = MAX_ERR_GENERIC;
+                break;
+            }
+        }
+
+        if (PyDict_Check(value)) {
+            const char* cpath = PyUnicode_AsUTF8(path);
+            if (cpath == NULL || Py_EnterRecursiveCall(" in dict output")) {
+                err = MAX_ERR_GENERIC;
+            } else {
+                err = this->dict_to_atoms(value, cpath, n);
+                Py_LeaveRecursiveCall();
+            }
+            Py_CLEAR(path);
+            continue;
+        }
+
+        err = this->append_to_atoms(path ? path : key, n);
+        Py_CLEAR(path);
+        if (err != MAX_ERR_NONE)
+            break;
+        if ((err = this->append_to_atoms(colon, n)) != MAX_ERR_NONE)
+            break;
+
+        if (PyList_Check(value) || PyTuple_Check(value)) {
+            Py_ssize_t size = PySequence_Fast_GET_SIZE(value);
+            PyObject** items = PySequence_Fast_ITEMS(value);
+            for (Py_ssize_t i = 0; i < size && err == MAX_ERR_NONE; i++)
+                err = this->append_to_atoms(items[i], n);
+        } else if (PyAnySet_Check(value)) {
+            PyObject* iter = PyObject_GetIter(value);
+            PyObject* item = NULL;
+            if (iter == NULL) {
+                err = MAX_ERR_GENERIC;
+                break;
+            }
+            while (err == MAX_ERR_NONE && (item = PyIter_Next(iter))) {
+                err = this->append_to_atoms(item, n);
+                Py_DECREF(item);
+            }
+            Py_DECREF(iter);
+            if (PyErr_Occurred())
+                err = MAX_ERR_GENERIC;
+        } else {
+            err = this->append_to_atoms(value, n);
+        }
+    }
+    Py_DECREF(colon);
+    return err;
+}
+
 /**
  * @brief Handler to output python dict as max list
  *
@@ -866,60 +995,29 @@ error:
  */
 t_max_err PythonInterpreter::handle_dict_output(void* outlet, PyObject* pdict)
 {
-    PyObject* pfun_co = NULL;
-    PyObject* pfun = NULL;
-    PyObject* pval = NULL;
+    long n = 0;
 
     if (pdict == NULL) {
         goto error;
     }
 
     if (PyDict_Check(pdict)) {
-
-        pfun_co = PyRun_String("def __py_maxmsp_out_dict(arg):\n"
-                               "\tres = []\n"
-                               "\tfor k,v in arg.items():\n"
-                               "\t\tres.append(k)\n"
-                               "\t\tres.append(':')\n"
-                               "\t\tif type(v) in [list, set, tuple]:\n"
-                               "\t\t\tfor i in v:\n"
-                               "\t\t\t\tres.append(i)\n"
-                               "\t\telse:\n"
-                               "\t\t\tres.append(v)\n"
-                               "\treturn res\n",
-                               Py_single_input, this->p_globals, this->p_globals);
-
-        if (pfun_co == NULL) {
-            this->log_error((char*)"out_dict function code object is NULL");
-            goto error;
-        }
-
-        pfun = PyDict_GetItemString(this->p_globals, "__py_maxmsp_out_dict");
-        if (pfun == NULL) {
-            this->log_error((char*)"retrieving out_dict func from globals failed");
-            goto error;
-        }
-
-        pval = PyObject_CallFunctionObjArgs(pfun, pdict, NULL);
-        if (pval == NULL) {
-            this->log_error((char*)"out_dict call failed to retrieve result");
+        if (this->dict_to_atoms(pdict, NULL, &n) != MAX_ERR_NONE) {
             goto error;
         }
-
-        if (PyList_Check(pval)) {                   // expecting a python list
-            this->handle_list_output(outlet, pval); // this decrefs pval
-            Py_XDECREF(pfun_co);
-            return MAX_ERR_NONE;
-        } else {
-            this->log_error((char*)"expected list output got something else");
+        if (n == 0) {
+            this->log_error((char*)"cannot convert py dict of length 0 to atoms");
             goto error;
         }
+        outlet_list(outlet, NULL, n, this->p_atoms);
     }
 
+    Py_XDECREF(pdict);
+    return MAX_ERR_NONE;
+
 error:
     this->handle_error((char*)"handle_dict_output failed");
-    Py_XDECREF(pfun_co);
-    Py_XDECREF(pval);
+    Py_XDECREF(pdict);
     return MAX_ERR_GENERIC;
 }
 
@@ -101,6 +101,8 @@ struct t_py
     short p_code_path;                      /*!< short code for max file system */
     t_symbol* p_code_filepath;              /*!< filepath to python file to execfile */
     PyObject* p_globals;                    /*!< per object 'globals' python namespace */
+    t_atom* p_atoms;                        /*!< reusable atom buffer for dict output */
+    long p_atoms_size;                      /*!< allocated size of atom buffer */
 };
 
 // clang-format on
@@ -117,11 +119,14 @@ t_max_err py_handle_long_output(t_py* x, void* outlet, PyObject* pval);
 t_max_err py_handle_string_output(t_py* x, void* outlet, PyObject* pval);
 t_max_err py_handle_list_output(t_py* x, void* outlet, PyObject* pval);
 t_max_err py_handle_dict_output(t_py* x, void* outlet, PyObject* pval);
+t_max_err py_dict_to_atoms(t_py* x, PyObject* pdict, const char* prefix,
+                           long* n);
 t_max_err py_handle_output(t_py* x, void* outlet, PyObject* pval);
 t_max_err py_eval_text(t_py* x, long argc, t_atom* argv, int offset,
                        void* outlet);
 
 PyObject* py_atoms_to_list(t_py* x, long argc, t_atom* argv, int start_from);
+PyObject* py_atoms_to_tuple(t_py* x, long argc, t_atom* argv, int start_from);
 
 
 // ---------------------------------------------------------------------------------------
@@ -197,6 +202,8 @@ t_py* py_init(void)
     x->p_code_pathname[0] = 0;
     x->p_code_path = 0;
     x->p_code_filepath = gensym("");
+    x->p_atoms = NULL;
+    x->p_atoms_size = 0;
 
     Py_Initialize();
 
@@ -225,6 +232,8 @@ void py_free(t_py* x)
 {
     py_log(x, (char*)"deleting object %s", x->p_name->s_name);
     Py_XDECREF(x->p_globals);
+    if (x->p_atoms)
+        sysmem_freeptr(x->p_atoms);
     Py_FinalizeEx();
     free(x);
 }
@@ -514,6 +523,128 @@ error:
     return MAX_ERR_GENERIC;
 }
 
+/**
+ * @brief Append python int, float or str to the atom buffer
+ *
+ * @param x pointer to object struct
+ * @param item python object (other types are skipped with an error)
+ * @param n current number of atoms in buffer (incremented)
+ * @return t_max_err error code
+ */
+static t_max_err py_dict_append_atom(t_py* x, PyObject* item, long* n)
+{
+    if (*n + 1 > x->p_atoms_size) {
+        long size = x->p_atoms_size ? x->p_atoms_size * 2 : PY_MAX_ATOMS;
+        t_atom* atoms = (t_atom*)sysmem_resizeptr(x->p_atoms,
+                                                  size * sizeof(t_atom));
+        if (atoms == NULL) {
+            PyErr_NoMemory();
+            return MAX_ERR_OUT_OF_MEM;
+        }
+        x->p_atoms = atoms;
+        x->p_atoms_size = size;
+    }
+
+    if (PyLong_Check(item)) {
+        long long_item = PyLong_AsLong(item);
+        if (long_item == -1 && PyErr_Occurred())
+            return MAX_ERR_GENERIC;
+        atom_setlong(x->p_atoms + (*n)++, long_item);
+    } else if (PyFloat_Check(item)) {
+        atom_setfloat(x->p_atoms + (*n)++, PyFloat_AS_DOUBLE(item));
+    } else if (PyUnicode_Check(item)) {
+        const char* unicode_item = PyUnicode_AsUTF8(item);
+        if (unicode_item == NULL)
+            return MAX_ERR_GENERIC;
+        atom_setsym(x->p_atoms + (*n)++, gensym(unicode_item));
+    } else {
+        py_error(x, (char*)"skipped a '%s' value in dict output",
+                 Py_TYPE(item)->tp_name);
+    }
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Flatten python dict into the atom buffer as `key : values ...`
+ *
+ * @param x pointer to object struct
+ * @param pdict python dict
+ * @param prefix key path of a nested dict or NULL at top-level
+ * @param n number of atoms written (incremented)
+ * @return t_max_err error code
+ *
+ * List, tuple and set values are expanded, and dict values are flattened
+ * recursively with `key::subkey` paths, as `py` does with `@nested 1`.
+ */
+t_max_err py_dict_to_atoms(t_py* x, PyObject* pdict, const char* prefix,
+                           long* n)
+{
+    PyObject* key = NULL;
+    PyObject* value = NULL;
+    PyObject* path = NULL;
+    Py_ssize_t pos = 0;
+    t_max_err err = MAX_ERR_NONE;
+
+    PyObject* colon = PyUnicode_InternFromString(":");
+    if (colon == NULL)
+        return MAX_ERR_GENERIC;
+
+    while (err == MAX_ERR_NONE && PyDict_Next(pdict, &pos, &key, &value)) {
+        if (prefix != NULL || PyDict_Check(value)) {
+            path = prefix ? PyUnicode_FromFormat("%s::%S", prefix, key)
+                          : PyObject_Str(key);
+            if (path == NULL) {
+                err = MAX_ERR_GENERIC;
+                break;
+            }
+        }
+
+        if (PyDict_Check(value)) {
+            const char* cpath = PyUnicode_AsUTF8(path);
+            if (cpath == NULL || Py_EnterRecursiveCall(" in dict output")) {
+                err = MAX_ERR_GENERIC;
+            } else {
+                err = py_dict_to_atoms(x, value, cpath, n);
+                Py_LeaveRecursiveCall();
+            }
+            Py_CLEAR(path);
+            continue;
+        }
+
+        err = py_dict_append_atom(x, path ? path : key, n);
+        Py_CLEAR(path);
+        if (err != MAX_ERR_NONE)
+            break;
+        if ((err = py_dict_append_atom(x, colon, n)) != MAX_ERR_NONE)
+            break;
+
+        if (PyList_Check(value) || PyTuple_Check(value)) {
+            Py_ssize_t size = PySequence_Fast_GET_SIZE(value);
+            PyObject** items = PySequence_Fast_ITEMS(value);
+            for (Py_ssize_t i = 0; i < size && err == MAX_ERR_NONE; i++)
+                err = py_dict_append_atom(x, items[i], n);
+        } else if (PyAnySet_Check(value)) {
+            PyObject* iter = PyObject_GetIter(value);
+            PyObject* item = NULL;
+            if (iter == NULL) {
+                err = MAX_ERR_GENERIC;
+                break;
+            }
+            while (err == MAX_ERR_NONE && (item = PyIter_Next(iter))) {
+                err = py_dict_append_atom(x, item, n);
+                Py_DECREF(item);
+            }
+            Py_DECREF(iter);
+            if (PyErr_Occurred())
+                err = MAX_ERR_GENERIC;
+        } else {
+            err = py_dict_append_atom(x, value, n);
+        }
+    }
+    Py_DECREF(colon);
+    return err;
+}
+
 /**
  * @brief Handler to output python dict as max list
  *
@@ -523,60 +654,29 @@ error:
  */
 t_max_err py_handle_dict_output(t_py* x, void* outlet, PyObject* pdict)
 {
-    PyObject* pfun_co = NULL;
-    PyObject* pfun = NULL;
-    PyObject* pval = NULL;
+    long n = 0;
 
     if (pdict == NULL) {
         goto error;
     }
 
     if (PyDict_Check(pdict)) {
-
-        pfun_co = PyRun_String("def __py_maxmsp_out_dict(arg):\n"
-                               "\tres = []\n"
-                               "\tfor k,v in arg.items():\n"
-                               "\t\tres.append(k)\n"
-                               "\t\tres.append(':')\n"
-                               "\t\tif type(v) in [list, set, tuple]:\n"
-                               "\t\t\tfor i in v:\n"
-                               "\t\t\t\tres.append(i)\n"
-                               "\t\telse:\n"
-                               "\t\t\tres.append(v)\n"
-                               "\treturn res\n",
-                               Py_single_input, x->p_globals, x->p_globals);
-
-        if (pfun_co == NULL) {
-            py_error(x, (char*)"out_dict function code object is NULL");
-            goto error;
-        }
-
-        pfun = PyDict_GetItemString(x->p_globals, "__py_maxmsp_out_dict");
-        if (pfun == NULL) {
-            py_error(x, (char*)"retrieving out_dict func from globals failed");
+        if (py_dict_to_atoms(x, pdict, NULL, &n) != MAX_ERR_NONE) {
             goto error;
         }
-
-        pval = PyObject_CallFunctionObjArgs(pfun, pdict, NULL);
-        if (pval == NULL) {
-            py_error(x, (char*)"out_dict call failed to retrieve result");
-            goto error;
-        }
-
-        if (PyList_Check(pval)) {                   // expecting a python list
-            py_handle_list_output(x, outlet, pval); // this decrefs pval
-            Py_XDECREF(pfun_co);
-            return MAX_ERR_NONE;
-        } else {
-            py_error(x, (char*)"expected list output got something else");
+        if (n == 0) {
+            py_error(x, (char*)"cannot convert py dict of length 0 to atoms");
             goto error;
         }
+        outlet_list(outlet, NULL, n, x->p_atoms);
     }
 
+    Py_XDECREF(pdict);
+    return MAX_ERR_NONE;
+
 error:
     py_handle_error(x, (char*)"py_handle_dict_output failed");
-    Py_XDECREF(pfun_co);
-    Py_XDECREF(pval);
+    Py_XDECREF(pdict);
     return MAX_ERR_GENERIC;
 }
 
@@ -797,6 +897,43 @@ error:
 // ---------------------------------------------------------------------------------------
 // EXTRA METHODS HELPERS
 
+/**
+ * @brief Translates a single atom to a python object
+ *
+ * @param atom atom
+ * @return PyObject* new reference or NULL if type is unknown or on error
+ */
+static PyObject* py_atom_to_object(t_atom* atom)
+{
+    switch (atom->a_type) {
+    case A_FLOAT:
+        return PyFloat_FromDouble(atom_getfloat(atom));
+    case A_LONG:
+        return PyLong_FromLong(atom_getlong(atom));
+    case A_SYM:
+        return PyUnicode_FromString(atom_getsym(atom)->s_name);
+    default:
+        return NULL;
+    }
+}
+
+/**
+ * @brief Count atoms which can be translated to python objects
+ *
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return long number of A_FLOAT, A_LONG and A_SYM atoms
+ */
+static long py_atoms_count(long argc, t_atom* argv)
+{
+    long n = 0;
+    for (long i = 0; i < argc; i++) {
+        short type = (argv + i)->a_type;
+        n += (type == A_FLOAT || type == A_LONG || type == A_SYM);
+    }
+    return n;
+}
+
 /**
  * @brief Translates atom vector to python list
  *
@@ -808,54 +945,74 @@ error:
  */
 PyObject* py_atoms_to_list(t_py* x, long argc, t_atom* argv, int start_from)
 {
-
     PyObject* plist = NULL; // python list
+    PyObject* item = NULL;
+    long n = 0;
+
+    if (start_from > argc)
+        start_from = argc;
 
-    if ((plist = PyList_New(0)) == NULL) {
-        py_error(x, (char*)"could not create an empty python list");
+    plist = PyList_New(py_atoms_count(argc - start_from, argv + start_from));
+    if (plist == NULL) {
+        py_error(x, (char*)"could not create a python list");
         goto error;
     }
 
-    for (int i = start_from; i < argc; i++) {
-        switch ((argv + i)->a_type) {
-        case A_FLOAT: {
-            double c_float = atom_getfloat(argv + i);
-            PyObject* p_float = PyFloat_FromDouble(c_float);
-            if (p_float == NULL) {
+    for (long i = start_from; i < argc; i++) {
+        if ((item = py_atom_to_object(argv + i)) == NULL) {
+            if (PyErr_Occurred())
                 goto error;
-            }
-            PyList_Append(plist, p_float);
-            Py_DECREF(p_float);
-            break;
-        }
-        case A_LONG: {
-            PyObject* p_long = PyLong_FromLong(atom_getlong(argv + i));
-            if (p_long == NULL) {
-                goto error;
-            }
-            PyList_Append(plist, p_long);
-            Py_DECREF(p_long);
-            break;
-        }
-        case A_SYM: {
-            PyObject* p_str = PyUnicode_FromString(
-                atom_getsym(argv + i)->s_name);
-            if (p_str == NULL) {
-                goto error;
-            }
-            PyList_Append(plist, p_str);
-            Py_DECREF(p_str);
-            break;
-        }
-        default:
             py_log(x, (char*)"cannot process unknown type");
-            break;
+            continue;
         }
+        PyList_SET_ITEM(plist, n++, item);
     }
     return plist;
 
 error:
     py_error(x, (char*)"atom to list conversion failed");
+    Py_XDECREF(plist);
+    return NULL;
+}
+
+/**
+ * @brief Translates atom vector to python tuple
+ *
+ * @param x pointer to object struct
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param start_from index of vector to start from
+ * @return PyObject* python tuple
+ */
+PyObject* py_atoms_to_tuple(t_py* x, long argc, t_atom* argv, int start_from)
+{
+    PyObject* ptuple = NULL; // python tuple
+    PyObject* item = NULL;
+    long n = 0;
+
+    if (start_from > argc)
+        start_from = argc;
+
+    ptuple = PyTuple_New(py_atoms_count(argc - start_from, argv + start_from));
+    if (ptuple == NULL) {
+        py_error(x, (char*)"could not create a python tuple");
+        goto error;
+    }
+
+    for (long i = start_from; i < argc; i++) {
+        if ((item = py_atom_to_object(argv + i)) == NULL) {
+            if (PyErr_Occurred())
+                goto error;
+            py_log(x, (char*)"cannot process unknown type");
+            continue;
+        }
+        PyTuple_SET_ITEM(ptuple, n++, item);
+    }
+    return ptuple;
+
+error:
+    py_error(x, (char*)"atom to tuple conversion failed");
+    Py_XDECREF(ptuple);
     return NULL;
 }
 
@@ -969,24 +1126,17 @@ t_max_err py_call(t_py* x, t_symbol* s, long argc, t_atom* argv, void* outlet)
         goto error;
     }
 
-    py_argslist = py_atoms_to_list(x, argc, argv, 1);
-    if (py_argslist == NULL) {
-        py_error(x, (char*)"atom to py list conversion failed");
-        goto error;
-    }
-
-    py_log(x, (char*)"length of argc:%ld list: %d", argc,
-           PyList_Size(py_argslist));
-
-    // convert py_args to tuple
-    py_args = PyList_AsTuple(py_argslist);
+    py_args = py_atoms_to_tuple(x, argc, argv, 1);
     if (py_args == NULL) {
-        py_error(x, (char*)"unable to convert args list to tuple");
+        py_error(x, (char*)"atom to py tuple conversion failed");
         goto error;
     }
 
+    py_log(x, (char*)"length of argc:%ld tuple: %d", argc,
+           PyTuple_GET_SIZE(py_args));
+
     pval = PyObject_CallObject(py_callable, py_args);
-    if (!PyErr_ExceptionMatches(PyExc_TypeError)) {
+    if (pval != NULL || !PyErr_ExceptionMatches(PyExc_TypeError)) {
         if (pval == NULL) {
             py_error(x, (char*)"unable to apply callable(*args)");
             goto error;
@@ -995,6 +1145,12 @@ t_max_err py_call(t_py* x, t_symbol* s, long argc, t_atom* argv, void* outlet)
     }
     PyErr_Clear();
 
+    py_argslist = PySequence_List(py_args);
+    if (py_argslist == NULL) {
+        py_error(x, (char*)"unable to convert args tuple to list");
+        goto error;
+    }
+
     pval = PyObject_CallFunctionObjArgs(py_callable, py_argslist, NULL);
     if (pval == NULL) {
         py_error(x, (char*)"could not retrieve result of callable(list)");
@@ -1006,6 +1162,7 @@ handle_output:
     py_handle_output(x, outlet, pval);
     // success cleanup
     Py_XDECREF(py_callable);
+    Py_XDECREF(py_args);
     Py_XDECREF(py_argslist);
     PyGILState_Release(gstate);
     return MAX_ERR_NONE;
@@ -1014,6 +1171,7 @@ error:
     py_handle_error(x, (char*)"method %s", s->s_name);
     // cleanup
     Py_XDECREF(py_callable);
+    Py_XDECREF(py_args);
     Py_XDECREF(py_argslist);
     Py_XDECREF(pval);
     PyGILState_Release(gstate);
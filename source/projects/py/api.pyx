@@ -1,4 +1,5 @@
 # api.pyx
+# cython: subinterpreters_compatible=own_gil
 """
 # api: max api wrapped by cython for use by `py` external
 
@@ -64,6 +65,7 @@ So far the following extension types are planned or implemnted (partial or other
 - [x] Buffer
 - [x] Database
 - [x] Dictionary
+- [x] Handle
 - [x] Hash Table
 - [x] Linked List
 - [x] Table
@@ -89,6 +91,7 @@ cimport cython
 from cpython cimport PyFloat_AsDouble
 from cpython cimport PyLong_AsLong
 from cpython.ref cimport PyObject
+from cpython.buffer cimport PyBUF_ND, PyBUF_STRIDES, PyBUF_FORMAT
 
 from libc.stdlib cimport malloc, free
 from libc.string cimport strcpy, strlen
@@ -109,7 +112,6 @@ IF INCLUDE_NUMPY:
 # constants
 
 DEF MAX_CHARS = 32767
-DEF PY_MAX_ATOMS = 1024
 
 
 # ----------------------------------------------------------------------------
@@ -119,6 +121,7 @@ DEF PY_MAX_ATOMS = 1024
 cdef extern from "Python.h":
     const char* PyUnicode_AsUTF8(object unicode)
     unicode PyUnicode_FromString(const char *u)
+    PyObject* PyEval_GetGlobals()
 
 # ----------------------------------------------------------------------------
 # helper cdef functions
@@ -140,6 +143,34 @@ cdef str sym_to_str(mx.t_symbol* symbol):
     return symbol.s_name.decode()
 
 
+cdef long args_count(object args):
+    """number of atoms needed for message arguments"""
+    if args is None:
+        return 0
+    if isinstance(args, (list, tuple)):
+        return len(args)
+    return 1
+
+
+cdef long args_to_atoms(object args, mx.t_atom* argv) except -1:
+    """converts message arguments to atoms
+
+    args is None, a number, a str or a list or tuple of them
+    """
+    cdef long n = 0
+    if args is None:
+        return 0
+    if not isinstance(args, (list, tuple)):
+        args = (args,)
+    for arg in args:
+        if isinstance(arg, str):
+            mx.atom_setsym(&argv[n], str_to_sym(arg))
+        elif px.py_number_to_atom(<PyObject*>arg, &argv[n]) == 0:
+            raise TypeError(f"cannot send {type(arg).__name__} as an atom")
+        n += 1
+    return n
+
+
 # ============================================================================
 # EXTENSION TYPES
 
@@ -253,80 +284,151 @@ cdef class Atom:
 
     @staticmethod
     cdef Atom from_seq(object seq):
-        cdef int size = len(seq)
-        cdef mx.t_atom *ptr = <mx.t_atom *>mx.sysmem_newptr(size * sizeof(mx.t_atom))
-        if ptr is NULL:
-            raise MemoryError
-
-        cdef int i
-        for i, obj in enumerate(seq):
-            
-            if isinstance(obj, float):
-                mx.atom_setfloat(ptr+i, <float>obj)
-            
-            elif isinstance(obj, int):
-                mx.atom_setlong(ptr+i, <long>obj)
-
-            elif isinstance(obj, bytes):
-                mx.atom_setsym(ptr+i, mx.gensym(obj))
-
-            elif isinstance(obj, str):
-                mx.atom_setsym(ptr+i, str_to_sym(obj))
+        """atoms for a sequence of numbers and strings
 
-            else:
-                print("cannot convert:", obj)
-                continue
+        The atoms are copied into a block owned by the Atom, as it can
+        outlive the call and be freed on another thread. Call-scoped
+        conversions (`send`, `out_list`) use the per-thread atom arena.
+        """
+        cdef Atom atom
 
-        return Atom.from_ptr(ptr, size, owner=True)
+        if not isinstance(seq, (list, tuple)):
+            seq = list(seq)
+        atom = Atom.new(max(len(seq), 1))
+        atom.size = len(seq)
+        px.py_items_to_atoms(seq, 0, atom.size, atom.ptr)
+        return atom
 
 # ----------------------------------------------------------------------------
 # Table 
 
 cdef class Table:
     """A wrapper class to acess a pre-existing Max table
+
+    A Table exports its storage through the buffer protocol as a writable
+    1-d array of C longs (format 'l', int64 on macOS), so lookup tables can
+    be rewritten in place without a copy:
+
+        t = api.Table('lut')
+        a = numpy.asarray(t)
+        a[:] = numpy.arange(t.size) * 2
+        t.dirty()
+
+    The storage and size are looked up again on each access, since the
+    table may be resized or recreated from the patch. While a view of the
+    storage exists, a changed table raises BufferError instead of handing
+    out (or writing through) storage the view no longer matches.
     """
     cdef str name
     cdef long **storage
     cdef readonly long size
+    cdef Py_ssize_t shape[1]
+    cdef Py_ssize_t strides[1]
+    cdef int exports           # number of exported buffer views
 
     def __cinit__(self, str name):
         self.name = name
+        self.exports = 0
         check = mx.table_get(str_to_sym(name), &self.storage, &self.size)
         assert check == 0, f"table with name '{name}' doesn't exist"
+        self.shape[0] = self.size
+        self.strides[0] = sizeof(long)
 
-    def populate(self, list[int] xs):
-        """populate table from python list[int]"""
-        if len(xs) <= self.size:
-            for i, x in enumerate(xs):
-                self.storage[0][i] = <long>x
-        else:
-            for i in range(self.size):
-                self.storage[0][i] = <long>xs[i]
+    cdef int refresh(self) except -1:
+        """look up the table storage and size again
 
+        raises BufferError if the table changed while views of it exist.
+        """
+        cdef long **storage = NULL
+        cdef long size = 0
+        if mx.table_get(str_to_sym(self.name), &storage, &size) != 0:
+            raise BufferError(f"table '{self.name}' no longer exists")
+        if storage != self.storage or size != self.size:
+            if self.exports > 0:
+                raise BufferError(f"table '{self.name}' was resized while "
+                                  f"{self.exports} view(s) of it exist")
+            self.storage = storage
+            self.size = size
+            self.shape[0] = size
+        return 0
+
+    def populate(self, object xs):
+        """populate table from a list of ints or any buffer of ints
+
+        raises ValueError, leaving the table unchanged, if the values do
+        not fit in the table.
+        """
+        cdef Py_ssize_t n = len(xs)
+        self.refresh()
+        if n > self.size:
+            raise ValueError(f"{n} values do not fit table '{self.name}' "
+                             f"of size {self.size}")
+        px.py_ints_to_longs(xs, self.storage[0], self.size)
+        self.dirty()
 
     def as_list(self):
         """converts table to python list of ints"""
-
-        cdef long value
-        cdef list[int] xs = []
-
-        for i in range(self.size):
-            value = self.storage[0][i]
-            xs.append(<int>value)
-
-        return xs
+        self.refresh()
+        return px.py_longs_to_list(self.storage[0], self.size)
+
+    def dirty(self):
+        """notify the table object that its contents changed"""
+        mx.table_dirty(str_to_sym(self.name))
+
+    def __len__(self):
+        self.refresh()
+        return self.size
+
+    def __getbuffer__(self, Py_buffer *view, int flags):
+        self.refresh()
+        view.buf = <void*>self.storage[0]
+        view.obj = self
+        view.len = self.size * sizeof(long)
+        view.readonly = 0
+        view.itemsize = sizeof(long)
+        view.format = NULL
+        if flags & PyBUF_FORMAT:
+            view.format = b'l'
+        view.ndim = 1
+        view.shape = NULL
+        if flags & PyBUF_ND:
+            view.shape = self.shape
+        view.strides = NULL
+        if (flags & PyBUF_STRIDES) == PyBUF_STRIDES:
+            view.strides = self.strides
+        view.suboffsets = NULL
+        view.internal = NULL
+        self.exports += 1
+
+    def __releasebuffer__(self, Py_buffer *view):
+        self.exports -= 1
 
 # ----------------------------------------------------------------------------
 # Buffer
 
 cdef class Buffer:
     """A wrapper class for a Max t_buffer_obj
+
+    While its samples are locked, a Buffer exports them through the buffer
+    protocol as float32 shaped (frames, channels), so `numpy.asarray(buf)`
+    or `memoryview(buf)` use the sample memory without a copy:
+
+        with api.get_buffer('drums') as buf:
+            a = numpy.asarray(buf)
+            a *= 0.5
+            del a
+
+    Leaving the `with` block marks the buffer~ dirty and unlocks it. Views
+    must be released before then, as the memory may move once unlocked.
     """
     cdef mp.t_buffer_obj *obj
     cdef mp.t_buffer_ref *ref
     # cdef mx.t_object *tobj # t_object with ref to buffer
     cdef bint is_locked
     cdef float* samples
+    cdef Py_ssize_t shape[2]   # frames, channels while locked
+    cdef Py_ssize_t strides[2]
+    cdef int exports           # number of exported buffer views
 
     # def __cinit__(self, str name):
     #     self.x = <mx.t_object*>mx.sysmem_newptr(sizeof(mx.t_object))
@@ -350,8 +452,13 @@ cdef class Buffer:
         self.ref = NULL
         self.samples = NULL
         self.is_locked = False
+        self.exports = 0
 
     def __dealloc__(self):
+        # exported views hold a reference, so none are left here
+        if self.is_locked:
+            mp.buffer_unlocksamples(self.obj)
+            self.is_locked = False
         # De-allocate if not null
         if self.ref is not NULL:
             mx.object_free(self.ref)
@@ -363,15 +470,19 @@ cdef class Buffer:
         # Call to __new__ bypasses __init__ constructor
         cdef Buffer buffer = Buffer.__new__(Buffer)
         buffer.ref = mp.buffer_ref_new(x, str_to_sym(name))
-        assert(mp.buffer_ref_exists(buffer.ref))
+        if not mp.buffer_ref_exists(buffer.ref):
+            raise ValueError(f"no buffer~ named '{name}'")
         buffer.obj = mp.buffer_ref_getobject(buffer.ref)
         return buffer
 
 
     def change_reference(self, str name):
         """Change a buffer reference to refer to a different buffer object by name."""
+        if self.is_locked:
+            raise BufferError("cannot change the reference of a locked buffer")
         mp.buffer_ref_set(self.ref, str_to_sym(name))
-        assert(mp.buffer_ref_exists(self.ref))
+        if not mp.buffer_ref_exists(self.ref):
+            raise ValueError(f"no buffer~ named '{name}'")
         self.obj = mp.buffer_ref_getobject(self.ref)
 
     def view(self):
@@ -403,6 +514,11 @@ cdef class Buffer:
         """Retrieve the name of the last file to be read by a buffer~."""
         return sym_to_str(mp.buffer_getfilename(self.obj))
 
+    @property
+    def locked(self):
+        """True while the samples are locked and can be viewed."""
+        return self.is_locked
+
     def setdirty(self):
         """Set the buffer's dirty flag, indicating that changes have been made."""
         mp.buffer_setdirty(self.obj)
@@ -412,31 +528,88 @@ cdef class Buffer:
         mp.buffer_setpadding(self.obj, samplecount)
 
     def locksamples(self):
-        """Claim the buffer∼ and get a pointer to the first sample in memory."""
+        """Claim the buffer∼ and get a pointer to the first sample in memory.
+
+        Returns False if the buffer~ has no samples or is being modified, in
+        which case it is not locked.
+        """
+        if self.is_locked:
+            return True
         self.samples = mp.buffer_locksamples(self.obj)
+        if self.samples == NULL:
+            return False
+        # the size cannot change while the samples are locked
+        self.shape[0] = mp.buffer_getframecount(self.obj)
+        self.shape[1] = mp.buffer_getchannelcount(self.obj)
+        self.strides[0] = self.shape[1] * sizeof(float)
+        self.strides[1] = sizeof(float)
         self.is_locked = True
+        return True
 
     def unlocksamples(self):
         """Release your claim on the buffer~ contents so that other objects may read/write to the buffer~."""
+        if not self.is_locked:
+            return
+        if self.exports > 0:
+            raise BufferError(f"{self.exports} view(s) of the samples still exist")
         mp.buffer_unlocksamples(self.obj)
+        self.samples = NULL
         self.is_locked = False
 
+    def __enter__(self):
+        if not self.locksamples():
+            raise BufferError("buffer~ has no samples or is being modified")
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        mp.buffer_setdirty(self.obj)
+        self.unlocksamples()
+        return False
+
+    def __getbuffer__(self, Py_buffer *view, int flags):
+        if not self.is_locked:
+            raise BufferError("lock the samples first, e.g. `with buf:`")
+        view.buf = <void*>self.samples
+        view.obj = self
+        view.len = self.shape[0] * self.shape[1] * sizeof(float)
+        view.readonly = 0
+        view.itemsize = sizeof(float)
+        view.format = NULL
+        if flags & PyBUF_FORMAT:
+            view.format = b'f'
+        view.ndim = 2
+        view.shape = NULL
+        if flags & PyBUF_ND:
+            view.shape = self.shape
+        # the samples are c-contiguous, so strides are only given on request
+        view.strides = NULL
+        if (flags & PyBUF_STRIDES) == PyBUF_STRIDES:
+            view.strides = self.strides
+        view.suboffsets = NULL
+        view.internal = NULL
+        self.exports += 1
+
+    def __releasebuffer__(self, Py_buffer *view):
+        self.exports -= 1
+
 # ----------------------------------------------------------------------------
 # Dictionary
 
 cdef class Dictionary:
     """A wrapper class for a Max t_dictionary
+
+    `to_dict()` and `from_dict()` convert whole dictionaries in C, with
+    child dictionaries as dicts and atomarrays as lists:
+
+        d = api.Dictionary.from_dict({'a': [1, 2.5], 'b': {'c': 'x'}})
+        d.to_dict()             # {'a': [1, 2.5], 'b': {'c': 'x'}}
+        api.get_dict('preset')  # a registered dictionary as a dict
     """
     cdef mx.t_dictionary *d
-    cdef dict type_map
 
     def __cinit__(self):
         # Create a new dictionary object.
         self.d = mx.dictionary_new() 
-        self.type_map = dict()
-
-    # def __init__(self):
-    #     self.type_map = dict()
 
     def __dealloc__(self):
         # De-allocate if not null
@@ -446,21 +619,52 @@ cdef class Dictionary:
 
     def __setitem__(self, str key, value):
         if isinstance(value, float):
-            self.type_map[key] = 'float'
             self.appendfloat(str_to_sym(key), <double>value)
         elif isinstance(value, int):
-            self.type_map[key] = 'long'
             self.appendlong(str_to_sym(key), <long>value)
         elif isinstance(value, str):
-            self.type_map[key] = 'str'
             self.appendsym(str_to_sym(key), str_to_sym(value))
+        else:
+            self.update({key: value})
 
     def __getitem__(self, str key):
-        return {
-            'float': self.get_float(key),
-            'long': self.get_long(key),
-            'str': self.get_str(key),
-        }[key]
+        return px.py_dictionary_entry_to_value(self.d, str_to_sym(key), False)
+
+    def __contains__(self, str key):
+        return bool(mx.dictionary_hasentry(self.d, str_to_sym(key)))
+
+    def __len__(self):
+        return mx.dictionary_getentrycount(self.d)
+
+    def to_dict(self, bint arrays=False) -> dict:
+        """Convert the dictionary to a python dict, recursively.
+
+        With `arrays=True`, atomarrays holding only numbers become
+        `array.array('q')` (all ints) or `array.array('d')` objects, which
+        are much smaller and faster to build than lists.
+        """
+        return px.py_dictionary_to_dict(self.d, arrays)
+
+    def update(self, dict d):
+        """Copy the entries of a python dict into the dictionary.
+
+        Nested dicts become child dictionaries and lists, tuples and sets
+        become atomarrays, as for the `py` dictionary output.
+        """
+        cdef PyExternal ext = PyExternal()
+        cdef mx.t_max_err err
+        if ext.obj == NULL:
+            raise RuntimeError("no py object to convert the dict")
+        err = px.py_dict_to_dictionary(ext.obj, d, self.d)
+        if err != mx.MAX_ERR_NONE:
+            raise RuntimeError("could not convert the dict")
+
+    @staticmethod
+    def from_dict(dict d) -> Dictionary:
+        """Create a new dictionary from a python dict (see `update`)."""
+        cdef Dictionary result = Dictionary()
+        result.update(d)
+        return result
 
     cdef mx.t_max_err appendlong(self, mx.t_symbol* key, mx.t_atom_long value):
         """Add a long integer value to the dictionary."""
@@ -1312,13 +1516,21 @@ cdef class PyExternal:
         """Retrieves the py object name and reference.
 
         PY_OBJ_NAME is set to __builtins__ at object creation
-        making it available to all modules.
+        making it available to all modules. It is also set in
+        the object namespace, which is preferred when called from
+        there since __builtins__ is shared by all objects in an
+        interpreter.
 
         Since all py objects are registered, knowing the name
         allows any module in the namespace to get a reference
         (as below) to its parent object.
         """
-        PY_OBJ_NAME = getattr(__builtins__, 'PY_OBJ_NAME')
+        cdef PyObject* caller_globals = PyEval_GetGlobals()
+        PY_OBJ_NAME = None
+        if caller_globals != NULL:
+            PY_OBJ_NAME = (<object>caller_globals).get('PY_OBJ_NAME')
+        if PY_OBJ_NAME is None:
+            PY_OBJ_NAME = getattr(__builtins__, 'PY_OBJ_NAME')
         self.name = PY_OBJ_NAME.encode('utf-8')
         self.obj = <px.t_py *>mx.object_findregistered(
             mx.CLASS_BOX, mx.gensym(self.name))
@@ -1339,22 +1551,18 @@ cdef class PyExternal:
         px.py_scan(self.obj)
 
     cdef lookup(self, str name):
-        cdef mx.t_hashtab* registry = px.get_global_registry()
-        cdef mx.t_object* obj = NULL
-        cdef mx.t_max_err err
-
-        if (mx.hashtab_getsize(registry) == 0):
-            self.error("registry not populated")
-            return
+        cdef mx.t_object* obj = px.py_registry_lookup(self.obj, str_to_sym(name), NULL)
 
-        err = mx.hashtab_lookup(registry, str_to_sym(name), &obj)
-
-        if ((err != mx.MAX_ERR_NONE) or (obj == NULL)):
+        if (obj == NULL):
             self.error("no object found with name")
         else:
             self.log("found object")
 
 
+    def get_buffer(self, str name):
+        """Return a `Buffer` referring to the buffer~ with the given name."""
+        return Buffer.from_name(<mx.t_object*>self.obj, name)
+
     def test_buffer(self, str name):
         buf = Buffer.from_name(<mx.t_object*>self.obj, name)
         buf.view()
@@ -1389,28 +1597,20 @@ cdef class PyExternal:
 
     cdef send(self, str name, list args):
         cdef long argc = <long>len(args) + 1
-        cdef mx.t_atom argv[PY_MAX_ATOMS]
-        _args = [name] + args
-
-        if argc < 1:
-            self.error("no arguments given")
-            return
+        cdef long capacity = 0
+        cdef mx.t_atom* argv = px.py_atom_arena_acquire(argc, &capacity)
 
-        if argc >= PY_MAX_ATOMS - 1:
-            self.error("number of args exceeded app limit")
-            return
-
-        for i, elem in enumerate(_args):
-            if type(elem) == float:
-                mx.atom_setfloat(&argv[i], <double>elem)
-            elif type(elem) == int:
-                mx.atom_setlong((&argv[i]), <long>elem)
-            elif type(elem) == str:
-                mx.atom_setsym((&argv[i]), str_to_sym(elem))
-            else:
-                continue
-        # mx.postatom(argv)
-        px.py_send(self.obj, mx.gensym(""), argc, argv)
+        if argv == NULL:
+            raise MemoryError
+        try:
+            if argc > capacity:
+                self.error("number of args exceeded app limit")
+                return
+            mx.atom_setsym(argv, str_to_sym(name))
+            px.py_items_to_atoms(args, 0, argc - 1, argv + 1)
+            px.py_send(self.obj, mx.gensym(""), argc, argv)
+        finally:
+            px.py_atom_arena_release(argv)
 
 
     # UNTESTED
@@ -1447,26 +1647,11 @@ cdef class PyExternal:
         mx.outlet_int(<void*>px.get_outlet(self.obj), <long>arg)
 
     cdef out_list(self, list arg):
-        """note: not recursive...(yet) still cannot deal with list in list"""
-        cdef long argc = <long>len(arg)
-        cdef mx.t_atom argv[PY_MAX_ATOMS]
+        """note: not recursive...(yet) still cannot deal with list in list
 
-        if argc >= PY_MAX_ATOMS :
-            self.error("number of args exceeded app limit")
-            return
-
-        for i, elem in enumerate(arg):
-            if type(elem) == float:
-                mx.atom_setfloat(&argv[i], <double>elem)
-            elif type(elem) == int:
-                mx.atom_setlong((&argv[i]), <long>elem)
-            elif type(elem) == str:
-                mx.atom_setsym((&argv[i]), str_to_sym(elem))
-            else:
-                continue
-
-        mx.outlet_list(<void*>px.get_outlet(self.obj), mx.gensym("list"),
-            argc, argv)
+        lists longer than `PY_ATOM_ARENA_MAX` are output in several parts.
+        """
+        px.py_outlet_items(<void*>px.get_outlet(self.obj), arg)
 
     cdef out_dict(self, dict arg):
         """note: not recursive...(yet) still cannot deal with dict in dict"""
@@ -1494,6 +1679,107 @@ cdef class PyExternal:
          return mx.object_method_binbuf(<mx.t_object*>self.obj, s, buf, rv)
 
 
+# ----------------------------------------------------------------------------
+# Handle
+
+cdef class Handle:
+    """A message bound to a named object (see `bind`)
+
+    Calling the handle sends its message straight to the receiver's method,
+    with atoms built in a buffer kept by the handle:
+
+        freq = api.bind('osc', 'frequency')
+        freq(440)
+
+    If the receiver is freed or renamed, its name is looked up again on
+    the next call.
+    """
+    cdef px.t_py_send_handle handle
+    cdef mx.t_atom* atoms
+    cdef long size
+    cdef bint busy
+
+    def __cinit__(self):
+        self.atoms = NULL
+        self.size = 0
+        self.busy = False
+
+    def __dealloc__(self):
+        if self.atoms != NULL:
+            mx.sysmem_freeptr(self.atoms)
+
+    @staticmethod
+    cdef Handle new(px.t_py* x, str name, str selector):
+        cdef Handle handle = Handle.__new__(Handle)
+        cdef mx.t_symbol* sel = NULL
+        if selector is not None:
+            sel = str_to_sym(selector)
+        if px.py_send_bind(x, &handle.handle, str_to_sym(name), sel) != mx.MAX_ERR_NONE:
+            raise LookupError(f"no object named '{name}'")
+        return handle
+
+    @property
+    def name(self):
+        return sym_to_str(self.handle.name)
+
+    @property
+    def selector(self):
+        if self.handle.sel == NULL:
+            return None
+        return sym_to_str(self.handle.sel)
+
+    cdef rebind(self):
+        cdef PyExternal ext = PyExternal()
+        if (ext.obj == NULL or px.py_send_bind(ext.obj, &self.handle,
+                self.handle.name, self.handle.sel) != mx.MAX_ERR_NONE):
+            raise LookupError(f"no object named '{self.name}'")
+
+    cdef send(self, long argc, mx.t_atom* argv):
+        cdef mx.t_max_err err = px.py_send_dispatch(&self.handle, argc, argv)
+        if err == mx.MAX_ERR_INVALID_PTR:
+            self.rebind()
+            err = px.py_send_dispatch(&self.handle, argc, argv)
+        if err != mx.MAX_ERR_NONE:
+            raise RuntimeError(f"failed to send to '{self.name}'")
+
+    cdef mx.t_atom* reserve(self, long size):
+        cdef mx.t_atom* atoms
+        if self.atoms == NULL or size > self.size:
+            size = max(size, 8)
+            if self.atoms == NULL:
+                atoms = <mx.t_atom*>mx.sysmem_newptr(size * sizeof(mx.t_atom))
+            else:
+                atoms = <mx.t_atom*>mx.sysmem_resizeptr(self.atoms, size * sizeof(mx.t_atom))
+            if atoms == NULL:
+                return NULL
+            self.atoms = atoms
+            self.size = size
+        return self.atoms
+
+    def __call__(self, *args):
+        cdef bint nested = self.busy
+        cdef mx.t_atom* argv = NULL
+        if len(args) == 1 and isinstance(args[0], (list, tuple)):
+            args = args[0]
+        cdef long argc = args_count(args)
+
+        if nested:
+            # re-entered from the receiver: keep the outer arguments intact
+            argv = <mx.t_atom*>mx.sysmem_newptr((argc + 1) * sizeof(mx.t_atom))
+        else:
+            argv = self.reserve(argc)
+        if argv == NULL:
+            raise MemoryError
+
+        self.busy = True
+        try:
+            self.send(args_to_atoms(args, argv), argv)
+        finally:
+            self.busy = nested
+            if nested:
+                mx.sysmem_freeptr(argv)
+
+
 # ----------------------------------------------------------------------------
 # numpy c-api import example
 
@@ -1514,6 +1800,227 @@ if INCLUDE_NUMPY:
         return out
 
 
+# ----------------------------------------------------------------------------
+# buffer kernels
+
+# Buffers can be given as `Buffer` objects or buffer~ names. Each function
+# locks the samples of its buffers (unless already locked by a `with`
+# block), runs a C kernel from py.c with the GIL released, marks changed
+# buffers dirty and unlocks. Frame ranges are [start, end) in frames.
+
+cdef Buffer as_buffer(object obj):
+    if isinstance(obj, Buffer):
+        return obj
+    if isinstance(obj, str):
+        return get_buffer(obj)
+    raise TypeError("expected a Buffer or the name of a buffer~")
+
+cdef list lock_buffers(list buffers):
+    """Lock buffers that are not locked yet and return those"""
+    cdef list locked = []
+    cdef Buffer buf
+    for buf in buffers:
+        if buf.is_locked:
+            continue
+        if not buf.locksamples():
+            unlock_buffers(locked, None)
+            raise BufferError("buffer~ has no samples or is being modified")
+        locked.append(buf)
+    return locked
+
+cdef unlock_buffers(list locked, Buffer dirty):
+    cdef Buffer buf
+    if dirty is not None:
+        mp.buffer_setdirty(dirty.obj)
+    for buf in locked:
+        buf.unlocksamples()
+
+cdef tuple frame_range(Buffer buf, long start, object end):
+    """Clamp a frame range to a locked buffer: (first sample, frames)"""
+    cdef long frames = buf.shape[0]
+    cdef long stop = frames if end is None else end
+    start = min(max(start, 0), frames)
+    stop = min(max(stop, start), frames)
+    return (start * buf.shape[1], stop - start)
+
+def kernel_isa():
+    """Name of the vector unit the buffer kernels use: avx, sse2, neon or scalar."""
+    return px.py_kernel_isa().decode()
+
+def gain(dst, float factor, long start=0, end=None):
+    """Multiply the samples of a buffer~ by a linear gain."""
+    cdef Buffer d = as_buffer(dst)
+    cdef list locked = lock_buffers([d])
+    cdef long offset, n
+    try:
+        offset, n = frame_range(d, start, end)
+        n *= d.shape[1]
+        with nogil:
+            px.py_kernel_gain(d.samples + offset, d.samples + offset, n, factor)
+    finally:
+        unlock_buffers(locked, d)
+
+def peak(src, long start=0, end=None):
+    """Return the largest absolute sample value of a buffer~."""
+    cdef Buffer s = as_buffer(src)
+    cdef list locked = lock_buffers([s])
+    cdef long offset, n
+    cdef float result = 0.0
+    try:
+        offset, n = frame_range(s, start, end)
+        n *= s.shape[1]
+        with nogil:
+            result = px.py_kernel_peak(s.samples + offset, n)
+    finally:
+        unlock_buffers(locked, None)
+    return result
+
+def rms(src, long start=0, end=None):
+    """Return the root mean square of the samples of a buffer~."""
+    cdef Buffer s = as_buffer(src)
+    cdef list locked = lock_buffers([s])
+    cdef long offset, n
+    cdef double sumsq = 0.0
+    try:
+        offset, n = frame_range(s, start, end)
+        n *= s.shape[1]
+        with nogil:
+            sumsq = px.py_kernel_sumsq(s.samples + offset, n)
+    finally:
+        unlock_buffers(locked, None)
+    return (sumsq / n) ** 0.5 if n > 0 else 0.0
+
+def normalize(dst, float level=1.0, long start=0, end=None):
+    """Scale a buffer~ so that its peak is `level` and return the gain used.
+
+    A silent range is left unchanged and returns 1.0.
+    """
+    cdef Buffer d = as_buffer(dst)
+    cdef list locked = lock_buffers([d])
+    cdef long offset, n
+    cdef float factor = 1.0
+    try:
+        offset, n = frame_range(d, start, end)
+        n *= d.shape[1]
+        with nogil:
+            factor = px.py_kernel_peak(d.samples + offset, n)
+            factor = level / factor if factor > 0.0 else 1.0
+            px.py_kernel_gain(d.samples + offset, d.samples + offset, n, factor)
+    finally:
+        unlock_buffers(locked, d)
+    return factor
+
+def mix(dst, a, b, float gain_a=1.0, float gain_b=1.0):
+    """Write a * gain_a + b * gain_b into dst, which may be a or b.
+
+    The buffers must have the same number of channels. The shortest one
+    sets the number of frames.
+    """
+    cdef Buffer d = as_buffer(dst)
+    cdef Buffer sa = as_buffer(a)
+    cdef Buffer sb = as_buffer(b)
+    cdef list locked = lock_buffers([d, sa, sb])
+    cdef long n
+    try:
+        if not d.shape[1] == sa.shape[1] == sb.shape[1]:
+            raise ValueError("buffers must have the same number of channels")
+        n = min(d.shape[0], sa.shape[0], sb.shape[0]) * d.shape[1]
+        with nogil:
+            px.py_kernel_mix(d.samples, sa.samples, gain_a, sb.samples, gain_b, n)
+    finally:
+        unlock_buffers(locked, d)
+
+def crossfade(dst, a, b):
+    """Write a linear crossfade from a to b into dst, which may be a or b.
+
+    The buffers must have the same number of channels. The shortest one
+    sets the length of the fade.
+    """
+    cdef Buffer d = as_buffer(dst)
+    cdef Buffer sa = as_buffer(a)
+    cdef Buffer sb = as_buffer(b)
+    cdef list locked = lock_buffers([d, sa, sb])
+    cdef long frames, channels
+    try:
+        if not d.shape[1] == sa.shape[1] == sb.shape[1]:
+            raise ValueError("buffers must have the same number of channels")
+        frames = min(d.shape[0], sa.shape[0], sb.shape[0])
+        channels = d.shape[1]
+        with nogil:
+            px.py_kernel_crossfade(d.samples, sa.samples, sb.samples, frames, channels)
+    finally:
+        unlock_buffers(locked, d)
+
+def resample(dst, src):
+    """Resample src to the length of dst by linear interpolation.
+
+    Channels present in both are resampled, dst must not be src.
+    """
+    cdef Buffer d = as_buffer(dst)
+    cdef Buffer s = as_buffer(src)
+    cdef list locked
+    cdef long channels, c
+    if d.obj == s.obj:
+        raise ValueError("cannot resample a buffer~ into itself")
+    locked = lock_buffers([d, s])
+    try:
+        channels = min(d.shape[1], s.shape[1])
+        with nogil:
+            for c in range(channels):
+                px.py_kernel_resample(d.samples + c, d.shape[0], d.shape[1],
+                                      s.samples + c, s.shape[0], s.shape[1])
+    finally:
+        unlock_buffers(locked, d)
+
+def frames(src, long size, long hop=0, long channel=0, str window='hann'):
+    """Cut one channel of a buffer~ into windowed frames for an FFT.
+
+    Returns a float32 memoryview shaped (frames, size) of the frames that
+    fit completely, `hop` frames apart (size // 2 by default). `window` is
+    'hann' or None for a rectangular window.
+    """
+    cdef Buffer s = as_buffer(src)
+    cdef list locked
+    cdef bytearray data
+    cdef float* out
+    cdef float* win = NULL
+    cdef float* samples
+    cdef long count = 0
+    cdef long stride, i
+    cdef bint hann = window is not None
+    if size <= 0:
+        raise ValueError("frame size must be positive")
+    if hop <= 0:
+        hop = max(size // 2, 1)
+    if hann and window != 'hann':
+        raise ValueError("window must be 'hann' or None")
+    locked = lock_buffers([s])
+    try:
+        if not 0 <= channel < s.shape[1]:
+            raise ValueError(f"no channel {channel} in buffer~")
+        if s.shape[0] >= size:
+            count = (s.shape[0] - size) // hop + 1
+        data = bytearray(count * size * sizeof(float))
+        win = <float*>malloc(size * sizeof(float))
+        if win == NULL:
+            raise MemoryError
+        out = <float*><char*>data
+        samples = s.samples + channel
+        stride = s.shape[1]
+        with nogil:
+            if hann:
+                px.py_kernel_hann(win, size)
+            else:
+                for i in range(size):
+                    win[i] = 1.0
+            for i in range(count):
+                px.py_kernel_window(out + i * size, samples + i * hop * stride,
+                                    stride, win, size)
+    finally:
+        free(win)
+        unlock_buffers(locked, None)
+    return memoryview(data).cast('f', (count, size))
+
 # ----------------------------------------------------------------------------
 # helper functions
 
@@ -1562,6 +2069,127 @@ def lookup(name):
     ext = PyExternal()
     ext.lookup(name)
 
+def bind(str name, str selector=None):
+    """Bind a message to a named object and return a callable `Handle`
+
+    The receiver is looked up in the registry and its method resolved once.
+    Without a selector, the message is chosen from the arguments of each
+    call as for the `send` message.
+    """
+    cdef PyExternal ext = PyExternal()
+    if ext.obj == NULL:
+        raise RuntimeError("no py object to look up names from")
+    return Handle.new(ext.obj, name, selector)
+
+def get_buffer(str name):
+    """Return a `Buffer` referring to the buffer~ with the given name
+
+    Use it as a context manager to view the samples without copying.
+    """
+    cdef PyExternal ext = PyExternal()
+    if ext.obj == NULL:
+        raise RuntimeError("no py object to own the buffer~ reference")
+    return Buffer.from_name(<mx.t_object*>ext.obj, name)
+
+def get_dict(str name, bint arrays=False) -> dict:
+    """Return the registered max dictionary `name` as a python dict
+
+    The conversion runs in C (see `Dictionary.to_dict`) while the
+    dictionary is retained, so it cannot be freed in the meantime.
+    """
+    cdef mx.t_dictionary* d = mx.dictobj_findregistered_retain(str_to_sym(name))
+    if d == NULL:
+        raise KeyError(f"no dictionary named '{name}'")
+    try:
+        return px.py_dictionary_to_dict(d, arrays)
+    finally:
+        mx.dictobj_release(d)
+
+def send_many(items):
+    """Send a batch of messages through handles returned by `bind`
+
+    items is a sequence of (handle, args) pairs where args is as for calling
+    a handle. All arguments are converted first, then the messages are
+    delivered in order by a single C loop with the GIL released.
+    """
+    cdef list batch = list(items)
+    cdef long n = len(batch)
+    cdef long total = 0
+    cdef long start = 0
+    cdef long done = 0
+    cdef mx.t_max_err err = mx.MAX_ERR_NONE
+    cdef px.t_py_send_item* sitems = NULL
+    cdef mx.t_atom* atoms = NULL
+    cdef Handle handle
+
+    for i in range(n):
+        handle, args = batch[i]
+        total += args_count(args)
+
+    sitems = <px.t_py_send_item*>mx.sysmem_newptr((n + 1) * sizeof(px.t_py_send_item))
+    atoms = <mx.t_atom*>mx.sysmem_newptr((total + 1) * sizeof(mx.t_atom))
+    try:
+        if sitems == NULL or atoms == NULL:
+            raise MemoryError
+        total = 0
+        for i in range(n):
+            handle, args = batch[i]
+            sitems[i].handle = &handle.handle
+            sitems[i].argv = atoms + total
+            sitems[i].argc = args_to_atoms(args, atoms + total)
+            total += sitems[i].argc
+
+        while start < n:
+            with nogil:
+                done = px.py_send_many(sitems + start, n - start, &err)
+            start += done
+            if start < n:
+                handle = batch[start][0]
+                if err != mx.MAX_ERR_INVALID_PTR:
+                    raise RuntimeError(f"failed to send to '{handle.name}'")
+                handle.rebind()
+    finally:
+        if sitems != NULL:
+            mx.sysmem_freeptr(sitems)
+        if atoms != NULL:
+            mx.sysmem_freeptr(atoms)
+
+cdef long sched_call(double ms, double interval, str name, tuple args) except 0:
+    cdef PyExternal ext = PyExternal()
+    cdef Atom atoms
+    cdef long timer_id = 0
+    if ext.obj == NULL:
+        raise RuntimeError("no py object to schedule the call on")
+    atoms = Atom.from_seq((name,) + args)
+    timer_id = px.py_sched_call(ext.obj, ms, interval, atoms.size, atoms.ptr)
+    if timer_id == 0:
+        raise ValueError(f"could not schedule a call of '{name}'")
+    return timer_id
+
+def sched(double ms, str name, *args) -> int:
+    """Call `name` in the object namespace with args after ms milliseconds
+
+    Returns the id of the call for `unsched`. Unlike the `sched_id`
+    message, the id belongs to this call whatever else is scheduled.
+    """
+    return sched_call(ms, 0.0, name, args)
+
+def sched_every(double ms, str name, *args) -> int:
+    """Call `name` with args every ms milliseconds and return the call id"""
+    if ms <= 0.0:
+        raise ValueError("sched_every needs a positive interval")
+    return sched_call(ms, ms, name, args)
+
+def unsched(*ids):
+    """Cancel the scheduled calls with the given ids, or all of them"""
+    cdef PyExternal ext = PyExternal()
+    cdef Atom atoms
+    if ext.obj == NULL:
+        raise RuntimeError("no py object to cancel calls on")
+    atoms = Atom.from_seq(ids)
+    if px.py_unsched_call(ext.obj, atoms.size, atoms.ptr) != mx.MAX_ERR_NONE:
+        raise ValueError(f"no scheduled call with one of the ids {ids}")
+
 def post(str s):
     mx.post(s.encode('utf-8'))
 
@@ -12,7 +12,6 @@ cdef extern from "py.h":
 
     cdef void py_log(t_py* x, char* fmt, ...)
     cdef void py_error(t_py* x, char* fmt, ...)
-    cdef mx.t_hashtab* get_global_registry()
     cdef mx.t_max_err py_eval_text(t_py* x, long argc, mx.t_atom* argv, int offset)
 
     # Path helpers
@@ -35,7 +34,11 @@ cdef extern from "py.h":
     cdef mx.t_max_err py_handle_string_output(t_py* x, PyObject* pval)
     cdef mx.t_max_err py_handle_list_output(t_py* x, PyObject* pval)
     cdef mx.t_max_err py_handle_dict_output(t_py* x, PyObject* pval)
+    cdef mx.t_max_err py_dict_to_dictionary(t_py* x, object pdict, mx.t_dictionary* d) except? -1
+    cdef object py_dictionary_entry_to_value(mx.t_dictionary* d, mx.t_symbol* key, bint arrays)
+    cdef object py_dictionary_to_dict(mx.t_dictionary* d, bint arrays)
     cdef mx.t_max_err py_handle_output(t_py* x, PyObject* pval)
+    cdef int py_number_to_atom(PyObject* item, mx.t_atom* atom) except -1
 
     # Core Python Methods
 
@@ -63,12 +66,34 @@ cdef extern from "py.h":
 
     cdef mx.t_max_err py_task(t_py* x)
     cdef mx.t_max_err py_sched(t_py* x, mx.t_symbol* s, long argc, mx.t_atom* argv)
+    cdef mx.t_max_err py_sched_every(t_py* x, mx.t_symbol* s, long argc, mx.t_atom* argv)
+    cdef mx.t_max_err py_unsched(t_py* x, mx.t_symbol* s, long argc, mx.t_atom* argv)
+    cdef long py_sched_call(t_py* x, double delay, double interval, long argc, mx.t_atom* argv)
+    cdef mx.t_max_err py_unsched_call(t_py* x, long argc, mx.t_atom* argv)
+    cdef mx.t_max_err py_async(t_py* x, mx.t_symbol* s, long argc, mx.t_atom* argv)
 
     # Interobject Methods
 
     cdef mx.t_max_err py_send(t_py* x, mx.t_symbol* s, long argc, mx.t_atom* argv)
+    ctypedef struct t_py_send_handle:
+        mx.t_symbol* name
+        mx.t_symbol* sel
+        long generation
+
+    ctypedef struct t_py_send_item:
+        t_py_send_handle* handle
+        long argc
+        mx.t_atom* argv
+
+    cdef mx.t_max_err py_send_bind(t_py* x, t_py_send_handle* handle, mx.t_symbol* name, mx.t_symbol* sel)
+    cdef mx.t_max_err py_send_dispatch(t_py_send_handle* handle, long argc, mx.t_atom* argv)
+    cdef long py_send_many(t_py_send_item* items, long n, mx.t_max_err* err) nogil
     cdef void py_scan(t_py* x)
-    cdef long py_scan_callback(t_py* x, mx.t_object* obj)
+
+    # Registry helpers
+
+    cdef mx.t_object* py_registry_lookup(t_py* x, mx.t_symbol* name, long* generation)
+    cdef mx.t_object* py_registry_resolve(mx.t_symbol* name, long generation)
 
     # Code editor Methods
 
@@ -80,10 +105,31 @@ cdef extern from "py.h":
     cdef void py_edclose(t_py* x, char** text, long size)
     cdef mx.t_max_err py_edsave(t_py* x, char** text, long size)
 
+    # atom arena
+
+    cdef int PY_ATOM_ARENA_MAX
+    cdef mx.t_atom* py_atom_arena_acquire(long size, long* capacity)
+    cdef void py_atom_arena_release(mx.t_atom* atoms)
+    cdef long py_items_to_atoms(object pseq, long start, long n, mx.t_atom* atoms) except -1
+    cdef long py_outlet_items(void* outlet, object pseq) except -1
+
     # Datastructure support methods
 
     # table
     cdef bint py_table_exists(t_py* x, char* table_name)
     cdef mx.t_max_err py_list_to_table(t_py* x, char* table_name, PyObject* plist)
     cdef PyObject* py_table_to_list(t_py* x, char* table_name)
-
+    cdef Py_ssize_t py_ints_to_longs(object obj, long* dst, Py_ssize_t size) except -1
+    cdef object py_longs_to_list(const long* src, Py_ssize_t n)
+
+    # buffer kernels
+
+    cdef const char* py_kernel_isa()
+    cdef void py_kernel_gain(float* dst, const float* src, long n, float gain) nogil
+    cdef void py_kernel_mix(float* dst, const float* a, float gain_a, const float* b, float gain_b, long n) nogil
+    cdef void py_kernel_crossfade(float* dst, const float* a, const float* b, long frames, long channels) nogil
+    cdef float py_kernel_peak(const float* src, long n) nogil
+    cdef double py_kernel_sumsq(const float* src, long n) nogil
+    cdef void py_kernel_resample(float* dst, long dst_frames, long dst_stride, const float* src, long src_frames, long src_stride) nogil
+    cdef void py_kernel_hann(float* window, long n) nogil
+    cdef void py_kernel_window(float* dst, const float* src, long src_stride, const float* window, long n) nogil
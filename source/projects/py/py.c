@@ -18,7 +18,45 @@ t_class* py_class; // global pointer to object class
 
 static int py_global_obj_count = 0; // when 0 then free interpreter
 
-static t_hashtab* py_global_registry = NULL; // global object lookups
+// named boxes, kept current by notifications (see `py_registry_watch`)
+static t_hashtab* py_global_registry = NULL; // name -> t_py_registry_entry
+static t_class* py_registry_class = NULL;    // class of the notify client
+static t_object* py_global_registry_client = NULL; // attached to watched
+static t_py_registry_entry** py_global_registry_table = NULL; // by pointer
+static long py_global_registry_size = 0;  // buckets in the table (power of 2)
+static long py_global_registry_count = 0; // watched boxes and patchers
+static long py_global_registry_generation = 0; // stamp of the last binding
+static t_systhread_mutex py_global_registry_mutex = NULL; // guards the above
+
+#if PY_VERSION_HEX >= 0x030C0000
+static int py_global_dict_watcher = -1; // dict watcher for cache invalidation
+static uint64_t py_global_dict_generation = 1; // bumped by watched dicts
+#endif
+
+static PyThreadState* py_global_main_tstate = NULL; // released main thread
+
+// subinterpreters (see `py_interp_acquire`)
+static t_systhread_mutex py_global_interp_mutex = NULL; // guards the list
+#if PY_VERSION_HEX >= 0x030C0000
+static t_py_interp* py_global_interps = NULL; // live subinterpreters
+#endif
+
+// shared worker pool (see `py_job_post`)
+static t_systhread py_global_workers[PY_WORKER_THREADS];
+static t_systhread_mutex py_global_jobs_mutex = NULL; // guards all job queues
+static t_systhread_cond py_global_jobs_ready = NULL;  // object became ready
+static t_systhread_cond py_global_jobs_done = NULL;   // a job has finished
+static t_py* py_global_jobs_head = NULL; // objects with a job ready to run
+static t_py* py_global_jobs_tail = NULL;
+static int py_global_workers_running = 0;
+static int py_global_workers_quit = 0;
+
+// record logs (see `py_record`)
+static _Thread_local t_py* py_record_inner = NULL; // object calling itself
+
+// last call scheduled by a message on this thread (see `py_sched_id`)
+static _Thread_local t_py* py_sched_last_obj = NULL;
+static _Thread_local long py_sched_last_id = 0;
 
 #if defined(__APPLE__) && (defined(PY_STATIC_EXT) || defined(PY_SHARED_PKG))
 CFBundleRef py_global_bundle;
@@ -31,6 +69,170 @@ static char* py_global_external_path[MAX_PATH_CHARS];
 /*--------------------------------------------------------------------------*/
 /* Datastructures */
 
+typedef struct t_py_code_entry {
+    char* text;                 /*!< source text (owned copy) */
+    unsigned long hash;         /*!< hash of source text */
+    int mode;                   /*!< compile mode: Py_eval_input, ... */
+    PyObject* code;             /*!< compiled code object (strong ref) */
+    unsigned long stamp;        /*!< last-use stamp for lru eviction */
+} t_py_code_entry;
+
+struct t_py_call_entry {
+    t_symbol* name;             /*!< callable name symbol (cache key) */
+    PyObject* names;            /*!< tuple of interned dotted name parts */
+    PyObject* callable;         /*!< resolved callable (strong ref) */
+    uint64_t globals_version;   /*!< globals dict version at resolution */
+    uint64_t builtins_version;  /*!< builtins dict version if found there */
+    int min_args;               /*!< min positional args or -1 if unknown */
+    int max_args;               /*!< max positional args or -1 if unknown */
+    long list_nargs;            /*!< arg count learned to need a list or -1 */
+    unsigned long stamp;        /*!< last-use stamp for lru eviction */
+};
+
+typedef struct t_py_sym_entry {
+    t_symbol* sym;              /*!< max symbol (cache key) */
+    PyObject* str;              /*!< interned python string (strong ref) */
+} t_py_sym_entry;
+
+struct t_py_pipe_entry {
+    long nstages;               /*!< number of stages or 0 if slot unused */
+    t_symbol* stages[PY_PIPE_MAX_STAGES]; /*!< stage symbols (cache key) */
+    PyObject* funcs[PY_PIPE_MAX_STAGES];  /*!< resolved stages (strong refs) */
+    uint64_t globals_version;   /*!< globals dict version at resolution */
+    uint64_t builtins_version;  /*!< builtins dict version at resolution */
+    unsigned long stamp;        /*!< last-use stamp for lru eviction */
+};
+
+struct t_py_registry_entry {
+    t_object* key;              /*!< watched box or patcher */
+    t_object* patcher;          /*!< patcher of the box or NULL if a patcher */
+    t_symbol* name;             /*!< scripting name or NULL if unnamed */
+    long generation;            /*!< stamp of the name binding or 0 */
+    t_py_registry_entry* next;  /*!< next entry in the same bucket */
+};
+
+enum { PY_GIL_NONE, PY_GIL_ENSURED, PY_GIL_ENTERED, PY_GIL_TEMPORARY };
+
+typedef struct t_py_interp_thread {
+    t_systhread thread;         /*!< thread owning the thread state */
+    PyThreadState* tstate;      /*!< thread state in the subinterpreter */
+} t_py_interp_thread;
+
+struct t_py_interp {
+    t_symbol* name;             /*!< group name or NULL if private */
+    long refcount;              /*!< number of objects using it */
+    PyInterpreterState* interp; /*!< subinterpreter with its own GIL */
+    int dict_watcher;           /*!< dict watcher id in this interpreter */
+    uint64_t dict_generation;   /*!< bumped by dicts watched in it */
+    t_py_interp_thread* threads; /*!< thread states created so far */
+    long nthreads;              /*!< number of thread states */
+    long threads_size;          /*!< allocated size of threads */
+    t_py_interp* next;          /*!< next subinterpreter in the global list */
+};
+
+typedef struct t_py_timer {
+    double when;                /*!< logical time of the call in ms */
+    double interval;            /*!< repeat interval in ms or 0 if once */
+    long id;                    /*!< handle for `unsched` */
+    unsigned long seq;          /*!< orders calls due at the same time */
+    long argc;                  /*!< number of atoms: callable and args */
+    t_atom* argv;               /*!< copied atoms (pooled) */
+    long argv_size;             /*!< allocated size of argv */
+} t_py_timer;
+
+enum { PY_JOB_FREE, PY_JOB_PENDING, PY_JOB_RUNNING, PY_JOB_DONE };
+
+typedef struct t_py_job {
+    t_symbol* sel;              /*!< message selector */
+    long argc;                  /*!< number of copied arguments */
+    t_atom* argv;               /*!< copied arguments (owned, reused) */
+    long argv_size;             /*!< allocated size of argv */
+    t_py_job_value value;       /*!< computes the result on a worker */
+    t_py_job_done done;         /*!< outputs the result on the main thread */
+    PyObject* pval;             /*!< result or NULL on error */
+    PyObject* err_type;         /*!< exception raised by value */
+    PyObject* err_value;
+    PyObject* err_tb;
+    int state;                  /*!< PY_JOB_FREE, PENDING, RUNNING or DONE */
+    long stats;                 /*!< PY_STATS_* of the message */
+} t_py_job;
+
+enum {
+    PY_TRACE_BEGIN,             /*!< message starts: selector, 1st symbol */
+    PY_TRACE_END,               /*!< message ends: selector, success */
+    PY_TRACE_CODE,              /*!< code evaluation starts: text length */
+    PY_TRACE_CODE_END,          /*!< code evaluation ends: success */
+    PY_TRACE_OUTPUT,            /*!< list output: atoms, from a buffer */
+    PY_TRACE_RETRY,             /*!< call retried with a list: callable */
+    PY_TRACE_SCHED,             /*!< scheduled call fires: id, repeats */
+    PY_TRACE_DROP,              /*!< job dropped: selector, total dropped */
+    PY_TRACE_ASYNC,             /*!< async task spawned: running tasks */
+    PY_TRACE_EVENTS
+};
+
+typedef struct t_py_trace_def {
+    const char* name;           /*!< event name or NULL to use symbol a */
+    char phase;                 /*!< 'B' begin, 'E' end or 'i' instant */
+    const char* args[3];        /*!< names of a, b and f or NULL if unused */
+    const char* kinds;          /*!< 's' symbol, 'l' long or 'f' float */
+} t_py_trace_def;
+
+static const t_py_trace_def py_trace_defs[PY_TRACE_EVENTS] = {
+    { NULL,        'B', { NULL, "arg", "argc" },       "-sl" },
+    { NULL,        'E', { NULL, "ok", NULL },          "-l-" },
+    { "code",      'B', { "length", NULL, NULL },      "l--" },
+    { "code",      'E', { "ok", NULL, NULL },          "l--" },
+    { "output",    'i', { "atoms", "buffer", NULL },   "ll-" },
+    { "retry",     'i', { "callable", "args", NULL },  "sl-" },
+    { "sched",     'i', { "id", "every", "time" },     "llf" },
+    { "drop",      'i', { "selector", "dropped", NULL }, "sl-" },
+    { "async",     'i', { "tasks", NULL, NULL },       "l--" },
+};
+
+enum {
+    PY_STATS_IMPORT,
+    PY_STATS_EVAL,
+    PY_STATS_EXEC,
+    PY_STATS_EXECFILE,
+    PY_STATS_ASSIGN,
+    PY_STATS_CALL,
+    PY_STATS_CODE,              /*!< code and anything messages */
+    PY_STATS_PIPE,
+    PY_STATS_LIST,              /*!< int, float and lists through `@pipe` */
+    PY_STATS_SEND,
+    PY_STATS_SCHED,             /*!< scheduled calls, including the call */
+    PY_STATS_ASYNC,             /*!< async messages spawning tasks */
+    PY_STATS_ASYNC_STEP,        /*!< asyncio loop steps running tasks */
+    PY_STATS_OUTPUT,            /*!< output handlers, atoms output */
+    PY_STATS_METHODS
+};
+
+static const char* py_stats_names[PY_STATS_METHODS] = {
+    "import", "eval", "exec", "execfile", "assign", "call", "code",
+    "pipe", "list", "send", "sched", "async", "async_step", "output",
+};
+
+struct t_py_stats_entry {
+    volatile int64_t count;     /*!< number of calls */
+    volatile int64_t errors;    /*!< number of failed calls */
+    volatile int64_t atoms;     /*!< number of atoms converted */
+    volatile int64_t wall_total; /*!< sum of wall times in ns */
+    volatile int64_t wall_max;  /*!< longest wall time in ns */
+    volatile int64_t wait_max;  /*!< longest gil wait in ns */
+    t_int32_atomic wall[PY_STATS_BUCKETS]; /*!< wall time histogram */
+    t_int32_atomic wait[PY_STATS_BUCKETS]; /*!< gil wait histogram */
+};
+
+struct t_py_trace_event {
+    volatile uint32_t seq;      /*!< sequence number or 0 while written */
+    long id;                    /*!< PY_TRACE_* event */
+    t_systhread thread;         /*!< recording thread */
+    double time;                /*!< systimer time in ms */
+    t_ptr_int a;                /*!< raw arguments, see `py_trace_defs` */
+    t_ptr_int b;
+    double f;
+};
+
 
 struct t_py {
     /* object header */
@@ -43,6 +245,72 @@ struct t_py {
     t_symbol* p_pythonpath;     /*!< path to python directory */
     t_bool p_debug;             /*!< bool to switch per-object debug state */
     PyObject* p_globals;        /*!< per object 'globals' python namespace */
+    t_symbol* p_interpreter;    /*!< "" for main, own or a group name */
+    t_py_interp* p_interp;      /*!< subinterpreter or NULL for main */
+
+    /* compiled code cache */
+    t_py_code_entry p_code_cache[PY_CODE_CACHE_SIZE]; /*!< lru cache of code objects */
+    unsigned long p_code_cache_stamp; /*!< monotonic lru use counter */
+    long p_code_cache_hits;     /*!< number of cache hits */
+    long p_code_cache_misses;   /*!< number of cache misses (compiles) */
+
+    /* resolved callable cache */
+    t_py_call_entry p_call_cache[PY_CALL_CACHE_SIZE]; /*!< lru cache of callables */
+    unsigned long p_call_cache_stamp; /*!< monotonic lru use counter */
+
+    /* compiled pipeline cache */
+    t_py_pipe_entry p_pipe_cache[PY_PIPE_CACHE_SIZE]; /*!< lru cache of pipelines */
+    unsigned long p_pipe_cache_stamp; /*!< monotonic lru use counter */
+    t_symbol* p_pipe[PY_PIPE_MAX_STAGES]; /*!< default pipeline for lists */
+    long p_pipe_count;          /*!< number of stages in default pipeline */
+
+    /* input conversion */
+    t_py_sym_entry p_sym_cache[PY_SYM_CACHE_SIZE]; /*!< symbol -> str cache */
+
+    /* output conversion */
+    t_atom* p_atoms;            /*!< reusable atom buffer for output */
+    long p_atoms_size;          /*!< allocated size of atom buffer */
+    t_bool p_nested;            /*!< flatten nested dicts as key::subkey */
+    t_symbol* p_strings;        /*!< string output mode: symbol, bytes */
+    t_symbol** p_gensyms;       /*!< set of symbols made from output */
+    long p_gensyms_size;        /*!< slots in the set (power of 2) */
+    long p_gensym_count;        /*!< distinct symbols made from output */
+    t_bool p_dictionary;        /*!< output dicts as max dictionaries */
+    t_dictionary* p_dict;       /*!< registered output dictionary (reused) */
+    t_symbol* p_dict_name;      /*!< name of registered output dictionary */
+
+    /* worker thread execution */
+    t_bool p_threaded;          /*!< run namespace messages on workers */
+    long p_queue;               /*!< max number of jobs waiting to run */
+    t_symbol* p_overflow;       /*!< when queue is full: drop or coalesce */
+    long p_dropped;             /*!< number of jobs dropped on overflow */
+    t_py_job p_jobs[PY_JOB_QUEUE_SIZE]; /*!< ring of jobs in message order */
+    long p_jobs_head;           /*!< index of oldest undelivered job */
+    long p_jobs_count;          /*!< number of undelivered jobs */
+    long p_jobs_next;           /*!< offset from head of next job to run */
+    t_bool p_jobs_busy;         /*!< queued for or held by a worker */
+    t_py* p_jobs_link;          /*!< next object in the global ready list */
+    void* p_jobs_qelem;         /*!< delivers results on the main thread */
+    t_bool p_jobs_delivering;   /*!< a result is being output */
+
+    /* tracing */
+    t_bool p_tracing;           /*!< record trace events */
+    t_py_trace_event* p_trace_ring; /*!< last PY_TRACE_SIZE events or NULL */
+    t_int32_atomic p_trace_head; /*!< sequence number of the last event */
+    uint32_t p_trace_mark;      /*!< last sequence number before `clear` */
+
+    /* stats */
+    t_py_stats_entry* p_stats;  /*!< latency histograms by PY_STATS_* */
+    t_dictionary* p_stats_dict; /*!< registered `stats` dictionary (reused) */
+    t_symbol* p_stats_dict_name; /*!< name of the `stats` dictionary */
+
+    /* recording */
+    FILE* p_record;             /*!< open record log or NULL */
+    t_systhread_mutex p_record_mutex; /*!< serializes writes and `stop` */
+    t_hashtab* p_record_syms;   /*!< symbol -> id of symbols in the log */
+    t_symbol* p_record_path;    /*!< path of the open record log */
+    long p_record_count;        /*!< number of messages recorded */
+    double p_record_time;       /*!< scheduler time of the last message */
 
     /* infrastructure objects */
     t_patcher* p_patcher;       /*!< to send msgs to objects */
@@ -50,7 +318,18 @@ struct t_py {
 
     /* time-based ops */
     void* p_clock;              /*!< a clock in case of scheduled ops */
-    t_atomarray* p_sched_atoms; /*!< atomarray for scheduled python function call */
+    t_py_timer* p_timers;       /*!< min-heap of scheduled calls by time */
+    long p_timers_count;        /*!< number of scheduled calls */
+    long p_timers_size;         /*!< allocated size of p_timers */
+    long p_timers_id;           /*!< id of the last scheduled call */
+    unsigned long p_timers_seq; /*!< monotonic scheduling counter */
+    long p_timers_firing;       /*!< id of the call being made or 0 */
+    t_py_timer p_timers_pool[PY_TIMER_POOL_SIZE]; /*!< unused atom buffers */
+    long p_timers_pool_count;   /*!< number of pooled atom buffers */
+    t_systhread_mutex p_timers_mutex; /*!< guards the heap and the pool */
+    void* p_async_clock;        /*!< steps the asyncio loop */
+    PyObject* p_async_loop;     /*!< asyncio loop or NULL until `async` */
+    PyObject* p_async_tasks;    /*!< list of unfinished `async` tasks */
 
     /* text editor attrs */
     t_object* p_code_editor;    /*!< code editor object */
@@ -101,10 +380,11 @@ void* get_outlet(t_py* x)
  * @param ... other arguments
  *
  * This log function is a variadic function which does not `post` its message
- * if the object struct member `x->p_debug` is 0.
+ * if the object struct member `x->p_debug` is 0. Messages longer than
+ * PY_MAX_LOG_CHAR are truncated.
  *
- * WARNING: if PY_MAX_LOG_CHAR (which defines PY_MAX_ERR_CHAR) is less than
- * the length of the log or err message, Max will crash.
+ * Formatting and posting is slow: use `py_trace` in per-message or per-item
+ * code paths instead.
  */
 void py_log(t_py* x, char* fmt, ...)
 {
@@ -113,7 +393,7 @@ void py_log(t_py* x, char* fmt, ...)
 
         va_list va;
         va_start(va, fmt);
-        vsprintf(msg, fmt, va);
+        vsnprintf(msg, PY_MAX_LOG_CHAR, fmt, va);
         va_end(va);
 
         post("[py %s]: %s", x->p_name->s_name, msg);
@@ -133,7 +413,7 @@ void py_error(t_py* x, char* fmt, ...)
 
     va_list va;
     va_start(va, fmt);
-    vsprintf(msg, fmt, va);
+    vsnprintf(msg, PY_MAX_ERR_CHAR, fmt, va);
     va_end(va);
 
     error("[py %s]: %s", x->p_name->s_name, msg);
@@ -165,6 +445,12 @@ void py_init_builtins(t_py* x)
     if (err == -1)
         goto error;
 
+    // builtins are shared by all objects in an interpreter, so the name is
+    // also set in the object namespace where it takes precedence
+    err = PyDict_SetItemString(x->p_globals, "PY_OBJ_NAME", p_name);
+    if (err == -1)
+        goto error;
+
     err = PyDict_SetItemString(x->p_globals, "__builtins__", builtins);
     if (err == -1)
         goto error;
@@ -178,16 +464,6 @@ error:
 }
 
 
-/**
- * @brief Get the global registry object
- * 
- * @return t_hashtab* 
- */
-t_hashtab* get_global_registry(void)
-{
-    return py_global_registry;
-}
-
 
 t_symbol* py_locate_path_to_external(t_py* x)
 {
@@ -307,20 +583,32 @@ void ext_main(void* module_ref)
     class_addmethod(c, (method)py_eval,       "eval",       A_GIMME,   0);
     class_addmethod(c, (method)py_exec,       "exec",       A_GIMME,   0);
     class_addmethod(c, (method)py_execfile,   "execfile",   A_DEFSYM,  0);
+    class_addmethod(c, (method)py_reset,      "reset",      A_NOTHING, 0);
 
     // core extra
     class_addmethod(c, (method)py_assign,     "assign",     A_GIMME,   0);
     class_addmethod(c, (method)py_call,       "call",       A_GIMME,   0);
     class_addmethod(c, (method)py_code,       "code",       A_GIMME,   0);
     class_addmethod(c, (method)py_pipe,       "pipe",       A_GIMME,   0);
+    class_addmethod(c, (method)py_list,       "list",       A_GIMME,   0);
+    class_addmethod(c, (method)py_int,        "int",        A_LONG,    0);
+    class_addmethod(c, (method)py_float,      "float",      A_FLOAT,   0);
     class_addmethod(c, (method)py_anything,   "anything",   A_GIMME,   0);
 
     // time-based
     class_addmethod(c, (method)py_sched,      "sched",      A_GIMME,   0);
+    class_addmethod(c, (method)py_sched_every, "sched_every", A_GIMME, 0);
+    class_addmethod(c, (method)py_unsched,    "unsched",    A_GIMME,   0);
+    class_addmethod(c, (method)py_sched_id,   "sched_id",   0);
+    class_addmethod(c, (method)py_async,      "async",      A_GIMME,   0);
 
     // meta
     class_addmethod(c, (method)py_assist,     "assist",     A_CANT,    0);
     class_addmethod(c, (method)py_count,      "count",      A_NOTHING, 0);
+    class_addmethod(c, (method)py_trace_msg,  "trace",      A_GIMME,   0);
+    class_addmethod(c, (method)py_stats,      "stats",      A_GIMME,   0);
+    class_addmethod(c, (method)py_record_msg, "record",     A_GIMME,   0);
+    class_addmethod(c, (method)py_stop,       "stop",       A_NOTHING, 0);
 
     // interobject
     class_addmethod(c, (method)py_scan,       "scan",       A_NOTHING, 0);
@@ -391,6 +679,12 @@ void ext_main(void* module_ref)
     CLASS_ATTR_BASIC(c,     "debug", 0);
     CLASS_ATTR_SAVE(c,      "debug", 0);
     
+    CLASS_ATTR_LABEL(c,     "nested", 0,  "output nested dicts as key::subkey");
+    CLASS_ATTR_LONG(c,      "nested", 0,  t_py, p_nested);
+    CLASS_ATTR_STYLE(c,     "nested", 0, "onoff");
+    CLASS_ATTR_BASIC(c,     "nested", 0);
+    CLASS_ATTR_SAVE(c,      "nested", 0);
+
     CLASS_ATTR_ORDER(c,     "name",         0,  "1");
     CLASS_ATTR_ORDER(c,     "file",         0,  "2");
     CLASS_ATTR_ORDER(c,     "autoload",     0,  "3");
@@ -399,6 +693,70 @@ void ext_main(void* module_ref)
     CLASS_ATTR_ORDER(c,     "run_on",       0,  "6");
     CLASS_ATTR_ORDER(c,     "pythonpath",   0,  "7");
     CLASS_ATTR_ORDER(c,     "debug",        0,  "8");
+    CLASS_ATTR_LABEL(c,     "strings", 0,  "output strings as symbol or bytes");
+    CLASS_ATTR_SYM(c,       "strings", 0,  t_py, p_strings);
+    CLASS_ATTR_STYLE(c,     "strings", 0,  "enum");
+    CLASS_ATTR_ENUM(c,      "strings", 0,  "symbol bytes");
+    CLASS_ATTR_DEFAULT(c,   "strings", 0,  "symbol");
+    CLASS_ATTR_BASIC(c,     "strings", 0);
+    CLASS_ATTR_SAVE(c,      "strings", 0);
+
+    CLASS_ATTR_LABEL(c,     "gensyms", 0,  "distinct output strings made symbols");
+    CLASS_ATTR_LONG(c,      "gensyms", ATTR_SET_OPAQUE_USER, t_py, p_gensym_count);
+
+    CLASS_ATTR_LABEL(c,     "pipe", 0,  "default pipeline for lists");
+    CLASS_ATTR_SYM_VARSIZE(c, "pipe", 0,  t_py, p_pipe, p_pipe_count,
+                           PY_PIPE_MAX_STAGES);
+    CLASS_ATTR_BASIC(c,     "pipe", 0);
+    CLASS_ATTR_SAVE(c,      "pipe", 0);
+
+    CLASS_ATTR_LABEL(c,     "dictionary", 0,  "output dicts as max dictionary");
+    CLASS_ATTR_LONG(c,      "dictionary", 0,  t_py, p_dictionary);
+    CLASS_ATTR_STYLE(c,     "dictionary", 0, "onoff");
+    CLASS_ATTR_BASIC(c,     "dictionary", 0);
+    CLASS_ATTR_SAVE(c,      "dictionary", 0);
+
+    CLASS_ATTR_ORDER(c,     "nested",       0,  "9");
+    CLASS_ATTR_ORDER(c,     "pipe",         0,  "10");
+    CLASS_ATTR_ORDER(c,     "strings",      0,  "11");
+    CLASS_ATTR_ORDER(c,     "dictionary",   0,  "12");
+
+    CLASS_ATTR_LABEL(c,     "threaded", 0,  "run namespace messages on worker threads");
+    CLASS_ATTR_LONG(c,      "threaded", 0,  t_py, p_threaded);
+    CLASS_ATTR_STYLE(c,     "threaded", 0, "onoff");
+    CLASS_ATTR_BASIC(c,     "threaded", 0);
+    CLASS_ATTR_SAVE(c,      "threaded", 0);
+
+    CLASS_ATTR_LABEL(c,     "queue", 0,  "max number of threaded jobs waiting to run");
+    CLASS_ATTR_LONG(c,      "queue", 0,  t_py, p_queue);
+    CLASS_ATTR_FILTER_CLIP(c, "queue", 1, PY_JOB_QUEUE_SIZE);
+    CLASS_ATTR_SAVE(c,      "queue", 0);
+
+    CLASS_ATTR_LABEL(c,     "overflow", 0,  "when the queue is full: drop or coalesce");
+    CLASS_ATTR_SYM(c,       "overflow", 0,  t_py, p_overflow);
+    CLASS_ATTR_STYLE(c,     "overflow", 0,  "enum");
+    CLASS_ATTR_ENUM(c,      "overflow", 0,  "drop coalesce");
+    CLASS_ATTR_DEFAULT(c,   "overflow", 0,  "drop");
+    CLASS_ATTR_SAVE(c,      "overflow", 0);
+
+    CLASS_ATTR_LABEL(c,     "dropped", 0,  "threaded jobs dropped on overflow");
+    CLASS_ATTR_LONG(c,      "dropped", ATTR_SET_OPAQUE_USER, t_py, p_dropped);
+
+    CLASS_ATTR_ORDER(c,     "threaded",     0,  "13");
+    CLASS_ATTR_ORDER(c,     "queue",        0,  "14");
+    CLASS_ATTR_ORDER(c,     "overflow",     0,  "15");
+
+    CLASS_ATTR_LABEL(c,     "interpreter", 0,  "own or named subinterpreter with its own GIL");
+    CLASS_ATTR_SYM(c,       "interpreter", 0,  t_py, p_interpreter);
+    CLASS_ATTR_ACCESSORS(c, "interpreter", NULL, py_interpreter_set);
+    CLASS_ATTR_SAVE(c,      "interpreter", 0);
+    CLASS_ATTR_ORDER(c,     "interpreter",  0,  "16");
+
+    CLASS_ATTR_LABEL(c,     "tracing", 0,  "record trace events for trace dump");
+    CLASS_ATTR_LONG(c,      "tracing", 0,  t_py, p_tracing);
+    CLASS_ATTR_STYLE(c,     "tracing", 0, "onoff");
+    CLASS_ATTR_ACCESSORS(c, "tracing", NULL, py_tracing_set);
+    CLASS_ATTR_ORDER(c,     "tracing",      0,  "17");
 
     // clang-format on
     //------------------------------------------------------------------------
@@ -411,6 +769,12 @@ void ext_main(void* module_ref)
 
     py_class = c;
 
+    // hidden client which receives patcher and box notifications
+    c = class_new("py_registry", NULL, NULL, (long)sizeof(t_object), 0L, 0);
+    class_addmethod(c, (method)py_registry_notify, "notify", A_CANT, 0);
+    class_register(CLASS_NOBOX, c);
+    py_registry_class = c;
+
 #if defined(__APPLE__) && (defined(PY_STATIC_EXT) || defined(PY_SHARED_PKG))
     // set global bundle ref for macos case
     py_global_bundle = module_ref;
@@ -455,6 +819,54 @@ void* py_new(t_symbol* s, long argc, t_atom* argv)
 
         // python-related
         x->p_pythonpath = gensym("");
+        x->p_globals = NULL;
+        x->p_interpreter = gensym("");
+        x->p_interp = NULL;
+
+        // output conversion
+        x->p_atoms = NULL;
+        x->p_atoms_size = 0;
+        x->p_nested = 0;
+        x->p_strings = gensym("symbol");
+        x->p_gensyms = NULL;
+        x->p_gensyms_size = 0;
+        x->p_gensym_count = 0;
+        x->p_dictionary = 0;
+        x->p_dict = NULL;
+        x->p_dict_name = NULL;
+
+        // worker thread execution
+        x->p_threaded = 0;
+        x->p_queue = PY_JOB_QUEUE_SIZE;
+        x->p_overflow = gensym("drop");
+        x->p_dropped = 0;
+        memset(x->p_jobs, 0, sizeof(x->p_jobs));
+        x->p_jobs_head = 0;
+        x->p_jobs_count = 0;
+        x->p_jobs_next = 0;
+        x->p_jobs_busy = 0;
+        x->p_jobs_link = NULL;
+        x->p_jobs_qelem = qelem_new((t_object*)x, (method)py_job_deliver);
+
+        // tracing
+        x->p_tracing = 0;
+        x->p_trace_ring = NULL;
+        x->p_trace_head = 0;
+        x->p_trace_mark = 0;
+
+        // stats
+        x->p_stats = (t_py_stats_entry*)sysmem_newptrclear(
+            PY_STATS_METHODS * sizeof(t_py_stats_entry));
+        x->p_stats_dict = NULL;
+        x->p_stats_dict_name = NULL;
+
+        // recording
+        x->p_record = NULL;
+        systhread_mutex_new(&x->p_record_mutex, 0);
+        x->p_record_syms = NULL;
+        x->p_record_path = gensym("");
+        x->p_record_count = 0;
+        x->p_record_time = 0.0;
 
         // text editor
         x->p_code = sysmem_newhandle(0);
@@ -474,9 +886,38 @@ void* py_new(t_symbol* s, long argc, t_atom* argv)
         // set default debug level
         x->p_debug = 0;
 
+        // compiled code cache
+        memset(x->p_code_cache, 0, sizeof(x->p_code_cache));
+        x->p_code_cache_stamp = 0;
+        x->p_code_cache_hits = 0;
+        x->p_code_cache_misses = 0;
+
+        // resolved callable cache
+        memset(x->p_call_cache, 0, sizeof(x->p_call_cache));
+        x->p_call_cache_stamp = 0;
+
+        // compiled pipeline cache
+        memset(x->p_pipe_cache, 0, sizeof(x->p_pipe_cache));
+        x->p_pipe_cache_stamp = 0;
+        x->p_pipe_count = 0;
+
+        // symbol string cache
+        memset(x->p_sym_cache, 0, sizeof(x->p_sym_cache));
+
         // test tasks
         x->p_clock = clock_new((t_object*)x, (method)py_task);
-        x->p_sched_atoms = NULL;
+        x->p_timers = NULL;
+        x->p_timers_count = 0;
+        x->p_timers_size = 0;
+        x->p_timers_id = 0;
+        x->p_timers_seq = 0;
+        x->p_timers_firing = 0;
+        memset(x->p_timers_pool, 0, sizeof(x->p_timers_pool));
+        x->p_timers_pool_count = 0;
+        systhread_mutex_new(&x->p_timers_mutex, 0);
+        x->p_async_clock = clock_new((t_object*)x, (method)py_async_tick);
+        x->p_async_loop = NULL;
+        x->p_async_tasks = NULL;
 
         // create inlet(s)
         // create outlet(s)
@@ -529,16 +970,27 @@ void* py_new(t_symbol* s, long argc, t_atom* argv)
         py_log(x, "via object_attr_getsym: %s",
                object_attr_getsym(x, gensym("file"))->s_name);
 
+        // before autoload, so that the loaded file can import from it
+        if (x->p_pythonpath != gensym("")) {
+            t_py_gil gstate = py_gil_ensure(x);
+            PyObject* sys_path = PySys_GetObject((char*)"path"); // borrowed
+            PyObject* py_path = PyUnicode_FromString(x->p_pythonpath->s_name);
+            if (sys_path == NULL) {
+                py_error(x, "could not add %s: no sys.path",
+                         x->p_pythonpath->s_name);
+            } else if (py_path == NULL
+                       || PyList_Append(sys_path, py_path) == -1) {
+                py_handle_error(x, "could not add %s to sys.path",
+                                x->p_pythonpath->s_name);
+            }
+            Py_XDECREF(py_path);
+            py_gil_release(x, gstate);
+        }
+
         if ((x->p_autoload == 1) && (x->p_code_filepath != gensym(""))) {
             py_log(x, "autoloading: %s", x->p_code_filepath->s_name);
             py_load(x, x->p_code_filepath);
         }
-
-        if (x->p_pythonpath != gensym("")) {
-            PyObject* sys_path = PySys_GetObject((char*)"path");
-            PyObject* py_path = PyUnicode_FromString(x->p_pythonpath->s_name);
-            PyList_Append(sys_path, py_path);
-        }
     }
 
     return (x);
@@ -670,18 +1122,42 @@ void py_init(t_py* x)
 #endif
 
     /* Add the cythonized 'api' built-in module, before Py_Initialize */
-    if (PyImport_AppendInittab("api", PyInit_api) == -1) {
+    if (!Py_IsInitialized()
+        && PyImport_AppendInittab("api", PyInit_api) == -1) {
         py_error(x, "could not add api to builtin modules table");
     }
 
 
     Py_Initialize();
 
+    // release the GIL taken by Py_Initialize so that other threads (the
+    // scheduler and the worker pool) can run python; every entry point
+    // takes it back with py_gil_ensure.
+    if (py_global_main_tstate == NULL) {
+        py_global_main_tstate = PyEval_SaveThread();
+        systhread_mutex_new(&py_global_jobs_mutex, 0);
+        systhread_cond_new(&py_global_jobs_ready, 0);
+        systhread_cond_new(&py_global_jobs_done, 0);
+        systhread_mutex_new(&py_global_interp_mutex, 0);
+    }
+
+    // fall back to the main interpreter if a subinterpreter is unavailable
+    if (py_interp_acquire(x) != MAX_ERR_NONE)
+        x->p_interpreter = gensym("");
+
+    t_py_gil gstate = py_gil_ensure(x);
+
     // python init
     PyObject* main_mod = PyImport_AddModule(x->p_name->s_name); // borrowed
     x->p_globals = PyModule_GetDict(main_mod); // borrowed reference
     py_init_builtins(x); // does this have to be a separate function?
 
+    // track namespace changes for the callable cache
+    py_dict_watch(x, x->p_globals);
+    py_dict_watch(x, PyEval_GetBuiltins());
+
+    py_gil_release(x, gstate);
+
     // register the object
     object_register(CLASS_BOX, x->p_name, x);
 
@@ -690,8 +1166,7 @@ void py_init(t_py* x)
 
     if (py_global_obj_count == 1) {
         // if first py object create the py_global_registry;
-        py_global_registry = (t_hashtab*)hashtab_new(0);
-        hashtab_flags(py_global_registry, OBJ_FLAG_REF);
+        py_registry_new();
     }
 }
 
@@ -705,26 +1180,77 @@ void py_free(t_py* x)
     // code editor cleanup
     object_free(x->p_code_editor);
     object_free(x->p_clock);
-    if (x->p_sched_atoms)
-        object_free(x->p_sched_atoms);
+    for (long i = 0; i < x->p_timers_count; i++)
+        sysmem_freeptr(x->p_timers[i].argv);
+    for (long i = 0; i < x->p_timers_pool_count; i++)
+        sysmem_freeptr(x->p_timers_pool[i].argv);
+    if (x->p_timers)
+        sysmem_freeptr(x->p_timers);
+    systhread_mutex_free(x->p_timers_mutex);
+    if (py_sched_last_obj == x)
+        py_sched_last_obj = NULL;
     if (x->p_code)
         sysmem_freehandle(x->p_code);
+    if (x->p_atoms)
+        sysmem_freeptr(x->p_atoms);
+    if (x->p_gensyms)
+        sysmem_freeptr(x->p_gensyms);
+    if (x->p_dict)
+        object_free(x->p_dict);
+
+    // wait for a running job and discard the others
+    py_job_cancel(x);
+    qelem_free(x->p_jobs_qelem);
+
+    x->p_tracing = 0;
+    if (x->p_trace_ring)
+        sysmem_freeptr(x->p_trace_ring);
+    if (x->p_stats)
+        sysmem_freeptr(x->p_stats);
+    if (x->p_stats_dict)
+        object_free(x->p_stats_dict);
+
+    py_record_stop(x);
+    systhread_mutex_free(x->p_record_mutex);
+
+    t_py_gil gstate = py_gil_ensure(x);
+    py_async_close(x);
+    py_code_cache_flush(x);
+    py_call_cache_flush(x);
+    py_pipe_cache_flush(x);
+    py_symbol_cache_flush(x);
 
     // crashes if one attempts to free.
     // #if defined(__APPLE__) && (defined(PY_STATIC_EXT) ||
     // defined(PY_SHARED_PKG)) CFRelease(py_global_bundle); #endif
 
     Py_XDECREF(x->p_globals);
+    py_gil_release(x, gstate);
+    object_free(x->p_async_clock);
+    py_interp_release(x);
     // python objects cleanup
     py_log(x, "will be deleted");
     py_global_obj_count--;
     if (py_global_obj_count == 0) {
         /* WARNING: don't call x here or max will crash */
-        hashtab_chuck(py_global_registry);
+        py_registry_free();
+
+        py_workers_stop();
+        systhread_cond_free(py_global_jobs_done);
+        systhread_cond_free(py_global_jobs_ready);
+        systhread_mutex_free(py_global_jobs_mutex);
+        py_global_jobs_mutex = NULL;
+        systhread_mutex_free(py_global_interp_mutex);
+        py_global_interp_mutex = NULL;
 
         post("last py obj freed -> finalizing py mem / interpreter.");
         // PyMem_RawFree(program);
+        PyEval_RestoreThread(py_global_main_tstate);
+        py_global_main_tstate = NULL;
         Py_FinalizeEx();
+#if PY_VERSION_HEX >= 0x030C0000
+        py_global_dict_watcher = -1;
+#endif
     }
 }
 
@@ -864,6 +1390,9 @@ void py_info(t_py* x)
     post("external_resources_path: %s", external_resources_path);
     post("python_path: %s", python_path);
 
+    post("code cache: %ld hits, %ld misses", x->p_code_cache_hits,
+         x->p_code_cache_misses);
+
     // char* package_path[MAX_PATH_CHARS];
     // char* package_externals_path[MAX_PATH_CHARS];
 
@@ -880,6 +1409,7 @@ void py_info(t_py* x)
  */
 void py_bang(t_py* x)
 {
+    py_record(x, gensym("bang"), 0, NULL);
     // just a passthrough: bang out the left outlet
     outlet_bang(x->p_outlet_left);
 }
@@ -907,505 +1437,5461 @@ void py_bang_failure(t_py* x)
 /*--------------------------------------------------------------------------*/
 /* Time-based */
 
+/* the timer heap is used from the scheduler thread (`py_task`) and from
+   whichever thread sends `sched`, `sched_every` and `unsched`, so it is
+   only touched with `p_timers_mutex` held. The lock is never held while
+   python runs, as a scheduled call may (un)schedule in turn. */
+
 /**
- * @brief Schedule a python function call
- * 
- * @param x pointer to object struct
- * @param s symbol
- * @param argc atom argument count
- * @param argv atom argument vector
- * @return t_max_err error code
+ * @brief Compare two scheduled calls by time, then by scheduling order
  */
-t_max_err py_sched(t_py* x, t_symbol* s, long argc, t_atom* argv)
+static inline int py_timer_before(t_py_timer* a, t_py_timer* b)
 {
-    t_max_err ret = 0;
-
-    // schedule a python call
-    // [sched <time> func arg1 arg2 ... argN]
-    float time = 0.0;
-
-    // first atom in argv must be a float
-    if (argv->a_type != A_FLOAT) {
-        py_error(x, "first atom must be a float!");
-        goto error;
-    }
-
-    if (argc < 2) {
-        py_error(x, "need at least 2 args to schedule function calls");
-        goto error;
-    }
-
-    if ((argv + 0)->a_type != A_FLOAT) {
-        py_error(x, "1st arg of sched needs to be a float time in ms");
-        goto error;
-    }
-
-    // argv+0 is the object name to send to
-    time = atom_getfloat(argv);
-    if (time == 0.0) {
-        goto error;
-    }
+    return a->when < b->when || (a->when == b->when && a->seq < b->seq);
+}
 
-    // atom after the name of the time
-    if ((argv + 1)->a_type != A_SYM) {
-        py_error(x, "2nd elem of sched atom needs to be the name of the callable");
-        goto error;
+/**
+ * @brief Restore the heap order after entry i moved
+ *
+ * @param x pointer to object struct
+ * @param i index of the moved entry
+ */
+static void py_timer_sift(t_py* x, long i)
+{
+    t_py_timer* heap = x->p_timers;
+    t_py_timer entry = heap[i];
+    long n = x->p_timers_count;
+
+    // up
+    while (i > 0 && py_timer_before(&entry, heap + (i - 1) / 2)) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
     }
-
-    // address the minimum case: e.g a bang
-    argc = argc - 1;
-    argv = argv + 1;
-
-    // success
-    // reset it
-    if (x->p_sched_atoms != NULL) {
-        object_free(x->p_sched_atoms);
-        x->p_sched_atoms = NULL;
+    // down
+    for (;;) {
+        long child = 2 * i + 1;
+        if (child >= n)
+            break;
+        if (child + 1 < n && py_timer_before(heap + child + 1, heap + child))
+            child++;
+        if (!py_timer_before(heap + child, &entry))
+            break;
+        heap[i] = heap[child];
+        i = child;
     }
+    heap[i] = entry;
+}
 
-    x->p_sched_atoms = atomarray_new(argc, argv);
-    if (x->p_sched_atoms == NULL) {
-        py_error(x, "atom not scheduled");
-        goto error;
+/**
+ * @brief Remove entry i from the heap
+ *
+ * @param x pointer to object struct
+ * @param i index of the entry
+ * @param timer receives the removed entry, which owns its atoms
+ */
+static void py_timer_remove(t_py* x, long i, t_py_timer* timer)
+{
+    *timer = x->p_timers[i];
+    x->p_timers_count--;
+    if (i < x->p_timers_count) {
+        x->p_timers[i] = x->p_timers[x->p_timers_count];
+        py_timer_sift(x, i);
     }
-    clock_fdelay(x->p_clock, time);
-    ret = MAX_ERR_NONE;
-    goto finally;
-
-error:
-    py_error(x, "send failed");
-    ret = MAX_ERR_GENERIC;
-
-finally:
-    return ret;
 }
 
-/** 
- * @brief Wraps a scheduled python function call.
- * 
+/**
+ * @brief Insert a call into the heap
+ *
  * @param x pointer to object struct
+ * @param timer call to insert, whose atoms are then owned by the heap
  * @return t_max_err error code
  */
-t_max_err py_task(t_py* x)
+static t_max_err py_timer_push(t_py* x, t_py_timer* timer)
 {
-    double time;
-    long argc = 0;
-    t_atom* argv = NULL;
-
-    clock_getftime(&time);
-    // also scheduler_gettime(&time);
-    t_max_err err = atomarray_getatoms(x->p_sched_atoms, &argc, &argv);
-    if (err != MAX_ERR_NONE) {
-        py_error(x, "atomarray arg initialization failed");
-        return MAX_ERR_GENERIC;
+    if (x->p_timers_count == x->p_timers_size) {
+        long size = x->p_timers_size ? x->p_timers_size * 2 : 16;
+        t_py_timer* timers = (t_py_timer*)sysmem_resizeptr(
+            x->p_timers, size * sizeof(t_py_timer));
+        if (timers == NULL)
+            return MAX_ERR_OUT_OF_MEM;
+        x->p_timers = timers;
+        x->p_timers_size = size;
     }
-    py_log(x, "%lx instance is executing at time %.2f", x, time);
-    py_call(x, gensym(""), argc, argv);
-    py_bang_success(x);
+    timer->seq = x->p_timers_seq++;
+    x->p_timers[x->p_timers_count++] = *timer;
+    py_timer_sift(x, x->p_timers_count - 1);
     return MAX_ERR_NONE;
 }
 
-
-/*--------------------------------------------------------------------------*/
-/* Handlers */
-
 /**
- * @brief Generic python error handler
- * 
+ * @brief Give the atom buffer of a finished or cancelled call back to the pool
+ *
  * @param x pointer to object struct
- * @param fmt format string
- * @param ... other args
+ * @param timer call whose atoms are released
  */
-void py_handle_error(t_py* x, char* fmt, ...)
+static void py_timer_recycle(t_py* x, t_py_timer* timer)
 {
-    if (PyErr_Occurred()) {
-
-        // build custom msg
-        char msg[PY_MAX_ERR_CHAR];
-
-        va_list va;
-        va_start(va, fmt);
-        vsprintf(msg, fmt, va);
-        va_end(va);
-
-        // get error info
-        PyObject *ptype, *pvalue, *ptraceback;
-        PyErr_Fetch(&ptype, &pvalue, &ptraceback);
-        PyErr_NormalizeException(&ptype, &pvalue, &ptraceback);
-        Py_XDECREF(ptype);
-
-        PyObject* pvalue_pstr = PyObject_Repr(pvalue);
-        const char* pvalue_str = PyUnicode_AsUTF8(pvalue_pstr);
-        Py_XDECREF(pvalue);
-        Py_XDECREF(pvalue_pstr);
-
-        Py_XDECREF(ptraceback);
-
-        error("[py %s] %s: %s", x->p_name->s_name, msg, pvalue_str);
+    if (timer->argv == NULL)
+        return;
+    if (x->p_timers_pool_count < PY_TIMER_POOL_SIZE) {
+        x->p_timers_pool[x->p_timers_pool_count++] = *timer;
+    } else {
+        sysmem_freeptr(timer->argv);
     }
+    timer->argv = NULL;
+    timer->argv_size = 0;
 }
 
 /**
- * @brief Handler to output python float as max float
- * 
+ * @brief Arm the object clock for the earliest scheduled call
+ *
  * @param x pointer to object struct
- * @param pfloat python float
- * @return t_max_err error code
+ *
+ * Must be called with `p_timers_mutex` held.
  */
-t_max_err py_handle_float_output(t_py* x, PyObject* pfloat)
+static void py_timer_reset(t_py* x)
 {
-    if (pfloat == NULL) {
-        goto error;
+    double now = 0.0;
+
+    if (x->p_timers_count == 0) {
+        clock_unset(x->p_clock);
+        return;
     }
+    clock_getftime(&now);
+    clock_fdelay(x->p_clock, x->p_timers[0].when - now);
+}
 
-    if (PyFloat_Check(pfloat)) {
-        float float_result = (float)PyFloat_AsDouble(pfloat);
-        if (float_result == -1.0 && PyErr_Occurred()) {
+/**
+ * @brief Add a python function call to the timer queue
+ *
+ * @param x pointer to object struct
+ * @param delay time from now in ms
+ * @param interval repeat interval in ms or 0 to call once
+ * @param argc atom argument count: callable and its arguments
+ * @param argv atom argument vector (copied)
+ * @return long id of the scheduled call or 0 on error
+ *
+ * Atom buffers of finished calls are reused, so scheduling does not
+ * allocate in the steady state.
+ */
+static long py_timer_add(t_py* x, double delay, double interval, long argc,
+                         t_atom* argv)
+{
+    t_py_timer timer = { 0 };
+    double now = 0.0;
+
+    systhread_mutex_lock(x->p_timers_mutex);
+    if (x->p_timers_pool_count > 0)
+        timer = x->p_timers_pool[--x->p_timers_pool_count];
+
+    if (argc > timer.argv_size) {
+        long size = argc > PY_TIMER_ATOMS ? argc : PY_TIMER_ATOMS;
+        t_atom* atoms = (t_atom*)sysmem_resizeptr(timer.argv,
+                                                  size * sizeof(t_atom));
+        if (atoms == NULL) {
+            py_timer_recycle(x, &timer);
             goto error;
         }
+        timer.argv = atoms;
+        timer.argv_size = size;
+    }
+    sysmem_copyptr(argv, timer.argv, argc * sizeof(t_atom));
+    timer.argc = argc;
 
-        outlet_float(x->p_outlet_left, float_result);
-        py_bang_success(x);
+    clock_getftime(&now);
+    timer.when = now + delay;
+    timer.interval = interval;
+    timer.id = ++x->p_timers_id;
+
+    if (py_timer_push(x, &timer) != MAX_ERR_NONE) {
+        py_timer_recycle(x, &timer);
+        goto error;
     }
-    Py_XDECREF(pfloat);
-    return MAX_ERR_NONE;
+    if (x->p_timers[0].id == timer.id)
+        py_timer_reset(x);
+    systhread_mutex_unlock(x->p_timers_mutex);
+    return timer.id;
 
 error:
-    py_handle_error(x, "py_handle_float_output failed");
-    Py_XDECREF(pfloat);
-    py_bang_failure(x);
-    return MAX_ERR_GENERIC;
+    systhread_mutex_unlock(x->p_timers_mutex);
+    return 0;
 }
 
 /**
- * @brief Handler to output python long as max int
+ * @brief Schedule a call of a python callable
  *
  * @param x pointer to object struct
- * @param plong python long
- * @return t_max_err error code
+ * @param delay time from now in ms
+ * @param interval repeat interval in ms or 0 to call once
+ * @param argc atom argument count: callable name and its arguments
+ * @param argv atom argument vector (copied)
+ * @return long id of the scheduled call for `unsched`, or 0 on error
+ *
+ * Used by the `sched` messages and by `api.sched`, which returns the id
+ * to its caller.
  */
-t_max_err py_handle_long_output(t_py* x, PyObject* plong)
+long py_sched_call(t_py* x, double delay, double interval, long argc,
+                   t_atom* argv)
 {
-    if (plong == NULL) {
-        goto error;
-    }
+    long timer_id = 0;
 
-    if (PyLong_Check(plong)) {
-        long long_result = PyLong_AsLong(plong);
-        if (long_result == -1 && PyErr_Occurred()) {
-            goto error;
-        }
-        
-        outlet_int(x->p_outlet_left, long_result);
-        py_bang_success(x);
+    if (argc < 1 || atom_gettype(argv) != A_SYM) {
+        py_error(x, "a scheduled call needs the name of the callable");
+        return 0;
     }
 
-    Py_XDECREF(plong);
-    return MAX_ERR_NONE;
+    if (delay < 0.0 || interval < 0.0) {
+        py_error(x, "a scheduled call needs a time of zero or more ms");
+        return 0;
+    }
 
-error:
-    py_handle_error(x, "py_handle_long_output failed");
-    Py_XDECREF(plong);
-    py_bang_failure(x);
-    return MAX_ERR_GENERIC;
+    timer_id = py_timer_add(x, delay, interval, argc, argv);
+    if (timer_id == 0)
+        py_error(x, "atom not scheduled");
+    return timer_id;
 }
 
 /**
- * @brief Handler to output python string as max symbol
+ * @brief Parse and queue a `sched` or `sched_every` message
  *
  * @param x pointer to object struct
- * @param pstring python string
+ * @param s message selector
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param every non-zero to repeat the call every <time> ms
  * @return t_max_err error code
  */
-t_max_err py_handle_string_output(t_py* x, PyObject* pstring)
+static t_max_err py_sched_add(t_py* x, t_symbol* s, long argc, t_atom* argv,
+                              int every)
 {
-    if (pstring == NULL) {
+    double time = 0.0;
+    long timer_id = 0;
+
+    if (argc < 2) {
+        py_error(x, "need at least 2 args to schedule function calls");
         goto error;
     }
 
-    if (PyUnicode_Check(pstring)) {
-        const char* unicode_result = PyUnicode_AsUTF8(pstring);
-        if (unicode_result == NULL) {
-            goto error;
-        }
-        outlet_anything(x->p_outlet_left, gensym(unicode_result), 0, NIL);
-        py_bang_success(x);
+    if (atom_gettype(argv) != A_FLOAT && atom_gettype(argv) != A_LONG) {
+        py_error(x, "1st arg of %s needs to be a time in ms", s->s_name);
+        goto error;
     }
 
-    Py_XDECREF(pstring);
+    time = atom_getfloat(argv);
+    if (time < 0.0 || (every && time == 0.0)) {
+        py_error(x, "%s time must be %s", s->s_name,
+                 every ? "positive" : "zero or positive");
+        goto error;
+    }
+
+    timer_id = py_sched_call(x, time, every ? time : 0.0, argc - 1, argv + 1);
+    if (timer_id == 0)
+        goto error;
+
+    py_sched_last_obj = x;
+    py_sched_last_id = timer_id;
     return MAX_ERR_NONE;
 
 error:
-    py_handle_error(x, "py_handle_string_output failed");
-    Py_XDECREF(pstring);
-    py_bang_failure(x);
+    py_error(x, "%s failed", s->s_name);
     return MAX_ERR_GENERIC;
 }
 
 /**
- * @brief Handler to output python list as max list
- *
+ * @brief Schedule a python function call
+ * 
  * @param x pointer to object struct
- * @param plist python list
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
  * @return t_max_err error code
+ *
+ * `sched <time> <callable> [args]` calls the callable after `time` ms.
+ * Any number of calls can be pending: they are kept in a per-object
+ * min-heap driven by a single clock. `sched_id` outputs the id of the
+ * call, which can be passed to `unsched`.
  */
-t_max_err py_handle_list_output(t_py* x, PyObject* plist)
+t_max_err py_sched(t_py* x, t_symbol* s, long argc, t_atom* argv)
 {
-    if (plist == NULL) {
-        goto error;
+    py_record(x, s, argc, argv);
+    return py_sched_add(x, gensym("sched"), argc, argv, 0);
+}
+
+/**
+ * @brief Schedule a repeating python function call
+ *
+ * @param x pointer to object struct
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ *
+ * `sched_every <interval> <callable> [args]` calls the callable every
+ * `interval` ms, starting `interval` ms from now, until `unsched <id>`.
+ * Repeats are scheduled from the logical time of the previous call, so
+ * they do not drift.
+ */
+t_max_err py_sched_every(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    py_record(x, s, argc, argv);
+    return py_sched_add(x, gensym("sched_every"), argc, argv, 1);
+}
+
+/**
+ * @brief Output the id of the call last scheduled by a message
+ *
+ * @param x pointer to object struct
+ *
+ * Outputs `sched_id <id>` of the last `sched` or `sched_every` message this
+ * object received on the calling thread (0 if none), so a patch can
+ * remember a call for `unsched`, e.g. `[t b l]` into `sched` then
+ * `sched_id`. Messages sent to the object from other threads in between,
+ * such as the scheduler thread, do not change it. The ids are not output by
+ * `sched` itself, which would add a message to the output of existing
+ * patches. From python, `api.sched` returns the id instead.
+ */
+void py_sched_id(t_py* x)
+{
+    t_atom id;
+
+    atom_setlong(&id, py_sched_last_obj == x ? py_sched_last_id : 0);
+    outlet_anything(x->p_outlet_left, gensym("sched_id"), 1, &id);
+}
+
+/**
+ * @brief Cancel scheduled python function calls
+ *
+ * @param x pointer to object struct
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ *
+ * `unsched <id> [id ...]` cancels the given calls and `unsched` without
+ * arguments cancels all of them. A repeating call can cancel itself.
+ */
+t_max_err py_unsched(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    py_record(x, s, argc, argv);
+    return py_unsched_call(x, argc, argv);
+}
+
+/**
+ * @brief Cancel scheduled calls by id
+ *
+ * @param x pointer to object struct
+ * @param argc number of ids, or 0 to cancel all calls
+ * @param argv ids returned by `py_sched_call`
+ * @return t_max_err error code
+ *
+ * Used by the `unsched` message and by `api.unsched`.
+ */
+t_max_err py_unsched_call(t_py* x, long argc, t_atom* argv)
+{
+    t_py_timer timer;
+    t_max_err ret = MAX_ERR_NONE;
+
+    systhread_mutex_lock(x->p_timers_mutex);
+    if (argc == 0) {
+        while (x->p_timers_count > 0) {
+            py_timer_remove(x, x->p_timers_count - 1, &timer);
+            py_timer_recycle(x, &timer);
+        }
+        x->p_timers_firing = 0;
+        clock_unset(x->p_clock);
+        systhread_mutex_unlock(x->p_timers_mutex);
+        return MAX_ERR_NONE;
     }
 
-    if (PySequence_Check(plist) && !PyUnicode_Check(plist)
-        && !PyBytes_Check(plist) && !PyByteArray_Check(plist)) {
-        PyObject* iter = NULL;
-        PyObject* item = NULL;
-        int i = 0;
+    for (long i = 0; i < argc; i++) {
+        long id = atom_getlong(argv + i);
+        long j = 0;
 
-        t_atom atoms_static[PY_MAX_ATOMS];
-        t_atom* atoms = NULL;
-        int is_dynamic = 0;
+        if (id > 0 && id == x->p_timers_firing) {
+            x->p_timers_firing = 0;
+            continue;
+        }
+        for (j = 0; j < x->p_timers_count; j++) {
+            if (x->p_timers[j].id == id)
+                break;
+        }
+        if (j == x->p_timers_count) {
+            py_error(x, "unsched: no scheduled call with id %ld", id);
+            ret = MAX_ERR_GENERIC;
+            continue;
+        }
+        py_timer_remove(x, j, &timer);
+        py_timer_recycle(x, &timer);
+    }
+    py_timer_reset(x);
+    systhread_mutex_unlock(x->p_timers_mutex);
+    return ret;
+}
 
-        Py_ssize_t seq_size = PySequence_Length(plist);
-        py_log(x, "seq_size: %d", seq_size);
+/** 
+ * @brief Wraps a scheduled python function call.
+ * 
+ * @param x pointer to object struct
+ * @return t_max_err error code
+ *
+ * Clock callback: makes all calls which are due, reschedules repeating
+ * ones and re-arms the clock for the next call.
+ */
+t_max_err py_task(t_py* x)
+{
+    t_py_timer timer;
+    t_py_stats_span span;
+    t_py* inner = NULL;
+    double time;
+    int repeat = 0;
 
-        if (seq_size == 0) {
-            py_error(x, "cannot convert py list of length 0 to atoms");
-            goto error;
+    clock_getftime(&time);
+    // also scheduler_gettime(&time);
+
+    // scheduled calls are replayed from their `sched` messages
+    inner = py_record_mute(x);
+
+    systhread_mutex_lock(x->p_timers_mutex);
+    // tolerate rounding between the requested and the actual clock time
+    while (x->p_timers_count > 0 && x->p_timers[0].when <= time + 1e-6) {
+        // the call owns its atoms while it runs, as python may (un)schedule
+        py_timer_remove(x, 0, &timer);
+        x->p_timers_firing = timer.interval > 0.0 ? timer.id : 0;
+        systhread_mutex_unlock(x->p_timers_mutex);
+
+        py_trace(x, PY_TRACE_SCHED, timer.id, timer.interval > 0.0, time);
+        span = py_stats_begin(timer.argc);
+        py_stats_end(x, PY_STATS_SCHED, &span,
+                     py_call(x, gensym("sched"), timer.argc, timer.argv));
+        py_bang_success(x);
+
+        systhread_mutex_lock(x->p_timers_mutex);
+        repeat = x->p_timers_firing != 0 && x->p_timers_firing == timer.id;
+        x->p_timers_firing = 0;
+        if (repeat) {
+            // catch up by skipping repeats rather than bursting
+            timer.when += timer.interval;
+            if (timer.when <= time)
+                timer.when = time + timer.interval;
+            repeat = py_timer_push(x, &timer) == MAX_ERR_NONE;
         }
+        if (!repeat)
+            py_timer_recycle(x, &timer);
+    }
+    py_timer_reset(x);
+    systhread_mutex_unlock(x->p_timers_mutex);
+    py_record_mute(inner);
+    return MAX_ERR_NONE;
+}
 
-        if (seq_size > PY_MAX_ATOMS) {
-            py_log(x, "dynamically increasing size of atom array");
-            atoms = atom_dynamic_start(atoms_static, PY_MAX_ATOMS,
-                                       seq_size + 1);
-            is_dynamic = 1;
+/*--------------------------------------------------------------------------*/
+/* Asyncio */
+
+/* per-object event loop, stepped by `py_async_tick`. Only public asyncio
+   and selectors API is used: the loop counts the callbacks and keeps the
+   timers added through `call_soon` and `call_at` to find the next delay,
+   and wakes the clock from `call_soon_threadsafe`. */
+static const char* py_async_source =
+    "import asyncio\n"
+    "import heapq\n"
+    "import selectors\n"
+    "\n"
+    "class _NoWaitSelector(selectors.DefaultSelector):\n"
+    "    def select(self, timeout=None):\n"
+    "        return super().select(0)\n"
+    "\n"
+    "class MaxEventLoop(asyncio.SelectorEventLoop):\n"
+    "    \"\"\"asyncio loop stepped by a max clock in max scheduler time\"\"\"\n"
+    "\n"
+    "    def __init__(self):\n"
+    "        self.selector = _NoWaitSelector()\n"
+    "        self.soon = 0    # callbacks added by call_soon\n"
+    "        self.seq = 0     # timers added by call_at\n"
+    "        self.timers = [] # heap of (when, seq, handle)\n"
+    "        super().__init__(self.selector)\n"
+    "        self.set_exception_handler(self.report)\n"
+    "\n"
+    "    def report(self, loop, context):\n"
+    "        exc = context.get('exception')\n"
+    "        _max_error(context['message'] + (f': {exc!r}' if exc else ''))\n"
+    "\n"
+    "    def call_soon(self, callback, *args, context=None):\n"
+    "        self.soon += 1\n"
+    "        return super().call_soon(callback, *args, context=context)\n"
+    "\n"
+    "    def call_soon_threadsafe(self, callback, *args, context=None):\n"
+    "        handle = super().call_soon_threadsafe(callback, *args,\n"
+    "                                              context=context)\n"
+    "        _max_wake()\n"
+    "        return handle\n"
+    "\n"
+    "    def call_at(self, when, callback, *args, context=None):\n"
+    "        handle = super().call_at(when, callback, *args, context=context)\n"
+    "        self.seq += 1\n"
+    "        heapq.heappush(self.timers, (when, self.seq, handle))\n"
+    "        return handle\n"
+    "\n"
+    "    def time(self):\n"
+    "        return _max_time()\n"
+    "\n"
+    "    def spawn(self, aw):\n"
+    "        return asyncio.ensure_future(aw, loop=self)\n"
+    "\n"
+    "    def step(self):\n"
+    "        # stop before run_forever runs a single iteration of the loop\n"
+    "        self.call_soon(self.stop)\n"
+    "        soon, seq, now = self.soon, self.seq, self.time()\n"
+    "        self.run_forever()\n"
+    "        if self.soon != soon:\n"
+    "            return 0.0 # callbacks added while running wait for a step\n"
+    "        # timers due when the step started have run\n"
+    "        timers = self.timers\n"
+    "        while timers and (timers[0][2].cancelled()\n"
+    "                          or (timers[0][0] <= now and timers[0][1] <= seq)):\n"
+    "            heapq.heappop(timers)\n"
+    "        delay = -1.0\n"
+    "        if timers:\n"
+    "            delay = max(0.0, (timers[0][0] - self.time()) * 1e3)\n"
+    "        if len(self.selector.get_map()) > 1:\n"
+    "            # file descriptors other than the self-pipe: poll them\n"
+    "            delay = POLL if delay < 0 else min(delay, POLL)\n"
+    "        return delay\n";
+
+/**
+ * @brief `_max_time()`: current max scheduler time in seconds
+ */
+static PyObject* py_async_time(PyObject* self, PyObject* args)
+{
+    double time = 0.0;
+    clock_getftime(&time);
+    return PyFloat_FromDouble(time / 1000.0);
+}
+
+/**
+ * @brief `_max_error(msg)`: post an error from the loop of an object
+ */
+static PyObject* py_async_error(PyObject* self, PyObject* arg)
+{
+    t_py* x = (t_py*)PyCapsule_GetPointer(self, NULL);
+    const char* msg = PyUnicode_AsUTF8(arg);
+    if (x == NULL || msg == NULL)
+        return NULL;
+    py_error(x, "async: %s", msg);
+    Py_RETURN_NONE;
+}
+
+/**
+ * @brief `_max_wake()`: step the loop of an object as soon as possible
+ *
+ * Called by `call_soon_threadsafe`, e.g. when a callback is added from
+ * another thread.
+ */
+static PyObject* py_async_wake(PyObject* self, PyObject* args)
+{
+    t_py* x = (t_py*)PyCapsule_GetPointer(self, NULL);
+    if (x == NULL)
+        return NULL;
+    clock_fdelay(x->p_async_clock, 0);
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef py_async_methods[] = {
+    { "_max_time", (PyCFunction)py_async_time, METH_NOARGS, NULL },
+    { "_max_error", (PyCFunction)py_async_error, METH_O, NULL },
+    { "_max_wake", (PyCFunction)py_async_wake, METH_NOARGS, NULL },
+    { NULL, NULL, 0, NULL },
+};
+
+/**
+ * @brief Create the asyncio loop of an object
+ *
+ * @param x pointer to object struct
+ * @return PyObject* new reference to the loop or NULL on error
+ *
+ * Must be called with the GIL held.
+ */
+static PyObject* py_async_loop_new(t_py* x)
+{
+    PyObject* ns = NULL;
+    PyObject* capsule = NULL;
+    PyObject* poll = NULL;
+    PyObject* res = NULL;
+    PyObject* loop = NULL;
+
+    ns = PyDict_New();
+    capsule = PyCapsule_New(x, NULL, NULL);
+    poll = PyFloat_FromDouble(PY_ASYNC_POLL);
+    if (ns == NULL || capsule == NULL || poll == NULL)
+        goto finally;
+
+    if (PyDict_SetItemString(ns, "__builtins__", PyEval_GetBuiltins()) == -1
+        || PyDict_SetItemString(ns, "POLL", poll) == -1)
+        goto finally;
+
+    for (PyMethodDef* def = py_async_methods; def->ml_name; def++) {
+        PyObject* func = PyCFunction_New(def, capsule);
+        if (func == NULL || PyDict_SetItemString(ns, def->ml_name, func) == -1) {
+            Py_XDECREF(func);
+            goto finally;
+        }
+        Py_DECREF(func);
+    }
+
+    res = PyRun_String(py_async_source, Py_file_input, ns, ns);
+    if (res == NULL)
+        goto finally;
+
+    loop = PyObject_CallNoArgs(PyDict_GetItemString(ns, "MaxEventLoop"));
+
+finally:
+    Py_XDECREF(res);
+    Py_XDECREF(poll);
+    Py_XDECREF(capsule);
+    Py_XDECREF(ns);
+    return loop;
+}
+
+/**
+ * @brief Output the results of finished `async` tasks
+ *
+ * @param x pointer to object struct
+ *
+ * Must be called with the GIL held.
+ */
+static void py_async_collect(t_py* x)
+{
+    Py_ssize_t i = 0;
+
+    while (i < PyList_GET_SIZE(x->p_async_tasks)) {
+        PyObject* task = PyList_GET_ITEM(x->p_async_tasks, i);
+        PyObject* done = PyObject_CallMethod(task, "done", NULL);
+        PyObject* pval = NULL;
+        int is_done = done != NULL && PyObject_IsTrue(done) == 1;
+
+        Py_XDECREF(done);
+        if (!is_done) {
+            PyErr_Clear();
+            i++;
+            continue;
+        }
 
+        Py_INCREF(task);
+        PyList_SetSlice(x->p_async_tasks, i, i + 1, NULL);
+        pval = PyObject_CallMethod(task, "result", NULL);
+        Py_DECREF(task);
+        if (pval != NULL) {
+            py_handle_output(x, pval); // steals pval
         } else {
-            atoms = atoms_static;
+            py_handle_error(x, "async");
+            py_bang_failure(x);
         }
+    }
+}
 
-        if ((iter = PyObject_GetIter(plist)) == NULL) {
-            goto error;
+/**
+ * @brief Clock callback which steps the asyncio loop of an object
+ *
+ * @param x pointer to object struct
+ *
+ * Runs due timers and ready callbacks, outputs the results of finished
+ * tasks, then re-arms the clock for the next timer. While callbacks are
+ * ready the loop is stepped up to PY_ASYNC_STEPS times before yielding to
+ * the scheduler. An idle loop leaves the clock unset.
+ */
+void py_async_tick(t_py* x)
+{
+    t_py_stats_span span;
+    t_py_gil gstate;
+    PyObject* delay = NULL;
+    double ms = -1.0;
+
+    if (x->p_async_loop == NULL)
+        return;
+
+    span = py_stats_begin(0);
+    gstate = py_gil_ensure(x);
+    span.wait = gstate.wait;
+    for (int i = 0; i < PY_ASYNC_STEPS; i++) {
+        delay = PyObject_CallMethod(x->p_async_loop, "step", NULL);
+        if (delay == NULL) {
+            py_handle_error(x, "async loop");
+            ms = -1.0;
+            break;
         }
-        py_log(x, "seq_size2: %d", seq_size);
+        ms = PyFloat_AsDouble(delay);
+        Py_DECREF(delay);
+        py_async_collect(x);
+        if (ms != 0.0)
+            break;
+    }
+    py_gil_release(x, gstate);
+    py_stats_end(x, PY_STATS_ASYNC_STEP, &span,
+                 delay ? MAX_ERR_NONE : MAX_ERR_GENERIC);
+
+    if (ms >= 0.0)
+        clock_fdelay(x->p_async_clock, ms);
+}
+
+/**
+ * @brief Run a coroutine on the object's asyncio loop
+ *
+ * @param x pointer to object struct
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ *
+ * `async <coro-expr>` evaluates an expression returning an awaitable, such
+ * as a call of an `async def` function, and runs it as a task on an
+ * asyncio loop which is stepped by a max clock and whose time is the max
+ * scheduler time, so `await asyncio.sleep(0.5)` resumes 500 ms later in
+ * logical time. Tasks run concurrently on the scheduler thread and their
+ * results are output as if by `eval` when they complete.
+ */
+t_max_err py_async(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_py_stats_span span = py_stats_begin(argc);
+    t_py_gil gstate;
+    long textsize = 0;
+    char* text = NULL;
+    PyObject* co = NULL;
+    PyObject* coro = NULL;
+    PyObject* task = NULL;
+
+    py_record(x, s, argc, argv);
+
+    if (argc < 1) {
+        py_error(x, "async needs a coroutine expression");
+        return py_stats_end(x, PY_STATS_ASYNC, &span, MAX_ERR_GENERIC);
+    }
+
+    if (atom_gettext(argc, argv, &textsize, &text,
+                     OBEX_UTIL_ATOM_GETTEXT_DEFAULT) != MAX_ERR_NONE
+        || text == NULL) {
+        py_error(x, "async: could not convert atoms to text");
+        return py_stats_end(x, PY_STATS_ASYNC, &span, MAX_ERR_GENERIC);
+    }
+
+    py_job_flush(x);
+    gstate = py_gil_ensure(x);
+    span.wait = gstate.wait;
+
+    if (x->p_async_loop == NULL) {
+        x->p_async_tasks = PyList_New(0);
+        if (x->p_async_tasks == NULL)
+            goto error;
+        x->p_async_loop = py_async_loop_new(x);
+        if (x->p_async_loop == NULL)
+            goto error;
+    }
+
+    co = py_code_cache_compile(x, text, Py_eval_input);
+    if (co == NULL)
+        goto error;
+
+    coro = PyEval_EvalCode(co, x->p_globals, x->p_globals);
+    if (coro == NULL)
+        goto error;
+
+    task = PyObject_CallMethod(x->p_async_loop, "spawn", "O", coro);
+    if (task == NULL || PyList_Append(x->p_async_tasks, task) == -1)
+        goto error;
+
+    py_trace(x, PY_TRACE_ASYNC, PyList_GET_SIZE(x->p_async_tasks), 0, 0.0);
+    Py_DECREF(task);
+    Py_DECREF(coro);
+    Py_DECREF(co);
+    py_gil_release(x, gstate);
+    sysmem_freeptr(text);
+    clock_fdelay(x->p_async_clock, 0);
+    return py_stats_end(x, PY_STATS_ASYNC, &span, MAX_ERR_NONE);
+
+error:
+    py_handle_error(x, "async %s", text);
+    Py_XDECREF(task);
+    Py_XDECREF(coro);
+    Py_XDECREF(co);
+    py_gil_release(x, gstate);
+    sysmem_freeptr(text);
+    py_bang_failure(x);
+    return py_stats_end(x, PY_STATS_ASYNC, &span, MAX_ERR_GENERIC);
+}
+
+/**
+ * @brief Cancel the `async` tasks of an object and close its loop
+ *
+ * @param x pointer to object struct
+ *
+ * The loop is stepped once so that cancelled tasks can clean up. Called
+ * from `py_free` with the GIL held.
+ */
+void py_async_close(t_py* x)
+{
+    PyObject* res = NULL;
+
+    if (x->p_async_loop == NULL)
+        return;
+
+    for (Py_ssize_t i = 0; i < PyList_GET_SIZE(x->p_async_tasks); i++) {
+        res = PyObject_CallMethod(PyList_GET_ITEM(x->p_async_tasks, i),
+                                  "cancel", NULL);
+        Py_XDECREF(res);
+    }
+    res = PyObject_CallMethod(x->p_async_loop, "step", NULL);
+    Py_XDECREF(res);
+    res = PyObject_CallMethod(x->p_async_loop, "close", NULL);
+    Py_XDECREF(res);
+    PyErr_Clear();
+    Py_CLEAR(x->p_async_loop);
+    Py_CLEAR(x->p_async_tasks);
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Handlers */
+
+/**
+ * @brief Generic python error handler
+ * 
+ * @param x pointer to object struct
+ * @param fmt format string
+ * @param ... other args
+ */
+void py_handle_error(t_py* x, char* fmt, ...)
+{
+    if (PyErr_Occurred()) {
+
+        // build custom msg
+        char msg[PY_MAX_ERR_CHAR];
+
+        va_list va;
+        va_start(va, fmt);
+        vsnprintf(msg, PY_MAX_ERR_CHAR, fmt, va);
+        va_end(va);
+
+        // get error info
+        PyObject *ptype, *pvalue, *ptraceback;
+        PyErr_Fetch(&ptype, &pvalue, &ptraceback);
+        PyErr_NormalizeException(&ptype, &pvalue, &ptraceback);
+        Py_XDECREF(ptype);
+
+        PyObject* pvalue_pstr = PyObject_Repr(pvalue);
+        const char* pvalue_str = PyUnicode_AsUTF8(pvalue_pstr);
+
+        error("[py %s] %s: %s", x->p_name->s_name, msg, pvalue_str);
+
+        // pvalue_str is owned by pvalue_pstr
+        Py_XDECREF(pvalue);
+        Py_XDECREF(pvalue_pstr);
+        Py_XDECREF(ptraceback);
+    }
+}
+
+/**
+ * @brief Handler to output python float as max float
+ * 
+ * @param x pointer to object struct
+ * @param pfloat python float
+ * @return t_max_err error code
+ */
+t_max_err py_handle_float_output(t_py* x, PyObject* pfloat)
+{
+    if (pfloat == NULL) {
+        goto error;
+    }
+
+    if (PyFloat_Check(pfloat)) {
+        float float_result = (float)PyFloat_AsDouble(pfloat);
+        if (float_result == -1.0 && PyErr_Occurred()) {
+            goto error;
+        }
+
+        outlet_float(x->p_outlet_left, float_result);
+        py_bang_success(x);
+    }
+    Py_XDECREF(pfloat);
+    return MAX_ERR_NONE;
+
+error:
+    py_handle_error(x, "py_handle_float_output failed");
+    Py_XDECREF(pfloat);
+    py_bang_failure(x);
+    return MAX_ERR_GENERIC;
+}
+
+/**
+ * @brief Handler to output python long as max int
+ *
+ * @param x pointer to object struct
+ * @param plong python long
+ * @return t_max_err error code
+ */
+t_max_err py_handle_long_output(t_py* x, PyObject* plong)
+{
+    if (plong == NULL) {
+        goto error;
+    }
+
+    if (PyLong_Check(plong)) {
+        long long_result = PyLong_AsLong(plong);
+        if (long_result == -1 && PyErr_Occurred()) {
+            goto error;
+        }
+        
+        outlet_int(x->p_outlet_left, long_result);
+        py_bang_success(x);
+    }
+
+    Py_XDECREF(plong);
+    return MAX_ERR_NONE;
+
+error:
+    py_handle_error(x, "py_handle_long_output failed");
+    Py_XDECREF(plong);
+    py_bang_failure(x);
+    return MAX_ERR_GENERIC;
+}
+
+/**
+ * @brief Slot of a symbol in the set of output symbols
+ *
+ * @param x pointer to object struct
+ * @param s symbol
+ * @return long first slot to probe
+ */
+static long py_gensym_hash(t_py* x, t_symbol* s)
+{
+    return (long)(((uint64_t)(uintptr_t)s * 0x9E3779B97F4A7C15ULL) >> 32
+                  & (x->p_gensyms_size - 1));
+}
+
+/**
+ * @brief Double the set of output symbols
+ *
+ * @param x pointer to object struct
+ * @return t_max_err error code
+ */
+static t_max_err py_gensym_grow(t_py* x)
+{
+    t_symbol** old = x->p_gensyms;
+    long old_size = x->p_gensyms_size;
+    long size = old_size ? old_size * 2 : 64;
+    t_symbol** set = (t_symbol**)sysmem_newptrclear(size * sizeof(t_symbol*));
+
+    if (set == NULL)
+        return MAX_ERR_OUT_OF_MEM;
+
+    x->p_gensyms = set;
+    x->p_gensyms_size = size;
+    for (long i = 0; i < old_size; i++) {
+        if (old[i] != NULL) {
+            long j = py_gensym_hash(x, old[i]);
+            while (set[j] != NULL)
+                j = (j + 1) & (size - 1);
+            set[j] = old[i];
+        }
+    }
+    if (old)
+        sysmem_freeptr(old);
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Intern an output string as a max symbol
+ *
+ * @param x pointer to object struct
+ * @param str utf-8 string
+ * @return t_symbol* symbol
+ *
+ * Max symbols are never freed, so the read-only `gensyms` attribute counts
+ * the distinct symbols an object has made from its output. It keeps rising
+ * only for objects which output unbounded numbers of distinct strings.
+ * Output runs with the GIL of the object's interpreter held, which also
+ * guards the set.
+ */
+t_symbol* py_gensym(t_py* x, const char* str)
+{
+    t_symbol* s = gensym(str);
+    long i = 0;
+
+    if (x->p_gensym_count * 2 >= x->p_gensyms_size
+        && py_gensym_grow(x) != MAX_ERR_NONE)
+        return s;
+
+    for (i = py_gensym_hash(x, s); x->p_gensyms[i] != NULL;
+         i = (i + 1) & (x->p_gensyms_size - 1)) {
+        if (x->p_gensyms[i] == s)
+            return s;
+    }
+    x->p_gensyms[i] = s;
+    x->p_gensym_count++;
+    return s;
+}
+
+/**
+ * @brief Handler to output python string as max symbol
+ *
+ * @param x pointer to object struct
+ * @param pstring python string
+ * @return t_max_err error code
+ *
+ * With `@strings bytes` the string is output as a list of its utf-8
+ * bytes, so that generated strings do not grow the max symbol table.
+ */
+t_max_err py_handle_string_output(t_py* x, PyObject* pstring)
+{
+    if (pstring == NULL) {
+        goto error;
+    }
+
+    if (PyUnicode_Check(pstring)) {
+        Py_ssize_t size = 0;
+        const char* unicode_result = PyUnicode_AsUTF8AndSize(pstring, &size);
+        if (unicode_result == NULL) {
+            goto error;
+        }
+
+        if (size > 0 && x->p_strings == gensym("bytes")) {
+            t_atom* atoms = py_atom_buffer(x, size);
+            if (atoms == NULL) {
+                PyErr_NoMemory();
+                goto error;
+            }
+            for (Py_ssize_t i = 0; i < size; i++) {
+                atom_setlong(atoms + i, (unsigned char)unicode_result[i]);
+            }
+            py_atom_buffer_output(x, size);
+
+        } else {
+            outlet_anything(x->p_outlet_left,
+                            py_gensym(x, unicode_result), 0, NIL);
+        }
+        py_bang_success(x);
+    }
+
+    Py_XDECREF(pstring);
+    return MAX_ERR_NONE;
+
+error:
+    py_handle_error(x, "py_handle_string_output failed");
+    Py_XDECREF(pstring);
+    py_bang_failure(x);
+    return MAX_ERR_GENERIC;
+}
+
+/**
+ * @brief Classify the element type of a buffer
+ *
+ * @param view buffer view with format information
+ *
+ * @return char 'i' for signed, 'u' for unsigned integers, 'f' for floats or
+ *         0 if the layout is not supported
+ *
+ * Only single native-endian items are supported, with the element size
+ * taken from `itemsize`.
+ */
+static char py_buffer_kind(const Py_buffer* view)
+{
+    const char* fmt = view->format ? view->format : "B";
+
+    switch (*fmt) {
+    case '@':
+    case '=':
+        fmt++;
+        break;
+#if PY_LITTLE_ENDIAN
+    case '<':
+#else
+    case '>':
+    case '!':
+#endif
+        fmt++;
+        break;
+    default:
+        break;
+    }
+
+    if (fmt[0] == '\0' || fmt[1] != '\0')
+        return 0;
+
+    switch (fmt[0]) {
+    case 'b': case 'h': case 'i': case 'l': case 'q': case 'n':
+        return (view->itemsize == 1 || view->itemsize == 2
+                || view->itemsize == 4 || view->itemsize == 8) ? 'i' : 0;
+    case 'B': case 'H': case 'I': case 'L': case 'Q': case 'N': case '?':
+        return (view->itemsize == 1 || view->itemsize == 2
+                || view->itemsize == 4 || view->itemsize == 8) ? 'u' : 0;
+    case 'f': case 'd':
+        return (view->itemsize == 4 || view->itemsize == 8) ? 'f' : 0;
+    default:
+        return 0;
+    }
+}
+
+#define PY_BUFFER_COPY(ctype, field, atype, dest, src, count)   \
+    do {                                                        \
+        const ctype* _src = (const ctype*)(src);                \
+        for (Py_ssize_t _i = 0; _i < (count); _i++) {           \
+            (dest)[_i].a_type = (atype);                        \
+            (dest)[_i].a_w.field = _src[_i];                    \
+        }                                                       \
+    } while (0)
+
+/**
+ * @brief Convert the elements of a contiguous numeric buffer to atoms
+ *
+ * @param kind element kind from `py_buffer_kind`
+ * @param itemsize element size in bytes
+ * @param buf contiguous elements
+ * @param count number of elements
+ * @param atoms atoms to set
+ *
+ * Unsigned 64-bit values above the max int range are set as floats rather
+ * than wrapping around to negative ints.
+ */
+static void py_buffer_copy(char kind, Py_ssize_t itemsize, const void* buf,
+                           Py_ssize_t count, t_atom* atoms)
+{
+    switch (kind) {
+    case 'i':
+        switch (itemsize) {
+        case 1: PY_BUFFER_COPY(int8_t, w_long, A_LONG, atoms, buf, count); break;
+        case 2: PY_BUFFER_COPY(int16_t, w_long, A_LONG, atoms, buf, count); break;
+        case 4: PY_BUFFER_COPY(int32_t, w_long, A_LONG, atoms, buf, count); break;
+        default: PY_BUFFER_COPY(int64_t, w_long, A_LONG, atoms, buf, count); break;
+        }
+        break;
+    case 'u':
+        switch (itemsize) {
+        case 1: PY_BUFFER_COPY(uint8_t, w_long, A_LONG, atoms, buf, count); break;
+        case 2: PY_BUFFER_COPY(uint16_t, w_long, A_LONG, atoms, buf, count); break;
+        case 4: PY_BUFFER_COPY(uint32_t, w_long, A_LONG, atoms, buf, count); break;
+        default: {
+            const uint64_t* src = (const uint64_t*)buf;
+            for (Py_ssize_t i = 0; i < count; i++) {
+                if (src[i] > (uint64_t)INT64_MAX)
+                    atom_setfloat(atoms + i, (double)src[i]);
+                else
+                    atom_setlong(atoms + i, (t_atom_long)src[i]);
+            }
+            break;
+        }
+        }
+        break;
+    default:
+        if (itemsize == 4)
+            PY_BUFFER_COPY(float, w_float, A_FLOAT, atoms, buf, count);
+        else
+            PY_BUFFER_COPY(double, w_float, A_FLOAT, atoms, buf, count);
+        break;
+    }
+}
+
+/**
+ * @brief Convert a numeric buffer to atoms in one pass
+ *
+ * @param x pointer to object struct
+ * @param pbuf python object supporting the buffer protocol
+ * @param n number of atoms written to the atom buffer
+ *
+ * @return int 1 if converted from an array, 2 if converted from a 0-d
+ *         buffer (a single scalar), 0 if the buffer is not a supported
+ *         numeric buffer (no error set), or -1 on error
+ *
+ * Used for `array.array`, `memoryview`, numpy arrays and numpy scalars to
+ * avoid creating a python object per element. Elements are converted by
+ * dtype and multi-dimensional arrays are flattened in C (row-major) order;
+ * non-contiguous views are first copied into a contiguous block.
+ */
+int py_buffer_to_atoms(t_py* x, PyObject* pbuf, long* n)
+{
+    Py_buffer view;
+    t_atom* atoms = NULL;
+    void* buf = NULL;
+    Py_ssize_t count = 0;
+    char kind = 0;
+    int res = 0;
+
+    if (PyObject_GetBuffer(pbuf, &view, PyBUF_RECORDS_RO) == -1) {
+        PyErr_Clear();
+        return 0;
+    }
+
+    kind = py_buffer_kind(&view);
+    count = view.itemsize ? view.len / view.itemsize : 0;
+    if (kind == 0 || count == 0) {
+        goto finally;
+    }
+
+    buf = view.buf;
+    if (!PyBuffer_IsContiguous(&view, 'C')) {
+        if ((buf = PyMem_Malloc(view.len)) == NULL) {
+            PyErr_NoMemory();
+            res = -1;
+            goto finally;
+        }
+        if (PyBuffer_ToContiguous(buf, &view, view.len, 'C') == -1) {
+            res = -1;
+            goto finally;
+        }
+    }
+
+    if ((atoms = py_atom_buffer(x, count)) == NULL) {
+        PyErr_NoMemory();
+        res = -1;
+        goto finally;
+    }
+
+    py_buffer_copy(kind, view.itemsize, buf, count, atoms);
+
+    *n = (long)count;
+    res = view.ndim == 0 ? 2 : 1;
+
+finally:
+    if (buf != NULL && buf != view.buf)
+        PyMem_Free(buf);
+    PyBuffer_Release(&view);
+    return res;
+}
+
+/**
+ * @brief Convert a python int to an atom
+ *
+ * @param plong python int
+ * @param atom atom to set
+ *
+ * @return int 1 if set, -1 on error
+ *
+ * Ints outside the range of a max int are set as floats rather than
+ * wrapping around or failing the whole list.
+ */
+static int py_long_to_atom(PyObject* plong, t_atom* atom)
+{
+    int overflow = 0;
+    long long long_item = PyLong_AsLongLongAndOverflow(plong, &overflow);
+
+    if (overflow) {
+        double float_item = PyLong_AsDouble(plong);
+        if (float_item == -1.0 && PyErr_Occurred())
+            return -1;
+        atom_setfloat(atom, float_item);
+        return 1;
+    }
+    if (long_item == -1 && PyErr_Occurred())
+        return -1;
+    atom_setlong(atom, (t_atom_long)long_item);
+    return 1;
+}
+
+/**
+ * @brief Convert a 0-d numeric buffer, such as a 0-d numpy array, to an atom
+ *
+ * @param item python object
+ * @param atom atom to set
+ *
+ * @return int 1 if set, 0 otherwise (no error set)
+ */
+static int py_buffer_scalar_to_atom(PyObject* item, t_atom* atom)
+{
+    Py_buffer view;
+    char kind = 0;
+
+    if (!PyObject_CheckBuffer(item) || PyBytes_Check(item)
+        || PyByteArray_Check(item))
+        return 0;
+
+    if (PyObject_GetBuffer(item, &view, PyBUF_RECORDS_RO) == -1) {
+        PyErr_Clear();
+        return 0;
+    }
+    if (view.ndim == 0 && (kind = py_buffer_kind(&view)) != 0)
+        py_buffer_copy(kind, view.itemsize, view.buf, 1, atom);
+    else
+        kind = 0;
+    PyBuffer_Release(&view);
+    return kind != 0;
+}
+
+/**
+ * @brief Convert a python number to an atom
+ *
+ * @param item python object
+ * @param atom atom to set
+ *
+ * @return int 1 if set, 0 if the object is not a number, -1 on error
+ *
+ * Besides int and float this accepts any object implementing the number
+ * protocol's `__index__` or `__float__` slots, such as numpy integer and
+ * floating point scalars, and 0-d numeric buffers such as 0-d numpy
+ * arrays. Complex numbers are not converted.
+ */
+int py_number_to_atom(PyObject* item, t_atom* atom)
+{
+    PyNumberMethods* nb = Py_TYPE(item)->tp_as_number;
+
+    if (PyFloat_Check(item)) {
+        atom_setfloat(atom, PyFloat_AS_DOUBLE(item));
+    } else if (PyLong_Check(item)) {
+        return py_long_to_atom(item, atom);
+    } else if (py_buffer_scalar_to_atom(item, atom)) {
+        return 1; // 0-d arrays are sequences but hold a single number
+    } else if (nb == NULL || PySequence_Check(item)) {
+        return 0; // arrays implement the number slots but are not scalars
+    } else if (nb->nb_index) {
+        PyObject* plong = PyNumber_Index(item);
+        int res = plong ? py_long_to_atom(plong, atom) : -1;
+        Py_XDECREF(plong);
+        return res;
+    } else if (nb->nb_float && !PyComplex_Check(item)) {
+        double float_item = PyFloat_AsDouble(item);
+        if (float_item == -1.0 && PyErr_Occurred())
+            return -1;
+        atom_setfloat(atom, float_item);
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Handler to output python list as max list
+ *
+ * @param x pointer to object struct
+ * @param plist python list
+ * @return t_max_err error code
+ */
+t_max_err py_handle_list_output(t_py* x, PyObject* plist)
+{
+    long n = 0;
+    int unsupported = 0; // a buffer of a format py_buffer_kind rejects
+
+    if (plist == NULL) {
+        goto error;
+    }
+
+    if (PyObject_CheckBuffer(plist) && !PyBytes_Check(plist)
+        && !PyByteArray_Check(plist)) {
+        int converted = py_buffer_to_atoms(x, plist, &n);
+        if (converted < 0) {
+            goto error;
+        }
+        unsupported = converted == 0;
+        if (converted == 2) {
+            py_stats_atoms(x, PY_STATS_OUTPUT, 1);
+            if (atom_gettype(x->p_atoms) == A_FLOAT)
+                outlet_float(x->p_outlet_left, atom_getfloat(x->p_atoms));
+            else
+                outlet_int(x->p_outlet_left, atom_getlong(x->p_atoms));
+            py_bang_success(x);
+            Py_XDECREF(plist);
+            return MAX_ERR_NONE;
+        }
+        if (converted) {
+            py_trace(x, PY_TRACE_OUTPUT, n, 1, 0.0);
+            py_stats_atoms(x, PY_STATS_OUTPUT, n);
+            py_atom_buffer_output(x, n);
+            py_bang_success(x);
+            Py_XDECREF(plist);
+            return MAX_ERR_NONE;
+        }
+    }
+
+    if (PySequence_Check(plist) && !PyUnicode_Check(plist)
+        && !PyBytes_Check(plist) && !PyByteArray_Check(plist)) {
+        PyObject* iter = NULL;
+        PyObject* item = NULL;
+        int i = 0;
+
+        t_atom atoms_static[PY_MAX_ATOMS];
+        t_atom* atoms = NULL;
+        int is_dynamic = 0;
+
+        Py_ssize_t seq_size = PySequence_Length(plist);
+
+        if (seq_size == 0) {
+            py_error(x, "cannot convert py list of length 0 to atoms");
+            goto error;
+        }
+
+        if (seq_size > PY_MAX_ATOMS) {
+            atoms = atom_dynamic_start(atoms_static, PY_MAX_ATOMS,
+                                       seq_size + 1);
+            is_dynamic = 1;
+
+        } else {
+            atoms = atoms_static;
+        }
+
+        if ((iter = PyObject_GetIter(plist)) == NULL) {
+            goto error;
+        }
+
+        while (i < seq_size && (item = PyIter_Next(iter)) != NULL) {
+            if (PyUnicode_Check(item)) {
+                const char* unicode_item = PyUnicode_AsUTF8(item);
+                if (unicode_item == NULL) {
+                    Py_DECREF(item);
+                    break;
+                }
+                atom_setsym(atoms + i, py_gensym(x, unicode_item));
+                i++;
+            }
+
+            else {
+                int res = py_number_to_atom(item, atoms + i);
+                if (res < 0) {
+                    Py_DECREF(item);
+                    break;
+                }
+                i += res;
+            }
+            Py_DECREF(item);
+        }
+        Py_DECREF(iter);
+
+        if (!PyErr_Occurred() && i == 0 && unsupported) {
+            PyErr_SetString(PyExc_TypeError,
+                            "cannot handle this buffer format");
+        }
+
+        if (!PyErr_Occurred()) {
+            py_trace(x, PY_TRACE_OUTPUT, i, 0, 0.0);
+            py_stats_atoms(x, PY_STATS_OUTPUT, i);
+            outlet_list(x->p_outlet_left, NULL, i, atoms);
+        }
+
+        if (is_dynamic) {
+            atom_dynamic_end(atoms_static, atoms);
+        }
+
+        if (PyErr_Occurred()) {
+            goto error;
+        }
+        py_bang_success(x);
+
+    } else {
+        // e.g. a struct or complex buffer which is not a sequence
+        py_error(x, "cannot handle this type of value");
+        goto error;
+    }
+
+    Py_XDECREF(plist);
+    return MAX_ERR_NONE;
+
+error:
+    py_handle_error(x, "py_handle_list_output failed");
+    Py_XDECREF(plist);
+    py_bang_failure(x);
+    return MAX_ERR_GENERIC;
+}
+
+/**
+ * @brief Get the per-object atom output buffer, growing it if needed
+ *
+ * @param x pointer to object struct
+ * @param size minimum number of atoms required
+ * @return t_atom* atom buffer or NULL if allocation failed
+ */
+t_atom* py_atom_buffer(t_py* x, long size)
+{
+    if (size > x->p_atoms_size) {
+        long new_size = x->p_atoms_size ? x->p_atoms_size * 2 : PY_MAX_ATOMS;
+        while (new_size < size)
+            new_size *= 2;
+
+        t_atom* atoms = (t_atom*)sysmem_resizeptr(x->p_atoms,
+                                                  new_size * sizeof(t_atom));
+        if (atoms == NULL) {
+            return NULL;
+        }
+        x->p_atoms = atoms;
+        x->p_atoms_size = new_size;
+    }
+    return x->p_atoms;
+}
+
+/**
+ * @brief Output the first n atoms of the atom buffer as a list
+ *
+ * @param x pointer to object struct
+ * @param n number of atoms
+ *
+ * The buffer is detached from the object while the outlet call runs, so
+ * an output which re-enters the object (a feedback cord, or several cords
+ * fanning out) gets a buffer of its own and cannot overwrite or resize the
+ * atoms max is still walking. Afterwards the larger of the two buffers is
+ * kept and the other one freed.
+ */
+void py_atom_buffer_output(t_py* x, long n)
+{
+    t_atom* atoms = x->p_atoms;
+    long size = x->p_atoms_size;
+
+    x->p_atoms = NULL;
+    x->p_atoms_size = 0;
+
+    outlet_list(x->p_outlet_left, NULL, n, atoms);
+
+    if (x->p_atoms == NULL) {
+        x->p_atoms = atoms;
+        x->p_atoms_size = size;
+    } else if (size > x->p_atoms_size) {
+        sysmem_freeptr(x->p_atoms);
+        x->p_atoms = atoms;
+        x->p_atoms_size = size;
+    } else {
+        sysmem_freeptr(atoms);
+    }
+}
+
+/**
+ * @brief Append a python scalar to the atom output buffer
+ *
+ * @param x pointer to object struct
+ * @param item python number or str (other types are skipped)
+ * @param n current number of atoms in buffer (incremented)
+ * @return t_max_err error code
+ */
+static t_max_err py_atom_buffer_append(t_py* x, PyObject* item, long* n)
+{
+    t_atom* atoms = py_atom_buffer(x, *n + 1);
+    if (atoms == NULL) {
+        PyErr_NoMemory();
+        return MAX_ERR_OUT_OF_MEM;
+    }
+
+    if (PyUnicode_Check(item)) {
+        const char* unicode_item = PyUnicode_AsUTF8(item);
+        if (unicode_item == NULL) {
+            return MAX_ERR_GENERIC;
+        }
+        atom_setsym(atoms + (*n)++, py_gensym(x, unicode_item));
+    } else {
+        int res = py_number_to_atom(item, atoms + *n);
+        if (res < 0) {
+            return MAX_ERR_GENERIC;
+        }
+        *n += res;
+    }
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Flatten a python dict into the atom output buffer
+ *
+ * @param x pointer to object struct
+ * @param pdict python dict
+ * @param prefix key path of a nested dict or NULL at top-level
+ * @param n current number of atoms in buffer (incremented)
+ * @return t_max_err error code
+ *
+ * Produces the `key : value1 value2 ...` layout, where list, tuple and set
+ * values are expanded. If the `nested` attribute is on, dict values are
+ * flattened recursively with `key::subkey` paths, otherwise they are
+ * skipped.
+ */
+t_max_err py_dict_to_atoms(t_py* x, PyObject* pdict, const char* prefix,
+                           long* n)
+{
+    PyObject* key = NULL;
+    PyObject* value = NULL;
+    PyObject* path = NULL;
+    Py_ssize_t pos = 0;
+    t_symbol* colon = gensym(":");
+    t_atom* atoms = NULL;
+    t_max_err err = MAX_ERR_NONE;
+
+    while (PyDict_Next(pdict, &pos, &key, &value)) {
+        if (prefix != NULL || (x->p_nested && PyDict_Check(value))) {
+            path = prefix ? PyUnicode_FromFormat("%s::%S", prefix, key)
+                          : PyObject_Str(key);
+            if (path == NULL) {
+                return MAX_ERR_GENERIC;
+            }
+        }
+
+        if (x->p_nested && PyDict_Check(value)) {
+            const char* cpath = PyUnicode_AsUTF8(path);
+            err = cpath ? py_dict_to_atoms(x, value, cpath, n)
+                        : MAX_ERR_GENERIC;
+            Py_CLEAR(path);
+            if (err != MAX_ERR_NONE)
+                return err;
+            continue;
+        }
+
+        // key
+        err = py_atom_buffer_append(x, path ? path : key, n);
+        Py_CLEAR(path);
+        if (err != MAX_ERR_NONE)
+            return err;
+
+        // separator
+        if ((atoms = py_atom_buffer(x, *n + 1)) == NULL) {
+            PyErr_NoMemory();
+            return MAX_ERR_OUT_OF_MEM;
+        }
+        atom_setsym(atoms + (*n)++, colon);
+
+        // value(s)
+        if (PyList_Check(value) || PyTuple_Check(value)) {
+            Py_ssize_t size = PySequence_Fast_GET_SIZE(value);
+            PyObject** items = PySequence_Fast_ITEMS(value);
+            for (Py_ssize_t i = 0; i < size; i++) {
+                if ((err = py_atom_buffer_append(x, items[i], n)) != MAX_ERR_NONE)
+                    return err;
+            }
+        } else if (PyAnySet_Check(value)) {
+            PyObject* iter = PyObject_GetIter(value);
+            PyObject* item = NULL;
+            if (iter == NULL)
+                return MAX_ERR_GENERIC;
+            while ((item = PyIter_Next(iter)) != NULL) {
+                err = py_atom_buffer_append(x, item, n);
+                Py_DECREF(item);
+                if (err != MAX_ERR_NONE)
+                    break;
+            }
+            Py_DECREF(iter);
+            if (err != MAX_ERR_NONE || PyErr_Occurred())
+                return MAX_ERR_GENERIC;
+        } else {
+            if ((err = py_atom_buffer_append(x, value, n)) != MAX_ERR_NONE)
+                return err;
+        }
+    }
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Convert a python value to an atom for a max dictionary
+ *
+ * @param x pointer to object struct
+ * @param value python object
+ * @param atom atom to set
+ * @return int 1 if set, 0 if the type is not supported, -1 on error
+ *
+ * Dicts become child dictionaries and lists, tuples, sets and numeric
+ * buffers (such as numpy arrays) become atomarrays, both set as A_OBJ atoms
+ * owned by the caller. Numpy scalars are converted to numbers, and ints
+ * too large for an atom to floats.
+ */
+static int py_value_to_dict_atom(t_py* x, PyObject* value, t_atom* atom)
+{
+    long n = 0;
+    int res = 0;
+
+    if (PyLong_Check(value)) {
+        if (py_long_to_atom(value, atom) < 0)
+            return -1;
+    } else if (PyFloat_Check(value)) {
+        atom_setfloat(atom, PyFloat_AS_DOUBLE(value));
+    } else if (PyUnicode_Check(value)) {
+        const char* str = PyUnicode_AsUTF8(value);
+        if (str == NULL)
+            return -1;
+        atom_setsym(atom, py_gensym(x, str));
+    } else if (PyDict_Check(value)) {
+        t_dictionary* d = dictionary_new();
+        if (d == NULL) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        if (py_dict_to_dictionary(x, value, d) != MAX_ERR_NONE) {
+            object_free(d);
+            return -1;
+        }
+        atom_setobj(atom, d);
+    } else if (PyList_Check(value) || PyTuple_Check(value)
+               || PyAnySet_Check(value)) {
+        t_atomarray* aa = py_seq_to_atomarray(x, value);
+        if (aa == NULL)
+            return -1;
+        atom_setobj(atom, aa);
+    } else if (PyObject_CheckBuffer(value) && !PyBytes_Check(value)
+               && !PyByteArray_Check(value)
+               && (res = py_buffer_to_atoms(x, value, &n)) != 0) {
+        if (res < 0)
+            return -1;
+        if (res == 2) {
+            *atom = x->p_atoms[0];
+        } else {
+            t_atomarray* aa = atomarray_new(n, x->p_atoms);
+            if (aa == NULL) {
+                PyErr_NoMemory();
+                return -1;
+            }
+            atom_setobj(atom, aa);
+        }
+    } else {
+        return py_number_to_atom(value, atom);
+    }
+    return 1;
+}
+
+/**
+ * @brief Convert a python list, tuple or set to a max atomarray
+ *
+ * @param x pointer to object struct
+ * @param pseq python sequence or set
+ * @return t_atomarray* new atomarray (freeing its child objects) or NULL
+ *         with a python error set
+ */
+t_atomarray* py_seq_to_atomarray(t_py* x, PyObject* pseq)
+{
+    PyObject* seq = NULL;
+    t_atomarray* aa = NULL;
+    t_atom* atoms = NULL;
+    Py_ssize_t size = 0;
+    long n = 0;
+
+    seq = PySequence_Fast(pseq, "expected a sequence");
+    if (seq == NULL)
+        return NULL;
+
+    size = PySequence_Fast_GET_SIZE(seq);
+    atoms = (t_atom*)sysmem_newptr(sizeof(t_atom) * (size ? size : 1));
+    if (atoms == NULL) {
+        PyErr_NoMemory();
+        goto finally;
+    }
+
+    for (Py_ssize_t i = 0; i < size; i++) {
+        int res = py_value_to_dict_atom(x, PySequence_Fast_GET_ITEM(seq, i),
+                                        atoms + n);
+        if (res < 0)
+            goto finally;
+        n += res;
+    }
+
+    aa = atomarray_new(n, atoms);
+    if (aa != NULL) {
+        atomarray_flags(aa, ATOMARRAY_FLAG_FREECHILDREN);
+        n = 0; // children now owned by the atomarray
+    } else {
+        PyErr_NoMemory();
+    }
+
+finally:
+    if (atoms != NULL) {
+        for (long i = 0; i < n; i++) {
+            if (atom_gettype(atoms + i) == A_OBJ)
+                object_free(atom_getobj(atoms + i));
+        }
+        sysmem_freeptr(atoms);
+    }
+    Py_DECREF(seq);
+    return aa;
+}
+
+/**
+ * @brief Copy a python dict into a max dictionary
+ *
+ * @param x pointer to object struct
+ * @param pdict python dict
+ * @param d max dictionary to append entries to
+ * @return t_max_err error code, with a python error set on failure
+ *
+ * Nested dicts become child dictionaries. Lists, tuples and sets of
+ * numbers and strings become atom arrays, and atomarrays when they hold
+ * dicts or further sequences. Non-string keys are converted with `str()`.
+ * Values of other types (including None) are skipped. With the `strings`
+ * attribute set to `bytes`, top-level string values are stored as max
+ * strings instead of symbols. Keys and strings in arrays stay symbols.
+ */
+t_max_err py_dict_to_dictionary(t_py* x, PyObject* pdict, t_dictionary* d)
+{
+    PyObject* key = NULL;
+    PyObject* value = NULL;
+    PyObject* pkey = NULL;
+    Py_ssize_t pos = 0;
+    t_symbol* skey = NULL;
+    t_atom atom;
+    int res = 0;
+
+    while (PyDict_Next(pdict, &pos, &key, &value)) {
+        if (PyUnicode_Check(key)) {
+            const char* ckey = PyUnicode_AsUTF8(key);
+            skey = ckey ? py_gensym(x, ckey) : NULL;
+        } else {
+            pkey = PyObject_Str(key);
+            const char* ckey = pkey ? PyUnicode_AsUTF8(pkey) : NULL;
+            skey = ckey ? py_gensym(x, ckey) : NULL;
+            Py_CLEAR(pkey);
+        }
+        if (skey == NULL)
+            return MAX_ERR_GENERIC;
+
+        if (PyUnicode_Check(value) && x->p_strings != gensym("symbol")) {
+            const char* str = PyUnicode_AsUTF8(value);
+            if (str == NULL)
+                return MAX_ERR_GENERIC;
+            dictionary_appendstring(d, skey, str);
+            continue;
+        }
+
+        res = py_value_to_dict_atom(x, value, &atom);
+        if (res < 0)
+            return MAX_ERR_GENERIC;
+        if (res == 0)
+            continue;
+
+        switch (atom_gettype(&atom)) {
+        case A_LONG:
+            dictionary_appendlong(d, skey, atom_getlong(&atom));
+            break;
+        case A_FLOAT:
+            dictionary_appendfloat(d, skey, atom_getfloat(&atom));
+            break;
+        case A_SYM:
+            dictionary_appendsym(d, skey, atom_getsym(&atom));
+            break;
+        default:
+            if (PyDict_Check(value)) {
+                dictionary_appenddictionary(d, skey, atom_getobj(&atom));
+            } else {
+                dictionary_appendatomarray(d, skey, atom_getobj(&atom));
+            }
+            break;
+        }
+    }
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Convert atoms of a max atomarray to a python list or array
+ *
+ * @param argc number of atoms
+ * @param argv atoms
+ * @param arrays if true, all-number atoms become an `array.array`
+ * @return PyObject* new reference, or NULL with a python error set
+ *
+ * With `arrays`, atoms which are all longs become `array('q')` and all
+ * numbers with at least one float become `array('d')`, filled from one
+ * bytes buffer instead of one python object per value.
+ */
+static PyObject* py_dict_atoms_to_value(long argc, t_atom* argv, int arrays)
+{
+    PyObject* pval = NULL;
+    PyObject* pbytes = NULL;
+    PyObject* array_module = NULL;
+    long nfloats = 0;
+    long i = 0;
+
+    for (i = 0; arrays && i < argc; i++) {
+        if (atom_gettype(argv + i) == A_FLOAT)
+            nfloats++;
+        else if (atom_gettype(argv + i) != A_LONG)
+            break;
+    }
+
+    if (arrays && argc > 0 && i == argc) {
+        size_t size = nfloats ? sizeof(double) : sizeof(long long);
+        pbytes = PyBytes_FromStringAndSize(NULL, argc * size);
+        if (pbytes == NULL)
+            return NULL;
+        if (nfloats) {
+            double* values = (double*)PyBytes_AS_STRING(pbytes);
+            for (i = 0; i < argc; i++)
+                values[i] = atom_getfloat(argv + i);
+        } else {
+            long long* values = (long long*)PyBytes_AS_STRING(pbytes);
+            for (i = 0; i < argc; i++)
+                values[i] = (long long)atom_getlong(argv + i);
+        }
+        array_module = PyImport_ImportModule("array");
+        if (array_module != NULL)
+            pval = PyObject_CallMethod(array_module, "array", "sO",
+                                       nfloats ? "d" : "q", pbytes);
+        Py_XDECREF(array_module);
+        Py_DECREF(pbytes);
+        return pval;
+    }
+
+    if ((pval = PyList_New(argc)) == NULL)
+        return NULL;
+
+    for (i = 0; i < argc; i++) {
+        PyObject* item = py_dict_atom_to_value(argv + i, arrays);
+        if (item == NULL) {
+            Py_DECREF(pval);
+            return NULL;
+        }
+        PyList_SET_ITEM(pval, i, item); // steals item
+    }
+    return pval;
+}
+
+/**
+ * @brief Convert an atom from a max dictionary to a python value
+ *
+ * @param atom atom to convert
+ * @param arrays passed on to nested atomarrays (see py_dictionary_to_dict)
+ * @return PyObject* new reference, or NULL with a python error set
+ *
+ * Child dictionaries become dicts, atomarrays become lists (or arrays),
+ * symbols and strings become str. Other objects become None.
+ */
+PyObject* py_dict_atom_to_value(t_atom* atom, int arrays)
+{
+    t_object* obj = NULL;
+    t_symbol* cls = NULL;
+    PyObject* pval = NULL;
+    long argc = 0;
+    t_atom* argv = NULL;
+
+    switch (atom_gettype(atom)) {
+    case A_LONG:
+        return PyLong_FromLongLong((long long)atom_getlong(atom));
+    case A_FLOAT:
+        return PyFloat_FromDouble(atom_getfloat(atom));
+    case A_SYM:
+        return PyUnicode_FromString(atom_getsym(atom)->s_name);
+    case A_OBJ:
+        break;
+    default:
+        Py_RETURN_NONE;
+    }
+
+    obj = (t_object*)atom_getobj(atom);
+    cls = obj ? object_classname(obj) : NULL;
+
+    if (cls == gensym("string")) {
+        return PyUnicode_FromString(string_getptr((t_string*)obj));
+    }
+    if (cls == gensym("dictionary")) {
+        if (Py_EnterRecursiveCall(" while converting a max dictionary"))
+            return NULL;
+        pval = py_dictionary_to_dict((t_dictionary*)obj, arrays);
+        Py_LeaveRecursiveCall();
+        return pval;
+    }
+    if (cls == gensym("atomarray")) {
+        if (Py_EnterRecursiveCall(" while converting a max atomarray"))
+            return NULL;
+        atomarray_getatoms((t_atomarray*)obj, &argc, &argv);
+        pval = py_dict_atoms_to_value(argc, argv, arrays);
+        Py_LeaveRecursiveCall();
+        return pval;
+    }
+    Py_RETURN_NONE;
+}
+
+/**
+ * @brief Convert one entry of a max dictionary to a python value
+ *
+ * @param d max dictionary
+ * @param key entry key
+ * @param arrays see py_dictionary_to_dict
+ * @return PyObject* new reference, or NULL with KeyError or another error
+ */
+PyObject* py_dictionary_entry_to_value(t_dictionary* d, t_symbol* key,
+                                       int arrays)
+{
+    t_atom atom;
+    long argc = 0;
+    t_atom* argv = NULL;
+
+    if (dictionary_entryisatomarray(d, key)) {
+        if (dictionary_getatoms(d, key, &argc, &argv) == MAX_ERR_NONE)
+            return py_dict_atoms_to_value(argc, argv, arrays);
+    } else if (dictionary_getatom(d, key, &atom) == MAX_ERR_NONE) {
+        return py_dict_atom_to_value(&atom, arrays);
+    }
+    PyErr_SetString(PyExc_KeyError, key->s_name);
+    return NULL;
+}
+
+/**
+ * @brief Convert a max dictionary to a python dict, recursively
+ *
+ * @param d max dictionary
+ * @param arrays if true, atomarrays of numbers become `array.array`
+ *               objects instead of lists
+ * @return PyObject* new reference to the dict, or NULL with a python
+ *         error set
+ *
+ * The reverse of py_dict_to_dictionary. Keys keep their max order. Child
+ * dictionaries become dicts, atomarrays become lists (or arrays) whose
+ * dictionaries and atomarrays are converted in turn, and symbols and
+ * strings become str. The whole conversion runs in C without calling back
+ * into python, so it suits large dictionaries such as presets.
+ */
+PyObject* py_dictionary_to_dict(t_dictionary* d, int arrays)
+{
+    PyObject* pdict = NULL;
+    PyObject* pkey = NULL;
+    PyObject* pval = NULL;
+    t_symbol** keys = NULL;
+    long numkeys = 0;
+
+    if (d == NULL) {
+        PyErr_SetString(PyExc_ValueError, "no max dictionary");
+        return NULL;
+    }
+
+    if ((pdict = PyDict_New()) == NULL)
+        return NULL;
+
+    if (dictionary_getkeys_ordered(d, &numkeys, &keys) != MAX_ERR_NONE) {
+        PyErr_SetString(PyExc_RuntimeError, "cannot get dictionary keys");
+        goto error;
+    }
+
+    for (long i = 0; i < numkeys; i++) {
+        pkey = PyUnicode_FromString(keys[i]->s_name);
+        pval = pkey ? py_dictionary_entry_to_value(d, keys[i], arrays) : NULL;
+        if (pval == NULL || PyDict_SetItem(pdict, pkey, pval) < 0)
+            goto error;
+        Py_CLEAR(pkey);
+        Py_CLEAR(pval);
+    }
+
+    if (keys)
+        dictionary_freekeys(d, numkeys, keys);
+    return pdict;
+
+error:
+    Py_XDECREF(pkey);
+    Py_XDECREF(pval);
+    Py_DECREF(pdict);
+    if (keys)
+        dictionary_freekeys(d, numkeys, keys);
+    return NULL;
+}
+
+/**
+ * @brief Handler to output python dict as max list or dictionary
+ *
+ * @param x pointer to object struct
+ * @param pdict python dict
+ * @return t_max_err error code
+ *
+ * The dict is flattened natively into the per-object atom buffer
+ * (see `py_dict_to_atoms`) without calling back into python. If the
+ * `dictionary` attribute is on, it is instead copied into a registered max
+ * dictionary owned by the object (see `py_dict_to_dictionary`) and output
+ * as `dictionary <name>`. The same dictionary is cleared and reused on
+ * each output.
+ */
+t_max_err py_handle_dict_output(t_py* x, PyObject* pdict)
+{
+    long n = 0;
+    t_atom name;
+
+    if (pdict == NULL) {
+        goto error;
+    }
+
+    if (PyDict_Check(pdict) && x->p_dictionary) {
+        if (x->p_dict == NULL) {
+            x->p_dict = dictobj_register(dictionary_new(), &x->p_dict_name);
+        } else {
+            dictionary_clear(x->p_dict);
+        }
+
+        if (x->p_dict == NULL
+            || py_dict_to_dictionary(x, pdict, x->p_dict) != MAX_ERR_NONE) {
+            goto error;
+        }
+
+        atom_setsym(&name, x->p_dict_name);
+        outlet_anything(x->p_outlet_left, gensym("dictionary"), 1, &name);
+        py_bang_success(x);
+    } else if (PyDict_Check(pdict)) {
+        if (py_dict_to_atoms(x, pdict, NULL, &n) != MAX_ERR_NONE) {
+            goto error;
+        }
+
+        if (n == 0) {
+            py_error(x, "cannot convert py dict of length 0 to atoms");
+            goto error;
+        }
+
+        py_atom_buffer_output(x, n);
+        py_bang_success(x);
+    }
+
+    Py_XDECREF(pdict);
+    return MAX_ERR_NONE;
+
+error:
+    py_handle_error(x, "py_handle_dict_output failed");
+    Py_XDECREF(pdict);
+    // fail bang
+    py_bang_failure(x);
+    return MAX_ERR_GENERIC;
+}
+
+/**
+ * @brief Generic handler to output arbitrarily-typed python object as max object
+ *
+ * @param x pointer to object struct
+ * @param pval python object
+ * @return t_max_err error code
+ */
+t_max_err py_handle_output(t_py* x, PyObject* pval)
+{
+    t_py_stats_span span = py_stats_begin(0);
+    t_atom atom;
+    int res = 0;
+
+    if (pval == NULL) {
+        py_error(x, "cannot handle NULL value");
+        return py_stats_end(x, PY_STATS_OUTPUT, &span, MAX_ERR_GENERIC);
+    }
+
+    if (PyFloat_Check(pval)) {
+        span.atoms = 1;
+        return py_stats_end(x, PY_STATS_OUTPUT, &span,
+                            py_handle_float_output(x, pval));
+    }
+
+    else if (PyLong_Check(pval)) {
+        span.atoms = 1;
+        return py_stats_end(x, PY_STATS_OUTPUT, &span,
+                            py_handle_long_output(x, pval));
+    }
+
+    else if (PyUnicode_Check(pval)) {
+        span.atoms = 1;
+        return py_stats_end(x, PY_STATS_OUTPUT, &span,
+                            py_handle_string_output(x, pval));
+    }
+
+    else if ((PySequence_Check(pval) || PyObject_CheckBuffer(pval))
+             && !PyBytes_Check(pval) && !PyByteArray_Check(pval)) {
+        // includes numpy arrays and scalars (via the buffer protocol)
+        return py_stats_end(x, PY_STATS_OUTPUT, &span,
+                            py_handle_list_output(x, pval));
+    }
+
+    else if (PyDict_Check(pval)) {
+        return py_stats_end(x, PY_STATS_OUTPUT, &span,
+                            py_handle_dict_output(x, pval));
+    }
+
+    else if ((res = py_number_to_atom(pval, &atom)) != 0) {
+        Py_DECREF(pval);
+        if (res < 0) {
+            py_handle_error(x, "py_handle_output failed");
+            py_bang_failure(x);
+            return py_stats_end(x, PY_STATS_OUTPUT, &span, MAX_ERR_GENERIC);
+        }
+        if (atom_gettype(&atom) == A_FLOAT)
+            outlet_float(x->p_outlet_left, atom_getfloat(&atom));
+        else
+            outlet_int(x->p_outlet_left, atom_getlong(&atom));
+        py_bang_success(x);
+        span.atoms = 1;
+        return py_stats_end(x, PY_STATS_OUTPUT, &span, MAX_ERR_NONE);
+    }
+
+    else if (pval == Py_None) {
+        // nothing to output is not an error
+        py_stats_end(x, PY_STATS_OUTPUT, &span, MAX_ERR_NONE);
+        return MAX_ERR_GENERIC;
+    }
+
+    else {
+        py_error(x, "cannot handle his type of value");
+        return py_stats_end(x, PY_STATS_OUTPUT, &span, MAX_ERR_GENERIC);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/* Translators */
+
+/**
+ * @brief Get the interned python string for a max symbol
+ *
+ * @param x pointer to object struct
+ * @param s max symbol
+ * @return PyObject* new reference to python string or NULL on error
+ *
+ * Max symbols are unique and never freed, so their address is used as key
+ * of a small direct-mapped per-object cache.
+ */
+PyObject* py_symbol_to_str(t_py* x, t_symbol* s)
+{
+    t_py_sym_entry* entry = x->p_sym_cache
+        + (((uint64_t)(uintptr_t)s * 0x9E3779B97F4A7C15ULL) >> 32
+           & (PY_SYM_CACHE_SIZE - 1));
+
+    if (entry->sym != s || entry->str == NULL) {
+        PyObject* str = PyUnicode_InternFromString(s->s_name);
+        if (str == NULL) {
+            return NULL;
+        }
+        Py_XSETREF(entry->str, str);
+        entry->sym = s;
+    }
+    Py_INCREF(entry->str);
+    return entry->str;
+}
+
+/**
+ * @brief Release all entries of the per-object symbol string cache.
+ *
+ * @param x pointer to object struct
+ *
+ * Must be called with the GIL held.
+ */
+void py_symbol_cache_flush(t_py* x)
+{
+    for (int i = 0; i < PY_SYM_CACHE_SIZE; i++) {
+        Py_CLEAR(x->p_sym_cache[i].str);
+        x->p_sym_cache[i].sym = NULL;
+    }
+}
+
+/**
+ * @brief Translates a single atom to a python object
+ *
+ * @param x pointer to object struct
+ * @param atom atom of type A_FLOAT, A_LONG or A_SYM
+ * @return PyObject* new reference or NULL on error
+ */
+static inline PyObject* py_atom_to_object(t_py* x, t_atom* atom)
+{
+    switch (atom->a_type) {
+    case A_FLOAT:
+        return PyFloat_FromDouble(atom_getfloat(atom));
+    case A_LONG:
+        return PyLong_FromLong(atom_getlong(atom));
+    default:
+        return py_symbol_to_str(x, atom_getsym(atom));
+    }
+}
+
+/**
+ * @brief Count atoms which can be translated to python objects
+ *
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return long number of A_FLOAT, A_LONG and A_SYM atoms
+ */
+static inline long py_atoms_count(long argc, t_atom* argv)
+{
+    long n = 0;
+
+    for (long i = 0; i < argc; i++) {
+        short type = (argv + i)->a_type;
+        n += (type == A_FLOAT || type == A_LONG || type == A_SYM);
+    }
+    return n;
+}
+
+/**
+ * @brief Translates atom vector to an array of python objects
+ *
+ * @param x pointer to object struct
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param stack output array of at least argc python object pointers
+ * @return long number of new references written to stack or -1 on error
+ *
+ * Atoms of unknown type are skipped, as in `py_atoms_to_list`.
+ */
+long py_atoms_to_stack(t_py* x, long argc, t_atom* argv, PyObject** stack)
+{
+    long n = 0;
+    PyObject* item = NULL;
+
+    for (long i = 0; i < argc; i++) {
+        short type = (argv + i)->a_type;
+        if (type != A_FLOAT && type != A_LONG && type != A_SYM) {
+            py_log(x, "cannot process unknown type");
+            continue;
+        }
+        if ((item = py_atom_to_object(x, argv + i)) == NULL) {
+            goto error;
+        }
+        stack[n++] = item;
+    }
+    return n;
+
+error:
+    for (long i = 0; i < n; i++)
+        Py_DECREF(stack[i]);
+    return -1;
+}
+
+/**
+ * @brief Translates atom vector to python list
+ * 
+ * @param x pointer to object struct
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param start_from index of vector to start from
+ * @return PyObject* python list
+ *
+ * The list is allocated at its final size and filled in place.
+ */
+PyObject* py_atoms_to_list(t_py* x, long argc, t_atom* argv, int start_from)
+{
+    PyObject* plist = NULL; // python list
+    PyObject* item = NULL;
+    long n = 0;
+
+    if (start_from > argc) {
+        start_from = argc;
+    }
+
+    plist = PyList_New(py_atoms_count(argc - start_from, argv + start_from));
+    if (plist == NULL) {
+        py_error(x, "could not create a python list");
+        goto error;
+    }
+
+    for (long i = start_from; i < argc; i++) {
+        short type = (argv + i)->a_type;
+        if (type != A_FLOAT && type != A_LONG && type != A_SYM) {
+            py_log(x, "cannot process unknown type");
+            continue;
+        }
+        if ((item = py_atom_to_object(x, argv + i)) == NULL) {
+            goto error;
+        }
+        PyList_SET_ITEM(plist, n++, item);
+    }
+    return plist;
+
+error:
+    py_error(x, "atom to list conversion failed");
+    Py_XDECREF(plist);
+    return NULL;
+}
+
+/**
+ * @brief Translates atom vector to python tuple
+ *
+ * @param x pointer to object struct
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param start_from index of vector to start from
+ * @return PyObject* python tuple
+ *
+ * Use for call arguments instead of converting a list with
+ * `PyList_AsTuple`.
+ */
+PyObject* py_atoms_to_tuple(t_py* x, long argc, t_atom* argv, int start_from)
+{
+    PyObject* ptuple = NULL; // python tuple
+    PyObject* item = NULL;
+    long n = 0;
+
+    if (start_from > argc) {
+        start_from = argc;
+    }
+
+    ptuple = PyTuple_New(py_atoms_count(argc - start_from, argv + start_from));
+    if (ptuple == NULL) {
+        py_error(x, "could not create a python tuple");
+        goto error;
+    }
+
+    for (long i = start_from; i < argc; i++) {
+        short type = (argv + i)->a_type;
+        if (type != A_FLOAT && type != A_LONG && type != A_SYM) {
+            py_log(x, "cannot process unknown type");
+            continue;
+        }
+        if ((item = py_atom_to_object(x, argv + i)) == NULL) {
+            goto error;
+        }
+        PyTuple_SET_ITEM(ptuple, n++, item);
+    }
+    return ptuple;
+
+error:
+    py_error(x, "atom to tuple conversion failed");
+    Py_XDECREF(ptuple);
+    return NULL;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Code cache */
+
+/**
+ * @brief Hash a source string for the compiled code cache (FNV-1a).
+ *
+ * @param text null-terminated source text
+ * @return unsigned long hash value
+ */
+static unsigned long py_code_cache_hash(const char* text)
+{
+    unsigned long hash = 2166136261UL;
+
+    while (*text) {
+        hash ^= (unsigned char)*text++;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Lookup a compiled code object in the per-object cache.
+ *
+ * @param x pointer to object struct
+ * @param text source text
+ * @param mode compile mode (Py_eval_input, Py_single_input, Py_file_input)
+ * @return PyObject* new reference to code object or NULL if not cached
+ *
+ * Does not set a python exception on a miss and does not update the
+ * hit/miss counters: that is left to the caller.
+ */
+PyObject* py_code_cache_get(t_py* x, const char* text, int mode)
+{
+    unsigned long hash = py_code_cache_hash(text);
+
+    for (int i = 0; i < PY_CODE_CACHE_SIZE; i++) {
+        t_py_code_entry* entry = x->p_code_cache + i;
+        if (entry->code != NULL && entry->hash == hash && entry->mode == mode
+            && strcmp(entry->text, text) == 0) {
+            entry->stamp = ++x->p_code_cache_stamp;
+            Py_INCREF(entry->code);
+            return entry->code;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Store a compiled code object in the per-object cache.
+ *
+ * @param x pointer to object struct
+ * @param text source text
+ * @param mode compile mode
+ * @param co compiled code object (a new reference is taken)
+ *
+ * If the cache is full, the least recently used entry is evicted.
+ */
+void py_code_cache_put(t_py* x, const char* text, int mode, PyObject* co)
+{
+    t_py_code_entry* slot = x->p_code_cache;
+    size_t len = strlen(text);
+
+    for (int i = 0; i < PY_CODE_CACHE_SIZE; i++) {
+        t_py_code_entry* entry = x->p_code_cache + i;
+        if (entry->code == NULL) {
+            slot = entry;
+            break;
+        }
+        if (entry->stamp < slot->stamp) {
+            slot = entry;
+        }
+    }
+
+    if (slot->code != NULL) {
+        Py_CLEAR(slot->code);
+        sysmem_freeptr(slot->text);
+        slot->text = NULL;
+    }
+
+    slot->text = (char*)sysmem_newptr((long)len + 1);
+    if (slot->text == NULL) {
+        return;
+    }
+    memcpy(slot->text, text, len + 1);
+    slot->hash = py_code_cache_hash(text);
+    slot->mode = mode;
+    slot->stamp = ++x->p_code_cache_stamp;
+    Py_INCREF(co);
+    slot->code = co;
+}
+
+/**
+ * @brief Compile source text, going through the per-object code cache.
+ *
+ * @param x pointer to object struct
+ * @param text source text
+ * @param mode compile mode
+ * @return PyObject* new reference to code object or NULL on error
+ */
+PyObject* py_code_cache_compile(t_py* x, const char* text, int mode)
+{
+    PyObject* co = py_code_cache_get(x, text, mode);
+
+    if (co != NULL) {
+        x->p_code_cache_hits++;
+        return co;
+    }
+
+    x->p_code_cache_misses++;
+    co = Py_CompileString(text, x->p_name->s_name, mode);
+    if (co != NULL) {
+        py_code_cache_put(x, text, mode, co);
+    }
+    return co;
+}
+
+/**
+ * @brief Release all entries of the per-object code cache.
+ *
+ * @param x pointer to object struct
+ *
+ * Must be called with the GIL held.
+ */
+void py_code_cache_flush(t_py* x)
+{
+    for (int i = 0; i < PY_CODE_CACHE_SIZE; i++) {
+        t_py_code_entry* entry = x->p_code_cache + i;
+        Py_CLEAR(entry->code);
+        if (entry->text != NULL) {
+            sysmem_freeptr(entry->text);
+            entry->text = NULL;
+        }
+        entry->stamp = 0;
+    }
+    x->p_code_cache_stamp = 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Call cache */
+
+#if PY_VERSION_HEX >= 0x030C0000
+/**
+ * @brief Dict watcher callback: any change to a watched dict bumps the
+ * generation of its interpreter, invalidating resolved callables.
+ *
+ * Each subinterpreter has its own GIL, so each keeps its own generation
+ * which is only touched while holding that GIL.
+ */
+static int py_dict_watch_callback(PyDict_WatchEvent event, PyObject* dict,
+                                  PyObject* key, PyObject* new_value)
+{
+    PyInterpreterState* interp = PyInterpreterState_Get();
+
+    if (interp == PyInterpreterState_Main()) {
+        py_global_dict_generation++;
+        return 0;
+    }
+    systhread_mutex_lock(py_global_interp_mutex);
+    for (t_py_interp* i = py_global_interps; i; i = i->next) {
+        if (i->interp == interp) {
+            i->dict_generation++;
+            break;
+        }
+    }
+    systhread_mutex_unlock(py_global_interp_mutex);
+    return 0;
+}
+#endif
+
+/**
+ * @brief Start tracking modifications of a python dict.
+ *
+ * @param x pointer to object struct
+ * @param dict python dict (namespace) to watch
+ *
+ * Only needed for python >= 3.12 where dict watchers replace the
+ * deprecated `ma_version_tag`. Watcher ids are per interpreter.
+ */
+void py_dict_watch(t_py* x, PyObject* dict)
+{
+#if PY_VERSION_HEX >= 0x030C0000
+    int* watcher = x->p_interp ? &x->p_interp->dict_watcher
+                               : &py_global_dict_watcher;
+    if (dict == NULL)
+        return;
+    if (*watcher == -1) {
+        *watcher = PyDict_AddWatcher(py_dict_watch_callback);
+        if (*watcher == -1) {
+            PyErr_Clear();
+            return;
+        }
+    }
+    if (PyDict_Watch(*watcher, dict) == -1)
+        PyErr_Clear();
+#endif
+}
+
+/**
+ * @brief Get a version number which changes whenever the dict is modified.
+ *
+ * @param x pointer to object struct
+ * @param dict python dict
+ * @return uint64_t version
+ */
+uint64_t py_dict_version(t_py* x, PyObject* dict)
+{
+#if PY_VERSION_HEX >= 0x030C0000
+    return x->p_interp ? x->p_interp->dict_generation
+                       : py_global_dict_generation;
+#else
+    return ((PyDictObject*)dict)->ma_version_tag;
+#endif
+}
+
+/**
+ * @brief Check if a callable name is a (dotted) python identifier.
+ *
+ * @param name callable name
+ * @return int 1 if name is of the form `a`, `a.b`, `a.b.c`, ...
+ */
+static int py_call_name_is_dotted(const char* name)
+{
+    int start = 1;
+
+    if (*name == '\0')
+        return 0;
+
+    for (; *name; name++) {
+        if (*name == '.') {
+            if (start)
+                return 0;
+            start = 1;
+        } else if (isalpha((unsigned char)*name) || *name == '_'
+                   || (!start && isdigit((unsigned char)*name))) {
+            start = 0;
+        } else {
+            return 0;
+        }
+    }
+    return !start;
+}
+
+/**
+ * @brief Compute positional arity of a cached callable.
+ *
+ * @param entry call cache entry
+ *
+ * Only python functions and bound methods have a known arity, other
+ * callables are marked as unknown (-1).
+ */
+static void py_call_cache_set_arity(t_py_call_entry* entry)
+{
+    PyObject* func = entry->callable;
+    int bound = 0;
+
+    entry->min_args = -1;
+    entry->max_args = -1;
+    entry->list_nargs = -1;
+
+    if (PyMethod_Check(func)) {
+        func = PyMethod_GET_FUNCTION(func);
+        bound = 1;
+    }
+
+    if (!PyFunction_Check(func))
+        return;
+
+    PyCodeObject* co = (PyCodeObject*)PyFunction_GET_CODE(func);
+    PyObject* defaults = PyFunction_GET_DEFAULTS(func);
+    int ndefaults = defaults ? (int)PyTuple_GET_SIZE(defaults) : 0;
+
+    entry->min_args = co->co_argcount - ndefaults - bound;
+    if (entry->min_args < 0)
+        entry->min_args = 0;
+    if (co->co_flags & CO_VARARGS)
+        entry->max_args = INT_MAX;
+    else
+        entry->max_args = co->co_argcount - bound;
+}
+
+/**
+ * @brief Decide whether a callable should receive its arguments as a list.
+ *
+ * @param entry call cache entry
+ * @param nargs number of arguments
+ * @return int 1 for `f([args])` style, 0 for `f(*args)` style
+ */
+static int py_call_cache_use_list(t_py_call_entry* entry, long nargs)
+{
+    if (entry->min_args < 0)
+        return entry->list_nargs == nargs; // unknown arity: learned
+
+    if (nargs >= entry->min_args && nargs <= entry->max_args)
+        return 0;
+
+    return (entry->min_args <= 1 && entry->max_args >= 1);
+}
+
+/**
+ * @brief Resolve a cache entry to its callable.
+ *
+ * @param x pointer to object struct
+ * @param entry call cache entry
+ * @return PyObject* borrowed reference to callable or NULL on error
+ *
+ * Simple names are only looked up again if the globals (or builtins) dict
+ * has changed since the last resolution. Dotted names walk their attribute
+ * chain every time, starting from the cached root.
+ */
+static PyObject* py_call_cache_resolve(t_py* x, t_py_call_entry* entry)
+{
+    PyObject* builtins = PyEval_GetBuiltins();
+    uint64_t globals_version = py_dict_version(x, x->p_globals);
+    uint64_t builtins_version = 0;
+    Py_ssize_t nparts = PyTuple_GET_SIZE(entry->names);
+    PyObject* first = PyTuple_GET_ITEM(entry->names, 0);
+    PyObject* obj = NULL;
+
+    if (entry->callable != NULL && nparts == 1
+        && entry->globals_version == globals_version
+        && (entry->builtins_version == 0
+            || entry->builtins_version == py_dict_version(x, builtins))) {
+        return entry->callable;
+    }
+
+    obj = PyDict_GetItemWithError(x->p_globals, first);
+    if (obj == NULL && !PyErr_Occurred() && builtins != NULL) {
+        obj = PyDict_GetItemWithError(builtins, first);
+        builtins_version = py_dict_version(x, builtins);
+    }
+    if (obj == NULL) {
+        if (!PyErr_Occurred())
+            PyErr_Format(PyExc_NameError, "name '%U' is not defined", first);
+        return NULL;
+    }
+    Py_INCREF(obj);
+
+    for (Py_ssize_t i = 1; i < nparts; i++) {
+        PyObject* next = PyObject_GetAttr(obj, PyTuple_GET_ITEM(entry->names, i));
+        Py_DECREF(obj);
+        if (next == NULL)
+            return NULL;
+        obj = next;
+    }
+
+    if (obj != entry->callable) {
+        Py_XSETREF(entry->callable, obj);
+        py_call_cache_set_arity(entry);
+    } else {
+        Py_DECREF(obj);
+    }
+    entry->globals_version = globals_version;
+    entry->builtins_version = builtins_version;
+    return entry->callable;
+}
+
+/**
+ * @brief Get (or create) the call cache entry for a callable name.
+ *
+ * @param x pointer to object struct
+ * @param name callable name symbol
+ * @return t_py_call_entry* entry or NULL on error
+ *
+ * The least recently used entry is recycled when the cache is full.
+ */
+t_py_call_entry* py_call_cache_get(t_py* x, t_symbol* name)
+{
+    t_py_call_entry* slot = x->p_call_cache;
+    PyObject* pname = NULL;
+
+    for (int i = 0; i < PY_CALL_CACHE_SIZE; i++) {
+        t_py_call_entry* entry = x->p_call_cache + i;
+        if (entry->name == name) {
+            entry->stamp = ++x->p_call_cache_stamp;
+            return entry;
+        }
+        if (entry->name == NULL) {
+            slot = entry;
+            break;
+        }
+        if (entry->stamp < slot->stamp) {
+            slot = entry;
+        }
+    }
+
+    pname = PyUnicode_FromString(name->s_name);
+    if (pname == NULL)
+        return NULL;
+
+    PyObject* sep = PyUnicode_FromString(".");
+    if (sep == NULL) {
+        Py_DECREF(pname);
+        return NULL;
+    }
+    PyObject* parts = PyUnicode_Split(pname, sep, -1);
+    Py_DECREF(pname);
+    Py_DECREF(sep);
+    if (parts == NULL)
+        return NULL;
+
+    Py_ssize_t nparts = PyList_GET_SIZE(parts);
+    PyObject* names = PyTuple_New(nparts);
+    if (names == NULL) {
+        Py_DECREF(parts);
+        return NULL;
+    }
+    for (Py_ssize_t i = 0; i < nparts; i++) {
+        PyObject* part = PyList_GET_ITEM(parts, i);
+        Py_INCREF(part);
+        PyUnicode_InternInPlace(&part);
+        PyTuple_SET_ITEM(names, i, part);
+    }
+    Py_DECREF(parts);
+
+    Py_CLEAR(slot->callable);
+    Py_XSETREF(slot->names, names);
+    slot->name = name;
+    slot->globals_version = 0;
+    slot->builtins_version = 0;
+    slot->min_args = -1;
+    slot->max_args = -1;
+    slot->list_nargs = -1;
+    slot->stamp = ++x->p_call_cache_stamp;
+    return slot;
+}
+
+/**
+ * @brief Release all entries of the per-object callable cache.
+ *
+ * @param x pointer to object struct
+ *
+ * Must be called with the GIL held.
+ */
+void py_call_cache_flush(t_py* x)
+{
+    for (int i = 0; i < PY_CALL_CACHE_SIZE; i++) {
+        t_py_call_entry* entry = x->p_call_cache + i;
+        Py_CLEAR(entry->callable);
+        Py_CLEAR(entry->names);
+        entry->name = NULL;
+        entry->stamp = 0;
+    }
+    x->p_call_cache_stamp = 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Pipeline cache */
+
+/**
+ * @brief Evaluate the stages of a pipeline to their callables.
+ *
+ * @param x pointer to object struct
+ * @param entry pipeline cache entry
+ * @return t_max_err error code
+ *
+ * Stages are python expressions (usually names) evaluated in the object
+ * namespace via the compiled code cache.
+ */
+static t_max_err py_pipe_cache_resolve(t_py* x, t_py_pipe_entry* entry)
+{
+    PyObject* builtins = PyEval_GetBuiltins();
+    PyObject* co = NULL;
+    PyObject* func = NULL;
+
+    for (long i = 0; i < entry->nstages; i++) {
+        co = py_code_cache_compile(x, entry->stages[i]->s_name,
+                                   Py_eval_input);
+        if (co == NULL)
+            return MAX_ERR_GENERIC;
+        func = PyEval_EvalCode(co, x->p_globals, x->p_globals);
+        Py_DECREF(co);
+        if (func == NULL)
+            return MAX_ERR_GENERIC;
+        if (!PyCallable_Check(func)) {
+            PyErr_Format(PyExc_TypeError, "pipe stage '%s' is not callable",
+                         entry->stages[i]->s_name);
+            Py_DECREF(func);
+            return MAX_ERR_GENERIC;
+        }
+        Py_XSETREF(entry->funcs[i], func);
+    }
+    entry->globals_version = py_dict_version(x, x->p_globals);
+    entry->builtins_version = builtins ? py_dict_version(x, builtins) : 0;
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Release the callables of a pipeline cache entry.
+ *
+ * @param entry pipeline cache entry
+ */
+static void py_pipe_cache_clear(t_py_pipe_entry* entry)
+{
+    for (long i = 0; i < PY_PIPE_MAX_STAGES; i++) {
+        Py_CLEAR(entry->funcs[i]);
+    }
+    entry->nstages = 0;
+    entry->stamp = 0;
+}
+
+/**
+ * @brief Get (or compile) the pipeline for a sequence of stage symbols.
+ *
+ * @param x pointer to object struct
+ * @param argc number of stages
+ * @param argv stage symbols
+ * @return t_py_pipe_entry* entry or NULL on error
+ *
+ * Pipelines are keyed by their symbol sequence and resolved once. They are
+ * only resolved again if the globals (or builtins) dict has changed. The
+ * least recently used entry is recycled when the cache is full.
+ */
+t_py_pipe_entry* py_pipe_cache_get(t_py* x, long argc, t_atom* argv)
+{
+    t_py_pipe_entry* slot = x->p_pipe_cache;
+    t_py_pipe_entry* entry = NULL;
+    PyObject* builtins = NULL;
+
+    if (argc < 1 || argc > PY_PIPE_MAX_STAGES) {
+        py_error(x, "pipe requires 1 to %d functions", PY_PIPE_MAX_STAGES);
+        return NULL;
+    }
+    for (long i = 0; i < argc; i++) {
+        if (atom_gettype(argv + i) != A_SYM) {
+            py_error(x, "pipe functions must be symbols");
+            return NULL;
+        }
+    }
+
+    for (int i = 0; i < PY_PIPE_CACHE_SIZE; i++) {
+        t_py_pipe_entry* e = x->p_pipe_cache + i;
+        if (e->nstages == argc) {
+            long j = 0;
+            while (j < argc && e->stages[j] == atom_getsym(argv + j))
+                j++;
+            if (j == argc) {
+                entry = e;
+                break;
+            }
+        }
+        if (e->nstages == 0) {
+            slot = e;
+            break;
+        }
+        if (e->stamp < slot->stamp) {
+            slot = e;
+        }
+    }
+
+    if (entry == NULL) {
+        entry = slot;
+        py_pipe_cache_clear(entry);
+        for (long i = 0; i < argc; i++) {
+            entry->stages[i] = atom_getsym(argv + i);
+        }
+        entry->nstages = argc;
+        entry->globals_version = 0;
+    } else {
+        builtins = PyEval_GetBuiltins();
+        if (entry->globals_version == py_dict_version(x, x->p_globals)
+            && (builtins == NULL
+                || entry->builtins_version == py_dict_version(x, builtins))) {
+            entry->stamp = ++x->p_pipe_cache_stamp;
+            return entry;
+        }
+    }
+
+    entry->stamp = ++x->p_pipe_cache_stamp;
+    if (py_pipe_cache_resolve(x, entry) != MAX_ERR_NONE) {
+        py_pipe_cache_clear(entry);
+        return NULL;
+    }
+    return entry;
+}
+
+/**
+ * @brief Run a value through a compiled pipeline.
+ *
+ * @param x pointer to object struct
+ * @param entry pipeline cache entry
+ * @param pval input value (reference is stolen)
+ * @return PyObject* new reference to result or NULL on error
+ */
+PyObject* py_pipe_run(t_py* x, t_py_pipe_entry* entry, PyObject* pval)
+{
+    PyObject* next = NULL;
+
+    for (long i = 0; i < entry->nstages && pval != NULL; i++) {
+        next = PyObject_CallOneArg(entry->funcs[i], pval);
+        Py_DECREF(pval);
+        pval = next;
+    }
+    return pval;
+}
+
+/**
+ * @brief Release all entries of the per-object pipeline cache.
+ *
+ * @param x pointer to object struct
+ *
+ * Must be called with the GIL held.
+ */
+void py_pipe_cache_flush(t_py* x)
+{
+    for (int i = 0; i < PY_PIPE_CACHE_SIZE; i++) {
+        py_pipe_cache_clear(x->p_pipe_cache + i);
+    }
+    x->p_pipe_cache_stamp = 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Interpreters */
+
+#if PY_VERSION_HEX >= 0x030D0000
+#define py_tstate_get() PyThreadState_GetUnchecked()
+#else
+#define py_tstate_get() _PyThreadState_UncheckedGet()
+#endif
+
+#if PY_VERSION_HEX >= 0x030C0000
+/**
+ * @brief Get the thread state of the calling thread in a subinterpreter
+ *
+ * @param interp subinterpreter
+ * @return PyThreadState* thread state (owned by the subinterpreter)
+ *
+ * Thread states are created on first use and kept until the subinterpreter
+ * ends. A thread is given a main interpreter thread state first if it has
+ * none, so that `PyGILState_Ensure` still resolves to the main interpreter
+ * on that thread.
+ */
+static PyThreadState* py_interp_tstate(t_py_interp* interp)
+{
+    t_systhread self = systhread_self();
+    PyThreadState* tstate = NULL;
+
+    systhread_mutex_lock(py_global_interp_mutex);
+    for (long i = 0; i < interp->nthreads; i++) {
+        if (interp->threads[i].thread == self) {
+            tstate = interp->threads[i].tstate;
+            goto finally;
+        }
+    }
+
+    if (interp->nthreads == interp->threads_size) {
+        long size = interp->threads_size ? interp->threads_size * 2 : 4;
+        t_py_interp_thread* threads = (t_py_interp_thread*)sysmem_resizeptr(
+            interp->threads, size * sizeof(t_py_interp_thread));
+        if (threads == NULL)
+            goto finally;
+        interp->threads = threads;
+        interp->threads_size = size;
+    }
+
+    if (PyGILState_GetThisThreadState() == NULL)
+        PyThreadState_New(PyInterpreterState_Main());
+
+    tstate = PyThreadState_New(interp->interp);
+    if (tstate != NULL) {
+        interp->threads[interp->nthreads].thread = self;
+        interp->threads[interp->nthreads].tstate = tstate;
+        interp->nthreads++;
+    }
+
+finally:
+    systhread_mutex_unlock(py_global_interp_mutex);
+    if (tstate == NULL)
+        Py_FatalError("py: could not create a subinterpreter thread state");
+    return tstate;
+}
+#endif
+
+/**
+ * @brief Give the object a subinterpreter according to `@interpreter`
+ *
+ * @param x pointer to object struct
+ * @return t_max_err error code
+ *
+ * With `@interpreter own` the object gets a private subinterpreter; any
+ * other name is shared by all objects using the same name. Subinterpreters
+ * have their own GIL (PEP 684), so objects in different subinterpreters
+ * run python in parallel on worker threads (see `@threaded`). Extension
+ * modules which do not support this, such as numpy, cannot be imported.
+ *
+ * If the builtin `api` module cannot be imported with its own GIL (it was
+ * generated by a Cython older than 3.1), the subinterpreter is created
+ * again sharing the main GIL and extension checks are turned off. This is
+ * reported on the console. The object keeps its own modules, but it does
+ * not run in parallel with the main interpreter.
+ *
+ * Called from `py_init` on the main thread without holding the GIL.
+ */
+t_max_err py_interp_acquire(t_py* x)
+{
+    t_symbol* name = x->p_interpreter;
+
+    if (name == gensym(""))
+        return MAX_ERR_NONE;
+
+#if PY_VERSION_HEX >= 0x030C0000
+    t_py_interp* interp = NULL;
+    PyThreadState* main_tstate = NULL;
+    PyThreadState* tstate = NULL;
+    PyObject* api_module = NULL;
+    PyGILState_STATE gstate;
+    PyStatus status;
+    PyInterpreterConfig config = {
+        .use_main_obmalloc = 0,
+        .allow_fork = 0,
+        .allow_exec = 0,
+        .allow_threads = 1,
+        .allow_daemon_threads = 0,
+        .check_multi_interp_extensions = 1,
+        .gil = PyInterpreterConfig_OWN_GIL,
+    };
+
+    if (name == gensym("own"))
+        name = NULL;
+
+    systhread_mutex_lock(py_global_interp_mutex);
+    for (interp = py_global_interps; name && interp; interp = interp->next) {
+        if (interp->name == name) {
+            interp->refcount++;
+            x->p_interp = interp;
+            systhread_mutex_unlock(py_global_interp_mutex);
+            return MAX_ERR_NONE;
+        }
+    }
+    systhread_mutex_unlock(py_global_interp_mutex);
+
+    interp = (t_py_interp*)sysmem_newptrclear(sizeof(t_py_interp));
+    if (interp == NULL) {
+        py_error(x, "could not allocate subinterpreter");
+        return MAX_ERR_OUT_OF_MEM;
+    }
+
+    gstate = PyGILState_Ensure();
+    main_tstate = PyThreadState_Get();
+    status = Py_NewInterpreterFromConfig(&tstate, &config);
+    if (!PyStatus_Exception(status)) {
+        // an api module without multi-phase init fails to import here
+        api_module = PyImport_ImportModule("api");
+        if (api_module == NULL && PyErr_ExceptionMatches(PyExc_ImportError)) {
+            PyErr_Clear();
+            Py_EndInterpreter(tstate);
+            PyEval_RestoreThread(main_tstate);
+            config.use_main_obmalloc = 1;
+            config.check_multi_interp_extensions = 0;
+            config.gil = PyInterpreterConfig_SHARED_GIL;
+            status = Py_NewInterpreterFromConfig(&tstate, &config);
+            if (!PyStatus_Exception(status)) {
+                py_error(x, "api module does not support its own GIL "
+                            "(needs Cython 3.1 or later): subinterpreter "
+                            "%s shares the main GIL",
+                         name ? name->s_name : "(own)");
+            }
+        }
+        PyErr_Clear();
+        Py_XDECREF(api_module);
+    }
+    if (PyStatus_Exception(status)) {
+        PyGILState_Release(gstate);
+        sysmem_freeptr(interp);
+        py_error(x, "could not create subinterpreter: %s",
+                 status.err_msg ? status.err_msg : "unknown error");
+        return MAX_ERR_GENERIC;
+    }
+
+    // the new interpreter's GIL is held and the main GIL was released
+    interp->name = name;
+    interp->refcount = 1;
+    interp->interp = PyThreadState_GetInterpreter(tstate);
+    interp->dict_watcher = -1;
+    interp->dict_generation = 1;
+    interp->threads = (t_py_interp_thread*)sysmem_newptr(
+        sizeof(t_py_interp_thread));
+    if (interp->threads != NULL) {
+        interp->threads[0].thread = systhread_self();
+        interp->threads[0].tstate = tstate;
+        interp->nthreads = interp->threads_size = 1;
+    }
+    PyEval_SaveThread();
+    PyEval_RestoreThread(main_tstate);
+    PyGILState_Release(gstate);
+
+    systhread_mutex_lock(py_global_interp_mutex);
+    interp->next = py_global_interps;
+    py_global_interps = interp;
+    systhread_mutex_unlock(py_global_interp_mutex);
+
+    x->p_interp = interp;
+    py_log(x, "created subinterpreter %s", name ? name->s_name : "(own)");
+    return MAX_ERR_NONE;
+#else
+    py_error(x, "@interpreter needs python 3.12 or later");
+    return MAX_ERR_GENERIC;
+#endif
+}
+
+/**
+ * @brief Leave the object's subinterpreter, ending it if unused
+ *
+ * @param x pointer to object struct
+ *
+ * Called from `py_free` on the main thread without holding the GIL, after
+ * the object's jobs were cancelled.
+ */
+void py_interp_release(t_py* x)
+{
+#if PY_VERSION_HEX >= 0x030C0000
+    t_py_interp* interp = x->p_interp;
+    t_py_interp** link = NULL;
+    PyThreadState* tstate = NULL;
+
+    if (interp == NULL)
+        return;
+    x->p_interp = NULL;
+
+    systhread_mutex_lock(py_global_interp_mutex);
+    if (--interp->refcount > 0) {
+        systhread_mutex_unlock(py_global_interp_mutex);
+        return;
+    }
+    for (link = &py_global_interps; *link; link = &(*link)->next) {
+        if (*link == interp) {
+            *link = interp->next;
+            break;
+        }
+    }
+    systhread_mutex_unlock(py_global_interp_mutex);
+
+    // Py_EndInterpreter requires its thread state to be the last one
+    tstate = py_interp_tstate(interp);
+    PyEval_RestoreThread(tstate);
+    for (long i = 0; i < interp->nthreads; i++) {
+        if (interp->threads[i].tstate != tstate) {
+            PyThreadState_Clear(interp->threads[i].tstate);
+            PyThreadState_Delete(interp->threads[i].tstate);
+        }
+    }
+    Py_EndInterpreter(tstate);
+
+    if (interp->threads)
+        sysmem_freeptr(interp->threads);
+    sysmem_freeptr(interp);
+#endif
+}
+
+/**
+ * @brief Acquire the GIL of the object's interpreter (see `py_gil_ensure`)
+ *
+ * @param x pointer to object struct
+ * @return t_py_gil state to pass to `py_gil_release`
+ */
+static t_py_gil py_gil_acquire(t_py* x)
+{
+    t_py_gil gil = { PY_GIL_NONE, PyGILState_UNLOCKED, NULL, 0.0 };
+
+#if PY_VERSION_HEX >= 0x030C0000
+    PyInterpreterState* interp = x->p_interp ? x->p_interp->interp
+                                             : PyInterpreterState_Main();
+    PyThreadState* tstate = py_tstate_get();
+
+    if (tstate != NULL) {
+        if (PyThreadState_GetInterpreter(tstate) == interp)
+            return gil; // already running in this interpreter
+        gil.prev = PyEval_SaveThread();
+    }
+
+    if (x->p_interp != NULL) {
+        PyEval_RestoreThread(py_interp_tstate(x->p_interp));
+        gil.mode = PY_GIL_ENTERED;
+        return gil;
+    }
+
+    tstate = PyGILState_GetThisThreadState();
+    if (tstate != NULL && PyThreadState_GetInterpreter(tstate) != interp) {
+        // a thread started by python in a subinterpreter
+        PyEval_RestoreThread(PyThreadState_New(interp));
+        gil.mode = PY_GIL_TEMPORARY;
+        return gil;
+    }
+#endif
+
+    gil.gstate = PyGILState_Ensure();
+    gil.mode = PY_GIL_ENSURED;
+    return gil;
+}
+
+/**
+ * @brief Acquire the GIL of the object's interpreter
+ *
+ * @param x pointer to object struct
+ * @return t_py_gil state to pass to `py_gil_release`
+ *
+ * Replaces `PyGILState_Ensure`, which only knows the main interpreter. It
+ * can be called from any thread, also from python code running in another
+ * interpreter (e.g. `api` sending a message to an object), whose thread
+ * state is swapped out until `py_gil_release`. The time spent waiting is
+ * returned in `wait` for `stats`.
+ */
+t_py_gil py_gil_ensure(t_py* x)
+{
+    double start = systimer_gettime();
+    t_py_gil gil = py_gil_acquire(x);
+
+    gil.wait = systimer_gettime() - start;
+    return gil;
+}
+
+/**
+ * @brief Release the GIL acquired by `py_gil_ensure`
+ *
+ * @param x pointer to object struct
+ * @param gil state returned by `py_gil_ensure`
+ */
+void py_gil_release(t_py* x, t_py_gil gil)
+{
+    switch (gil.mode) {
+    case PY_GIL_ENSURED:
+        PyGILState_Release(gil.gstate);
+        break;
+    case PY_GIL_ENTERED:
+        PyEval_SaveThread();
+        break;
+    case PY_GIL_TEMPORARY:
+        PyThreadState_Clear(PyThreadState_Get());
+        PyThreadState_DeleteCurrent();
+        break;
+    default:
+        break;
+    }
+    if (gil.prev != NULL)
+        PyEval_RestoreThread(gil.prev);
+}
+
+/**
+ * @brief Setter of the `interpreter` attribute
+ *
+ * @param x pointer to object struct
+ * @param attr attribute
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ *
+ * The interpreter is chosen when the object is created, so it can only be
+ * set as an object argument.
+ */
+t_max_err py_interpreter_set(t_py* x, void* attr, long argc, t_atom* argv)
+{
+    t_symbol* s = (argc && argv) ? atom_getsym(argv) : gensym("");
+
+    if (x->p_globals != NULL) {
+        if (s != x->p_interpreter)
+            py_error(x, "@interpreter can only be set at object creation");
+        return MAX_ERR_GENERIC;
+    }
+    x->p_interpreter = s;
+    return MAX_ERR_NONE;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Worker Threads */
+
+/**
+ * @brief Worker thread loop: run ready jobs until the pool is stopped
+ *
+ * @param arg unused
+ * @return void* NULL
+ *
+ * Objects, not jobs, are queued in the shared ready list and an object is
+ * held by at most one worker at a time, which preserves the message order
+ * of each object while different objects run in parallel (subject to the
+ * GIL of their interpreter, see `py_interp_acquire`). The result is left in
+ * the job slot and `py_job_deliver` is scheduled on the main thread to
+ * output it.
+ */
+static void* py_worker_run(void* arg)
+{
+    t_py* x = NULL;
+    t_py_job* job = NULL;
+    t_py_gil gstate;
+    t_py_stats_span span;
+
+    systhread_mutex_lock(py_global_jobs_mutex);
+    for (;;) {
+        while (!py_global_workers_quit && py_global_jobs_head == NULL) {
+            systhread_cond_wait(py_global_jobs_ready, py_global_jobs_mutex);
+        }
+        if (py_global_workers_quit)
+            break;
+
+        x = py_global_jobs_head;
+        py_global_jobs_head = x->p_jobs_link;
+        if (py_global_jobs_head == NULL)
+            py_global_jobs_tail = NULL;
+        x->p_jobs_link = NULL;
+
+        job = x->p_jobs
+            + (x->p_jobs_head + x->p_jobs_next) % PY_JOB_QUEUE_SIZE;
+        job->state = PY_JOB_RUNNING;
+        systhread_mutex_unlock(py_global_jobs_mutex);
+
+        span = py_stats_begin(job->argc);
+        gstate = py_gil_ensure(x);
+        span.wait = gstate.wait;
+        job->pval = py_trace_value(x, job->sel, job->value, job->argc,
+                                   job->argv);
+        if (job->pval == NULL)
+            PyErr_Fetch(&job->err_type, &job->err_value, &job->err_tb);
+        py_gil_release(x, gstate);
+        py_stats_end(x, job->stats, &span,
+                     job->pval ? MAX_ERR_NONE : MAX_ERR_GENERIC);
+
+        systhread_mutex_lock(py_global_jobs_mutex);
+        job->state = PY_JOB_DONE;
+        x->p_jobs_next++;
+        if (x->p_jobs_next < x->p_jobs_count) {
+            // more jobs for this object: back of the ready list
+            if (py_global_jobs_tail)
+                py_global_jobs_tail->p_jobs_link = x;
+            else
+                py_global_jobs_head = x;
+            py_global_jobs_tail = x;
+        } else {
+            x->p_jobs_busy = 0;
+        }
+        qelem_set(x->p_jobs_qelem);
+        systhread_cond_broadcast(py_global_jobs_done);
+    }
+    systhread_mutex_unlock(py_global_jobs_mutex);
+    py_atom_arena_free();
+    systhread_exit(0);
+    return NULL;
+}
+
+/**
+ * @brief Start the shared worker pool if it is not running
+ *
+ * @return t_max_err error code
+ *
+ * Must be called with `py_global_jobs_mutex` held.
+ */
+t_max_err py_workers_start(void)
+{
+    if (py_global_workers_running)
+        return MAX_ERR_NONE;
+
+    py_global_workers_quit = 0;
+    for (int i = 0; i < PY_WORKER_THREADS; i++) {
+        if (systhread_create((method)py_worker_run, NULL, 0, 0, 0,
+                             py_global_workers + i)
+            != 0) {
+            error("py: could not create worker thread");
+            py_global_workers_running = i;
+            return i ? MAX_ERR_NONE : MAX_ERR_GENERIC;
+        }
+    }
+    py_global_workers_running = PY_WORKER_THREADS;
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Stop and join the shared worker pool
+ *
+ * Called when the last object is freed, without holding the GIL.
+ */
+void py_workers_stop(void)
+{
+    unsigned int retval = 0;
+    int running = 0;
+
+    if (py_global_jobs_mutex == NULL)
+        return;
+
+    systhread_mutex_lock(py_global_jobs_mutex);
+    running = py_global_workers_running;
+    py_global_workers_quit = 1;
+    py_global_workers_running = 0;
+    systhread_cond_broadcast(py_global_jobs_ready);
+    systhread_mutex_unlock(py_global_jobs_mutex);
+
+    for (int i = 0; i < running; i++) {
+        systhread_join(py_global_workers[i], &retval);
+    }
+}
+
+/**
+ * @brief Queue a message to run on the worker pool
+ *
+ * @param x pointer to object struct
+ * @param s message selector
+ * @param argc atom argument count
+ * @param argv atom argument vector (copied)
+ * @param value computes the python result on a worker (GIL held)
+ * @param done outputs the result on the main thread (GIL held)
+ * @param stats PY_STATS_* under which the worker records the message
+ * @return t_max_err error code
+ *
+ * At most `queue` jobs wait to run per object. When the queue is full, the
+ * new job is dropped, or with `@overflow coalesce` it replaces the arguments
+ * of the newest waiting job with the same selector and first atom (e.g. the
+ * same `call` function), so that the latest value wins. Dropped jobs are
+ * counted in the read-only `dropped` attribute.
+ */
+t_max_err py_job_post(t_py* x, t_symbol* s, long argc, t_atom* argv,
+                      t_py_job_value value, t_py_job_done done, long stats)
+{
+    t_py_job* job = NULL;
+    long waiting = 0;
+
+    systhread_mutex_lock(py_global_jobs_mutex);
+
+    waiting = x->p_jobs_count - x->p_jobs_next;
+    if (waiting >= x->p_queue || x->p_jobs_count >= PY_JOB_QUEUE_SIZE) {
+        if (x->p_overflow == gensym("coalesce") && argc > 0) {
+            for (long i = x->p_jobs_count - 1; i >= x->p_jobs_next; i--) {
+                t_py_job* pending = x->p_jobs
+                    + (x->p_jobs_head + i) % PY_JOB_QUEUE_SIZE;
+                if (pending->state == PY_JOB_PENDING && pending->sel == s
+                    && pending->argc > 0 && atom_gettype(argv) == A_SYM
+                    && atom_gettype(pending->argv) == A_SYM
+                    && atom_getsym(pending->argv) == atom_getsym(argv)) {
+                    job = pending;
+                    break;
+                }
+            }
+        }
+        if (job == NULL) {
+            x->p_dropped++;
+            systhread_mutex_unlock(py_global_jobs_mutex);
+            py_trace(x, PY_TRACE_DROP, (t_ptr_int)s, x->p_dropped, 0.0);
+            return MAX_ERR_GENERIC;
+        }
+    } else {
+        job = x->p_jobs
+            + (x->p_jobs_head + x->p_jobs_count) % PY_JOB_QUEUE_SIZE;
+        x->p_jobs_count++;
+    }
+
+    if (argc > job->argv_size) {
+        t_atom* atoms = (t_atom*)sysmem_resizeptr(job->argv,
+                                                  argc * sizeof(t_atom));
+        if (atoms == NULL) {
+            // give the slot back unless it was coalesced
+            if (job->state != PY_JOB_PENDING)
+                x->p_jobs_count--;
+            systhread_mutex_unlock(py_global_jobs_mutex);
+            py_error(x, "could not queue %s", s->s_name);
+            return MAX_ERR_OUT_OF_MEM;
+        }
+        job->argv = atoms;
+        job->argv_size = argc;
+    }
+    if (argc > 0)
+        sysmem_copyptr(argv, job->argv, argc * sizeof(t_atom));
+    job->argc = argc;
+    job->sel = s;
+    job->value = value;
+    job->done = done;
+    job->stats = stats;
+    job->state = PY_JOB_PENDING;
+
+    if (!x->p_jobs_busy) {
+        x->p_jobs_busy = 1;
+        if (py_global_jobs_tail)
+            py_global_jobs_tail->p_jobs_link = x;
+        else
+            py_global_jobs_head = x;
+        py_global_jobs_tail = x;
+        systhread_cond_signal(py_global_jobs_ready);
+    }
+
+    py_workers_start();
+    systhread_mutex_unlock(py_global_jobs_mutex);
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Output the results of finished jobs in message order
+ *
+ * @param x pointer to object struct
+ *
+ * Runs on the main thread from the object's qelem, so outlets never fire
+ * on a worker thread.
+ */
+void py_job_deliver(t_py* x)
+{
+    t_py_job* job = NULL;
+    t_py_gil gstate;
+
+    for (;;) {
+        systhread_mutex_lock(py_global_jobs_mutex);
+        job = x->p_jobs + x->p_jobs_head;
+        if (x->p_jobs_count == 0 || job->state != PY_JOB_DONE) {
+            systhread_mutex_unlock(py_global_jobs_mutex);
+            break;
+        }
+        systhread_mutex_unlock(py_global_jobs_mutex);
+
+        // a done slot is not touched by workers or producers
+        gstate = py_gil_ensure(x);
+        if (job->pval == NULL)
+            PyErr_Restore(job->err_type, job->err_value, job->err_tb);
+        x->p_jobs_delivering = 1;
+        job->done(x, job->argc, job->argv, job->pval); // steals pval
+        x->p_jobs_delivering = 0;
+        PyErr_Clear();
+        py_gil_release(x, gstate);
+        job->pval = NULL;
+        job->err_type = job->err_value = job->err_tb = NULL;
+
+        systhread_mutex_lock(py_global_jobs_mutex);
+        job->state = PY_JOB_FREE;
+        x->p_jobs_head = (x->p_jobs_head + 1) % PY_JOB_QUEUE_SIZE;
+        x->p_jobs_count--;
+        x->p_jobs_next--;
+        systhread_mutex_unlock(py_global_jobs_mutex);
+    }
+}
+
+/**
+ * @brief Finish and output the object's queued jobs
+ *
+ * @param x pointer to object struct
+ *
+ * Messages which use the namespace but do not run on workers (`execfile`,
+ * `load`, `run`, `reset`, `async` and `@run_on_save`) call this first.
+ * They then see the namespace as left by all earlier messages, and their
+ * output follows the earlier results. The main thread blocks until the
+ * object's jobs are done. Nothing is done on other threads, while python
+ * runs on this thread, or while a result is output, as waiting there
+ * could deadlock.
+ *
+ * Called without holding the GIL.
+ */
+void py_job_flush(t_py* x)
+{
+    if (py_global_jobs_mutex == NULL || x->p_jobs_delivering
+        || !systhread_ismainthread() || py_tstate_get() != NULL)
+        return;
+
+    systhread_mutex_lock(py_global_jobs_mutex);
+    if (x->p_jobs_count == 0) {
+        systhread_mutex_unlock(py_global_jobs_mutex);
+        return;
+    }
+    while (x->p_jobs_next < x->p_jobs_count) {
+        systhread_cond_wait(py_global_jobs_done, py_global_jobs_mutex);
+    }
+    systhread_mutex_unlock(py_global_jobs_mutex);
+    py_job_deliver(x);
+}
+
+/**
+ * @brief Wait for a running job of an object and discard its other jobs
+ *
+ * @param x pointer to object struct
+ *
+ * Called from `py_free` without holding the GIL.
+ */
+void py_job_cancel(t_py* x)
+{
+    t_py_gil gstate;
+    t_py_job* job = NULL;
+    t_py** link = NULL;
+
+    if (py_global_jobs_mutex == NULL)
+        return;
+
+    systhread_mutex_lock(py_global_jobs_mutex);
+    for (;;) {
+        int running = 0;
+        for (long i = 0; i < x->p_jobs_count; i++) {
+            job = x->p_jobs + (x->p_jobs_head + i) % PY_JOB_QUEUE_SIZE;
+            running |= job->state == PY_JOB_RUNNING;
+        }
+        if (!running)
+            break;
+        systhread_cond_wait(py_global_jobs_done, py_global_jobs_mutex);
+    }
+
+    // unlink from the ready list
+    py_global_jobs_tail = NULL;
+    for (link = &py_global_jobs_head; *link; link = &(*link)->p_jobs_link) {
+        if (*link == x)
+            *link = x->p_jobs_link;
+        if (*link == NULL)
+            break;
+        py_global_jobs_tail = *link;
+    }
+    x->p_jobs_busy = 0;
+    x->p_jobs_count = 0;
+    x->p_jobs_next = 0;
+    systhread_mutex_unlock(py_global_jobs_mutex);
+
+    gstate = py_gil_ensure(x);
+    for (int i = 0; i < PY_JOB_QUEUE_SIZE; i++) {
+        job = x->p_jobs + i;
+        Py_CLEAR(job->pval);
+        Py_CLEAR(job->err_type);
+        Py_CLEAR(job->err_value);
+        Py_CLEAR(job->err_tb);
+        if (job->argv)
+            sysmem_freeptr(job->argv);
+        job->argv = NULL;
+        job->state = PY_JOB_FREE;
+    }
+    py_gil_release(x, gstate);
+}
+
+/*--------------------------------------------------------------------------*/
+/* Tracing */
+
+/**
+ * @brief Full memory barrier around the payload of a trace event
+ */
+static inline void py_trace_fence(void)
+{
+#if defined(_MSC_VER)
+    MemoryBarrier();
+#else
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+}
+
+/**
+ * @brief Record a trace event
+ *
+ * @param x pointer to object struct
+ * @param id PY_TRACE_* event
+ * @param a first raw argument (symbol pointer or integer)
+ * @param b second raw argument (symbol pointer or integer)
+ * @param f float argument
+ *
+ * Costs a flag test when `@tracing` is off and otherwise an atomic
+ * increment and a few stores into the object's ring of the last
+ * PY_TRACE_SIZE events: there is no lock, allocation or formatting, so it
+ * can be called from any thread and in per-item loops. Arguments are only
+ * interpreted by `trace dump` (see `py_trace_defs`): symbols are recorded
+ * as pointers since they are never freed, strings by length.
+ */
+void py_trace(t_py* x, long id, t_ptr_int a, t_ptr_int b, double f)
+{
+    t_py_trace_event* event = NULL;
+    uint32_t seq = 0;
+
+    if (!x->p_tracing || x->p_trace_ring == NULL)
+        return;
+
+    seq = (uint32_t)ATOMIC_INCREMENT_BARRIER(&x->p_trace_head);
+    event = x->p_trace_ring + ((seq - 1) & (PY_TRACE_SIZE - 1));
+
+    // readers skip the slot until its sequence number is stored again
+    event->seq = 0;
+    py_trace_fence();
+    event->id = id;
+    event->thread = systhread_self();
+    event->time = systimer_gettime();
+    event->a = a;
+    event->b = b;
+    event->f = f;
+    py_trace_fence();
+    event->seq = seq;
+}
+
+/**
+ * @brief Compute the value of a message between begin and end events
+ *
+ * @param x pointer to object struct
+ * @param s message selector
+ * @param value computes the python result (GIL held)
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return PyObject* result of value
+ */
+PyObject* py_trace_value(t_py* x, t_symbol* s, t_py_job_value value,
+                         long argc, t_atom* argv)
+{
+    PyObject* pval = NULL;
+    t_symbol* arg = NULL;
+
+    if (!x->p_tracing)
+        return value(x, argc, argv);
+
+    if (argc > 0 && atom_gettype(argv) == A_SYM)
+        arg = atom_getsym(argv);
+
+    py_trace(x, PY_TRACE_BEGIN, (t_ptr_int)s, (t_ptr_int)arg, (double)argc);
+    pval = value(x, argc, argv);
+    py_trace(x, PY_TRACE_END, (t_ptr_int)s, pval != NULL, 0.0);
+    return pval;
+}
+
+/**
+ * @brief Setter of the `tracing` attribute
+ *
+ * @param x pointer to object struct
+ * @param attr attribute
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ *
+ * The event ring is allocated when tracing is first enabled and kept until
+ * the object is freed, so events can still be dumped after `@tracing 0`.
+ */
+t_max_err py_tracing_set(t_py* x, void* attr, long argc, t_atom* argv)
+{
+    t_bool tracing = (argc && argv) ? atom_getlong(argv) != 0 : 0;
+
+    if (tracing && x->p_trace_ring == NULL) {
+        x->p_trace_ring = (t_py_trace_event*)sysmem_newptrclear(
+            PY_TRACE_SIZE * sizeof(t_py_trace_event));
+        if (x->p_trace_ring == NULL) {
+            py_error(x, "could not allocate trace events");
+            return MAX_ERR_OUT_OF_MEM;
+        }
+        py_trace_fence();
+    }
+    x->p_tracing = tracing;
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Copy the events recorded since the last `trace clear` in order
+ *
+ * @param x pointer to object struct
+ * @param events destination for up to PY_TRACE_SIZE events
+ * @return long number of events copied
+ *
+ * Slots which are being written or were overwritten during the copy are
+ * skipped.
+ */
+static long py_trace_snapshot(t_py* x, t_py_trace_event* events)
+{
+    t_py_trace_event* event = NULL;
+    uint32_t head = 0;
+    uint32_t seq = 0;
+    long n = 0;
+
+    if (x->p_trace_ring == NULL)
+        return 0;
+
+    py_trace_fence();
+    head = (uint32_t)x->p_trace_head;
+    seq = x->p_trace_mark + 1;
+    if (head - x->p_trace_mark > PY_TRACE_SIZE)
+        seq = head - PY_TRACE_SIZE + 1;
+
+    for (; seq != head + 1; seq++) {
+        event = x->p_trace_ring + ((seq - 1) & (PY_TRACE_SIZE - 1));
+        if (event->seq != seq)
+            continue;
+        py_trace_fence();
+        events[n] = *event;
+        py_trace_fence();
+        if (event->seq == seq && events[n].id >= 0
+            && events[n].id < PY_TRACE_EVENTS)
+            n++;
+    }
+    return n;
+}
+
+/**
+ * @brief Name of a trace event
+ *
+ * @param event recorded event
+ * @return const char* event name
+ */
+static const char* py_trace_name(t_py_trace_event* event)
+{
+    const t_py_trace_def* def = py_trace_defs + event->id;
+    t_symbol* s = (t_symbol*)event->a;
+
+    if (def->name)
+        return def->name;
+    return (s && s->s_name[0]) ? s->s_name : "message";
+}
+
+/**
+ * @brief Format an argument of a trace event
+ *
+ * @param event recorded event
+ * @param i argument index: 0 for a, 1 for b, 2 for f
+ * @param buf destination
+ * @param size size of destination
+ * @return char kind of the argument, '-' if unused
+ */
+static char py_trace_arg(t_py_trace_event* event, int i, char* buf,
+                         size_t size)
+{
+    const t_py_trace_def* def = py_trace_defs + event->id;
+    t_ptr_int v = i == 0 ? event->a : event->b;
+    t_symbol* s = NULL;
+
+    if (def->args[i] == NULL)
+        return '-';
+
+    switch (def->kinds[i]) {
+    case 's':
+        s = (t_symbol*)v;
+        snprintf(buf, size, "%s", s ? s->s_name : "");
+        break;
+    case 'f':
+        snprintf(buf, size, "%.3f", event->f);
+        break;
+    default:
+        snprintf(buf, size, "%ld", i == 2 ? (long)event->f : (long)v);
+        break;
+    }
+    return def->kinds[i];
+}
+
+/**
+ * @brief Small id of the thread of a trace event
+ *
+ * @param threads threads seen so far
+ * @param count number of threads seen so far
+ * @param thread thread of the event
+ * @return long 1-based thread id
+ */
+static long py_trace_thread(t_systhread* threads, long* count,
+                            t_systhread thread)
+{
+    for (long i = 0; i < *count; i++) {
+        if (threads[i] == thread)
+            return i + 1;
+    }
+    if (*count == PY_WORKER_THREADS + 2)
+        return *count;
+    threads[(*count)++] = thread;
+    return *count;
+}
+
+/**
+ * @brief Write a json string
+ *
+ * @param f open file
+ * @param str string to escape
+ */
+static void py_trace_json_string(FILE* f, const char* str)
+{
+    fputc('"', f);
+    for (; *str; str++) {
+        unsigned char c = (unsigned char)*str;
+        if (c == '"' || c == '\\')
+            fprintf(f, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(f, "\\u%04x", c);
+        else
+            fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+/**
+ * @brief Format recorded trace events to the console or a file
+ *
+ * @param x pointer to object struct
+ * @param path file to write or NULL to post to the console
+ * @return t_max_err error code
+ *
+ * Files are written in the chrome trace event format, which can be opened
+ * with `chrome://tracing` or https://ui.perfetto.dev. Timestamps are in
+ * microseconds from the first event and threads are numbered in order of
+ * appearance.
+ */
+t_max_err py_trace_dump(t_py* x, t_symbol* path)
+{
+    t_py_trace_event* events = NULL;
+    t_systhread threads[PY_WORKER_THREADS + 2];
+    long nthreads = 0;
+    long n = 0;
+    double start = 0.0;
+    char native[MAX_PATH_CHARS];
+    char value[PY_MAX_LOG_CHAR];
+    char line[PY_MAX_LOG_CHAR];
+    FILE* f = NULL;
+    t_max_err err = MAX_ERR_NONE;
+
+    events = (t_py_trace_event*)sysmem_newptr(PY_TRACE_SIZE
+                                              * sizeof(t_py_trace_event));
+    if (events == NULL)
+        return MAX_ERR_OUT_OF_MEM;
+
+    n = py_trace_snapshot(x, events);
+    for (long i = 0; i < n; i++) {
+        if (i == 0 || events[i].time < start)
+            start = events[i].time;
+    }
+
+    if (path == NULL) {
+        post("[py %s]: trace: %ld events", x->p_name->s_name, n);
+        for (long i = 0; i < n; i++) {
+            t_py_trace_event* event = events + i;
+            int len = snprintf(line, sizeof(line), "%10.3f ms t%ld %c %s",
+                               event->time - start,
+                               py_trace_thread(threads, &nthreads,
+                                               event->thread),
+                               py_trace_defs[event->id].phase,
+                               py_trace_name(event));
+            for (int j = 0; j < 3 && len < (int)sizeof(line); j++) {
+                if (py_trace_arg(event, j, value, sizeof(value)) == '-')
+                    continue;
+                len += snprintf(line + len, sizeof(line) - len, " %s=%s",
+                                py_trace_defs[event->id].args[j], value);
+            }
+            post("[py %s]: %s", x->p_name->s_name, line);
+        }
+        goto finally;
+    }
+
+    path_nameconform(path->s_name, native, PATH_STYLE_NATIVE,
+                     PATH_TYPE_ABSOLUTE);
+    f = fopen(native, "w");
+    if (f == NULL) {
+        py_error(x, "trace: could not open %s", native);
+        err = MAX_ERR_GENERIC;
+        goto finally;
+    }
+
+    fputs("{\"traceEvents\":[", f);
+    for (long i = 0; i < n; i++) {
+        t_py_trace_event* event = events + i;
+        char kind = 0;
+
+        fputs(i ? ",\n{\"name\":" : "\n{\"name\":", f);
+        py_trace_json_string(f, py_trace_name(event));
+        fprintf(f, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%ld",
+                py_trace_defs[event->id].phase,
+                (event->time - start) * 1000.0,
+                py_trace_thread(threads, &nthreads, event->thread));
+        if (py_trace_defs[event->id].phase == 'i')
+            fputs(",\"s\":\"t\"", f);
+        fputs(",\"args\":{", f);
+        for (int j = 0, first = 1; j < 3; j++) {
+            kind = py_trace_arg(event, j, value, sizeof(value));
+            if (kind == '-')
+                continue;
+            fprintf(f, "%s\"%s\":", first ? "" : ",",
+                    py_trace_defs[event->id].args[j]);
+            if (kind == 's')
+                py_trace_json_string(f, value);
+            else
+                fputs(value, f);
+            first = 0;
+        }
+        fputs("}}", f);
+    }
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", f);
+
+    if (fclose(f) != 0) {
+        py_error(x, "trace: could not write %s", native);
+        err = MAX_ERR_GENERIC;
+        goto finally;
+    }
+    py_log(x, "trace: %ld events written to %s", n, native);
+
+finally:
+    sysmem_freeptr(events);
+    return err;
+}
+
+/**
+ * @brief Dump or clear recorded trace events
+ *
+ * @param x pointer to object struct
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ *
+ * `trace dump` posts the events recorded while `@tracing` is on,
+ * `trace dump <file>` writes them as chrome trace event json and
+ * `trace clear` forgets them.
+ */
+t_max_err py_trace_msg(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_symbol* cmd = argc > 0 ? atom_getsym(argv) : gensym("dump");
+
+    if (cmd == gensym("dump")) {
+        if (argc > 1 && atom_gettype(argv + 1) == A_SYM)
+            return py_trace_dump(x, atom_getsym(argv + 1));
+        return py_trace_dump(x, NULL);
+    }
+
+    if (cmd == gensym("clear")) {
+        py_trace_fence();
+        x->p_trace_mark = (uint32_t)x->p_trace_head;
+        return MAX_ERR_NONE;
+    }
+
+    py_error(x, "trace: unknown command %s, use dump or clear",
+             cmd->s_name);
+    return MAX_ERR_GENERIC;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Stats */
+
+/**
+ * @brief Add to a counter shared between threads
+ *
+ * @param counter counter
+ * @param n amount to add
+ */
+static inline void py_stats_add(volatile int64_t* counter, int64_t n)
+{
+#if defined(_MSC_VER)
+    InterlockedExchangeAdd64(counter, n);
+#else
+    __atomic_fetch_add(counter, n, __ATOMIC_RELAXED);
+#endif
+}
+
+/**
+ * @brief Raise a maximum shared between threads
+ *
+ * @param max current maximum
+ * @param n new value
+ */
+static inline void py_stats_raise(volatile int64_t* max, int64_t n)
+{
+    int64_t cur = *max;
+
+    while (n > cur) {
+#if defined(_MSC_VER)
+        int64_t prev = InterlockedCompareExchange64(max, n, cur);
+        if (prev == cur)
+            break;
+        cur = prev;
+#else
+        if (__atomic_compare_exchange_n(max, &cur, n, 1, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED))
+            break;
+#endif
+    }
+}
+
+/**
+ * @brief Histogram bucket of a duration
+ *
+ * @param ns duration in nanoseconds
+ * @return long bucket index
+ *
+ * Durations below 2^(PY_STATS_SUB_BITS + 1) ns have a bucket each, longer
+ * ones share 2^PY_STATS_SUB_BITS buckets per power of 2, so a bucket is
+ * within 12.5% of the durations it counts (HDR histogram layout).
+ */
+static inline long py_stats_bucket(int64_t ns)
+{
+    unsigned long e = 0;
+
+    if (ns < (2 << PY_STATS_SUB_BITS))
+        return ns < 0 ? 0 : (long)ns;
+
+#if defined(_MSC_VER)
+    _BitScanReverse64(&e, (unsigned __int64)ns);
+#else
+    e = 63 - __builtin_clzll((unsigned long long)ns);
+#endif
+    if (e > PY_STATS_MAX_EXP)
+        return PY_STATS_BUCKETS - 1;
+
+    return (2 << PY_STATS_SUB_BITS)
+        + ((long)(e - PY_STATS_SUB_BITS - 1) << PY_STATS_SUB_BITS)
+        + (long)((ns >> (e - PY_STATS_SUB_BITS))
+                 & ((1 << PY_STATS_SUB_BITS) - 1));
+}
+
+/**
+ * @brief Middle of the durations counted by a histogram bucket
+ *
+ * @param bucket bucket index
+ * @return double duration in nanoseconds
+ */
+static double py_stats_bucket_value(long bucket)
+{
+    long e = 0;
+    long sub = 0;
+
+    if (bucket < (2 << PY_STATS_SUB_BITS))
+        return (double)bucket;
+
+    bucket -= 2 << PY_STATS_SUB_BITS;
+    e = (bucket >> PY_STATS_SUB_BITS) + PY_STATS_SUB_BITS + 1;
+    sub = bucket & ((1 << PY_STATS_SUB_BITS) - 1);
+    return (double)(((1LL << PY_STATS_SUB_BITS) + sub)
+                    << (e - PY_STATS_SUB_BITS))
+        + (double)(1LL << (e - PY_STATS_SUB_BITS)) / 2.0;
+}
+
+/**
+ * @brief Start timing a method
+ *
+ * @param atoms number of atoms converted by the method
+ * @return t_py_stats_span span to pass to `py_stats_end`
+ *
+ * Set `wait` of the span from the `t_py_gil` returned by `py_gil_ensure`.
+ */
+t_py_stats_span py_stats_begin(long atoms)
+{
+    t_py_stats_span span = { systimer_gettime(), 0.0, atoms };
+    return span;
+}
+
+/**
+ * @brief Record the wall time, gil wait and outcome of a method
+ *
+ * @param x pointer to object struct
+ * @param id PY_STATS_* method
+ * @param span span returned by `py_stats_begin`
+ * @param err error code of the method
+ * @return t_max_err err, to be returned by the method
+ *
+ * Safe to call from any thread: counters and histogram buckets are updated
+ * atomically, without locks or allocation.
+ */
+t_max_err py_stats_end(t_py* x, long id, t_py_stats_span* span,
+                       t_max_err err)
+{
+    t_py_stats_entry* entry = NULL;
+    int64_t wall = 0;
+    int64_t wait = 0;
+
+    if (x->p_stats == NULL)
+        return err;
+
+    entry = x->p_stats + id;
+    wall = (int64_t)((systimer_gettime() - span->start) * 1e6);
+    wait = (int64_t)(span->wait * 1e6);
+
+    py_stats_add(&entry->count, 1);
+    py_stats_add(&entry->wall_total, wall);
+    if (err != MAX_ERR_NONE)
+        py_stats_add(&entry->errors, 1);
+    if (span->atoms)
+        py_stats_add(&entry->atoms, span->atoms);
+    py_stats_raise(&entry->wall_max, wall);
+    py_stats_raise(&entry->wait_max, wait);
+    ATOMIC_INCREMENT(&entry->wall[py_stats_bucket(wall)]);
+    ATOMIC_INCREMENT(&entry->wait[py_stats_bucket(wait)]);
+    return err;
+}
+
+/**
+ * @brief Count atoms converted by a method outside of its span
+ *
+ * @param x pointer to object struct
+ * @param id PY_STATS_* method
+ * @param atoms number of atoms
+ */
+void py_stats_atoms(t_py* x, long id, long atoms)
+{
+    if (x->p_stats != NULL)
+        py_stats_add(&x->p_stats[id].atoms, atoms);
+}
+
+/**
+ * @brief Percentile of a histogram
+ *
+ * @param hist histogram buckets
+ * @param count number of recorded durations
+ * @param max longest recorded duration in ns
+ * @param p percentile between 0 and 1
+ * @return double duration in ms
+ */
+static double py_stats_percentile(t_int32_atomic* hist, int64_t count,
+                                  int64_t max, double p)
+{
+    int64_t rank = (int64_t)(p * (double)count + 0.5);
+    int64_t seen = 0;
+    double ns = 0.0;
+
+    if (count == 0)
+        return 0.0;
+    if (rank < 1)
+        rank = 1;
+
+    for (long i = 0; i < PY_STATS_BUCKETS; i++) {
+        seen += hist[i];
+        if (seen >= rank) {
+            ns = py_stats_bucket_value(i);
+            break;
+        }
+    }
+    if (ns > (double)max || seen < rank)
+        ns = (double)max;
+    return ns / 1e6;
+}
+
+/**
+ * @brief Summarize a histogram into a dictionary
+ *
+ * @param d dictionary to fill
+ * @param hist histogram buckets
+ * @param count number of recorded durations
+ * @param max longest recorded duration in ns
+ */
+static void py_stats_hist_to_dictionary(t_dictionary* d, t_int32_atomic* hist,
+                                        int64_t count, int64_t max)
+{
+    dictionary_appendfloat(d, gensym("p50"),
+                           py_stats_percentile(hist, count, max, 0.50));
+    dictionary_appendfloat(d, gensym("p99"),
+                           py_stats_percentile(hist, count, max, 0.99));
+    dictionary_appendfloat(d, gensym("max"), (double)max / 1e6);
+}
+
+/**
+ * @brief Fill a dictionary with the stats of an object
+ *
+ * @param x pointer to object struct
+ * @param d dictionary to fill
+ * @return t_max_err error code
+ *
+ * Each method has a sub-dictionary with `count`, `errors`, `atoms` and
+ * `wall` and `gil` dictionaries of `p50`, `p99` and `max` times in ms.
+ * `wall` also has the `total` time, to find the objects which take the
+ * most scheduler time.
+ */
+t_max_err py_stats_to_dictionary(t_py* x, t_dictionary* d)
+{
+    t_py_stats_entry* entry = NULL;
+    t_dictionary* sub = NULL;
+    t_dictionary* hist = NULL;
+
+    if (x->p_stats == NULL)
+        return MAX_ERR_GENERIC;
+
+    dictionary_appendsym(d, gensym("name"), x->p_name);
+    for (long i = 0; i < PY_STATS_METHODS; i++) {
+        entry = x->p_stats + i;
+        sub = dictionary_new();
+        if (sub == NULL)
+            return MAX_ERR_OUT_OF_MEM;
+        dictionary_appendlong(sub, gensym("count"), entry->count);
+        dictionary_appendlong(sub, gensym("errors"), entry->errors);
+        dictionary_appendlong(sub, gensym("atoms"), entry->atoms);
+
+        hist = dictionary_new();
+        py_stats_hist_to_dictionary(hist, entry->wall, entry->count,
+                                    entry->wall_max);
+        dictionary_appendfloat(hist, gensym("total"),
+                               (double)entry->wall_total / 1e6);
+        dictionary_appenddictionary(sub, gensym("wall"), (t_object*)hist);
+
+        hist = dictionary_new();
+        py_stats_hist_to_dictionary(hist, entry->wait, entry->count,
+                                    entry->wait_max);
+        dictionary_appenddictionary(sub, gensym("gil"), (t_object*)hist);
+
+        dictionary_appenddictionary(d, gensym(py_stats_names[i]),
+                                    (t_object*)sub);
+    }
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Output or reset the latency stats of the object
+ *
+ * @param x pointer to object struct
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ *
+ * `stats` outputs `dictionary <name>` from the left outlet, `stats reset`
+ * clears the counters. Stats are recorded for every message whether or not
+ * they are output.
+ */
+t_max_err py_stats(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_atom name;
+
+    if (argc > 0 && atom_getsym(argv) == gensym("reset")) {
+        if (x->p_stats)
+            memset(x->p_stats, 0,
+                   PY_STATS_METHODS * sizeof(t_py_stats_entry));
+        return MAX_ERR_NONE;
+    }
+
+    if (argc > 0) {
+        py_error(x, "stats: unknown command %s, use reset",
+                 atom_getsym(argv)->s_name);
+        return MAX_ERR_GENERIC;
+    }
+
+    if (x->p_stats_dict == NULL) {
+        x->p_stats_dict = dictobj_register(dictionary_new(),
+                                           &x->p_stats_dict_name);
+    } else {
+        dictionary_clear(x->p_stats_dict);
+    }
+
+    if (x->p_stats_dict == NULL
+        || py_stats_to_dictionary(x, x->p_stats_dict) != MAX_ERR_NONE) {
+        py_error(x, "stats: could not fill dictionary");
+        return MAX_ERR_GENERIC;
+    }
+
+    atom_setsym(&name, x->p_stats_dict_name);
+    outlet_anything(x->p_outlet_left, gensym("dictionary"), 1, &name);
+    return MAX_ERR_NONE;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Recording */
+
+/**
+ * @brief Mark the calling thread as making an internal call on an object
+ *
+ * @param x pointer to object struct or NULL
+ * @return t_py* previous object, to be restored after the call
+ *
+ * Methods that are reached from another method of the same object, such
+ * as `py_call` from a scheduled call or `py_assign` from `py_anything`,
+ * are not recorded while the mark is set, so a replay does not run them
+ * twice.
+ */
+t_py* py_record_mute(t_py* x)
+{
+    t_py* inner = py_record_inner;
+    py_record_inner = x;
+    return inner;
+}
+
+/**
+ * @brief Record a message with a single symbol argument
+ *
+ * @param x pointer to object struct
+ * @param s message selector
+ * @param arg argument, left out when it is the empty symbol
+ */
+static void py_record_sym(t_py* x, t_symbol* s, t_symbol* arg)
+{
+    t_atom atom;
+
+    if (x->p_record == NULL)
+        return;
+    atom_setsym(&atom, arg);
+    py_record(x, s, arg != gensym("") ? 1 : 0, &atom);
+}
+
+static void py_record_varint(FILE* f, unsigned long long n)
+{
+    while (n >= 0x80) {
+        putc((int)(n & 0x7f) | 0x80, f);
+        n >>= 7;
+    }
+    putc((int)n, f);
+}
+
+static void py_record_zigzag(FILE* f, long long n)
+{
+    py_record_varint(f, ((unsigned long long)n << 1)
+                            ^ (unsigned long long)(n >> 63));
+}
+
+/**
+ * @brief Write a symbol to the record log, defining it on first use
+ *
+ * @param x pointer to object struct
+ * @param s symbol
+ * @return t_atom_long id of the symbol in the log
+ *
+ * Must be called with `p_record_mutex` held.
+ */
+static t_atom_long py_record_symbol(t_py* x, t_symbol* s)
+{
+    t_atom_long id = 0;
+    size_t len = 0;
+
+    if (hashtab_lookuplong(x->p_record_syms, s, &id) == MAX_ERR_NONE)
+        return id;
+
+    id = (t_atom_long)hashtab_getsize(x->p_record_syms);
+    hashtab_storelong(x->p_record_syms, s, id);
+    len = strlen(s->s_name);
+    putc(PY_RECORD_SYMBOL, x->p_record);
+    py_record_varint(x->p_record, (unsigned long long)id);
+    py_record_varint(x->p_record, len);
+    fwrite(s->s_name, 1, len, x->p_record);
+    return id;
+}
+
+/**
+ * @brief Append an inbound message to the record log of the object
+ *
+ * @param x pointer to object struct
+ * @param s message selector
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ *
+ * Does nothing unless the object is recording. Writes go to a stdio buffer
+ * of PY_RECORD_BUFFER bytes, so most messages cost a lock and a few bytes
+ * of encoding.
+ */
+void py_record(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_atom_long sel = 0;
+    double time = 0.0;
+    double value = 0.0;
+
+    if (x->p_record == NULL || py_record_inner == x)
+        return;
+
+    clock_getftime(&time);
+    systhread_mutex_lock(x->p_record_mutex);
+    if (x->p_record == NULL)
+        goto finally;
+
+    // define new symbols before the message that uses them
+    sel = py_record_symbol(x, s);
+    for (long i = 0; i < argc; i++) {
+        if (atom_gettype(argv + i) == A_SYM)
+            py_record_symbol(x, atom_getsym(argv + i));
+    }
+
+    putc(PY_RECORD_MESSAGE, x->p_record);
+    py_record_zigzag(x->p_record,
+                     llround((time - x->p_record_time) * 1000.0));
+    py_record_varint(x->p_record, (unsigned long long)sel);
+    py_record_varint(x->p_record, (unsigned long long)argc);
+    for (long i = 0; i < argc; i++) {
+        switch (atom_gettype(argv + i)) {
+        case A_LONG:
+            putc(PY_RECORD_LONG, x->p_record);
+            py_record_zigzag(x->p_record, atom_getlong(argv + i));
+            break;
+        case A_FLOAT:
+            value = atom_getfloat(argv + i);
+            putc(PY_RECORD_FLOAT, x->p_record);
+            fwrite(&value, sizeof(double), 1, x->p_record);
+            break;
+        case A_SYM:
+            putc(PY_RECORD_SYM, x->p_record);
+            py_record_varint(x->p_record, (unsigned long long)
+                             py_record_symbol(x, atom_getsym(argv + i)));
+            break;
+        default:
+            // keep the atom count: unknown atoms are replayed as 0
+            putc(PY_RECORD_LONG, x->p_record);
+            py_record_zigzag(x->p_record, 0);
+            break;
+        }
+    }
+    x->p_record_time = time;
+    x->p_record_count++;
+
+finally:
+    systhread_mutex_unlock(x->p_record_mutex);
+}
+
+/**
+ * @brief Start recording inbound messages to a file
+ *
+ * @param x pointer to object struct
+ * @param path path of the record log, replaced if it exists
+ * @return t_max_err error code
+ *
+ * A recording in progress is stopped first.
+ */
+t_max_err py_record_start(t_py* x, t_symbol* path)
+{
+    char native[MAX_PATH_CHARS];
+    unsigned char version = PY_RECORD_VERSION;
+    FILE* f = NULL;
+    double time = 0.0;
+
+    py_record_stop(x);
+
+    path_nameconform(path->s_name, native, PATH_STYLE_NATIVE,
+                     PATH_TYPE_ABSOLUTE);
+    f = fopen(native, "wb");
+    if (f == NULL) {
+        py_error(x, "record: could not open %s", native);
+        return MAX_ERR_GENERIC;
+    }
+    setvbuf(f, NULL, _IOFBF, PY_RECORD_BUFFER);
+
+    clock_getftime(&time);
+    fwrite(PY_RECORD_MAGIC, 1, 4, f);
+    fwrite(&version, 1, 1, f);
+    fwrite(&time, sizeof(double), 1, f);
+
+    systhread_mutex_lock(x->p_record_mutex);
+    x->p_record_syms = hashtab_new(0);
+    x->p_record_path = gensym(native);
+    x->p_record_count = 0;
+    x->p_record_time = time;
+    x->p_record = f;
+    systhread_mutex_unlock(x->p_record_mutex);
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Stop recording and close the record log
+ *
+ * @param x pointer to object struct
+ * @return t_max_err error code, MAX_ERR_GENERIC if the log could not be
+ *         written completely
+ */
+t_max_err py_record_stop(t_py* x)
+{
+    FILE* f = NULL;
+    t_max_err err = MAX_ERR_NONE;
+
+    systhread_mutex_lock(x->p_record_mutex);
+    f = x->p_record;
+    x->p_record = NULL;
+    if (x->p_record_syms) {
+        hashtab_chuck(x->p_record_syms);
+        x->p_record_syms = NULL;
+    }
+    systhread_mutex_unlock(x->p_record_mutex);
+
+    if (f == NULL)
+        return MAX_ERR_NONE;
+
+    if (ferror(f) | fclose(f)) {
+        py_error(x, "record: could not write %s", x->p_record_path->s_name);
+        err = MAX_ERR_GENERIC;
+    } else {
+        post("[py %s]: record: %ld messages written to %s",
+             x->p_name->s_name, x->p_record_count, x->p_record_path->s_name);
+    }
+    return err;
+}
+
+/**
+ * @brief Record inbound messages to a file for replay
+ *
+ * @param x pointer to object struct
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ *
+ * `record <file>` logs every message the object receives from then on
+ * with its scheduler time, until `stop`. Messages that only inspect the
+ * object (`info`, `count`, `trace`, `stats`, `record`) are not logged.
+ * `tests/replay_py` plays a log back on a headless `py` object.
+ */
+t_max_err py_record_msg(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    if (argc < 1 || atom_gettype(argv) != A_SYM) {
+        py_error(x, "record: requires a file path");
+        return MAX_ERR_GENERIC;
+    }
+    return py_record_start(x, atom_getsym(argv));
+}
+
+/**
+ * @brief Stop recording inbound messages
+ *
+ * @param x pointer to object struct
+ */
+void py_stop(t_py* x)
+{
+    if (x->p_record == NULL) {
+        py_error(x, "stop: not recording");
+        return;
+    }
+    py_record_stop(x);
+}
+
+/*--------------------------------------------------------------------------*/
+/* Core Methods */
+
+/**
+ * @brief Import the module of an `import` message into the namespace
+ *
+ * @param x pointer to object structure
+ * @param argc atom argument count
+ * @param argv atom argument vector: the module name
+ * @return PyObject* new reference to the module or NULL on error
+ */
+static PyObject* py_import_value(t_py* x, long argc, t_atom* argv)
+{
+    char* name = atom_getsym(argv)->s_name;
+    PyObject* x_module = PyImport_ImportModule(name);
+
+    if (x_module != NULL
+        && PyDict_SetItemString(x->p_globals, name, x_module) != 0) {
+        Py_CLEAR(x_module);
+    }
+    return x_module;
+}
+
+/**
+ * @brief Bang success or failure of an `import` message
+ *
+ * @param x pointer to object structure
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param pval module (reference is stolen) or NULL on error
+ * @return t_max_err error code
+ */
+static t_max_err py_import_done(t_py* x, long argc, t_atom* argv,
+                                PyObject* pval)
+{
+    char* name = atom_getsym(argv)->s_name;
+
+    if (pval == NULL) {
+        py_handle_error(x, "import %s", name);
+        py_bang_failure(x);
+        return MAX_ERR_GENERIC;
+    }
+    Py_DECREF(pval);
+    py_bang_success(x);
+    py_log(x, "imported: %s", name);
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Import a python module
+ * 
+ * @param x pointer to object structure
+ * @param s symbol of module to be imported
+ * @return t_max_err error code
+ */
+t_max_err py_import(t_py* x, t_symbol* s)
+{
+    t_py_stats_span span;
+    t_py_gil gstate;
+    t_max_err err = MAX_ERR_NONE;
+    t_atom name;
+
+    py_record_sym(x, gensym("import"), s);
+
+    if (s == gensym(""))
+        return MAX_ERR_NONE;
+    atom_setsym(&name, s);
+
+    if (x->p_threaded) {
+        return py_job_post(x, gensym("import"), 1, &name, py_import_value,
+                           py_import_done, PY_STATS_IMPORT);
+    }
+
+    span = py_stats_begin(0);
+    gstate = py_gil_ensure(x);
+    span.wait = gstate.wait;
+    err = py_import_done(x, 1, &name, py_import_value(x, 1, &name));
+    py_gil_release(x, gstate);
+    return py_stats_end(x, PY_STATS_IMPORT, &span, err);
+}
+
+/**
+ * @brief Compute the value of an `eval` message
+ *
+ * @param x pointer to object structure
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return PyObject* new reference or NULL on error
+ */
+static PyObject* py_eval_value(t_py* x, long argc, t_atom* argv)
+{
+    PyObject* pval = NULL;
+    PyObject* co = py_code_cache_compile(x, atom_getsym(argv)->s_name,
+                                         Py_eval_input);
+    if (co != NULL) {
+        pval = PyEval_EvalCode(co, x->p_globals, x->p_globals);
+        Py_DECREF(co);
+    }
+    return pval;
+}
+
+/**
+ * @brief Output the value of an `eval` message
+ *
+ * @param x pointer to object structure
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param pval result (reference is stolen) or NULL on error
+ * @return t_max_err error code
+ */
+static t_max_err py_eval_done(t_py* x, long argc, t_atom* argv,
+                              PyObject* pval)
+{
+    if (pval != NULL) {
+        py_handle_output(x, pval);
+        return MAX_ERR_NONE;
+    }
+    py_handle_error(x, "eval %s", atom_getsym(argv)->s_name);
+    py_bang_failure(x);
+    return MAX_ERR_GENERIC;
+}
+
+/**
+ * @brief Evaluate a max symbol as a python expression
+ * 
+ * @param x pointer to object structure
+ * @param s symbol of object to be evaluated
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ */
+t_max_err py_eval(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_py_gil gstate;
+    t_py_stats_span span;
+    t_max_err err = MAX_ERR_NONE;
+
+    py_record(x, s, argc, argv);
+
+    if (x->p_threaded) {
+        return py_job_post(x, s, argc, argv, py_eval_value, py_eval_done,
+                           PY_STATS_EVAL);
+    }
+
+    span = py_stats_begin(argc);
+    gstate = py_gil_ensure(x);
+    span.wait = gstate.wait;
+    err = py_eval_done(x, argc, argv,
+                       py_trace_value(x, s, py_eval_value, argc, argv));
+    py_gil_release(x, gstate);
+    return py_stats_end(x, PY_STATS_EVAL, &span, err);
+}
+
+/**
+ * @brief Compute the value of an `exec` message
+ *
+ * @param x pointer to object structure
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return PyObject* new reference or NULL on error
+ */
+static PyObject* py_exec_value(t_py* x, long argc, t_atom* argv)
+{
+    return PyRun_String(atom_getsym(argv)->s_name, Py_single_input,
+                        x->p_globals, x->p_globals);
+}
+
+/**
+ * @brief Bang success or failure of an `exec` message
+ *
+ * @param x pointer to object structure
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param pval result (reference is stolen) or NULL on error
+ * @return t_max_err error code
+ */
+static t_max_err py_exec_done(t_py* x, long argc, t_atom* argv,
+                              PyObject* pval)
+{
+    char* py_argv = atom_getsym(argv)->s_name;
+
+    if (pval == NULL) {
+        py_handle_error(x, "exec %s", py_argv);
+        py_bang_failure(x);
+        return MAX_ERR_GENERIC;
+    }
+    Py_DECREF(pval);
+    py_bang_success(x);
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Execute a max symbol as a line of python code
+ *
+ * @param x pointer to object structure
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ */
+t_max_err py_exec(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_py_gil gstate;
+    t_py_stats_span span;
+    t_max_err err = MAX_ERR_NONE;
+
+    py_record(x, s, argc, argv);
+
+    if (x->p_threaded) {
+        return py_job_post(x, s, argc, argv, py_exec_value, py_exec_done,
+                           PY_STATS_EXEC);
+    }
+
+    span = py_stats_begin(argc);
+    gstate = py_gil_ensure(x);
+    span.wait = gstate.wait;
+    err = py_exec_done(x, argc, argv,
+                       py_trace_value(x, s, py_exec_value, argc, argv));
+    py_gil_release(x, gstate);
+    return py_stats_end(x, PY_STATS_EXEC, &span, err);
+}
+
+/**
+ * @brief Execute contents of a file (obtained from symbol) as python code
+ *
+ * @param x pointer to object structure
+ * @param s symbol
+ * @return t_max_err error code
+ */
+t_max_err py_execfile(t_py* x, t_symbol* s)
+{
+    t_py_stats_span span = py_stats_begin(0);
+    t_py_gil gstate;
+    py_record_sym(x, gensym("execfile"), s);
+    py_job_flush(x);
+    gstate = py_gil_ensure(x);
+    span.wait = gstate.wait;
+
+    PyObject* pval = NULL;
+    FILE* fhandle = NULL;
+
+    if (s != gensym("")) {
+        // set x->p_code_filepath
+        t_max_err err = py_locate_path_from_symbol(x, s);
+        if (err != MAX_ERR_NONE) {
+            py_error(x, "could not locate path from symbol");
+            goto error;
+        }
+    }
+
+    if (s == gensym("") || x->p_code_filepath == gensym("")) {
+        py_error(x, "could not set filepath");
+        goto error;
+    }
+
+    // assume x->p_code_filepath has be been set without errors
+
+    py_log(x, "pathname: %s", x->p_code_filepath->s_name);
+    fhandle = fopen(x->p_code_filepath->s_name, "r+");
+
+    if (fhandle == NULL) {
+        py_error(x, "could not open file");
+        goto error;
+    }
+
+    pval = PyRun_File(fhandle, x->p_code_filepath->s_name, Py_file_input,
+                      x->p_globals, x->p_globals);
+    if (pval == NULL) {
+        fclose(fhandle);
+        goto error;
+    }
+
+    // success cleanup
+    fclose(fhandle);
+    Py_DECREF(pval);
+    py_gil_release(x, gstate);
+    py_bang_success(x);
+    return py_stats_end(x, PY_STATS_EXECFILE, &span, MAX_ERR_NONE);
+
+error:
+    py_handle_error(x, "execfile");
+    Py_XDECREF(pval);
+    py_gil_release(x, gstate);
+    py_bang_failure(x);
+    return py_stats_end(x, PY_STATS_EXECFILE, &span, MAX_ERR_GENERIC);
+}
+
+/**
+ * @brief Reset the object's python namespace
+ *
+ * @param x pointer to object structure
+ * @return t_max_err error code
+ *
+ * Clears all names from the object 'globals' namespace, restores its
+ * builtins and flushes the compiled code cache.
+ */
+t_max_err py_reset(t_py* x)
+{
+    t_py_gil gstate;
+    py_record(x, gensym("reset"), 0, NULL);
+    py_job_flush(x);
+    gstate = py_gil_ensure(x);
+
+    PyObject* p_name = NULL;
+
+    PyDict_Clear(x->p_globals);
+
+    p_name = PyUnicode_FromString(x->p_name->s_name);
+    if (p_name == NULL) {
+        goto error;
+    }
+
+    if (PyDict_SetItemString(x->p_globals, "__name__", p_name) == -1) {
+        goto error;
+    }
+    Py_DECREF(p_name);
+
+    py_init_builtins(x);
+    py_code_cache_flush(x);
+    py_call_cache_flush(x);
+    py_pipe_cache_flush(x);
+
+    py_gil_release(x, gstate);
+    py_bang_success(x);
+    py_log(x, "namespace reset");
+    return MAX_ERR_NONE;
+
+error:
+    py_handle_error(x, "reset");
+    Py_XDECREF(p_name);
+    py_gil_release(x, gstate);
+    py_bang_failure(x);
+    return MAX_ERR_GENERIC;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Extra Methods */
+
+/**
+ * @brief Call a resolved callable in `f(*args)` or `f([args])` style.
+ *
+ * @param x pointer to object structure
+ * @param entry call cache entry (holds arity information)
+ * @param callable python callable
+ * @param args argument vector (args[-1] must be writable)
+ * @param nargs number of arguments
+ * @return PyObject* new reference to result or NULL on error
+ *
+ * If the arity of the callable is unknown (builtins, classes, ...) and the
+ * `f(*args)` call raises a TypeError, `f([args])` is tried once and the
+ * outcome is remembered for that number of arguments.
+ */
+static PyObject* py_call_vector(t_py* x, t_py_call_entry* entry,
+                                PyObject* callable, PyObject** args,
+                                long nargs)
+{
+    PyObject* plist = NULL;
+    PyObject* pval = NULL;
+
+    if (!py_call_cache_use_list(entry, nargs)) {
+        pval = PyObject_Vectorcall(callable, args,
+                                   nargs | PY_VECTORCALL_ARGUMENTS_OFFSET,
+                                   NULL);
+        if (pval != NULL || entry->min_args >= 0
+            || !PyErr_ExceptionMatches(PyExc_TypeError)) {
+            return pval;
+        }
+        PyErr_Clear();
+        py_trace(x, PY_TRACE_RETRY, (t_ptr_int)entry->name, nargs, 0.0);
+    }
+
+    plist = PyList_New(nargs);
+    if (plist == NULL) {
+        return NULL;
+    }
+    for (long i = 0; i < nargs; i++) {
+        Py_INCREF(args[i]);
+        PyList_SET_ITEM(plist, i, args[i]);
+    }
+
+    pval = PyObject_Vectorcall(callable, &plist, 1, NULL);
+    Py_DECREF(plist);
+
+    if (pval != NULL && entry->min_args < 0) {
+        entry->list_nargs = nargs;
+    }
+    return pval;
+}
+
+/**
+ * @brief Compute the value of a `call` message
+ *
+ * @param x pointer to object structure
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return PyObject* new reference or NULL on error
+ *
+ * Dotted callable names (`f`, `mod.f`) are resolved once and cached per
+ * symbol until the object namespace changes. Other expressions are
+ * evaluated for each call using the compiled code cache.
+ */
+static PyObject* py_call_value(t_py* x, long argc, t_atom* argv)
+{
+    char* callable_name = NULL;
+    t_py_call_entry* entry = NULL;
+    t_py_call_entry expr_entry;
+    PyObject* py_callable = NULL; // borrowed
+    PyObject* py_expr = NULL;
+    PyObject* co = NULL;
+    PyObject* pval = NULL;
+    PyObject* stack_static[PY_MAX_ATOMS + 1];
+    PyObject** stack = stack_static;
+    long nargs = 0;
 
-        while ((item = PyIter_Next(iter)) != NULL) {
-            if (PyLong_Check(item)) {
-                long long_item = PyLong_AsLong(item);
-                if (long_item == -1 && PyErr_Occurred()) {
-                    goto error;
-                }
-                atom_setlong(atoms + i, long_item);
-                py_log(x, "%d long: %ld\n", i, long_item);
-                i++;
-            }
+    // first atom in argv must be a symbol
+    if (argc < 1 || argv->a_type != A_SYM) {
+        py_error(x, "first atom must be a symbol!");
+        goto finally;
 
-            if (PyFloat_Check(item)) {
-                float float_item = PyFloat_AsDouble(item);
-                if (float_item == -1.0 && PyErr_Occurred()) {
-                    goto error;
-                }
-                atom_setfloat(atoms + i, float_item);
-                py_log(x, "%d float: %f\n", i, float_item);
-                i++;
-            }
+    } else {
+        callable_name = atom_getsym(argv)->s_name;
+    }
 
-            if (PyUnicode_Check(item)) {
-                const char* unicode_item = PyUnicode_AsUTF8(item);
-                if (unicode_item == NULL) {
-                    goto error;
-                }
-                atom_setsym(atoms + i, gensym(unicode_item));
-                py_log(x, "%d unicode: %s\n", i, unicode_item);
-                i++;
-            }
-            Py_DECREF(item);
+    if (py_call_name_is_dotted(callable_name)) {
+        entry = py_call_cache_get(x, atom_getsym(argv));
+        if (entry != NULL) {
+            py_callable = py_call_cache_resolve(x, entry);
+        }
+    } else {
+        co = py_code_cache_compile(x, callable_name, Py_eval_input);
+        if (co != NULL) {
+            py_expr = PyEval_EvalCode(co, x->p_globals, x->p_globals);
+            Py_DECREF(co);
         }
+        if (py_expr != NULL) {
+            memset(&expr_entry, 0, sizeof(expr_entry));
+            expr_entry.callable = py_expr;
+            py_call_cache_set_arity(&expr_entry);
+            entry = &expr_entry;
+            py_callable = py_expr;
+        }
+    }
 
-        outlet_list(x->p_outlet_left, NULL, i, atoms);
-        py_bang_success(x);
-        py_log(x, "end iter op: %d", i);
+    if (py_callable == NULL) {
+        py_error(x, "could not evaluate %s", callable_name);
+        goto finally;
+    }
 
-        if (is_dynamic) {
-            py_log(x, "restoring to static atom array");
-            atom_dynamic_end(atoms_static, atoms);
+    // stack[0] is reserved for PY_VECTORCALL_ARGUMENTS_OFFSET
+    if (argc > PY_MAX_ATOMS) {
+        stack = (PyObject**)PyMem_Malloc(argc * sizeof(PyObject*));
+        if (stack == NULL) {
+            PyErr_NoMemory();
+            goto finally;
         }
     }
 
-    Py_XDECREF(plist);
-    return MAX_ERR_NONE;
+    nargs = py_atoms_to_stack(x, argc - 1, argv + 1, stack + 1);
+    if (nargs < 0) {
+        nargs = 0;
+        py_error(x, "atom to py args conversion failed");
+        goto finally;
+    }
 
-error:
-    py_handle_error(x, "py_handle_list_output failed");
-    Py_XDECREF(plist);
-    py_bang_failure(x);
-    return MAX_ERR_GENERIC;
+    pval = py_call_vector(x, entry, py_callable, stack + 1, nargs);
+    if (pval == NULL) {
+        py_error(x, "unable to apply callable");
+    }
+
+finally:
+    for (long i = 1; i <= nargs; i++)
+        Py_DECREF(stack[i]);
+    if (stack != stack_static)
+        PyMem_Free(stack);
+    Py_XDECREF(py_expr);
+    return pval;
 }
 
 /**
- * @brief Handler to output python dict as max list
+ * @brief Output the value of a `call` message
  *
- * @param x pointer to object struct
- * @param pdict python dict
+ * @param x pointer to object structure
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param pval result (reference is stolen) or NULL on error
  * @return t_max_err error code
  */
-t_max_err py_handle_dict_output(t_py* x, PyObject* pdict)
+static t_max_err py_call_done(t_py* x, long argc, t_atom* argv,
+                              PyObject* pval)
 {
-    PyObject* pfun_co = NULL;
-    PyObject* pfun = NULL;
-    PyObject* pval = NULL;
-
-    if (pdict == NULL) {
-        goto error;
+    if (pval == NULL) {
+        py_handle_error(x, "call %s",
+                        (argc > 0 && argv->a_type == A_SYM)
+                            ? atom_getsym(argv)->s_name
+                            : "call");
+        py_bang_failure(x);
+        return MAX_ERR_GENERIC;
     }
+    py_handle_output(x, pval);
+    py_bang_success(x);
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Converts a Max list to call a python function with arguments
+ *
+ * @param x pointer to object structure
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ */
+t_max_err py_call(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_py_gil gstate;
+    t_py_stats_span span;
+    t_max_err err = MAX_ERR_NONE;
 
-    if (PyDict_Check(pdict)) {
+    py_record(x, s, argc, argv);
 
-        pfun_co = PyRun_String("def __py_maxmsp_out_dict(arg):\n"
-                               "\tres = []\n"
-                               "\tfor k,v in arg.items():\n"
-                               "\t\tres.append(k)\n"
-                               "\t\tres.append(':')\n"
-                               "\t\tif type(v) in [list, set, tuple]:\n"
-                               "\t\t\tfor i in v:\n"
-                               "\t\t\t\tres.append(i)\n"
-                               "\t\telse:\n"
-                               "\t\t\tres.append(v)\n"
-                               "\treturn res\n",
-                               Py_single_input, x->p_globals, x->p_globals);
+    if (x->p_threaded) {
+        return py_job_post(x, s, argc, argv, py_call_value, py_call_done,
+                           PY_STATS_CALL);
+    }
 
-        if (pfun_co == NULL) {
-            py_error(x, "out_dict function code object is NULL");
-            goto error;
-        }
+    span = py_stats_begin(argc);
+    gstate = py_gil_ensure(x);
+    span.wait = gstate.wait;
+    err = py_call_done(x, argc, argv,
+                       py_trace_value(x, s, py_call_value, argc, argv));
+    py_gil_release(x, gstate);
+    return py_stats_end(x, PY_STATS_CALL, &span, err);
+}
 
-        pfun = PyDict_GetItemString(x->p_globals, "__py_maxmsp_out_dict");
-        if (pfun == NULL) {
-            py_error(x, "retrieving out_dict func from globals failed");
-            goto error;
-        }
+/**
+ * @brief Assign the list of an `assign` message to a python variable
+ *
+ * @param x pointer to object structure
+ * @param argc atom argument count
+ * @param argv atom argument vector: the variable name, then its items
+ * @return PyObject* new reference to the assigned list or NULL on error
+ */
+static PyObject* py_assign_value(t_py* x, long argc, t_atom* argv)
+{
+    PyObject* list = NULL;
 
-        pval = PyObject_CallFunctionObjArgs(pfun, pdict, NULL);
-        if (pval == NULL) {
-            py_error(x, "out_dict call failed to retrieve result");
-            goto error;
-        }
+    // first atom in argv must be a symbol
+    if (argc < 1 || argv->a_type != A_SYM) {
+        PyErr_SetString(PyExc_TypeError, "first atom must be a symbol");
+        return NULL;
+    }
 
-        if (PyList_Check(pval)) {           // expecting a python list
-            py_handle_list_output(x, pval); // this decrefs pval
-            Py_XDECREF(pfun_co);
-            py_bang_success(x);
-            return MAX_ERR_NONE;
-        } else {
-            py_error(x, "expected list output got something else");
-            goto error;
-        }
+    list = py_atoms_to_list(x, argc, argv, 1);
+    if (list == NULL) {
+        return NULL;
     }
 
-error:
-    py_handle_error(x, "py_handle_dict_output failed");
-    Py_XDECREF(pfun_co);
-    Py_XDECREF(pval);
-    // fail bang
-    py_bang_failure(x);
-    return MAX_ERR_GENERIC;
+    // finally, assign list to varname in object namespace
+    if (PyDict_SetItemString(x->p_globals, atom_getsym(argv)->s_name, list)
+        != 0) {
+        Py_CLEAR(list);
+    }
+    return list;
 }
 
 /**
- * @brief Generic handler to output arbitrarily-typed python object as max object
+ * @brief Bang success or failure of an `assign` message
  *
- * @param x pointer to object struct
- * @param pval python object
+ * @param x pointer to object structure
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param pval assigned list (reference is stolen) or NULL on error
  * @return t_max_err error code
  */
-t_max_err py_handle_output(t_py* x, PyObject* pval)
+static t_max_err py_assign_done(t_py* x, long argc, t_atom* argv,
+                                PyObject* pval)
 {
     if (pval == NULL) {
-        py_error(x, "cannot handle NULL value");
+        py_handle_error(x, "assign %s",
+                        (argc > 0 && argv->a_type == A_SYM)
+                            ? atom_getsym(argv)->s_name
+                            : "");
+        py_bang_failure(x);
         return MAX_ERR_GENERIC;
     }
+    Py_DECREF(pval);
+    py_bang_success(x);
+    return MAX_ERR_NONE;
+}
 
-    if (PyFloat_Check(pval)) {
-        return py_handle_float_output(x, pval);
-    }
+/**
+ * @brief Converts an atom list to a python assignment
+ *
+ * @param x pointer to object structure
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ * 
+ * The first item of the Max list must be a symbol. This is converted into a python variable
+ * and the rest of the list is assignment to this variable in the object's python
+ * namespace.
+ */
+t_max_err py_assign(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_py_stats_span span;
+    t_py_gil gstate;
+    t_max_err err = MAX_ERR_NONE;
 
-    else if (PyLong_Check(pval)) {
-        return py_handle_long_output(x, pval);
+    py_record(x, s, argc, argv);
+
+    if (x->p_threaded) {
+        return py_job_post(x, gensym("assign"), argc, argv, py_assign_value,
+                           py_assign_done, PY_STATS_ASSIGN);
     }
 
-    else if (PyUnicode_Check(pval)) {
-        return py_handle_string_output(x, pval);
+    span = py_stats_begin(argc);
+    gstate = py_gil_ensure(x);
+    span.wait = gstate.wait;
+    err = py_assign_done(x, argc, argv, py_assign_value(x, argc, argv));
+    py_gil_release(x, gstate);
+    return py_stats_end(x, PY_STATS_ASSIGN, &span, err);
+}
+
+/**
+ * @brief Compile and run the text of a `code` or `anything` message
+ *
+ * @param x pointer to object structure
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return PyObject* new reference to `(is_eval, value)` or NULL on error
+ *
+ * The text is compiled as an expression, or as a statement if it is not
+ * one. The flag tells `py_code_done` whether to output the value or to
+ * bang, as an expression may evaluate to None.
+ */
+static PyObject* py_code_value(t_py* x, long argc, t_atom* argv)
+{
+    long textsize = 0;
+    char* text = NULL;
+    int is_eval = 1;
+    PyObject* co = NULL;
+    PyObject* pval = NULL;
+
+    t_max_err err = atom_gettext(argc, argv, &textsize, &text,
+                                 OBEX_UTIL_ATOM_GETTEXT_DEFAULT);
+    if (err != MAX_ERR_NONE || !textsize || !text) {
+        if (text)
+            sysmem_freeptr(text);
+        PyErr_SetString(PyExc_ValueError, "could not convert atoms to text");
+        return NULL;
     }
+    py_trace(x, PY_TRACE_CODE, textsize, 0, 0.0);
+
+    // try the code cache for either compile mode before compiling
+    co = py_code_cache_get(x, text, Py_eval_input);
+    if (co == NULL) {
+        co = py_code_cache_get(x, text, Py_single_input);
+        if (co != NULL)
+            is_eval = 0;
+    }
+
+    if (co != NULL) {
+        x->p_code_cache_hits++;
+    } else {
+        x->p_code_cache_misses++;
+        co = Py_CompileString(text, x->p_name->s_name, Py_eval_input);
+
+        if (co == NULL && PyErr_ExceptionMatches(PyExc_SyntaxError)) {
+            PyErr_Clear();
+            co = Py_CompileString(text, x->p_name->s_name, Py_single_input);
+            is_eval = 0;
+        }
 
-    else if (PySequence_Check(pval) && !PyBytes_Check(pval)
-             && !PyByteArray_Check(pval)) {
-        return py_handle_list_output(x, pval);
+        if (co != NULL) { // can be eval-co or exec-co here
+            py_code_cache_put(x, text,
+                              is_eval ? Py_eval_input : Py_single_input, co);
+        }
     }
+    sysmem_freeptr(text);
 
-    else if (PyDict_Check(pval)) {
-        return py_handle_dict_output(x, pval);
+    if (co != NULL) {
+        pval = PyEval_EvalCode(co, x->p_globals, x->p_globals);
+        Py_DECREF(co);
     }
+    py_trace(x, PY_TRACE_CODE_END, pval != NULL, 0, 0.0);
 
-    else if (pval == Py_None) {
+    if (pval == NULL)
+        return NULL;
+    return Py_BuildValue("(ON)", is_eval ? Py_True : Py_False, pval);
+}
+
+/**
+ * @brief Output the value of an expression or bang after a statement
+ *
+ * @param x pointer to object structure
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param pval `(is_eval, value)` (reference is stolen) or NULL on error
+ * @return t_max_err error code
+ */
+static t_max_err py_code_done(t_py* x, long argc, t_atom* argv,
+                              PyObject* pval)
+{
+    PyObject* value = NULL;
+    int is_eval = 0;
+
+    if (pval == NULL) {
+        py_handle_error(x, "python code evaluation failed");
+        py_bang_failure(x);
         return MAX_ERR_GENERIC;
     }
 
-    else {
-        py_error(x, "cannot handle his type of value");
-        return MAX_ERR_GENERIC;
+    is_eval = PyTuple_GET_ITEM(pval, 0) == Py_True;
+    value = PyTuple_GET_ITEM(pval, 1);
+    Py_INCREF(value);
+    Py_DECREF(pval);
+
+    if (!is_eval) {
+        // bang for exec-type op
+        Py_DECREF(value);
+        py_bang_success(x);
+    } else {
+        py_handle_output(x, value);
     }
+    return MAX_ERR_NONE;
 }
 
-/*--------------------------------------------------------------------------*/
-/* Translators */
+/**
+ * @brief A helper function to evaluate Max text as a Python expression.
+ *
+ * @param x pointer to object structure
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param offset offset of atom vector from which to evaluate
+ * @return t_max_err error code
+ */
+t_max_err py_eval_text(t_py* x, long argc, t_atom* argv, int offset)
+{
+    t_py_stats_span span;
+    t_py_gil gstate;
+    t_max_err err = MAX_ERR_NONE;
+
+    if (x->p_threaded) {
+        return py_job_post(x, gensym("code"), argc + offset, argv,
+                           py_code_value, py_code_done, PY_STATS_CODE);
+    }
+
+    span = py_stats_begin(argc + offset);
+    gstate = py_gil_ensure(x);
+    span.wait = gstate.wait;
+    err = py_code_done(x, argc + offset, argv,
+                       py_code_value(x, argc + offset, argv));
+    py_gil_release(x, gstate);
+    return py_stats_end(x, PY_STATS_CODE, &span, err);
+}
 
 /**
- * @brief Translates atom vector to python list
- * 
- * @param x pointer to object struct
+ * @brief Converts all of the atom to text and evaluate as python code.
+ *
+ * @param x pointer to object structure
+ * @param s symbol
  * @param argc atom argument count
  * @param argv atom argument vector
- * @param start_from index of vector to start from
- * @return PyObject* python list
+ * @return t_max_err error code
  */
-PyObject* py_atoms_to_list(t_py* x, long argc, t_atom* argv, int start_from)
+t_max_err py_code(t_py* x, t_symbol* s, long argc, t_atom* argv)
 {
+    py_record(x, s, argc, argv);
+    return py_eval_text(x, argc, argv, 0);
+}
 
-    PyObject* plist = NULL; // python list
+/**
+ * @brief Anything method converting all of the atom to text and evaluate as python code.
+ *
+ * @param x pointer to object structure
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ */
+t_max_err py_anything(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_atom atoms[PY_MAX_ATOMS];
+    t_py* inner = NULL;
 
-    if ((plist = PyList_New(0)) == NULL) {
-        py_error(x, "could not create an empty python list");
-        goto error;
+    if (s == gensym("")) {
+        return MAX_ERR_GENERIC; 
+    }
+
+    py_record(x, s, argc, argv);
+
+    // set '=' as shorthand for assign method
+    if (s == gensym("=")) {
+        inner = py_record_mute(x);
+        py_assign(x, gensym(""), argc, argv);
+        py_record_mute(inner);
+        return MAX_ERR_NONE;
     }
 
-    for (int i = start_from; i < argc; i++) {
+    // set symbol as first atom in new atoms array
+    atom_setsym(atoms, s);
+
+    for (int i = 0; i < argc; i++) {
         switch ((argv + i)->a_type) {
         case A_FLOAT: {
-            double c_float = atom_getfloat(argv + i);
-            PyObject* p_float = PyFloat_FromDouble(c_float);
-            if (p_float == NULL) {
-                goto error;
-            }
-            PyList_Append(plist, p_float);
-            Py_DECREF(p_float);
+            atom_setfloat((atoms + (i + 1)), atom_getfloat(argv + i));
             break;
         }
         case A_LONG: {
-            PyObject* p_long = PyLong_FromLong(atom_getlong(argv + i));
-            if (p_long == NULL) {
-                goto error;
-            }
-            PyList_Append(plist, p_long);
-            Py_DECREF(p_long);
+            atom_setlong((atoms + (i + 1)), atom_getlong(argv + i));
             break;
         }
         case A_SYM: {
-            PyObject* p_str = PyUnicode_FromString(
-                atom_getsym(argv + i)->s_name);
-            if (p_str == NULL) {
-                goto error;
-            }
-            PyList_Append(plist, p_str);
-            Py_DECREF(p_str);
+            atom_setsym((atoms + (i + 1)), atom_getsym(argv + i));
             break;
         }
         default:
@@ -1413,638 +6899,649 @@ PyObject* py_atoms_to_list(t_py* x, long argc, t_atom* argv, int start_from)
             break;
         }
     }
-    return plist;
 
-error:
-    py_error(x, "atom to list conversion failed");
-    return NULL;
+    return py_eval_text(x, argc, atoms, 1);
 }
 
-/*--------------------------------------------------------------------------*/
-/* Core Methods */
-
 /**
- * @brief Import a python module
- * 
+ * @brief Output the result of a pipeline and bang success or failure.
+ *
  * @param x pointer to object structure
- * @param s symbol of module to be imported
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param pval result (reference is stolen) or NULL on error
  * @return t_max_err error code
+ *
+ * Must be called with the GIL held.
  */
-t_max_err py_import(t_py* x, t_symbol* s)
+static t_max_err py_pipe_done(t_py* x, long argc, t_atom* argv,
+                              PyObject* pval)
 {
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
-
-    PyObject* x_module = NULL;
-
-    if (s != gensym("")) {
-        x_module = PyImport_ImportModule(s->s_name);
-        // x_module borrrowed ref
-        if (x_module == NULL) {
-            goto error;
-        }
-        PyDict_SetItemString(x->p_globals, s->s_name, x_module);
-        PyGILState_Release(gstate);
-        py_bang_success(x);
-        py_log(x, "imported: %s", s->s_name);
+    if (pval == NULL) {
+        py_handle_error(x, "pipe failed");
+        py_bang_failure(x);
+        return MAX_ERR_GENERIC;
     }
-    return MAX_ERR_NONE;
 
-error:
-    py_handle_error(x, "import %s", s->s_name);
-    PyGILState_Release(gstate);
-    py_bang_failure(x);
-    return MAX_ERR_GENERIC;
+    py_handle_output(x, pval); // this decrefs pval
+    py_bang_success(x);
+    return MAX_ERR_NONE;
 }
 
 /**
- * @brief Evaluate a max symbol as a python expression
- * 
+ * @brief Compute the value of a `pipe` message
+ *
  * @param x pointer to object structure
- * @param s symbol of object to be evaluated
  * @param argc atom argument count
  * @param argv atom argument vector
- * @return t_max_err error code
+ * @return PyObject* new reference or NULL on error
  */
-t_max_err py_eval(t_py* x, t_symbol* s, long argc, t_atom* argv)
+static PyObject* py_pipe_value(t_py* x, long argc, t_atom* argv)
 {
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    t_py_pipe_entry* entry = NULL;
+    PyObject* pval = NULL;
+    PyObject* co = NULL;
 
-    char* py_argv = atom_getsym(argv)->s_name;
-    py_log(x, "%s %s", s->s_name, py_argv);
+    if (argc < 2) {
+        py_error(x, "pipe requires an argument and at least one function");
+        return NULL;
+    }
 
-    PyObject* pval = PyRun_String(py_argv, Py_eval_input, x->p_globals,
-                                  x->p_globals);
+    entry = py_pipe_cache_get(x, argc - 1, argv + 1);
+    if (entry == NULL) {
+        return NULL;
+    }
 
-    if (pval != NULL) {
-        py_handle_output(x, pval);
-        PyGILState_Release(gstate);
-        return MAX_ERR_NONE;
-    } else {
-        py_handle_error(x, "eval %s", py_argv);
-        PyGILState_Release(gstate);
-        py_bang_failure(x);
-        return MAX_ERR_GENERIC;
+    switch (atom_gettype(argv)) {
+    case A_LONG:
+        pval = PyLong_FromLong(atom_getlong(argv));
+        break;
+    case A_FLOAT:
+        pval = PyFloat_FromDouble(atom_getfloat(argv));
+        break;
+    case A_SYM:
+        co = py_code_cache_compile(x, atom_getsym(argv)->s_name,
+                                   Py_eval_input);
+        if (co != NULL) {
+            pval = PyEval_EvalCode(co, x->p_globals, x->p_globals);
+            Py_DECREF(co);
+        }
+        break;
+    default:
+        py_error(x, "cannot process unknown type");
+        break;
     }
+
+    return pval ? py_pipe_run(x, entry, pval) : NULL;
 }
 
 /**
- * @brief Execute a max symbol as a line of python code
+ * @brief Create a function python pipeline from a Max list
  *
  * @param x pointer to object structure
  * @param s symbol
  * @param argc atom argument count
  * @param argv atom argument vector
  * @return t_max_err error code
+ *
+ * Responds to `pipe <arg> <f1> <f2> ... <fN>`: the value of `arg` is
+ * passed through `f1` to `fN` in turn. The chain of functions is compiled
+ * once per symbol sequence (see `py_pipe_cache_get`).
  */
-t_max_err py_exec(t_py* x, t_symbol* s, long argc, t_atom* argv)
+t_max_err py_pipe(t_py* x, t_symbol* s, long argc, t_atom* argv)
 {
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    t_py_gil gstate;
+    t_py_stats_span span;
+    t_max_err err = MAX_ERR_NONE;
 
-    char* py_argv = NULL;
-    PyObject* pval = NULL;
-
-    py_argv = atom_getsym(argv)->s_name;
-    if (py_argv == NULL) {
-        goto error;
-    }
+    py_record(x, s, argc, argv);
 
-    pval = PyRun_String(py_argv, Py_single_input, x->p_globals, x->p_globals);
-    if (pval == NULL) {
-        goto error;
+    if (x->p_threaded) {
+        return py_job_post(x, s, argc, argv, py_pipe_value, py_pipe_done,
+                           PY_STATS_PIPE);
     }
-    Py_DECREF(pval);
-    PyGILState_Release(gstate);
 
-    py_bang_success(x);
-    py_log(x, "exec %s", py_argv);
-    return MAX_ERR_NONE;
-
-error:
-    py_handle_error(x, "exec %s", py_argv);
-    Py_XDECREF(pval);
-    PyGILState_Release(gstate);
-    py_bang_failure(x);
-    return MAX_ERR_GENERIC;
+    span = py_stats_begin(argc);
+    gstate = py_gil_ensure(x);
+    span.wait = gstate.wait;
+    err = py_pipe_done(x, argc, argv,
+                       py_trace_value(x, s, py_pipe_value, argc, argv));
+    py_gil_release(x, gstate);
+    return py_stats_end(x, PY_STATS_PIPE, &span, err);
 }
 
 /**
- * @brief Execute contents of a file (obtained from symbol) as python code
+ * @brief Compute the value of a bare list through the `@pipe` pipeline
  *
  * @param x pointer to object structure
- * @param s symbol
- * @return t_max_err error code
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return PyObject* new reference or NULL on error
  */
-t_max_err py_execfile(t_py* x, t_symbol* s)
+static PyObject* py_list_value(t_py* x, long argc, t_atom* argv)
 {
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
-
+    t_py_pipe_entry* entry = NULL;
     PyObject* pval = NULL;
-    FILE* fhandle = NULL;
-
-    if (s != gensym("")) {
-        // set x->p_code_filepath
-        t_max_err err = py_locate_path_from_symbol(x, s);
-        if (err != MAX_ERR_NONE) {
-            py_error(x, "could not locate path from symbol");
-            goto error;
-        }
-    }
+    t_atom stages[PY_PIPE_MAX_STAGES];
 
-    if (s == gensym("") || x->p_code_filepath == gensym("")) {
-        py_error(x, "could not set filepath");
-        goto error;
+    for (long i = 0; i < x->p_pipe_count; i++) {
+        atom_setsym(stages + i, x->p_pipe[i]);
     }
-
-    // assume x->p_code_filepath has be been set without errors
-
-    py_log(x, "pathname: %s", x->p_code_filepath->s_name);
-    fhandle = fopen(x->p_code_filepath->s_name, "r+");
-
-    if (fhandle == NULL) {
-        py_error(x, "could not open file");
-        goto error;
+    entry = py_pipe_cache_get(x, x->p_pipe_count, stages);
+    if (entry == NULL) {
+        return NULL;
     }
 
-    pval = PyRun_File(fhandle, x->p_code_filepath->s_name, Py_file_input,
-                      x->p_globals, x->p_globals);
-    if (pval == NULL) {
-        fclose(fhandle);
-        goto error;
+    if (argc == 1) {
+        switch (atom_gettype(argv)) {
+        case A_LONG:
+            pval = PyLong_FromLong(atom_getlong(argv));
+            break;
+        case A_FLOAT:
+            pval = PyFloat_FromDouble(atom_getfloat(argv));
+            break;
+        case A_SYM:
+            pval = py_symbol_to_str(x, atom_getsym(argv));
+            break;
+        default:
+            py_error(x, "cannot process unknown type");
+            break;
+        }
+    } else {
+        pval = py_atoms_to_list(x, argc, argv, 0);
     }
 
-    // success cleanup
-    fclose(fhandle);
-    Py_DECREF(pval);
-    PyGILState_Release(gstate);
-    py_bang_success(x);
-    return MAX_ERR_NONE;
-
-error:
-    py_handle_error(x, "execfile");
-    Py_XDECREF(pval);
-    PyGILState_Release(gstate);
-    py_bang_failure(x);
-    return MAX_ERR_GENERIC;
+    return pval ? py_pipe_run(x, entry, pval) : NULL;
 }
 
-/*--------------------------------------------------------------------------*/
-/* Extra Methods */
-
 /**
- * @brief Converts a Max list to call a python function with arguments
+ * @brief Pass a bare Max list through the default `@pipe` pipeline
  *
  * @param x pointer to object structure
  * @param s symbol
  * @param argc atom argument count
  * @param argv atom argument vector
  * @return t_max_err error code
+ *
+ * A single atom is passed as a python scalar, longer lists as a python
+ * list. Without a `@pipe` attribute, the list is handled as before by
+ * `py_anything`.
  */
-t_max_err py_call(t_py* x, t_symbol* s, long argc, t_atom* argv)
+t_max_err py_list(t_py* x, t_symbol* s, long argc, t_atom* argv)
 {
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
-
-    char* callable_name = NULL;
-    PyObject* py_argslist = NULL;
-    PyObject* pval = NULL;
-    PyObject* py_callable = NULL;
-    // python list
-    PyObject* py_args = NULL; // python tuple
-
-    // first atom in argv must be a symbol
-    if (argv->a_type != A_SYM) {
-        py_error(x, "first atom must be a symbol!");
-        goto error;
-
-    } else {
-        callable_name = atom_getsym(argv)->s_name;
-        py_log(x, "callable_name: %s", callable_name);
-    }
-
-    py_callable = PyRun_String(callable_name, Py_eval_input, x->p_globals,
-                               x->p_globals);
-    if (py_callable == NULL) {
-        py_error(x, "could not evaluate %s", callable_name);
-        goto error;
-    }
-
-    py_argslist = py_atoms_to_list(x, argc, argv, 1);
-    if (py_argslist == NULL) {
-        py_error(x, "atom to py list conversion failed");
-        goto error;
-    }
-
-    py_log(x, "length of argc:%ld list: %d", argc, PyList_Size(py_argslist));
-
-    // convert py_args to tuple
-    py_args = PyList_AsTuple(py_argslist);
-    if (py_args == NULL) {
-        py_error(x, "unable to convert args list to tuple");
-        goto error;
-    }
-
-    pval = PyObject_CallObject(py_callable, py_args);
-    if (!PyErr_ExceptionMatches(PyExc_TypeError)) {
-        if (pval == NULL) {
-            py_error(x, "unable to apply callable(*args)");
-            goto error;
-        }
-        goto handle_output;
+    t_py_gil gstate;
+    t_py_stats_span span;
+    t_max_err err = MAX_ERR_NONE;
+    t_py* inner = NULL;
+
+    py_record(x, s, argc, argv);
+
+    if (x->p_pipe_count == 0) {
+        inner = py_record_mute(x);
+        err = py_anything(x, s, argc, argv);
+        py_record_mute(inner);
+        return err;
     }
-    PyErr_Clear();
 
-    pval = PyObject_CallFunctionObjArgs(py_callable, py_argslist, NULL);
-    if (pval == NULL) {
-        py_error(x, "could not retrieve result of callable(list)");
-        goto error;
+    if (x->p_threaded) {
+        return py_job_post(x, s, argc, argv, py_list_value, py_pipe_done,
+                           PY_STATS_LIST);
     }
-    goto handle_output; // this is redundant but safer in case code is added
 
-handle_output:
-    py_handle_output(x, pval);
-    // success cleanup
-    Py_XDECREF(py_callable);
-    Py_XDECREF(py_argslist);
-    PyGILState_Release(gstate);
-    py_bang_success(x);
-    return MAX_ERR_NONE;
+    span = py_stats_begin(argc);
+    gstate = py_gil_ensure(x);
+    span.wait = gstate.wait;
+    err = py_pipe_done(x, argc, argv,
+                       py_trace_value(x, s, py_list_value, argc, argv));
+    py_gil_release(x, gstate);
+    return py_stats_end(x, PY_STATS_LIST, &span, err);
+}
 
-error:
-    py_handle_error(x, "anything %s", s->s_name);
-    // cleanup
-    Py_XDECREF(py_callable);
-    Py_XDECREF(py_argslist);
-    Py_XDECREF(pval);
-    PyGILState_Release(gstate);
-    py_bang_failure(x);
-    return MAX_ERR_GENERIC;
+/**
+ * @brief Pass an int through the default `@pipe` pipeline
+ *
+ * @param x pointer to object structure
+ * @param n integer value
+ * @return t_max_err error code
+ */
+t_max_err py_int(t_py* x, long n)
+{
+    t_atom atom;
+    atom_setlong(&atom, n);
+    return py_list(x, gensym("int"), 1, &atom);
 }
 
 /**
- * @brief Converts an atom list to a python assignment
+ * @brief Pass a float through the default `@pipe` pipeline
  *
  * @param x pointer to object structure
- * @param s symbol
- * @param argc atom argument count
- * @param argv atom argument vector
+ * @param f float value
  * @return t_max_err error code
- * 
- * The first item of the Max list must be a symbol. This is converted into a python variable
- * and the rest of the list is assignment to this variable in the object's python
- * namespace.
  */
-t_max_err py_assign(t_py* x, t_symbol* s, long argc, t_atom* argv)
+t_max_err py_float(t_py* x, double f)
 {
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    t_atom atom;
+    atom_setfloat(&atom, f);
+    return py_list(x, gensym("float"), 1, &atom);
+}
 
-    char* varname = NULL;
-    PyObject* list = NULL;
-    int res = 0;
+/*--------------------------------------------------------------------------*/
+/* Registry */
 
-    if (s != gensym(""))
-        py_log(x, "s: %s", s->s_name);
+/**
+ * @brief Bucket of a watched box or patcher in the registry table
+ *
+ * @param key box or patcher
+ * @return long bucket index
+ */
+static long py_registry_hash(t_object* key)
+{
+    return (long)(((uint64_t)(uintptr_t)key * 0x9E3779B97F4A7C15ULL) >> 32
+                  & (py_global_registry_size - 1));
+}
 
-    // first atom in argv must be a symbol
-    if (argv->a_type != A_SYM) {
-        py_error(x, "first atom must be a symbol!");
-        goto error;
+/**
+ * @brief Find the entry of a watched box or patcher
+ *
+ * @param key box or patcher
+ * @return t_py_registry_entry* entry or NULL if not watched
+ *
+ * Called with `py_global_registry_mutex` held.
+ */
+static t_py_registry_entry* py_registry_find(t_object* key)
+{
+    t_py_registry_entry* entry = NULL;
 
-    } else {
-        varname = atom_getsym(argv)->s_name;
-        py_log(x, "varname: %s", varname);
-    }
+    if (py_global_registry_table == NULL)
+        return NULL;
 
-    list = py_atoms_to_list(x, argc, argv, 1);
-    if (list == NULL) {
-        py_error(x, "atom to py list conversion failed");
-        goto error;
-    }
+    entry = py_global_registry_table[py_registry_hash(key)];
+    while (entry != NULL && entry->key != key)
+        entry = entry->next;
+    return entry;
+}
 
-    if (PyList_Size(list) != argc - 1) {
-        py_error(x, "PyList_Size(list) != argc - 1");
-        goto error;
-    } else {
-        py_log(x, "length of list: %d", PyList_Size(list));
+/**
+ * @brief Double the number of buckets in the registry table
+ *
+ * @return t_max_err error code
+ */
+static t_max_err py_registry_grow(void)
+{
+    t_py_registry_entry** table = py_global_registry_table;
+    long size = py_global_registry_size;
+
+    py_global_registry_size = size ? size * 2 : PY_REGISTRY_SIZE;
+    py_global_registry_table = (t_py_registry_entry**)sysmem_newptrclear(
+        py_global_registry_size * sizeof(t_py_registry_entry*));
+    if (py_global_registry_table == NULL) {
+        py_global_registry_table = table;
+        py_global_registry_size = size;
+        return MAX_ERR_OUT_OF_MEM;
     }
 
-    // finally, assign list to varname in object namespace
-    py_log(x, "setting %s to list in namespace", varname);
-    // following does not steal ref to list
-    res = PyDict_SetItemString(x->p_globals, varname, list);
-    if (res != 0) {
-        py_error(x, "assign varname to list failed");
-        goto error;
+    for (long i = 0; i < size; i++) {
+        t_py_registry_entry* entry = table[i];
+        while (entry != NULL) {
+            t_py_registry_entry* next = entry->next;
+            long h = py_registry_hash(entry->key);
+            entry->next = py_global_registry_table[h];
+            py_global_registry_table[h] = entry;
+            entry = next;
+        }
     }
-    // Py_XDECREF(list); // causes a crash (because it still exists?)
-    PyGILState_Release(gstate);
-    py_bang_success(x);
+    if (table)
+        sysmem_freeptr(table);
     return MAX_ERR_NONE;
+}
 
-error:
-    py_handle_error(x, "assign %s", s->s_name);
-    Py_XDECREF(list);
-    PyGILState_Release(gstate);
-    py_bang_failure(x);
-    return MAX_ERR_GENERIC;
+/**
+ * @brief Remove the scripting name of an entry from the registry
+ *
+ * @param entry registry entry
+ */
+static void py_registry_unbind(t_py_registry_entry* entry)
+{
+    t_object* bound = NULL;
+
+    if (entry->name == NULL)
+        return;
+
+    // a name used in several patchers is bound to the last box given it
+    if (hashtab_lookup(py_global_registry, entry->name, &bound)
+            == MAX_ERR_NONE
+        && bound == (t_object*)entry)
+        hashtab_chuckkey(py_global_registry, entry->name);
+
+    entry->name = NULL;
+    entry->generation = 0;
 }
 
 /**
- * @brief A helper function to evaluate Max text as a Python expression.
+ * @brief Bind a scripting name to an entry with a new generation
  *
- * @param x pointer to object structure
- * @param argc atom argument count
- * @param argv atom argument vector
- * @param offset offset of atom vector from which to evaluate
- * @return t_max_err error code
+ * @param entry registry entry of a box
+ * @param name scripting name, empty or NULL to unbind
  */
-t_max_err py_eval_text(t_py* x, long argc, t_atom* argv, int offset)
+static void py_registry_bind(t_py_registry_entry* entry, t_symbol* name)
 {
-    PyGILState_STATE gstate = PyGILState_Ensure();
+    py_registry_unbind(entry);
+    if (name == NULL || name->s_name[0] == '\0')
+        return;
 
-    long textsize = 0;
-    char* text = NULL;
-    int is_eval = 1;
-    PyObject* co = NULL;
-    PyObject* pval = NULL;
+    entry->name = name;
+    entry->generation = ++py_global_registry_generation;
+    hashtab_store(py_global_registry, name, (t_object*)entry);
+}
 
-    t_max_err err = atom_gettext(argc + offset, argv, &textsize, &text,
-                                 OBEX_UTIL_ATOM_GETTEXT_DEFAULT);
-    if (err == MAX_ERR_NONE && textsize && text) {
-        py_log(x, ">>> %s", text);
-    } else {
-        goto error;
-    }
+/**
+ * @brief Start watching a box or patcher
+ *
+ * @param key box or patcher
+ * @param patcher patcher of the box or NULL if key is a patcher
+ * @return t_py_registry_entry* new entry or NULL on error
+ */
+static t_py_registry_entry* py_registry_add(t_object* key, t_object* patcher)
+{
+    t_py_registry_entry* entry = NULL;
+    long h = 0;
+
+    if (py_global_registry_count >= py_global_registry_size
+        && py_registry_grow() != MAX_ERR_NONE)
+        return NULL;
+
+    entry = (t_py_registry_entry*)sysmem_newptrclear(
+        sizeof(t_py_registry_entry));
+    if (entry == NULL)
+        return NULL;
+
+    entry->key = key;
+    entry->patcher = patcher;
+    h = py_registry_hash(key);
+    entry->next = py_global_registry_table[h];
+    py_global_registry_table[h] = entry;
+    py_global_registry_count++;
+
+    object_attach_byptr_register(py_global_registry_client, key, CLASS_NOBOX);
+    if (patcher != NULL)
+        py_registry_bind(entry, jbox_get_varname(key));
+    return entry;
+}
 
-    co = Py_CompileString(text, x->p_name->s_name, Py_eval_input);
+/**
+ * @brief Stop watching a box or patcher and free its entry
+ *
+ * @param entry registry entry
+ * @param detach detach from the key (not needed once it is being freed)
+ */
+static void py_registry_remove(t_py_registry_entry* entry, int detach)
+{
+    t_py_registry_entry** link = py_global_registry_table
+        + py_registry_hash(entry->key);
+
+    while (*link != entry)
+        link = &(*link)->next;
+    *link = entry->next;
+    py_global_registry_count--;
+
+    py_registry_unbind(entry);
+    if (detach)
+        object_detach_byptr(py_global_registry_client, entry->key);
+    sysmem_freeptr(entry);
+}
 
-    if (PyErr_ExceptionMatches(PyExc_SyntaxError)) {
-        PyErr_Clear();
-        co = Py_CompileString(text, x->p_name->s_name, Py_single_input);
-        is_eval = 0;
-    }
+static void py_registry_scan(t_object* patcher);
 
-    if (co == NULL) { // can be eval-co or exec-co or NULL here
-        goto error;
-    }
-    sysmem_freeptr(text);
+/**
+ * @brief Watch a box and the subpatchers of its object
+ *
+ * @param patcher patcher of the box
+ * @param box box to watch
+ */
+static void py_registry_add_box(t_object* patcher, t_object* box)
+{
+    t_object* obj = NULL;
+    t_object* sub = NULL;
+    long index = 0;
 
-    pval = PyEval_EvalCode(co, x->p_globals, x->p_globals);
-    if (pval == NULL) {
-        goto error;
-    }
-    Py_DECREF(co);
+    if (py_registry_find(box) || py_registry_add(box, patcher) == NULL)
+        return;
 
-    if (!is_eval) {
-        // bang for exec-type op
-        PyGILState_Release(gstate);
-        py_bang_success(x);
-    } else {
-        py_handle_output(x, pval);
-        PyGILState_Release(gstate);
-    }
-    return MAX_ERR_NONE;
+    obj = jbox_get_object(box);
+    if (obj == NULL || object_getmethod(obj, gensym("subpatcher")) == NULL)
+        return;
 
-error:
-    py_handle_error(x, "python code evaluation failed");
-    // fail bang
-    PyGILState_Release(gstate);
-    py_bang_failure(x);
-    return MAX_ERR_GENERIC;
+    while ((sub = (t_object*)object_subpatcher(obj, &index, NULL)) != NULL)
+        py_registry_scan(sub);
 }
 
 /**
- * @brief Converts all of the atom to text and evaluate as python code.
+ * @brief Watch a patcher, its boxes and all subpatchers
  *
- * @param x pointer to object structure
- * @param s symbol
- * @param argc atom argument count
- * @param argv atom argument vector
- * @return t_max_err error code
+ * @param patcher patcher to watch
+ *
+ * This is the only walk over boxes; afterwards the registry follows
+ * notifications (see `py_registry_notify`).
  */
-t_max_err py_code(t_py* x, t_symbol* s, long argc, t_atom* argv)
+static void py_registry_scan(t_object* patcher)
 {
-    return py_eval_text(x, argc, argv, 0);
+    t_object* box = NULL;
+
+    if (py_registry_find(patcher) || py_registry_add(patcher, NULL) == NULL)
+        return;
+
+    for (box = jpatcher_get_firstobject(patcher); box != NULL;
+         box = jbox_get_nextobject(box))
+        py_registry_add_box(patcher, box);
 }
 
 /**
- * @brief Anything method converting all of the atom to text and evaluate as python code.
+ * @brief Create the registry of named objects
  *
- * @param x pointer to object structure
- * @param s symbol
- * @param argc atom argument count
- * @param argv atom argument vector
  * @return t_max_err error code
+ *
+ * Called when the first py object is created.
  */
-t_max_err py_anything(t_py* x, t_symbol* s, long argc, t_atom* argv)
+t_max_err py_registry_new(void)
 {
-    t_atom atoms[PY_MAX_ATOMS];
-
-    if (s == gensym("")) {
-        return MAX_ERR_GENERIC; 
-    }
-
-    // set '=' as shorthand for assign method
-    if (s == gensym("=")) {
-        py_assign(x, gensym(""), argc, argv);
-        return MAX_ERR_NONE;
-    }
+    py_global_registry = (t_hashtab*)hashtab_new(0);
+    if (py_global_registry == NULL)
+        return MAX_ERR_OUT_OF_MEM;
+    hashtab_flags(py_global_registry, OBJ_FLAG_DATA);
+
+    py_global_registry_client = (t_object*)object_alloc(py_registry_class);
+    systhread_mutex_new(&py_global_registry_mutex, 0);
+    py_global_registry_generation = 0;
+    return MAX_ERR_NONE;
+}
 
-    // set symbol as first atom in new atoms array
-    atom_setsym(atoms, s);
+/**
+ * @brief Stop watching all boxes and patchers
+ */
+void py_registry_clear(void)
+{
+    if (py_global_registry_mutex == NULL)
+        return;
 
-    for (int i = 0; i < argc; i++) {
-        switch ((argv + i)->a_type) {
-        case A_FLOAT: {
-            atom_setfloat((atoms + (i + 1)), atom_getfloat(argv + i));
-            break;
-        }
-        case A_LONG: {
-            atom_setlong((atoms + (i + 1)), atom_getlong(argv + i));
-            break;
-        }
-        case A_SYM: {
-            atom_setsym((atoms + (i + 1)), atom_getsym(argv + i));
-            break;
-        }
-        default:
-            py_log(x, "cannot process unknown type");
-            break;
-        }
+    systhread_mutex_lock(py_global_registry_mutex);
+    for (long i = 0; i < py_global_registry_size; i++) {
+        while (py_global_registry_table[i] != NULL)
+            py_registry_remove(py_global_registry_table[i], 1);
     }
-
-    return py_eval_text(x, argc, atoms, 1);
+    systhread_mutex_unlock(py_global_registry_mutex);
 }
 
 /**
- * @brief Create a function python pipeline from a Max list
+ * @brief Free the registry of named objects
  *
- * @param x pointer to object structure
- * @param s symbol
- * @param argc atom argument count
- * @param argv atom argument vector
- * @return t_max_err error code
+ * Called when the last py object is freed.
  */
-t_max_err py_pipe(t_py* x, t_symbol* s, long argc, t_atom* argv)
+void py_registry_free(void)
 {
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
-
-    long textsize = 0;
-    char* text = NULL;
-    t_max_err err;
-    PyObject* pipe_pre = NULL;
-    PyObject* pipe_fun = NULL;
-    PyObject* pval = NULL;
-    PyObject* pstr = NULL;
+    py_registry_clear();
+
+    if (py_global_registry_table)
+        sysmem_freeptr(py_global_registry_table);
+    py_global_registry_table = NULL;
+    py_global_registry_size = 0;
+
+    object_free(py_global_registry_client);
+    py_global_registry_client = NULL;
+    hashtab_chuck(py_global_registry);
+    py_global_registry = NULL;
+    systhread_mutex_free(py_global_registry_mutex);
+    py_global_registry_mutex = NULL;
+}
 
-    err = atom_gettext(argc, argv, &textsize, &text,
-                       OBEX_UTIL_ATOM_GETTEXT_DEFAULT);
-    if (err != MAX_ERR_NONE || !textsize || !text) {
-        py_error(x, "atom -> text conversion failed");
-        goto error;
-    }
+/**
+ * @brief Make sure the registry covers a patcher
+ *
+ * @param patcher any patcher in the tree to cover
+ *
+ * The first call for a patcher tree walks all its boxes once and attaches
+ * to every patcher and box in it. From then on the registry is kept current
+ * by their notifications: boxes added to a watched patcher, scripting names
+ * changed and boxes or patchers freed. Further calls cost a table lookup.
+ */
+void py_registry_watch(t_object* patcher)
+{
+    t_object* top = NULL;
 
-    pipe_pre = PyRun_String(
-        "def __py_maxmsp_pipe(arg):\n"
-        "\targs = arg.split()\n"
-        "\tval = eval(args[0], locals(), globals())\n"
-        "\tfuncs = [eval(f, locals(), globals()) for f in args[1:]]\n"
-        "\tfor f in funcs:\n"
-        "\t\tval = f(val)\n"
-        "\treturn val\n",
-        Py_single_input, x->p_globals, x->p_globals);
+    if (patcher == NULL || py_global_registry_mutex == NULL)
+        return;
 
-    if (pipe_pre == NULL)
-    {
-        py_error(x, "pipe func is NULL");
-        goto error;
-    }
+    top = jpatcher_get_toppatcher(patcher);
+    if (top == NULL)
+        top = patcher;
 
-    pstr = PyUnicode_FromString(text);
-    if (pstr == NULL) {
-        py_error(x, "cstr -> pyunicode conversion failed");
-        goto error;
-    }
+    systhread_mutex_lock(py_global_registry_mutex);
+    if (py_registry_find(top) == NULL)
+        py_registry_scan(top);
+    systhread_mutex_unlock(py_global_registry_mutex);
+}
 
-    sysmem_freeptr(text);
+/**
+ * @brief Look up a named object in the registry
+ *
+ * @param x pointer to object struct whose patcher tree is searched
+ * @param name scripting name
+ * @param generation set to the generation of the binding if not NULL
+ * @return t_object* named object or NULL if not found
+ *
+ * The generation can be given later to `py_registry_resolve` to find out
+ * whether a pointer obtained here is still valid.
+ */
+t_object* py_registry_lookup(t_py* x, t_symbol* name, long* generation)
+{
+    t_py_registry_entry* entry = NULL;
+    t_object* obj = NULL;
 
-    pipe_fun = PyDict_GetItemString(x->p_globals, "__py_maxmsp_pipe");
-    if (pipe_fun == NULL) {
-        py_error(x, "retrieving pipe func from globals failed");
-        goto error;
+    py_registry_watch(x->p_patcher);
+    if (py_global_registry_mutex == NULL)
+        return NULL;
+
+    systhread_mutex_lock(py_global_registry_mutex);
+    if (hashtab_lookup(py_global_registry, name, (t_object**)&entry)
+            == MAX_ERR_NONE
+        && entry != NULL) {
+        obj = jbox_get_object(entry->key);
+        if (generation)
+            *generation = entry->generation;
     }
+    systhread_mutex_unlock(py_global_registry_mutex);
+    return obj;
+}
 
-    pval = PyObject_CallFunctionObjArgs(pipe_fun, pstr, NULL);
+/**
+ * @brief Get a named object if it is still bound as it was when looked up
+ *
+ * @param name scripting name
+ * @param generation generation returned by `py_registry_lookup`
+ * @return t_object* named object or NULL if it was freed or renamed
+ */
+t_object* py_registry_resolve(t_symbol* name, long generation)
+{
+    t_py_registry_entry* entry = NULL;
+    t_object* obj = NULL;
 
-    if (pval != NULL) {
+    if (py_global_registry_mutex == NULL)
+        return NULL;
 
-        if (!PyUnicode_Check(pval)) {
-            py_handle_output(x, pval); // this decrefs pval
-        } else {
-            // special case strings, which will cause crash if handled
-            // out of this methods's scope. (huge PITA to debug!)
-            const char* unicode_result = PyUnicode_AsUTF8(pval);
-            if (unicode_result == NULL) {
-                goto error;
-            }
-            outlet_anything(x->p_outlet_left, gensym(unicode_result), 0, NIL);
-            py_bang_success(x);
-            Py_XDECREF(pval);
-        }
+    systhread_mutex_lock(py_global_registry_mutex);
+    if (hashtab_lookup(py_global_registry, name, (t_object**)&entry)
+            == MAX_ERR_NONE
+        && entry != NULL && entry->generation == generation)
+        obj = jbox_get_object(entry->key);
+    systhread_mutex_unlock(py_global_registry_mutex);
+    return obj;
+}
 
-        Py_XDECREF(pipe_pre);
-        Py_XDECREF(pstr);
-        PyGILState_Release(gstate);
-        py_bang_success(x);
-        return MAX_ERR_NONE;
-    } else {
-        goto error;
+/**
+ * @brief Follow notifications from watched patchers and boxes
+ *
+ * @param client registry client object
+ * @param s registered name of the sender
+ * @param msg notification
+ * @param sender box or patcher
+ * @param data notification data
+ * @return t_max_err error code
+ */
+t_max_err py_registry_notify(t_object* client, t_symbol* s, t_symbol* msg,
+                             void* sender, void* data)
+{
+    t_py_registry_entry* entry = NULL;
+    t_symbol* name = NULL;
+
+    systhread_mutex_lock(py_global_registry_mutex);
+    entry = py_registry_find((t_object*)sender);
+    if (entry == NULL)
+        goto finally;
+
+    if (msg == gensym("free") || msg == gensym("willfree")) {
+        py_registry_remove(entry, 0);
+    } else if (entry->patcher == NULL) {
+        // a patcher passes a new box as data; boxes are appended, so only
+        // its last box is taken as new (anything else is left to `scan`)
+        if (data != NULL
+            && (t_object*)data == jpatcher_get_lastobject((t_object*)sender))
+            py_registry_add_box((t_object*)sender, (t_object*)data);
+    } else if (msg == gensym("attr_modified")) {
+        name = jbox_get_varname((t_object*)sender);
+        if (name != NULL && name->s_name[0] == '\0')
+            name = NULL;
+        if (name != entry->name)
+            py_registry_bind(entry, name);
     }
 
-error:
-    py_handle_error(x, "pipe failed");
-    Py_XDECREF(pipe_pre);
-    Py_XDECREF(pstr);
-    Py_XDECREF(pval);
-    // fail bang
-    PyGILState_Release(gstate);
-    py_bang_failure(x);
-    return MAX_ERR_GENERIC;
+finally:
+    systhread_mutex_unlock(py_global_registry_mutex);
+    return MAX_ERR_NONE;
 }
 
 /*--------------------------------------------------------------------------*/
 /* Interobject Methods */
 
 /**
- * @brief Scan object registry and populate object IDs.
+ * @brief Rebuild the registry of named objects from the object's patcher.
  * 
- * @param x 
+ * @param x pointer to object structure
+ *
+ * The registry follows patcher and box notifications, so this is only
+ * needed to recover from changes it could not observe.
  */
 void py_scan(t_py* x)
 {
-    long result = 0;
-
-    hashtab_clear(py_global_registry);
+    py_record(x, gensym("scan"), 0, NULL);
 
     if (x->p_patcher == NULL) {
-        post("p_patcher == NULL");
-    } else {
-        post("p_patcher != NULL");
-    }
-
-    if (x->p_patcher) {
-        object_method(x->p_patcher, gensym("iterate"),
-                      (method)py_scan_callback, x, PI_DEEP | PI_WANTBOX,
-                      &result);
-    } else {
         py_error(x, "scan failed");
-    }
-}
-
-/**
- * @brief A help function used by scan to scan registry and retrieve object IDs.
- * 
- * @param x 
- * @param box 
- * @return long 
- */
-long py_scan_callback(t_py* x, t_object* box)
-{
-    t_rect jr;
-    t_object* p;
-    t_symbol* s;
-    t_symbol* varname;
-    t_object* obj;
-    t_symbol* obj_id;
-
-    jbox_get_patching_rect(box, &jr);
-    p = jbox_get_patcher(box);
-    varname = jbox_get_varname(box);
-    obj = jbox_get_object(box);
-
-    // STRANGE BUG: single quotes in py_log cause a crash but not with post!!
-    // perhaps because post is a macro for object_post?
-    if (varname && varname != gensym("")) {
-        // post("XXXX -> '%s'", varname->s_name);
-        py_log(x, "storing object %s in the global registry", varname->s_name);
-        hashtab_store(py_global_registry, varname, obj);
-
-        obj_id = jbox_get_id(box);
-        s = jpatcher_get_name(p);
-
-        object_post(
-            (t_object*)x,
-            "in patcher:%s, varname:%s id:%s box @ x %ld y %ld, w %ld, h %ld",
-            s->s_name, varname->s_name, obj_id->s_name, (long)jr.x, (long)jr.y,
-            (long)jr.width, (long)jr.height);
+        return;
     }
 
-    return 0;
+    py_registry_clear();
+    py_registry_watch(x->p_patcher);
+    py_log(x, "registry: %ld named objects",
+           (long)hashtab_getsize(py_global_registry));
 }
 
 /**
@@ -2058,11 +7555,14 @@ long py_scan_callback(t_py* x, t_object* box)
  */
 t_max_err py_send(t_py* x, t_symbol* s, long argc, t_atom* argv)
 {
-    t_object* obj = NULL;
+    t_py_stats_span span = py_stats_begin(argc);
+    t_py_send_handle handle;
     char* obj_name = NULL;
     t_symbol* msg_sym = NULL;
     t_max_err err = 0;
 
+    py_record(x, s, argc, argv);
+
     if (argc < 2) {
         py_error(x, "need at least 2 args to send msg");
         goto error;
@@ -2080,18 +7580,6 @@ t_max_err py_send(t_py* x, t_symbol* s, long argc, t_atom* argv)
         goto error;
     }
 
-    // if registry is empty, scan it
-    if (hashtab_getsize(py_global_registry) == 0) {
-        py_scan(x);
-    }
-
-    // // lookup name in registry
-    err = hashtab_lookup(py_global_registry, gensym(obj_name), &obj);
-    if (err != MAX_ERR_NONE || obj == NULL) {
-        py_error(x, "no object found in the registry");
-        goto error;
-    }
-
     // atom after the name of the receiver
     switch ((argv + 1)->a_type) {
     case A_SYM: {
@@ -2115,46 +7603,186 @@ t_max_err py_send(t_py* x, t_symbol* s, long argc, t_atom* argv)
             goto error;
         }
 
-        argc = argc - 1;
-        argv = argv + 1;
+        argc = argc - 1;
+        argv = argv + 1;
+
+        break;
+    }
+    case A_LONG: {
+        msg_sym = gensym("int");
+        if (msg_sym == NULL) { // should check type here
+            goto error;
+        }
+
+        argc = argc - 1;
+        argv = argv + 1;
+
+        break;
+    }
+    default:
+        py_log(x, "cannot process unknown type");
+        goto error;
+    }
+
+    // lookup name in registry
+    err = py_send_bind(x, &handle, gensym(obj_name), msg_sym);
+    if (err != MAX_ERR_NONE) {
+        py_error(x, "no object found in the registry");
+        goto error;
+    }
+
+    err = py_send_dispatch(&handle, argc, argv);
+    if (err != MAX_ERR_NONE) {
+        py_error(x, "failed to send a message to object %s", obj_name);
+        goto error;
+    }
+
+    // success
+    return py_stats_end(x, PY_STATS_SEND, &span, MAX_ERR_NONE);
+
+error:
+    py_error(x, "send failed");
+    return py_stats_end(x, PY_STATS_SEND, &span, MAX_ERR_GENERIC);
+}
+
+/**
+ * @brief Bind a message to a named object.
+ *
+ * @param x pointer to object structure whose patcher tree is searched
+ * @param handle handle to fill in
+ * @param name scripting name of the receiver
+ * @param sel selector or NULL to choose one from the arguments
+ * @return t_max_err error code
+ *
+ * The receiver and, given a selector, its method are resolved once so that
+ * `py_send_dispatch` can call the method directly. Methods taking a single
+ * int or float, no argument or A_GIMME are called directly; any other
+ * signature goes through `object_method_typed`.
+ */
+t_max_err py_send_bind(t_py* x, t_py_send_handle* handle, t_symbol* name,
+                       t_symbol* sel)
+{
+    t_messlist* mess = NULL;
+
+    handle->name = name;
+    handle->sel = sel;
+    handle->fun = NULL;
+    handle->type = A_NOTHING;
+    handle->obj = py_registry_lookup(x, name, &handle->generation);
+    if (handle->obj == NULL)
+        return MAX_ERR_GENERIC;
+
+    if (sel == NULL)
+        return MAX_ERR_NONE;
+
+    mess = object_mess(handle->obj, sel);
+    if (mess == NULL)
+        return MAX_ERR_NONE;
 
+    switch (mess->m_type[0]) {
+    case A_GIMME:
+        break;
+    case A_LONG:
+    case A_FLOAT:
+    case A_NOTHING:
+        if (mess->m_type[0] != A_NOTHING && mess->m_type[1] != A_NOTHING)
+            return MAX_ERR_NONE;
         break;
+    default:
+        return MAX_ERR_NONE;
     }
-    case A_LONG: {
-        msg_sym = gensym("int");
-        if (msg_sym == NULL) { // should check type here
-            goto error;
+    handle->fun = mess->m_fun;
+    handle->type = mess->m_type[0];
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Send a message through a bound handle.
+ *
+ * @param handle handle filled in by `py_send_bind`
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err MAX_ERR_INVALID_PTR if the receiver was freed or renamed
+ *                   since binding, so the handle needs binding again
+ *
+ * Without a selector, no argument sends `bang`, a single number `int` or
+ * `float`, a leading symbol is the selector and anything else is a `list`.
+ */
+t_max_err py_send_dispatch(t_py_send_handle* handle, long argc, t_atom* argv)
+{
+    t_symbol* sel = handle->sel;
+    t_object* obj = py_registry_resolve(handle->name, handle->generation);
+
+    if (obj == NULL || obj != handle->obj)
+        return MAX_ERR_INVALID_PTR;
+
+    if (sel == NULL) {
+        if (argc == 0) {
+            sel = gensym("bang");
+        } else if (atom_gettype(argv) == A_SYM) {
+            sel = atom_getsym(argv);
+            argc--;
+            argv++;
+        } else if (argc > 1) {
+            sel = gensym("list");
+        } else if (atom_gettype(argv) == A_FLOAT) {
+            sel = gensym("float");
+        } else {
+            sel = gensym("int");
         }
+        return object_method_typed(obj, sel, argc, argv, NULL);
+    }
 
-        argc = argc - 1;
-        argv = argv + 1;
+    if (handle->fun == NULL)
+        return object_method_typed(obj, sel, argc, argv, NULL);
 
+    switch (handle->type) {
+    case A_GIMME:
+        ((t_py_gimme_method)handle->fun)(obj, sel, argc, argv);
+        break;
+    case A_LONG:
+        if (argc != 1)
+            return object_method_typed(obj, sel, argc, argv, NULL);
+        ((t_py_long_method)handle->fun)(obj, atom_getlong(argv));
+        break;
+    case A_FLOAT:
+        if (argc != 1)
+            return object_method_typed(obj, sel, argc, argv, NULL);
+        ((t_py_float_method)handle->fun)(obj, atom_getfloat(argv));
         break;
-    }
     default:
-        py_log(x, "cannot process unknown type");
+        if (argc != 0)
+            return object_method_typed(obj, sel, argc, argv, NULL);
+        ((t_py_none_method)handle->fun)(obj);
         break;
     }
+    return MAX_ERR_NONE;
+}
 
-    // methods to get method type
-    t_messlist* messlist = object_mess((t_object*)obj, msg_sym);
-    if (messlist) {
-        post("messlist->m_sym  (name of msg): %s", messlist->m_sym->s_name);
-        post("messlist->m_type (type of msg): %d", messlist->m_type[0]);
-    }
+/**
+ * @brief Send a batch of messages through bound handles.
+ *
+ * @param items handles and arguments in delivery order
+ * @param n number of items
+ * @param err set to the error of the first item not delivered
+ * @return long number of items delivered before stopping
+ *
+ * Does not touch python objects, so callers may release the GIL around it.
+ * Stops at the first failure so that the caller can bind that handle again
+ * and resume without reordering messages.
+ */
+long py_send_many(t_py_send_item* items, long n, t_max_err* err)
+{
+    long i = 0;
 
-    err = object_method_typed(obj, msg_sym, argc, argv, NULL);
-    if (err) {
-        py_error(x, "failed to send a message to object %s", obj_name);
-        goto error;
+    *err = MAX_ERR_NONE;
+    for (i = 0; i < n; i++) {
+        *err = py_send_dispatch(items[i].handle, items[i].argc,
+                                items[i].argv);
+        if (*err != MAX_ERR_NONE)
+            break;
     }
-
-    // success
-    return MAX_ERR_NONE;
-
-error:
-    py_error(x, "send failed");
-    return MAX_ERR_GENERIC;
+    return i;
 }
 
 /*--------------------------------------------------------------------------*/
@@ -2188,6 +7816,7 @@ void py_dblclick(t_py* x)
  */
 void py_read(t_py* x, t_symbol* s)
 {
+    py_record_sym(x, gensym("read"), s);
     defer((t_object*)x, (method)py_doread, s, 0, NULL);
 }
 
@@ -2222,8 +7851,10 @@ void py_doread(t_py* x, t_symbol* s, long argc, t_atom* argv)
  */
 void py_run(t_py* x)
 {
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    t_py_gil gstate;
+    py_record(x, gensym("run"), 0, NULL);
+    py_job_flush(x);
+    gstate = py_gil_ensure(x);
 
     PyObject* pval = NULL;
 
@@ -2239,14 +7870,14 @@ void py_run(t_py* x)
 
     // success cleanup
     Py_DECREF(pval);
-    PyGILState_Release(gstate);
+    py_gil_release(x, gstate);
     py_bang_success(x);
     return;
 
 error:
     py_handle_error(x, "run x->p_code failed");
     Py_XDECREF(pval);
-    PyGILState_Release(gstate);
+    py_gil_release(x, gstate);
     py_bang_failure(x);
 }
 
@@ -2268,7 +7899,9 @@ void py_edclose(t_py* x, char** text, long size)
     x->p_code_size = size + 1;
     x->p_code_editor = NULL;
     if (x->p_run_on_close) {
-        py_run(x);        
+        t_py* inner = py_record_mute(x);
+        py_run(x);
+        py_record_mute(inner);
     }
 }
 
@@ -2301,8 +7934,10 @@ void py_okclose(t_py* x, char *s, short *result)
  */
 t_max_err py_edsave(t_py* x, char** text, long size)
 {
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    t_py_gil gstate;
+    if (x->p_run_on_save)
+        py_job_flush(x);
+    gstate = py_gil_ensure(x);
 
     PyObject* pval = NULL;
 
@@ -2319,14 +7954,14 @@ t_max_err py_edsave(t_py* x, char** text, long size)
         // success cleanup
         Py_DECREF(pval);
     }
-    PyGILState_Release(gstate);
+    py_gil_release(x, gstate);
     py_log(x, "py_edsave: returning 0");
     return MAX_ERR_NONE;
 
 error:
     py_handle_error(x, "py_edsave with (possible) execution failed");
     Py_XDECREF(pval);
-    PyGILState_Release(gstate);
+    py_gil_release(x, gstate);
     py_log(x, "py_edsave: returning 1");
     return MAX_ERR_GENERIC;
 }
@@ -2339,10 +7974,222 @@ error:
  */
 void py_load(t_py* x, t_symbol* s)
 {
+    t_py* inner = NULL;
+
+    py_record_sym(x, gensym("load"), s);
+    inner = py_record_mute(x);
     py_read(x, s);
     py_execfile(x, s);
+    py_record_mute(inner);
+}
+
+
+
+/*--------------------------------------------------------------------------*/
+/* Atom arena */
+
+/* atoms for call-scoped `api` conversions (PyExternal.out_list and send)
+   come from a per-thread arena that is grown on demand and kept between
+   calls, so converting and sending a list does not allocate once the
+   arena has warmed up. Each thread has PY_ATOM_ARENA_LEVELS blocks, so
+   output that re-enters python on the same thread (one py object feeding
+   another) still gets arena atoms. Deeper nesting falls back to the heap.
+   A block must be given back on the thread that took it, before the call
+   returns: atoms that outlive a call (Atom.from_seq) are heap blocks. */
+
+typedef struct _py_atom_arena {
+    t_atom* atoms[PY_ATOM_ARENA_LEVELS];
+    long size[PY_ATOM_ARENA_LEVELS];
+    char busy[PY_ATOM_ARENA_LEVELS];
+} t_py_atom_arena;
+
+static _Thread_local t_py_atom_arena py_atom_arena;
+
+/**
+ * @brief Take a block of atoms from the calling thread's arena
+ *
+ * @param size number of atoms wanted, capped at PY_ATOM_ARENA_MAX
+ * @param capacity set to the number of atoms available (at least the
+ *                 capped size)
+ * @return t_atom* atoms to give back with py_atom_arena_release, or NULL
+ *         if allocation failed
+ */
+t_atom* py_atom_arena_acquire(long size, long* capacity)
+{
+    t_py_atom_arena* arena = &py_atom_arena;
+    t_atom* atoms = NULL;
+    long new_size = 0;
+
+    size = size < 1 ? 1 : (size > PY_ATOM_ARENA_MAX ? PY_ATOM_ARENA_MAX : size);
+
+    for (int i = 0; i < PY_ATOM_ARENA_LEVELS; i++) {
+        if (arena->busy[i])
+            continue;
+        if (size > arena->size[i]) {
+            new_size = arena->size[i] ? arena->size[i] : PY_MAX_ATOMS;
+            while (new_size < size)
+                new_size *= 2;
+            if (new_size > PY_ATOM_ARENA_MAX)
+                new_size = PY_ATOM_ARENA_MAX;
+            atoms = (t_atom*)sysmem_resizeptr(arena->atoms[i],
+                                              new_size * sizeof(t_atom));
+            if (atoms == NULL)
+                return NULL;
+            arena->atoms[i] = atoms;
+            arena->size[i] = new_size;
+        }
+        arena->busy[i] = 1;
+        *capacity = arena->size[i];
+        return arena->atoms[i];
+    }
+
+    // nested too deep: a temporary block
+    *capacity = size;
+    return (t_atom*)sysmem_newptr(size * sizeof(t_atom));
+}
+
+/**
+ * @brief Give atoms from py_atom_arena_acquire back, in any order
+ *
+ * @param atoms atoms returned by py_atom_arena_acquire on this thread
+ */
+void py_atom_arena_release(t_atom* atoms)
+{
+    t_py_atom_arena* arena = &py_atom_arena;
+
+    if (atoms == NULL)
+        return;
+    for (int i = 0; i < PY_ATOM_ARENA_LEVELS; i++) {
+        if (arena->busy[i] && arena->atoms[i] == atoms) {
+            arena->busy[i] = 0;
+            return;
+        }
+    }
+    sysmem_freeptr(atoms);
+}
+
+/**
+ * @brief Free the calling thread's arena before the thread exits
+ */
+void py_atom_arena_free(void)
+{
+    t_py_atom_arena* arena = &py_atom_arena;
+
+    for (int i = 0; i < PY_ATOM_ARENA_LEVELS; i++) {
+        if (arena->atoms[i] != NULL && !arena->busy[i]) {
+            sysmem_freeptr(arena->atoms[i]);
+            arena->atoms[i] = NULL;
+            arena->size[i] = 0;
+        }
+    }
+}
+
+/**
+ * @brief Convert a slice of a python list or tuple to atoms
+ *
+ * @param pseq python list or tuple
+ * @param start index of the first item
+ * @param n number of items to convert
+ * @param atoms atoms to set (at least n)
+ * @return long n, or -1 with a python error set
+ *
+ * The exact types int, float and str are handled first without any
+ * further checks. Ints too large for an atom become floats. Subclasses,
+ * bytes and numpy scalars take the slower path; other types raise
+ * TypeError.
+ */
+long py_items_to_atoms(PyObject* pseq, long start, long n, t_atom* atoms)
+{
+    PyObject** items = NULL;
+    PyObject* item = NULL;
+    const char* str = NULL;
+
+    if (!PyList_Check(pseq) && !PyTuple_Check(pseq)) {
+        PyErr_SetString(PyExc_TypeError, "expected a list or tuple");
+        return -1;
+    }
+    if (start < 0 || n < 0 || start + n > PySequence_Fast_GET_SIZE(pseq)) {
+        PyErr_SetString(PyExc_IndexError, "atom range out of bounds");
+        return -1;
+    }
+
+    items = PySequence_Fast_ITEMS(pseq) + start;
+    for (long i = 0; i < n; i++) {
+        item = items[i];
+        if (PyFloat_CheckExact(item)) {
+            atom_setfloat(atoms + i, PyFloat_AS_DOUBLE(item));
+        } else if (PyLong_CheckExact(item)) {
+            if (py_long_to_atom(item, atoms + i) < 0)
+                return -1;
+        } else if (PyUnicode_Check(item)) {
+            if ((str = PyUnicode_AsUTF8(item)) == NULL)
+                return -1;
+            atom_setsym(atoms + i, gensym(str));
+        } else if (PyBytes_Check(item)) {
+            atom_setsym(atoms + i, gensym(PyBytes_AS_STRING(item)));
+        } else {
+            int res = py_number_to_atom(item, atoms + i);
+            if (res < 0)
+                return -1;
+            if (res == 0) {
+                PyErr_Format(PyExc_TypeError, "cannot convert %s to an atom",
+                             Py_TYPE(item)->tp_name);
+                return -1;
+            }
+        }
+    }
+    return n;
 }
 
+/**
+ * @brief Output a python list or tuple as lists of atoms from the arena
+ *
+ * @param outlet outlet to output to
+ * @param pseq python list or tuple
+ * @return long number of list messages output, or -1 with a python error
+ *
+ * Sequences longer than PY_ATOM_ARENA_MAX are output as consecutive
+ * lists of at most that many atoms instead of being dropped. An empty
+ * sequence outputs an empty list.
+ */
+long py_outlet_items(void* outlet, PyObject* pseq)
+{
+    t_atom* atoms = NULL;
+    long argc = 0;
+    long capacity = 0;
+    long start = 0;
+    long count = 0;
+    long n = 0;
+
+    if (!PyList_Check(pseq) && !PyTuple_Check(pseq)) {
+        PyErr_SetString(PyExc_TypeError, "expected a list or tuple");
+        return -1;
+    }
+
+    argc = (long)PySequence_Fast_GET_SIZE(pseq);
+    if ((atoms = py_atom_arena_acquire(argc, &capacity)) == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    do {
+        // the list may change while output re-enters python
+        argc = (long)PySequence_Fast_GET_SIZE(pseq);
+        n = argc - start < capacity ? argc - start : capacity;
+        if (n < 0)
+            break;
+        if (py_items_to_atoms(pseq, start, n, atoms) < 0) {
+            count = -1;
+            break;
+        }
+        outlet_list(outlet, NULL, n, atoms);
+        start += n;
+        count++;
+    } while (start < argc);
+
+    py_atom_arena_release(atoms);
+    return count;
+}
 
 
 /*--------------------------------------------------------------------------*/
@@ -2356,73 +8203,459 @@ bool py_table_exists(t_py* x, char* table_name)
     return (table_get(gensym(table_name), &storage, &size) == 0);
 }
 
-t_max_err py_list_to_table(t_py* x, char* table_name, PyObject* plist)
+/**
+ * @brief Copy python ints into a table's storage in one pass
+ *
+ * Buffer objects with an integer format (array.array, numpy, memoryview,
+ * `api.Table`) are copied directly, anything else must be a sequence of
+ * ints. Copying a buffer whose format is the native long is a memcpy.
+ *
+ * @param obj    python buffer or sequence of ints
+ * @param dst    destination storage
+ * @param size   capacity of dst; extra source elements are not copied
+ * @return the number of source elements, or -1 with a python error set
+ */
+Py_ssize_t py_ints_to_longs(PyObject* obj, long* dst, Py_ssize_t size)
+{
+    Py_buffer view;
+    PyObject* seq = NULL;
+    PyObject** items = NULL;
+    const char* fmt = NULL;
+    Py_ssize_t len = 0;
+    Py_ssize_t n = 0;
+
+    if (PyObject_CheckBuffer(obj)) {
+        if (PyObject_GetBuffer(obj, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS))
+            return -1;
+        if (view.ndim > 1) {
+            PyErr_SetString(PyExc_ValueError, "expected a 1-d buffer");
+            goto buffer_error;
+        }
+        len = view.len / view.itemsize;
+        n = len < size ? len : size;
+        fmt = view.format ? view.format : "B";
+        if (*fmt == '@')
+            fmt++;
+
+#define PY_COPY_INTS(type)                                                    \
+    for (Py_ssize_t i = 0; i < n; i++)                                        \
+        dst[i] = (long)((const type*)view.buf)[i];                            \
+    break
+
+        switch (fmt[1] == '\0' ? fmt[0] : '\0') {
+        case 'b': PY_COPY_INTS(signed char);
+        case 'B': PY_COPY_INTS(unsigned char);
+        case 'h': PY_COPY_INTS(short);
+        case 'H': PY_COPY_INTS(unsigned short);
+        case 'i': PY_COPY_INTS(int);
+        case 'I': PY_COPY_INTS(unsigned int);
+        case 'l': memcpy(dst, view.buf, n * sizeof(long)); break;
+        case 'L': PY_COPY_INTS(unsigned long);
+        case 'q': PY_COPY_INTS(long long);
+        case 'Q': PY_COPY_INTS(unsigned long long);
+        case 'n': PY_COPY_INTS(Py_ssize_t);
+        case 'N': PY_COPY_INTS(size_t);
+        default:
+            PyErr_Format(PyExc_TypeError,
+                         "expected a buffer of ints, got format '%s'",
+                         view.format);
+            goto buffer_error;
+        }
+#undef PY_COPY_INTS
+
+        PyBuffer_Release(&view);
+        return len;
+
+    buffer_error:
+        PyBuffer_Release(&view);
+        return -1;
+    }
+
+    if ((seq = PySequence_Fast(obj, "expected a buffer or sequence of ints"))
+        == NULL)
+        return -1;
+
+    len = PySequence_Fast_GET_SIZE(seq);
+    n = len < size ? len : size;
+    items = PySequence_Fast_ITEMS(seq);
+    for (Py_ssize_t i = 0; i < n; i++) {
+        dst[i] = PyLong_AsLong(items[i]);
+        if (dst[i] == -1 && PyErr_Occurred()) {
+            Py_DECREF(seq);
+            return -1;
+        }
+    }
+    Py_DECREF(seq);
+    return len;
+}
+
+/**
+ * @brief Convert longs to a python list of ints, preallocated in one go
+ *
+ * @param src    source values
+ * @param n      number of values
+ * @return new reference to the list, or NULL with a python error set
+ */
+PyObject* py_longs_to_list(const long* src, Py_ssize_t n)
 {
-    long **storage, size, value;
+    PyObject* plist = NULL;
+    PyObject* p_long = NULL;
 
+    if ((plist = PyList_New(n)) == NULL)
+        return NULL;
+
+    for (Py_ssize_t i = 0; i < n; i++) {
+        if ((p_long = PyLong_FromLong(src[i])) == NULL) {
+            Py_DECREF(plist);
+            return NULL;
+        }
+        PyList_SET_ITEM(plist, i, p_long); // steals p_long
+    }
+    return plist;
+}
+
+t_max_err py_list_to_table(t_py* x, char* table_name, PyObject* plist)
+{
+    long **storage, size;
     Py_ssize_t len = 0;
-    PyObject* elem = NULL;
 
     if (plist == NULL) {
         goto error;
     }
 
-    if (!PyList_Check(plist)) {
+    if (table_get(gensym(table_name), &storage, &size)) {
+        PyErr_Format(PyExc_KeyError, "no table named '%s'", table_name);
         goto error;
     }
 
-    len = PyList_Size(plist);
-
+    // check the length first so the table is not partly overwritten
+    if ((len = PyObject_Length(plist)) < 0) {
+        goto error;
+    }
 
-    if (table_get(gensym(table_name), &storage, &size)) {
-        if (len > size)
-            goto error;
+    if (len > size) {
+        PyErr_Format(PyExc_ValueError, "%zd values do not fit table '%s' "
+                     "of size %ld", len, table_name, size);
+        goto error;
+    }
 
-        for(int i = 0; i < len; i++) {
-            elem = PyList_GetItem(plist, i);
-            value = PyLong_AsLong(elem);
-            *((*storage)+i) = value;
-            py_log(x, "storage[%d] = %d", i, value);
-        }
+    if (py_ints_to_longs(plist, *storage, size) < 0) {
+        goto error;
     }
-    Py_XDECREF(plist);
-    Py_XDECREF(elem);
+
+    table_dirty(gensym(table_name));
     return MAX_ERR_NONE;
 
 error:
     py_handle_error(x, "plist to table failed");
-    Py_XDECREF(plist);
-    Py_XDECREF(elem);
     return MAX_ERR_GENERIC;
 }
 
 
 PyObject* py_table_to_list(t_py* x, char* table_name)
 {
-
     PyObject* plist = NULL;
-    long **storage, size, value;
+    long **storage, size;
 
-    if ((plist = PyList_New(0)) == NULL) {
-        py_log(x, "could not create an empty python list");
+    if (table_get(gensym(table_name), &storage, &size)) {
+        py_error(x, "no table named '%s'", table_name);
         goto error;
     }
 
-    if (table_get(gensym(table_name), &storage, &size) == 0) {
-        for(int i = 0; i < size; i++) {
-            value = *((*storage)+i);
-            py_log(x, "storage[%d] = %d", i, value);
-            PyObject* p_long = PyLong_FromLong(value);
-            if (p_long == NULL) {
-                goto error;
-            }
-            PyList_Append(plist, p_long);
-            Py_DECREF(p_long);
-        }
-        return plist;
+    if ((plist = py_longs_to_list(*storage, size)) == NULL) {
+        py_handle_error(x, "table to list conversion failed");
+        goto error;
     }
+    return plist;
 
 error:
-    py_error(x, "table to list conversion failed");
     Py_RETURN_NONE;
 }
+
+
+/*--------------------------------------------------------------------------*/
+/* Buffer kernels */
+
+/* sample kernels for `api` buffer processing. They touch no python or max
+   state, so they can run without the GIL. The widest vector unit the
+   external is compiled for is used, with a scalar loop for the tail. */
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PY_VEC_WIDTH 8
+typedef __m256 t_py_vec;
+#define py_vec_load(p) _mm256_loadu_ps(p)
+#define py_vec_store(p, v) _mm256_storeu_ps(p, v)
+#define py_vec_set1(f) _mm256_set1_ps(f)
+#define py_vec_add(a, b) _mm256_add_ps(a, b)
+#define py_vec_sub(a, b) _mm256_sub_ps(a, b)
+#define py_vec_mul(a, b) _mm256_mul_ps(a, b)
+#define py_vec_max(a, b) _mm256_max_ps(a, b)
+#define py_vec_abs(v) _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v)
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PY_VEC_WIDTH 4
+typedef __m128 t_py_vec;
+#define py_vec_load(p) _mm_loadu_ps(p)
+#define py_vec_store(p, v) _mm_storeu_ps(p, v)
+#define py_vec_set1(f) _mm_set1_ps(f)
+#define py_vec_add(a, b) _mm_add_ps(a, b)
+#define py_vec_sub(a, b) _mm_sub_ps(a, b)
+#define py_vec_mul(a, b) _mm_mul_ps(a, b)
+#define py_vec_max(a, b) _mm_max_ps(a, b)
+#define py_vec_abs(v) _mm_andnot_ps(_mm_set1_ps(-0.0f), v)
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PY_VEC_WIDTH 4
+typedef float32x4_t t_py_vec;
+#define py_vec_load(p) vld1q_f32(p)
+#define py_vec_store(p, v) vst1q_f32(p, v)
+#define py_vec_set1(f) vdupq_n_f32(f)
+#define py_vec_add(a, b) vaddq_f32(a, b)
+#define py_vec_sub(a, b) vsubq_f32(a, b)
+#define py_vec_mul(a, b) vmulq_f32(a, b)
+#define py_vec_max(a, b) vmaxq_f32(a, b)
+#define py_vec_abs(v) vabsq_f32(v)
+#else
+#define PY_VEC_WIDTH 1
+typedef float t_py_vec;
+#define py_vec_load(p) (*(p))
+#define py_vec_store(p, v) (*(p) = (v))
+#define py_vec_set1(f) (f)
+#define py_vec_add(a, b) ((a) + (b))
+#define py_vec_sub(a, b) ((a) - (b))
+#define py_vec_mul(a, b) ((a) * (b))
+#define py_vec_max(a, b) ((a) > (b) ? (a) : (b))
+#define py_vec_abs(v) fabsf(v)
+#endif
+
+#define PY_VEC_BLOCK 1024 // vectors summed in float before adding to a double
+
+/**
+ * @brief Name of the vector unit the kernels were compiled for
+ *
+ * @return const char* "avx", "sse2", "neon" or "scalar"
+ */
+const char* py_kernel_isa(void)
+{
+#if defined(__AVX__)
+    return "avx";
+#elif defined(__SSE2__) || defined(_M_X64)
+    return "sse2";
+#elif defined(__ARM_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+/**
+ * @brief Multiply samples by a gain: dst = src * gain
+ *
+ * @param dst destination samples, may be src
+ * @param src source samples
+ * @param n number of samples
+ * @param gain linear gain
+ */
+void py_kernel_gain(float* dst, const float* src, long n, float gain)
+{
+    t_py_vec g = py_vec_set1(gain);
+    long i = 0;
+
+    for (; i + PY_VEC_WIDTH <= n; i += PY_VEC_WIDTH)
+        py_vec_store(dst + i, py_vec_mul(py_vec_load(src + i), g));
+    for (; i < n; i++)
+        dst[i] = src[i] * gain;
+}
+
+/**
+ * @brief Mix two signals: dst = a * gain_a + b * gain_b
+ *
+ * @param dst destination samples, may be a or b
+ * @param a first source
+ * @param gain_a gain of the first source
+ * @param b second source
+ * @param gain_b gain of the second source
+ * @param n number of samples
+ */
+void py_kernel_mix(float* dst, const float* a, float gain_a, const float* b,
+                   float gain_b, long n)
+{
+    t_py_vec ga = py_vec_set1(gain_a);
+    t_py_vec gb = py_vec_set1(gain_b);
+    long i = 0;
+
+    for (; i + PY_VEC_WIDTH <= n; i += PY_VEC_WIDTH)
+        py_vec_store(dst + i,
+                     py_vec_add(py_vec_mul(py_vec_load(a + i), ga),
+                                py_vec_mul(py_vec_load(b + i), gb)));
+    for (; i < n; i++)
+        dst[i] = a[i] * gain_a + b[i] * gain_b;
+}
+
+/**
+ * @brief Crossfade linearly from one signal to another
+ *
+ * @param dst destination samples, may be a or b
+ * @param a signal at the first frame
+ * @param b signal at the last frame
+ * @param frames number of frames
+ * @param channels interleaved channels per frame
+ *
+ * Each frame is a + (b - a) * t with t going from 0 to 1. Mono signals
+ * are vectorized; interleaved frames share t, so they are done per frame.
+ */
+void py_kernel_crossfade(float* dst, const float* a, const float* b,
+                         long frames, long channels)
+{
+    float step = frames > 1 ? 1.0f / (frames - 1) : 0.0f;
+    long i = 0;
+
+    if (channels == 1) {
+        float lanes[PY_VEC_WIDTH];
+        t_py_vec offsets, vstep;
+        for (int k = 0; k < PY_VEC_WIDTH; k++)
+            lanes[k] = (float)k;
+        offsets = py_vec_load(lanes);
+        vstep = py_vec_set1(step);
+        for (; i + PY_VEC_WIDTH <= frames; i += PY_VEC_WIDTH) {
+            // t from the frame index, so it does not drift over long fades
+            t_py_vec t = py_vec_mul(py_vec_add(py_vec_set1((float)i),
+                                               offsets), vstep);
+            t_py_vec va = py_vec_load(a + i);
+            t_py_vec d = py_vec_sub(py_vec_load(b + i), va);
+            py_vec_store(dst + i, py_vec_add(va, py_vec_mul(d, t)));
+        }
+    }
+    for (; i < frames; i++) {
+        float t = i * step;
+        for (long c = i * channels; c < (i + 1) * channels; c++)
+            dst[c] = a[c] + (b[c] - a[c]) * t;
+    }
+}
+
+/**
+ * @brief Largest absolute sample value
+ *
+ * @param src samples
+ * @param n number of samples
+ * @return float peak, 0 if n is 0
+ */
+float py_kernel_peak(const float* src, long n)
+{
+    float lanes[PY_VEC_WIDTH];
+    t_py_vec acc = py_vec_set1(0.0f);
+    float peak = 0.0f;
+    long i = 0;
+
+    for (; i + PY_VEC_WIDTH <= n; i += PY_VEC_WIDTH)
+        acc = py_vec_max(acc, py_vec_abs(py_vec_load(src + i)));
+    py_vec_store(lanes, acc);
+    for (int k = 0; k < PY_VEC_WIDTH; k++)
+        peak = lanes[k] > peak ? lanes[k] : peak;
+    for (; i < n; i++)
+        peak = fabsf(src[i]) > peak ? fabsf(src[i]) : peak;
+    return peak;
+}
+
+/**
+ * @brief Sum of squared sample values
+ *
+ * @param src samples
+ * @param n number of samples
+ * @return double sum of squares (rms is sqrt(sum / n))
+ *
+ * Lanes are summed in float for PY_VEC_BLOCK vectors at a time and then
+ * added to a double, which keeps long buffers accurate.
+ */
+double py_kernel_sumsq(const float* src, long n)
+{
+    float lanes[PY_VEC_WIDTH];
+    double sum = 0.0;
+    long i = 0;
+
+    while (i + PY_VEC_WIDTH <= n) {
+        t_py_vec acc = py_vec_set1(0.0f);
+        long end = i + PY_VEC_BLOCK * PY_VEC_WIDTH;
+        if (end > n)
+            end = n;
+        for (; i + PY_VEC_WIDTH <= end; i += PY_VEC_WIDTH) {
+            t_py_vec v = py_vec_load(src + i);
+            acc = py_vec_add(acc, py_vec_mul(v, v));
+        }
+        py_vec_store(lanes, acc);
+        for (int k = 0; k < PY_VEC_WIDTH; k++)
+            sum += lanes[k];
+    }
+    for (; i < n; i++)
+        sum += (double)src[i] * src[i];
+    return sum;
+}
+
+/**
+ * @brief Resample one channel by linear interpolation
+ *
+ * @param dst destination samples
+ * @param dst_frames number of destination frames
+ * @param dst_stride distance between destination frames in samples
+ * @param src source samples
+ * @param src_frames number of source frames
+ * @param src_stride distance between source frames in samples
+ *
+ * The first and last frames of both line up. Strides select one channel
+ * of interleaved samples, which rules out vector loads, so this is scalar.
+ */
+void py_kernel_resample(float* dst, long dst_frames, long dst_stride,
+                        const float* src, long src_frames, long src_stride)
+{
+    double ratio = 0.0;
+
+    if (dst_frames <= 0 || src_frames <= 0)
+        return;
+    if (dst_frames > 1)
+        ratio = (double)(src_frames - 1) / (dst_frames - 1);
+
+    for (long i = 0; i < dst_frames; i++) {
+        double pos = i * ratio;
+        long j = (long)pos;
+        float frac = (float)(pos - j);
+        float s0 = src[j * src_stride];
+        float s1 = j + 1 < src_frames ? src[(j + 1) * src_stride] : s0;
+        dst[i * dst_stride] = s0 + (s1 - s0) * frac;
+    }
+}
+
+/**
+ * @brief Fill a periodic hann window
+ *
+ * @param window destination
+ * @param n window size
+ */
+void py_kernel_hann(float* window, long n)
+{
+    for (long i = 0; i < n; i++)
+        window[i] = (float)(0.5 - 0.5 * cos(2.0 * Py_MATH_PI * i / n));
+}
+
+/**
+ * @brief Copy a frame of one channel multiplied by a window
+ *
+ * @param dst destination of n samples
+ * @param src first source sample
+ * @param src_stride distance between source frames in samples
+ * @param window n window coefficients
+ * @param n frame size
+ */
+void py_kernel_window(float* dst, const float* src, long src_stride,
+                      const float* window, long n)
+{
+    long i = 0;
+
+    if (src_stride == 1) {
+        for (; i + PY_VEC_WIDTH <= n; i += PY_VEC_WIDTH)
+            py_vec_store(dst + i, py_vec_mul(py_vec_load(src + i),
+                                             py_vec_load(window + i)));
+    }
+    for (; i < n; i++)
+        dst[i] = src[i * src_stride] * window[i];
+}
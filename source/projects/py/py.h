@@ -18,6 +18,8 @@
 /* max api */
 #include "ext.h"
 #include "ext_obex.h"
+#include "ext_dictobj.h"
+#include "ext_atomic.h"
 
 /* python */
 #define PY_SSIZE_T_CLEAN
@@ -33,8 +35,30 @@
 /* Constants */
 
 #define PY_MAX_ATOMS 128
+#define PY_ATOM_ARENA_LEVELS 4   // nested conversions per thread
+#define PY_ATOM_ARENA_MAX 32767  // atoms per arena block and list message
+                                 // (outlet_list takes a short argc)
 #define PY_MAX_LOG_CHAR 500 // high number during development
 #define PY_MAX_ERR_CHAR PY_MAX_LOG_CHAR
+#define PY_CODE_CACHE_SIZE 64 // compiled code objects cached per object
+#define PY_CALL_CACHE_SIZE 32 // resolved callables cached per object
+#define PY_PIPE_CACHE_SIZE 8 // compiled pipelines cached per object
+#define PY_PIPE_MAX_STAGES 16 // maximum number of functions in a pipeline
+#define PY_SYM_CACHE_SIZE 256 // interned symbol strings per object (power of 2)
+#define PY_WORKER_THREADS 8 // threads in the shared worker pool
+#define PY_JOB_QUEUE_SIZE 64 // queued and undelivered jobs per object
+#define PY_TIMER_ATOMS 8 // minimum atoms allocated per scheduled call
+#define PY_TIMER_POOL_SIZE 32 // atom buffers kept for reuse per object
+#define PY_ASYNC_STEPS 16 // asyncio loop steps per clock tick while busy
+#define PY_ASYNC_POLL 10.0 // ms between polls of asyncio file descriptors
+#define PY_REGISTRY_SIZE 64 // initial buckets of the registry (power of 2)
+#define PY_TRACE_SIZE 1024 // events kept per object when tracing (power of 2)
+#define PY_STATS_SUB_BITS 3 // latency histogram: 8 buckets per power of 2
+#define PY_STATS_MAX_EXP 34 // latency histogram: up to 2^35 ns (34 s)
+#define PY_STATS_BUCKETS (((PY_STATS_MAX_EXP - PY_STATS_SUB_BITS) << PY_STATS_SUB_BITS) + (2 << PY_STATS_SUB_BITS))
+#define PY_RECORD_MAGIC "PYRC" // signature at the start of a record log
+#define PY_RECORD_VERSION 1 // record log format version
+#define PY_RECORD_BUFFER 65536 // bytes buffered before a record log is written
 
 /*--------------------------------------------------------------------------*/
 /* Macros */
@@ -50,7 +74,7 @@
 /*--------------------------------------------------------------------------*/
 /* Globals */
 
-t_class* py_class;                    // global pointer to object class
+extern t_class* py_class;             // global pointer to object class
 static int py_global_obj_count;       // when 0 then free interpreter
 static t_hashtab* py_global_registry; // global object lookups
 
@@ -58,6 +82,14 @@ static t_hashtab* py_global_registry; // global object lookups
 /* Datastructures */
 
 typedef struct t_py t_py;
+typedef struct t_py_interp t_py_interp;
+
+typedef struct t_py_gil {
+    int mode;                   /*!< how the interpreter was entered */
+    PyGILState_STATE gstate;    /*!< main interpreter gil state */
+    PyThreadState* prev;        /*!< thread state swapped out on entry */
+    double wait;                /*!< ms spent acquiring the gil */
+} t_py_gil;
 
 /*--------------------------------------------------------------------------*/
 /* Object creation and destruction Methods */
@@ -74,9 +106,133 @@ void py_init_builtins(t_py* x);
 void py_init_osx_set_home_static_ext(void);
 void py_init_osx_set_home_shared_pkg(void);
 void py_init_osx_set_home_framework_ext(void);
-t_hashtab* get_global_registry(void);
 t_max_err py_eval_text(t_py* x, long argc, t_atom* argv, int offset);
 
+/*--------------------------------------------------------------------------*/
+/* Code cache helpers */
+
+PyObject* py_code_cache_get(t_py* x, const char* text, int mode);
+void py_code_cache_put(t_py* x, const char* text, int mode, PyObject* co);
+PyObject* py_code_cache_compile(t_py* x, const char* text, int mode);
+void py_code_cache_flush(t_py* x);
+
+/*--------------------------------------------------------------------------*/
+/* Call cache helpers */
+
+typedef struct t_py_call_entry t_py_call_entry;
+
+void py_dict_watch(t_py* x, PyObject* dict);
+uint64_t py_dict_version(t_py* x, PyObject* dict);
+t_py_call_entry* py_call_cache_get(t_py* x, t_symbol* name);
+void py_call_cache_flush(t_py* x);
+
+/*--------------------------------------------------------------------------*/
+/* Pipeline cache helpers */
+
+typedef struct t_py_pipe_entry t_py_pipe_entry;
+
+t_py_pipe_entry* py_pipe_cache_get(t_py* x, long argc, t_atom* argv);
+PyObject* py_pipe_run(t_py* x, t_py_pipe_entry* entry, PyObject* pval);
+void py_pipe_cache_flush(t_py* x);
+
+/*--------------------------------------------------------------------------*/
+/* Interpreter helpers */
+
+t_max_err py_interp_acquire(t_py* x);
+void py_interp_release(t_py* x);
+t_py_gil py_gil_ensure(t_py* x);
+void py_gil_release(t_py* x, t_py_gil gil);
+t_max_err py_interpreter_set(t_py* x, void* attr, long argc, t_atom* argv);
+
+/*--------------------------------------------------------------------------*/
+/* Registry helpers */
+
+typedef struct t_py_registry_entry t_py_registry_entry;
+
+t_max_err py_registry_new(void);
+void py_registry_free(void);
+void py_registry_clear(void);
+void py_registry_watch(t_object* patcher);
+t_object* py_registry_lookup(t_py* x, t_symbol* name, long* generation);
+t_object* py_registry_resolve(t_symbol* name, long generation);
+t_max_err py_registry_notify(t_object* client, t_symbol* s, t_symbol* msg,
+                             void* sender, void* data);
+
+/*--------------------------------------------------------------------------*/
+/* Worker thread helpers */
+
+typedef PyObject* (*t_py_job_value)(t_py* x, long argc, t_atom* argv);
+typedef t_max_err (*t_py_job_done)(t_py* x, long argc, t_atom* argv,
+                                   PyObject* pval);
+
+t_max_err py_workers_start(void);
+void py_workers_stop(void);
+t_max_err py_job_post(t_py* x, t_symbol* s, long argc, t_atom* argv,
+                      t_py_job_value value, t_py_job_done done, long stats);
+void py_job_deliver(t_py* x);
+void py_job_flush(t_py* x);
+void py_job_cancel(t_py* x);
+
+/*--------------------------------------------------------------------------*/
+/* Trace helpers */
+
+typedef struct t_py_trace_event t_py_trace_event;
+
+void py_trace(t_py* x, long id, t_ptr_int a, t_ptr_int b, double f);
+PyObject* py_trace_value(t_py* x, t_symbol* s, t_py_job_value value,
+                         long argc, t_atom* argv);
+t_max_err py_tracing_set(t_py* x, void* attr, long argc, t_atom* argv);
+t_max_err py_trace_dump(t_py* x, t_symbol* path);
+t_max_err py_trace_msg(t_py* x, t_symbol* s, long argc, t_atom* argv);
+
+/*--------------------------------------------------------------------------*/
+/* Stats helpers */
+
+typedef struct t_py_stats_entry t_py_stats_entry;
+
+typedef struct t_py_stats_span {
+    double start;               /*!< systimer time at entry in ms */
+    double wait;                /*!< ms spent acquiring the gil */
+    long atoms;                 /*!< number of atoms converted */
+} t_py_stats_span;
+
+t_py_stats_span py_stats_begin(long atoms);
+t_max_err py_stats_end(t_py* x, long id, t_py_stats_span* span,
+                       t_max_err err);
+void py_stats_atoms(t_py* x, long id, long atoms);
+t_max_err py_stats_to_dictionary(t_py* x, t_dictionary* d);
+t_max_err py_stats(t_py* x, t_symbol* s, long argc, t_atom* argv);
+
+/*--------------------------------------------------------------------------*/
+/* Record helpers */
+
+/* A record log starts with PY_RECORD_MAGIC, a PY_RECORD_VERSION byte and
+   the scheduler time in ms at which recording started as a double. Then
+   come records, each starting with a tag:
+
+   'S' <id> <length> <bytes>         defines the symbol with the next id
+   'M' <dt> <selector> <argc> atoms  a message, dt in microseconds since
+                                     the previous message (or the start)
+   atoms are 'l' <long>, 'f' <8 byte double> or 's' <symbol id>
+
+   Integers are LEB128 varints, signed ones (dt and longs) zigzag encoded.
+   Doubles are stored in host byte order (little endian on all targets). */
+
+enum {
+    PY_RECORD_SYMBOL = 'S',
+    PY_RECORD_MESSAGE = 'M',
+    PY_RECORD_LONG = 'l',
+    PY_RECORD_FLOAT = 'f',
+    PY_RECORD_SYM = 's',
+};
+
+void py_record(t_py* x, t_symbol* s, long argc, t_atom* argv);
+t_py* py_record_mute(t_py* x);
+t_max_err py_record_start(t_py* x, t_symbol* path);
+t_max_err py_record_stop(t_py* x);
+t_max_err py_record_msg(t_py* x, t_symbol* s, long argc, t_atom* argv);
+void py_stop(t_py* x);
+
 /*--------------------------------------------------------------------------*/
 /* Path helpers */
 
@@ -102,6 +258,28 @@ t_max_err py_handle_string_output(t_py* x, PyObject* pval);
 t_max_err py_handle_list_output(t_py* x, PyObject* pval);
 t_max_err py_handle_dict_output(t_py* x, PyObject* pval);
 t_max_err py_handle_output(t_py* x, PyObject* pval);
+t_symbol* py_gensym(t_py* x, const char* str);
+t_atom* py_atom_buffer(t_py* x, long size);
+void py_atom_buffer_output(t_py* x, long n);
+int py_buffer_to_atoms(t_py* x, PyObject* pbuf, long* n);
+int py_number_to_atom(PyObject* item, t_atom* atom);
+t_max_err py_dict_to_atoms(t_py* x, PyObject* pdict, const char* prefix,
+                           long* n);
+t_max_err py_dict_to_dictionary(t_py* x, PyObject* pdict, t_dictionary* d);
+t_atomarray* py_seq_to_atomarray(t_py* x, PyObject* pseq);
+PyObject* py_dict_atom_to_value(t_atom* atom, int arrays);
+PyObject* py_dictionary_entry_to_value(t_dictionary* d, t_symbol* key,
+                                       int arrays);
+PyObject* py_dictionary_to_dict(t_dictionary* d, int arrays);
+
+/*--------------------------------------------------------------------------*/
+/* Translators */
+
+PyObject* py_atoms_to_list(t_py* x, long argc, t_atom* argv, int start_from);
+PyObject* py_atoms_to_tuple(t_py* x, long argc, t_atom* argv, int start_from);
+PyObject* py_symbol_to_str(t_py* x, t_symbol* s);
+void py_symbol_cache_flush(t_py* x);
+long py_atoms_to_stack(t_py* x, long argc, t_atom* argv, PyObject** stack);
 
 /*--------------------------------------------------------------------------*/
 /* Core Python Methods */
@@ -110,6 +288,7 @@ t_max_err py_import(t_py* x, t_symbol* s);
 t_max_err py_eval(t_py* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err py_exec(t_py* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err py_execfile(t_py* x, t_symbol* s);
+t_max_err py_reset(t_py* x);
 
 /*--------------------------------------------------------------------------*/
 /* Extra Python Methods */
@@ -118,6 +297,9 @@ t_max_err py_assign(t_py* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err py_call(t_py* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err py_code(t_py* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err py_pipe(t_py* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err py_list(t_py* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err py_int(t_py* x, long n);
+t_max_err py_float(t_py* x, double f);
 t_max_err py_anything(t_py* x, t_symbol* s, long argc, t_atom* argv);
 
 /*--------------------------------------------------------------------------*/
@@ -133,13 +315,46 @@ void py_appendtodict(t_py* x, t_dictionary* dict);
 
 t_max_err py_task(t_py* x);
 t_max_err py_sched(t_py* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err py_sched_every(t_py* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err py_unsched(t_py* x, t_symbol* s, long argc, t_atom* argv);
+long py_sched_call(t_py* x, double delay, double interval, long argc,
+                   t_atom* argv);
+t_max_err py_unsched_call(t_py* x, long argc, t_atom* argv);
+void py_sched_id(t_py* x);
+t_max_err py_async(t_py* x, t_symbol* s, long argc, t_atom* argv);
+void py_async_tick(t_py* x);
+void py_async_close(t_py* x);
 
 /*--------------------------------------------------------------------------*/
 /* Interobject Methods */
 
+typedef void (*t_py_gimme_method)(t_object* x, t_symbol* s, long argc,
+                                  t_atom* argv);
+typedef void (*t_py_long_method)(t_object* x, t_atom_long n);
+typedef void (*t_py_float_method)(t_object* x, double f);
+typedef void (*t_py_none_method)(t_object* x);
+
+typedef struct t_py_send_handle {
+    t_symbol* name;             /*!< scripting name of the receiver */
+    t_symbol* sel;              /*!< selector or NULL to choose by args */
+    long generation;            /*!< registry generation of the binding */
+    t_object* obj;              /*!< receiver when bound */
+    method fun;                 /*!< resolved method or NULL if typed */
+    long type;                  /*!< argument type of fun */
+} t_py_send_handle;
+
+typedef struct t_py_send_item {
+    t_py_send_handle* handle;   /*!< bound receiver and selector */
+    long argc;                  /*!< number of atoms */
+    t_atom* argv;               /*!< message arguments */
+} t_py_send_item;
+
 t_max_err py_send(t_py* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err py_send_bind(t_py* x, t_py_send_handle* handle, t_symbol* name,
+                       t_symbol* sel);
+t_max_err py_send_dispatch(t_py_send_handle* handle, long argc, t_atom* argv);
+long py_send_many(t_py_send_item* items, long n, t_max_err* err);
 void py_scan(t_py* x);
-long py_scan_callback(t_py* x, t_object* obj);
 
 /*--------------------------------------------------------------------------*/
 /* Code editor Methods */
@@ -153,6 +368,15 @@ void py_edclose(t_py* x, char** text, long size);
 t_max_err py_edsave(t_py* x, char** text, long size);
 void py_okclose(t_py* x, char *s, short *result);
 
+/*--------------------------------------------------------------------------*/
+/* per-thread atom arena for `api` conversions */
+
+t_atom* py_atom_arena_acquire(long size, long* capacity);
+void py_atom_arena_release(t_atom* atoms);
+void py_atom_arena_free(void);
+long py_items_to_atoms(PyObject* pseq, long start, long n, t_atom* atoms);
+long py_outlet_items(void* outlet, PyObject* pseq);
+
 /*--------------------------------------------------------------------------*/
 /* max datastructure support methods */
 
@@ -160,6 +384,25 @@ void py_okclose(t_py* x, char *s, short *result);
 bool py_table_exists(t_py* x, char* table_name);
 t_max_err py_list_to_table(t_py* x, char* table_name, PyObject* plist);
 PyObject* py_table_to_list(t_py* x, char* table_name);
+Py_ssize_t py_ints_to_longs(PyObject* obj, long* dst, Py_ssize_t size);
+PyObject* py_longs_to_list(const long* src, Py_ssize_t n);
+
+/*--------------------------------------------------------------------------*/
+/* buffer kernels (no python or max state, safe without the GIL) */
+
+const char* py_kernel_isa(void);
+void py_kernel_gain(float* dst, const float* src, long n, float gain);
+void py_kernel_mix(float* dst, const float* a, float gain_a, const float* b,
+                   float gain_b, long n);
+void py_kernel_crossfade(float* dst, const float* a, const float* b,
+                         long frames, long channels);
+float py_kernel_peak(const float* src, long n);
+double py_kernel_sumsq(const float* src, long n);
+void py_kernel_resample(float* dst, long dst_frames, long dst_stride,
+                        const float* src, long src_frames, long src_stride);
+void py_kernel_hann(float* window, long n);
+void py_kernel_window(float* dst, const float* src, long src_stride,
+                      const float* window, long n);
 
 
 
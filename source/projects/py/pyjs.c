@@ -15,6 +15,13 @@ struct t_pyjs {
     t_symbol* p_pythonpath;    /*!< path to python directory */
     t_symbol* p_code_filepath; /*!< python filepath */
     t_bool p_debug;            /*!< bool to switch per-object debug state */
+    /* output conversion */
+    t_atom* p_atoms;           /*!< reusable atom buffer for output */
+    long p_atoms_size;         /*!< allocated size of atom buffer */
+    t_bool p_nested;           /*!< flatten nested dicts as key::subkey */
+    t_bool p_dictionary;       /*!< output dicts as max dictionaries */
+    t_dictionary* p_dict;      /*!< registered output dictionary (reused) */
+    t_symbol* p_dict_name;     /*!< name of registered output dictionary */
 };
 
 /*--------------------------------------------------------------------------*/
@@ -55,6 +62,8 @@ void ext_main(void* module_ref)
     CLASS_ATTR_CHAR(c, "debug",     0, t_pyjs, p_debug);
     CLASS_ATTR_SYM(c, "file",       0, t_pyjs, p_code_filepath);
     CLASS_ATTR_SYM(c, "pythonpath", 0, t_pyjs, p_pythonpath);
+    CLASS_ATTR_CHAR(c, "nested",    0, t_pyjs, p_nested);
+    CLASS_ATTR_CHAR(c, "dictionary", 0, t_pyjs, p_dictionary);
 
     /* activate for javascript wrapping */
     c->c_flags = CLASS_FLAG_POLYGLOT;
@@ -101,6 +110,12 @@ void* pyjs_new(t_symbol* s, long argc, t_atom* argv)
         x->p_pythonpath = gensym("");
         x->p_debug = 1;
         x->p_code_filepath = gensym("");
+        x->p_atoms = NULL;
+        x->p_atoms_size = 0;
+        x->p_nested = 0;
+        x->p_dictionary = 0;
+        x->p_dict = NULL;
+        x->p_dict_name = NULL;
 
         /* process @arg attributes */
         attr_args_process(x, argc, argv);
@@ -119,6 +134,10 @@ void* pyjs_new(t_symbol* s, long argc, t_atom* argv)
 void pyjs_free(t_pyjs* x)
 {
     Py_XDECREF(x->p_globals);
+    if (x->p_atoms)
+        sysmem_freeptr(x->p_atoms);
+    if (x->p_dict)
+        object_free(x->p_dict);
     pyjs_log(x, "will be deleted");
 
     /* crashes if one attempts to free.
@@ -548,6 +567,276 @@ error:
     return MAX_ERR_GENERIC;
 }
 
+/**
+ * @brief      Classify the element type of a buffer
+ *
+ * @param      view  buffer view with format information
+ *
+ * @return     'i' for signed, 'u' for unsigned integers, 'f' for floats or
+ *             0 if the layout is not supported
+ *
+ * Only single native-endian items are supported, with the element size
+ * taken from `itemsize`.
+ */
+static char pyjs_buffer_kind(const Py_buffer* view)
+{
+    const char* fmt = view->format ? view->format : "B";
+
+    switch (*fmt) {
+    case '@':
+    case '=':
+        fmt++;
+        break;
+#if PY_LITTLE_ENDIAN
+    case '<':
+#else
+    case '>':
+    case '!':
+#endif
+        fmt++;
+        break;
+    default:
+        break;
+    }
+
+    if (fmt[0] == '\0' || fmt[1] != '\0')
+        return 0;
+
+    switch (fmt[0]) {
+    case 'b': case 'h': case 'i': case 'l': case 'q': case 'n':
+        return (view->itemsize == 1 || view->itemsize == 2
+                || view->itemsize == 4 || view->itemsize == 8) ? 'i' : 0;
+    case 'B': case 'H': case 'I': case 'L': case 'Q': case 'N': case '?':
+        return (view->itemsize == 1 || view->itemsize == 2
+                || view->itemsize == 4 || view->itemsize == 8) ? 'u' : 0;
+    case 'f': case 'd':
+        return (view->itemsize == 4 || view->itemsize == 8) ? 'f' : 0;
+    default:
+        return 0;
+    }
+}
+
+#define PYJS_BUFFER_COPY(ctype, field, atype, dest, src, count)   \
+    do {                                                        \
+        const ctype* _src = (const ctype*)(src);                \
+        for (Py_ssize_t _i = 0; _i < (count); _i++) {           \
+            (dest)[_i].a_type = (atype);                        \
+            (dest)[_i].a_w.field = _src[_i];                    \
+        }                                                       \
+    } while (0)
+
+/**
+ * @brief      Convert the elements of a contiguous numeric buffer to atoms
+ *
+ * @param      kind      element kind from `pyjs_buffer_kind`
+ * @param      itemsize  element size in bytes
+ * @param      buf       contiguous elements
+ * @param      count     number of elements
+ * @param      atoms     atoms to set
+ *
+ * Unsigned 64-bit values above the max int range are set as floats.
+ */
+static void pyjs_buffer_copy(char kind, Py_ssize_t itemsize, const void* buf,
+                             Py_ssize_t count, t_atom* atoms)
+{
+    switch (kind) {
+    case 'i':
+        switch (itemsize) {
+        case 1: PYJS_BUFFER_COPY(int8_t, w_long, A_LONG, atoms, buf, count); break;
+        case 2: PYJS_BUFFER_COPY(int16_t, w_long, A_LONG, atoms, buf, count); break;
+        case 4: PYJS_BUFFER_COPY(int32_t, w_long, A_LONG, atoms, buf, count); break;
+        default: PYJS_BUFFER_COPY(int64_t, w_long, A_LONG, atoms, buf, count); break;
+        }
+        break;
+    case 'u':
+        switch (itemsize) {
+        case 1: PYJS_BUFFER_COPY(uint8_t, w_long, A_LONG, atoms, buf, count); break;
+        case 2: PYJS_BUFFER_COPY(uint16_t, w_long, A_LONG, atoms, buf, count); break;
+        case 4: PYJS_BUFFER_COPY(uint32_t, w_long, A_LONG, atoms, buf, count); break;
+        default: {
+            const uint64_t* src = (const uint64_t*)buf;
+            for (Py_ssize_t i = 0; i < count; i++) {
+                if (src[i] > (uint64_t)INT64_MAX)
+                    atom_setfloat(atoms + i, (double)src[i]);
+                else
+                    atom_setlong(atoms + i, (t_atom_long)src[i]);
+            }
+            break;
+        }
+        }
+        break;
+    default:
+        if (itemsize == 4)
+            PYJS_BUFFER_COPY(float, w_float, A_FLOAT, atoms, buf, count);
+        else
+            PYJS_BUFFER_COPY(double, w_float, A_FLOAT, atoms, buf, count);
+        break;
+    }
+}
+
+/**
+ * @brief      Convert a numeric buffer to atoms in one pass
+ *
+ * @param      x     pointer to object struct
+ * @param      pbuf  python object supporting the buffer protocol
+ * @param      n     number of atoms written to the atom buffer
+ *
+ * @return     1 if converted from an array, 2 if converted from a 0-d
+ *             buffer (a single scalar), 0 if the buffer is not a supported
+ *             numeric buffer (no error set), or -1 on error
+ *
+ * Used for `array.array`, `memoryview`, numpy arrays and numpy scalars to
+ * avoid creating a python object per element. Multi-dimensional arrays are
+ * flattened in C (row-major) order.
+ */
+int pyjs_buffer_to_atoms(t_pyjs* x, PyObject* pbuf, long* n)
+{
+    Py_buffer view;
+    t_atom* atoms = NULL;
+    void* buf = NULL;
+    Py_ssize_t count = 0;
+    char kind = 0;
+    int res = 0;
+
+    if (PyObject_GetBuffer(pbuf, &view, PyBUF_RECORDS_RO) == -1) {
+        PyErr_Clear();
+        return 0;
+    }
+
+    kind = pyjs_buffer_kind(&view);
+    count = view.itemsize ? view.len / view.itemsize : 0;
+    if (kind == 0 || count == 0) {
+        goto finally;
+    }
+
+    buf = view.buf;
+    if (!PyBuffer_IsContiguous(&view, 'C')) {
+        if ((buf = PyMem_Malloc(view.len)) == NULL) {
+            PyErr_NoMemory();
+            res = -1;
+            goto finally;
+        }
+        if (PyBuffer_ToContiguous(buf, &view, view.len, 'C') == -1) {
+            res = -1;
+            goto finally;
+        }
+    }
+
+    if ((atoms = pyjs_atom_buffer(x, count)) == NULL) {
+        PyErr_NoMemory();
+        res = -1;
+        goto finally;
+    }
+
+    pyjs_buffer_copy(kind, view.itemsize, buf, count, atoms);
+
+    *n = (long)count;
+    res = view.ndim == 0 ? 2 : 1;
+
+finally:
+    if (buf != NULL && buf != view.buf)
+        PyMem_Free(buf);
+    PyBuffer_Release(&view);
+    return res;
+}
+
+/**
+ * @brief      Convert a python int to an atom
+ *
+ * @param      plong  python int
+ * @param      atom   atom to set
+ *
+ * @return     1 if set, -1 on error
+ *
+ * Ints outside the range of a max int are set as floats.
+ */
+static int pyjs_long_to_atom(PyObject* plong, t_atom* atom)
+{
+    int overflow = 0;
+    long long long_item = PyLong_AsLongLongAndOverflow(plong, &overflow);
+
+    if (overflow) {
+        double float_item = PyLong_AsDouble(plong);
+        if (float_item == -1.0 && PyErr_Occurred())
+            return -1;
+        atom_setfloat(atom, float_item);
+        return 1;
+    }
+    if (long_item == -1 && PyErr_Occurred())
+        return -1;
+    atom_setlong(atom, (t_atom_long)long_item);
+    return 1;
+}
+
+/**
+ * @brief      Convert a 0-d numeric buffer, such as a 0-d numpy array
+ *
+ * @param      item  python object
+ * @param      atom  atom to set
+ *
+ * @return     1 if set, 0 otherwise (no error set)
+ */
+static int pyjs_buffer_scalar_to_atom(PyObject* item, t_atom* atom)
+{
+    Py_buffer view;
+    char kind = 0;
+
+    if (!PyObject_CheckBuffer(item) || PyBytes_Check(item)
+        || PyByteArray_Check(item))
+        return 0;
+
+    if (PyObject_GetBuffer(item, &view, PyBUF_RECORDS_RO) == -1) {
+        PyErr_Clear();
+        return 0;
+    }
+    if (view.ndim == 0 && (kind = pyjs_buffer_kind(&view)) != 0)
+        pyjs_buffer_copy(kind, view.itemsize, view.buf, 1, atom);
+    else
+        kind = 0;
+    PyBuffer_Release(&view);
+    return kind != 0;
+}
+
+/**
+ * @brief      Convert a python number to an atom
+ *
+ * @param      item  python object
+ * @param      atom  atom to set
+ *
+ * @return     1 if set, 0 if the object is not a number, -1 on error
+ *
+ * Besides int and float this accepts objects implementing `__index__` or
+ * `__float__`, such as numpy integer and floating point scalars, and 0-d
+ * numeric buffers such as 0-d numpy arrays.
+ */
+int pyjs_number_to_atom(PyObject* item, t_atom* atom)
+{
+    PyNumberMethods* nb = Py_TYPE(item)->tp_as_number;
+
+    if (PyFloat_Check(item)) {
+        atom_setfloat(atom, PyFloat_AS_DOUBLE(item));
+    } else if (PyLong_Check(item)) {
+        return pyjs_long_to_atom(item, atom);
+    } else if (pyjs_buffer_scalar_to_atom(item, atom)) {
+        return 1; /* 0-d arrays are sequences but hold a single number */
+    } else if (nb == NULL || PySequence_Check(item)) {
+        return 0; /* arrays implement the number slots but are not scalars */
+    } else if (nb->nb_index) {
+        PyObject* plong = PyNumber_Index(item);
+        int res = plong ? pyjs_long_to_atom(plong, atom) : -1;
+        Py_XDECREF(plong);
+        return res;
+    } else if (nb->nb_float && !PyComplex_Check(item)) {
+        double float_item = PyFloat_AsDouble(item);
+        if (float_item == -1.0 && PyErr_Occurred())
+            return -1;
+        atom_setfloat(atom, float_item);
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
 /**
  * @brief      Handler to output python list as max list
  *
@@ -559,10 +848,33 @@ error:
  */
 t_max_err pyjs_handle_list_output(t_pyjs* x, PyObject* plist, t_atom* rv)
 {
+    long n = 0;
+    int unsupported = 0; /* a buffer of a format pyjs_buffer_kind rejects */
+
     if (plist == NULL) {
         goto error;
     }
 
+    if (PyObject_CheckBuffer(plist) && !PyBytes_Check(plist)
+        && !PyByteArray_Check(plist)) {
+        int converted = pyjs_buffer_to_atoms(x, plist, &n);
+        if (converted < 0) {
+            goto error;
+        }
+        unsupported = converted == 0;
+        if (converted == 2) {
+            *rv = x->p_atoms[0];
+            Py_XDECREF(plist);
+            return MAX_ERR_NONE;
+        }
+        if (converted) {
+            atom_setobj(rv, object_new(gensym("nobox"), gensym("atomarray"),
+                                       n, x->p_atoms));
+            Py_XDECREF(plist);
+            return MAX_ERR_NONE;
+        }
+    }
+
     if (PySequence_Check(plist) && !PyUnicode_Check(plist)
         && !PyBytes_Check(plist) && !PyByteArray_Check(plist)) {
         PyObject* iter = NULL;
@@ -594,62 +906,49 @@ t_max_err pyjs_handle_list_output(t_pyjs* x, PyObject* plist, t_atom* rv)
             goto error;
         }
 
-        while ((item = PyIter_Next(iter)) != NULL) {
-
-            if (PyFloat_Check(item)) {
-                float float_item = PyFloat_AsDouble(item);
-                if (float_item == -1.0) {
-                    if (PyErr_Occurred())
-                        goto error;
-                }
-                atom_setfloat(atoms + i, float_item);
-                pyjs_log(x, "%d float: %f\n", i, float_item);
-                i++;
-            }
-
-            if (PyLong_Check(item)) {
-                long long_item = PyLong_AsLong(item);
-                if (long_item == -1) {
-                    if (PyErr_Occurred())
-                        goto error;
-                }
-                atom_setlong(atoms + i, long_item);
-                pyjs_log(x, "%d long: %ld\n", i, long_item);
-                i++;
-            }
-
-            // only for numpy int64 (not recognized by PyLong_Check)
-            // if (PyNumber_Check(item)) {
-            //     long long_item = PyLong_AsLong(item);
-            //     if (long_item == -1) {
-            //         if (PyErr_Occurred())
-            //             goto error;
-            //     }
-            //     atom_setlong(atoms + i, long_item);
-            //     pyjs_log(x, "%d long: %ld\n", i, long_item);
-            //     i++;
-            // }
-
+        while (i < seq_size && (item = PyIter_Next(iter)) != NULL) {
             if (PyUnicode_Check(item)) {
                 const char* unicode_item = PyUnicode_AsUTF8(item);
                 if (unicode_item == NULL) {
-                    goto error;
+                    Py_DECREF(item);
+                    break;
                 }
                 atom_setsym(atoms + i, gensym(unicode_item));
-                pyjs_log(x, "%d unicode: %s\n", i, unicode_item);
                 i++;
+            } else {
+                /* includes numpy scalars (via the number protocol) */
+                int res = pyjs_number_to_atom(item, atoms + i);
+                if (res < 0) {
+                    Py_DECREF(item);
+                    break;
+                }
+                i += res;
             }
             Py_DECREF(item);
         }
+        Py_DECREF(iter);
 
-        atom_setobj(
-            rv,
-            object_new(gensym("nobox"), gensym("atomarray"), (long)i, atoms));
-        pyjs_log(x, "end iter op: %d", i);
+        if (!PyErr_Occurred() && i == 0 && unsupported) {
+            PyErr_SetString(PyExc_TypeError,
+                            "cannot handle this buffer format");
+        }
+
+        if (!PyErr_Occurred()) {
+            atom_setobj(rv, object_new(gensym("nobox"), gensym("atomarray"),
+                                       (long)i, atoms));
+        }
         if (is_dynamic) {
             pyjs_log(x, "restoring to static atom array");
             atom_dynamic_end(atoms_static, atoms);
         }
+        if (PyErr_Occurred()) {
+            goto error;
+        }
+
+    } else {
+        /* e.g. a struct or complex buffer which is not a sequence */
+        pyjs_error(x, "cannot handle this type of value");
+        goto error;
     }
 
     Py_XDECREF(plist);
@@ -662,69 +961,387 @@ error:
 }
 
 /**
- * @brief      Handler to output python dict as max list
+ * @brief      Get the per-object atom output buffer, growing it if needed
+ *
+ * @param      x     pointer to object struct
+ * @param[in]  size  minimum number of atoms required
+ *
+ * @return     atom buffer or NULL if allocation failed
+ */
+t_atom* pyjs_atom_buffer(t_pyjs* x, long size)
+{
+    if (size > x->p_atoms_size) {
+        long new_size = x->p_atoms_size ? x->p_atoms_size * 2 : PY_MAX_ATOMS;
+        while (new_size < size)
+            new_size *= 2;
+
+        t_atom* atoms = (t_atom*)sysmem_resizeptr(x->p_atoms,
+                                                  new_size * sizeof(t_atom));
+        if (atoms == NULL) {
+            return NULL;
+        }
+        x->p_atoms = atoms;
+        x->p_atoms_size = new_size;
+    }
+    return x->p_atoms;
+}
+
+/**
+ * @brief      Append a python scalar to the atom output buffer
+ *
+ * @param      x     pointer to object struct
+ * @param      item  python number or str (other types are skipped)
+ * @param      n     current number of atoms in buffer (incremented)
+ *
+ * @return     The t_max_err error.
+ */
+static t_max_err pyjs_atom_buffer_append(t_pyjs* x, PyObject* item, long* n)
+{
+    t_atom* atoms = pyjs_atom_buffer(x, *n + 1);
+    if (atoms == NULL) {
+        PyErr_NoMemory();
+        return MAX_ERR_OUT_OF_MEM;
+    }
+
+    if (PyUnicode_Check(item)) {
+        const char* unicode_item = PyUnicode_AsUTF8(item);
+        if (unicode_item == NULL) {
+            return MAX_ERR_GENERIC;
+        }
+        atom_setsym(atoms + (*n)++, gensym(unicode_item));
+    } else {
+        int res = pyjs_number_to_atom(item, atoms + *n);
+        if (res < 0) {
+            return MAX_ERR_GENERIC;
+        }
+        *n += res;
+    }
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief      Flatten a python dict into the atom output buffer
+ *
+ * @param      x       pointer to object struct
+ * @param      pdict   python dict object
+ * @param      prefix  key path of a nested dict or NULL at top-level
+ * @param      n       current number of atoms in buffer (incremented)
+ *
+ * @return     The t_max_err error.
+ *
+ * Produces the `key : value1 value2 ...` layout, where list, tuple and set
+ * values are expanded. If the `nested` attribute is on, dict values are
+ * flattened recursively with `key::subkey` paths, otherwise they are
+ * skipped.
+ */
+t_max_err pyjs_dict_to_atoms(t_pyjs* x, PyObject* pdict, const char* prefix,
+                             long* n)
+{
+    PyObject* key = NULL;
+    PyObject* value = NULL;
+    PyObject* path = NULL;
+    Py_ssize_t pos = 0;
+    t_symbol* colon = gensym(":");
+    t_atom* atoms = NULL;
+    t_max_err err = MAX_ERR_NONE;
+
+    while (PyDict_Next(pdict, &pos, &key, &value)) {
+        if (prefix != NULL || (x->p_nested && PyDict_Check(value))) {
+            path = prefix ? PyUnicode_FromFormat("%s::%S", prefix, key)
+                          : PyObject_Str(key);
+            if (path == NULL) {
+                return MAX_ERR_GENERIC;
+            }
+        }
+
+        if (x->p_nested && PyDict_Check(value)) {
+            const char* cpath = PyUnicode_AsUTF8(path);
+            err = cpath ? pyjs_dict_to_atoms(x, value, cpath, n)
+                        : MAX_ERR_GENERIC;
+            Py_CLEAR(path);
+            if (err != MAX_ERR_NONE)
+                return err;
+            continue;
+        }
+
+        /* key */
+        err = pyjs_atom_buffer_append(x, path ? path : key, n);
+        Py_CLEAR(path);
+        if (err != MAX_ERR_NONE)
+            return err;
+
+        /* separator */
+        if ((atoms = pyjs_atom_buffer(x, *n + 1)) == NULL) {
+            PyErr_NoMemory();
+            return MAX_ERR_OUT_OF_MEM;
+        }
+        atom_setsym(atoms + (*n)++, colon);
+
+        /* value(s) */
+        if (PyList_Check(value) || PyTuple_Check(value)) {
+            Py_ssize_t size = PySequence_Fast_GET_SIZE(value);
+            PyObject** items = PySequence_Fast_ITEMS(value);
+            for (Py_ssize_t i = 0; i < size; i++) {
+                if ((err = pyjs_atom_buffer_append(x, items[i], n)) != MAX_ERR_NONE)
+                    return err;
+            }
+        } else if (PyAnySet_Check(value)) {
+            PyObject* iter = PyObject_GetIter(value);
+            PyObject* item = NULL;
+            if (iter == NULL)
+                return MAX_ERR_GENERIC;
+            while ((item = PyIter_Next(iter)) != NULL) {
+                err = pyjs_atom_buffer_append(x, item, n);
+                Py_DECREF(item);
+                if (err != MAX_ERR_NONE)
+                    break;
+            }
+            Py_DECREF(iter);
+            if (err != MAX_ERR_NONE || PyErr_Occurred())
+                return MAX_ERR_GENERIC;
+        } else {
+            if ((err = pyjs_atom_buffer_append(x, value, n)) != MAX_ERR_NONE)
+                return err;
+        }
+    }
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief      Convert a python value to an atom for a max dictionary
+ *
+ * @param      x      pointer to object struct
+ * @param      value  python object
+ * @param      atom   atom to set
+ *
+ * @return     1 if set, 0 if the type is not supported, -1 on error
+ *
+ * Dicts become child dictionaries and lists, tuples, sets and numeric
+ * buffers (such as numpy arrays) become atomarrays, both set as A_OBJ atoms
+ * owned by the caller. Numpy scalars are converted to numbers, and ints
+ * too large for an atom to floats.
+ */
+static int pyjs_value_to_dict_atom(t_pyjs* x, PyObject* value, t_atom* atom)
+{
+    long n = 0;
+    int res = 0;
+
+    if (PyLong_Check(value)) {
+        if (pyjs_long_to_atom(value, atom) < 0)
+            return -1;
+    } else if (PyFloat_Check(value)) {
+        atom_setfloat(atom, PyFloat_AS_DOUBLE(value));
+    } else if (PyUnicode_Check(value)) {
+        const char* str = PyUnicode_AsUTF8(value);
+        if (str == NULL)
+            return -1;
+        atom_setsym(atom, gensym(str));
+    } else if (PyDict_Check(value)) {
+        t_dictionary* d = dictionary_new();
+        if (pyjs_dict_to_dictionary(x, value, d) != MAX_ERR_NONE) {
+            object_free(d);
+            return -1;
+        }
+        atom_setobj(atom, d);
+    } else if (PyList_Check(value) || PyTuple_Check(value)
+               || PyAnySet_Check(value)) {
+        t_atomarray* aa = pyjs_seq_to_atomarray(x, value);
+        if (aa == NULL)
+            return -1;
+        atom_setobj(atom, aa);
+    } else if (PyObject_CheckBuffer(value) && !PyBytes_Check(value)
+               && !PyByteArray_Check(value)
+               && (res = pyjs_buffer_to_atoms(x, value, &n)) != 0) {
+        if (res < 0)
+            return -1;
+        if (res == 2) {
+            *atom = x->p_atoms[0];
+        } else {
+            t_atomarray* aa = atomarray_new(n, x->p_atoms);
+            if (aa == NULL)
+                return -1;
+            atom_setobj(atom, aa);
+        }
+    } else {
+        return pyjs_number_to_atom(value, atom);
+    }
+    return 1;
+}
+
+/**
+ * @brief      Convert a python list, tuple or set to a max atomarray
+ *
+ * @param      x     pointer to object struct
+ * @param      pseq  python sequence or set
+ *
+ * @return     new atomarray (freeing its child objects) or NULL
+ */
+t_atomarray* pyjs_seq_to_atomarray(t_pyjs* x, PyObject* pseq)
+{
+    PyObject* seq = NULL;
+    t_atomarray* aa = NULL;
+    t_atom* atoms = NULL;
+    Py_ssize_t size = 0;
+    long n = 0;
+
+    seq = PySequence_Fast(pseq, "expected a sequence");
+    if (seq == NULL)
+        return NULL;
+
+    size = PySequence_Fast_GET_SIZE(seq);
+    atoms = (t_atom*)sysmem_newptr(sizeof(t_atom) * (size ? size : 1));
+    if (atoms == NULL) {
+        PyErr_NoMemory();
+        goto finally;
+    }
+
+    for (Py_ssize_t i = 0; i < size; i++) {
+        int res = pyjs_value_to_dict_atom(x, PySequence_Fast_GET_ITEM(seq, i),
+                                          atoms + n);
+        if (res < 0)
+            goto finally;
+        n += res;
+    }
+
+    aa = atomarray_new(n, atoms);
+    if (aa != NULL) {
+        atomarray_flags(aa, ATOMARRAY_FLAG_FREECHILDREN);
+        n = 0; /* children now owned by the atomarray */
+    }
+
+finally:
+    if (atoms != NULL) {
+        for (long i = 0; i < n; i++) {
+            if (atom_gettype(atoms + i) == A_OBJ)
+                object_free(atom_getobj(atoms + i));
+        }
+        sysmem_freeptr(atoms);
+    }
+    Py_DECREF(seq);
+    return aa;
+}
+
+/**
+ * @brief      Copy a python dict into a max dictionary
+ *
+ * @param      x      pointer to object struct
+ * @param      pdict  python dict object
+ * @param      d      max dictionary to append entries to
+ *
+ * @return     The t_max_err error.
+ *
+ * Nested dicts become child dictionaries and lists, tuples and sets become
+ * atomarrays. Non-string keys are converted with `str()` and values of
+ * other types (including None) are skipped.
+ */
+t_max_err pyjs_dict_to_dictionary(t_pyjs* x, PyObject* pdict, t_dictionary* d)
+{
+    PyObject* key = NULL;
+    PyObject* value = NULL;
+    PyObject* pkey = NULL;
+    Py_ssize_t pos = 0;
+    t_symbol* skey = NULL;
+    t_atom atom;
+    int res = 0;
+
+    while (PyDict_Next(pdict, &pos, &key, &value)) {
+        pkey = PyObject_Str(key);
+        const char* ckey = pkey ? PyUnicode_AsUTF8(pkey) : NULL;
+        skey = ckey ? gensym(ckey) : NULL;
+        Py_CLEAR(pkey);
+        if (skey == NULL)
+            return MAX_ERR_GENERIC;
+
+        res = pyjs_value_to_dict_atom(x, value, &atom);
+        if (res < 0)
+            return MAX_ERR_GENERIC;
+        if (res == 0)
+            continue;
+
+        switch (atom_gettype(&atom)) {
+        case A_LONG:
+            dictionary_appendlong(d, skey, atom_getlong(&atom));
+            break;
+        case A_FLOAT:
+            dictionary_appendfloat(d, skey, atom_getfloat(&atom));
+            break;
+        case A_SYM:
+            dictionary_appendsym(d, skey, atom_getsym(&atom));
+            break;
+        default:
+            if (PyDict_Check(value)) {
+                dictionary_appenddictionary(d, skey, atom_getobj(&atom));
+            } else {
+                dictionary_appendatomarray(d, skey, atom_getobj(&atom));
+            }
+            break;
+        }
+    }
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief      Handler to output python dict as max list or dictionary
  *
  * @param      x      pointer to object struct
  * @param      pdict  python dict object
  * @param      rv     atom vector to populate in-place
  *
  * @return     The t_max_err error.
+ *
+ * The dict is flattened natively into the per-object atom buffer
+ * (see `pyjs_dict_to_atoms`) without calling back into python. If the
+ * `dictionary` attribute is on, it is copied into a registered max
+ * dictionary owned by the object instead, and `["dictionary", name]` is
+ * returned so that javascript can open it with `new Dict(name)`.
  */
 t_max_err pyjs_handle_dict_output(t_pyjs* x, PyObject* pdict, t_atom* rv)
 {
-    PyObject* pfun_co = NULL;
-    PyObject* pfun = NULL;
-    PyObject* pval = NULL;
+    long n = 0;
+    t_atom result[2];
 
     if (pdict == NULL) {
         goto error;
     }
 
-    if (PyDict_Check(pdict)) {
-
-        pfun_co = PyRun_String("def __py_maxmsp_out_dict(arg):\n"
-                               "\tres = []\n"
-                               "\tfor k,v in arg.items():\n"
-                               "\t\tres.append(k)\n"
-                               "\t\tres.append(':')\n"
-                               "\t\tif type(v) in [list, set, tuple]:\n"
-                               "\t\t\tfor i in v:\n"
-                               "\t\t\t\tres.append(i)\n"
-                               "\t\telse:\n"
-                               "\t\t\tres.append(v)\n"
-                               "\treturn res\n",
-                               Py_single_input, x->p_globals, x->p_globals);
-
-        if (pfun_co == NULL) {
-            pyjs_error(x, "out_dict function code object is NULL");
-            goto error;
+    if (PyDict_Check(pdict) && x->p_dictionary) {
+        if (x->p_dict == NULL) {
+            x->p_dict = dictobj_register(dictionary_new(), &x->p_dict_name);
+        } else {
+            dictionary_clear(x->p_dict);
         }
 
-        pfun = PyDict_GetItemString(x->p_globals, "__py_maxmsp_out_dict");
-        if (pfun == NULL) {
-            pyjs_error(x, "retrieving out_dict func from globals failed");
+        if (x->p_dict == NULL
+            || pyjs_dict_to_dictionary(x, pdict, x->p_dict) != MAX_ERR_NONE) {
             goto error;
         }
 
-        pval = PyObject_CallFunctionObjArgs(pfun, pdict, NULL);
-        if (pval == NULL) {
-            pyjs_error(x, "out_dict call failed to retrieve result");
+        atom_setsym(result, gensym("dictionary"));
+        atom_setsym(result + 1, x->p_dict_name);
+        atom_setobj(
+            rv,
+            object_new(gensym("nobox"), gensym("atomarray"), 2, result));
+    } else if (PyDict_Check(pdict)) {
+        if (pyjs_dict_to_atoms(x, pdict, NULL, &n) != MAX_ERR_NONE) {
             goto error;
         }
 
-        if (PyList_Check(pval)) { // expecting a python list
-            Py_XDECREF(pfun_co);
-            return pyjs_handle_list_output(x, pval, rv); // this decrefs pval
-        } else {
-            pyjs_error(x, "expected list output got something else");
+        if (n == 0) {
+            pyjs_error(x, "cannot convert py dict of length 0 to atoms");
             goto error;
         }
+
+        atom_setobj(
+            rv,
+            object_new(gensym("nobox"), gensym("atomarray"), n, x->p_atoms));
     }
 
+    Py_XDECREF(pdict);
+    return MAX_ERR_NONE;
+
 error:
     pyjs_handle_error(x, "pyjs_handle_dict_output failed");
-    Py_XDECREF(pfun_co);
-    Py_XDECREF(pval);
+    Py_XDECREF(pdict);
     return MAX_ERR_GENERIC;
 }
 
@@ -739,6 +1356,8 @@ error:
  */
 t_max_err pyjs_handle_output(t_pyjs* x, PyObject* pval, t_atom* rv)
 {
+    int res = 0;
+
     if (pval == NULL) {
         pyjs_error(x, "cannot handle NULL value");
         return MAX_ERR_GENERIC;
@@ -756,8 +1375,9 @@ t_max_err pyjs_handle_output(t_pyjs* x, PyObject* pval, t_atom* rv)
         return pyjs_handle_string_output(x, pval, rv);
     }
 
-    else if (PySequence_Check(pval) && !PyBytes_Check(pval)
-             && !PyByteArray_Check(pval)) {
+    else if ((PySequence_Check(pval) || PyObject_CheckBuffer(pval))
+             && !PyBytes_Check(pval) && !PyByteArray_Check(pval)) {
+        /* includes numpy arrays and scalars (via the buffer protocol) */
         return pyjs_handle_list_output(x, pval, rv);
     }
 
@@ -765,6 +1385,15 @@ t_max_err pyjs_handle_output(t_pyjs* x, PyObject* pval, t_atom* rv)
         return pyjs_handle_dict_output(x, pval, rv);
     }
 
+    else if ((res = pyjs_number_to_atom(pval, rv)) != 0) {
+        Py_DECREF(pval);
+        if (res < 0) {
+            pyjs_handle_error(x, "pyjs_handle_output failed");
+            return MAX_ERR_GENERIC;
+        }
+        return MAX_ERR_NONE;
+    }
+
     else if (pval == Py_None) {
         return MAX_ERR_NONE;
     }
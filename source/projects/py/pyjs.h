@@ -20,6 +20,7 @@
 
 #include "ext.h"
 #include "ext_obex.h"
+#include "ext_dictobj.h"
 
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
@@ -74,6 +75,12 @@ t_max_err pyjs_handle_float_output(t_pyjs* x, PyObject* pfloat, t_atom* rv);
 t_max_err pyjs_handle_long_output(t_pyjs* x, PyObject* plong, t_atom* rv);
 t_max_err pyjs_handle_list_output(t_pyjs* x, PyObject* plist, t_atom* rv);
 t_max_err pyjs_handle_dict_output(t_pyjs* x, PyObject* pdict, t_atom* rv);
+t_atom* pyjs_atom_buffer(t_pyjs* x, long size);
+int pyjs_buffer_to_atoms(t_pyjs* x, PyObject* pbuf, long* n);
+int pyjs_number_to_atom(PyObject* item, t_atom* atom);
+t_max_err pyjs_dict_to_atoms(t_pyjs* x, PyObject* pdict, const char* prefix, long* n);
+t_max_err pyjs_dict_to_dictionary(t_pyjs* x, PyObject* pdict, t_dictionary* d);
+t_atomarray* pyjs_seq_to_atomarray(t_pyjs* x, PyObject* pseq);
 
 
 #endif // PYJS_H
@@ -0,0 +1,521 @@
+/* bench_py.c -- micro-benchmarks of py's conversion and dispatch paths
+
+runs the real `py.c` against the headless max stub (see `maxstub/`) and
+measures atom -> python conversion, each kind of output handling, `call`
+at increasing arity, `code` evaluation, `pipe`, dict output, `api`
+list output, table and dictionary conversions at sizes from 1 to 100k atoms.
+
+for every scenario it reports the median ns/op over a fixed number of
+repeats, python and max allocations per op, and the peak resident set
+size seen so far. scenarios, sizes and data are fixed so that runs on the
+same machine can be compared directly.
+
+build and run (from the headless cmake build):
+
+    ./bench_py                      # all scenarios, table on stdout
+    ./bench_py -o before.json call  # only scenarios matching 'call'
+    ./bench_py --quick              # 1/100 of the iterations
+
+*/
+
+#include "ext.h"
+#include "ext_obex.h"
+
+#include "py.h"
+
+#include <sys/resource.h>
+#include <time.h>
+
+void ext_main(void* r);
+
+
+/* --------------------------------------- */
+// configuration
+
+#define BENCH_REPEATS 5
+#define BENCH_WORK 2000000 // atoms processed per repeat (before --quick)
+#define BENCH_MIN_ITERS 3
+#define BENCH_MAX_ATOMS 100000
+
+static const long bench_sizes[] = { 1, 10, 100, 1000, 10000, 100000 };
+static const long bench_arities[] = { 0, 1, 2, 4, 8, 16, 32, 64 };
+
+#define BENCH_COUNT(a) (long)(sizeof(a) / sizeof(a[0]))
+
+
+/* --------------------------------------- */
+// allocation counting
+
+static long bench_allocs = 0;
+
+static PyMemAllocatorEx bench_raw, bench_mem, bench_obj;
+
+static void* bench_malloc(void* ctx, size_t size)
+{
+    PyMemAllocatorEx* a = ctx;
+    __atomic_fetch_add(&bench_allocs, 1, __ATOMIC_RELAXED);
+    return a->malloc(a->ctx, size);
+}
+
+static void* bench_calloc(void* ctx, size_t nelem, size_t elsize)
+{
+    PyMemAllocatorEx* a = ctx;
+    __atomic_fetch_add(&bench_allocs, 1, __ATOMIC_RELAXED);
+    return a->calloc(a->ctx, nelem, elsize);
+}
+
+static void* bench_realloc(void* ctx, void* ptr, size_t size)
+{
+    PyMemAllocatorEx* a = ctx;
+    __atomic_fetch_add(&bench_allocs, 1, __ATOMIC_RELAXED);
+    return a->realloc(a->ctx, ptr, size);
+}
+
+static void bench_free(void* ctx, void* ptr)
+{
+    PyMemAllocatorEx* a = ctx;
+    a->free(a->ctx, ptr);
+}
+
+/**
+ * @brief Wrap the python allocators of a domain with a counting hook
+ *
+ * The hooks forward to the installed allocators, so they can be set up
+ * at any time.
+ */
+static void bench_hook(PyMemAllocatorDomain domain, PyMemAllocatorEx* orig)
+{
+    PyMemAllocatorEx hook = { orig, bench_malloc, bench_calloc,
+                              bench_realloc, bench_free };
+    PyMem_GetAllocator(domain, orig);
+    PyMem_SetAllocator(domain, &hook);
+}
+
+static long bench_alloc_count(void)
+{
+    return __atomic_load_n(&bench_allocs, __ATOMIC_RELAXED)
+        + maxstub_alloc_count();
+}
+
+
+/* --------------------------------------- */
+// scenarios
+
+typedef struct t_bench t_bench;
+typedef void (*t_bench_op)(t_bench* b);
+
+struct t_bench {
+    t_py* x;
+    long size;
+    long argc;
+    t_atom* argv;
+    PyObject* pval;
+    t_dictionary* d;
+};
+
+typedef struct t_bench_result {
+    char name[64];
+    long size;
+    long iters;
+    double ns_per_op;
+    double ns_min;
+    double allocs_per_op;
+    long peak_rss_kb;
+} t_bench_result;
+
+static t_bench_result* bench_results = NULL;
+static long bench_nresults = 0;
+static const char* bench_filter = NULL;
+static int bench_quick = 0;
+static t_atom bench_atoms[BENCH_MAX_ATOMS + 2];
+
+static double bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static long bench_peak_rss_kb(void)
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+static int bench_compare(const void* a, const void* b)
+{
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+/**
+ * @brief Fill the shared atom buffer with deterministic mixed atoms
+ *
+ * Atoms cycle through int, float and a small set of symbols, so symbol
+ * conversion exercises the cache rather than allocating new strings.
+ */
+static void bench_fill(long offset, long n)
+{
+    static const char* words[] = { "alpha", "beta", "gamma", "delta" };
+
+    for (long i = 0; i < n; i++) {
+        t_atom* a = bench_atoms + offset + i;
+        switch (i % 3) {
+        case 0:
+            atom_setlong(a, i);
+            break;
+        case 1:
+            atom_setfloat(a, i * 0.5);
+            break;
+        default:
+            atom_setsym(a, gensym(words[i % 4]));
+            break;
+        }
+    }
+}
+
+static void bench_run(t_bench* b, const char* name, t_bench_op op)
+{
+    double times[BENCH_REPEATS];
+    long work = bench_quick ? BENCH_WORK / 100 : BENCH_WORK;
+    long iters = work / (b->size > 0 ? b->size : 1);
+    long allocs = 0;
+    t_bench_result* r = NULL;
+
+    if (bench_filter && strstr(name, bench_filter) == NULL)
+        return;
+    if (iters < BENCH_MIN_ITERS)
+        iters = BENCH_MIN_ITERS;
+
+    // warm up caches (code, callables, symbols) before measuring
+    for (long i = 0; i < iters / 10 + 1; i++)
+        op(b);
+
+    for (int rep = 0; rep < BENCH_REPEATS; rep++) {
+        long before = bench_alloc_count();
+        double start = bench_now_ns();
+        for (long i = 0; i < iters; i++)
+            op(b);
+        times[rep] = (bench_now_ns() - start) / iters;
+        if (rep == 0)
+            allocs = bench_alloc_count() - before;
+    }
+    qsort(times, BENCH_REPEATS, sizeof(double), bench_compare);
+
+    bench_results = realloc(bench_results,
+                            (bench_nresults + 1) * sizeof(t_bench_result));
+    r = bench_results + bench_nresults++;
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->size = b->size;
+    r->iters = iters;
+    r->ns_per_op = times[BENCH_REPEATS / 2];
+    r->ns_min = times[0];
+    r->allocs_per_op = (double)allocs / iters;
+    r->peak_rss_kb = bench_peak_rss_kb();
+
+    printf("%-24s %8ld %10ld %14.1f %14.1f %10.2f %10ld\n", r->name,
+           r->size, r->iters, r->ns_per_op, r->ns_min, r->allocs_per_op,
+           r->peak_rss_kb);
+    fflush(stdout);
+}
+
+static void op_atoms_to_list(t_bench* b)
+{
+    Py_DECREF(py_atoms_to_list(b->x, b->argc, b->argv, 0));
+}
+
+// py_handle_output consumes its reference
+static void op_output(t_bench* b)
+{
+    Py_INCREF(b->pval);
+    py_handle_output(b->x, b->pval);
+}
+
+static void op_call(t_bench* b)
+{
+    py_call(b->x, gensym("call"), b->argc, b->argv);
+}
+
+static void op_code(t_bench* b)
+{
+    py_code(b->x, gensym("code"), b->argc, b->argv);
+}
+
+static void op_pipe(t_bench* b)
+{
+    py_pipe(b->x, gensym("pipe"), b->argc, b->argv);
+}
+
+static void op_list_to_table(t_bench* b)
+{
+    py_list_to_table(b->x, "bench_table", b->pval);
+}
+
+static void op_table_to_list(t_bench* b)
+{
+    Py_DECREF(py_table_to_list(b->x, "bench_table"));
+}
+
+static void op_outlet_items(t_bench* b)
+{
+    py_outlet_items(maxstub_outlet(b->x, 0), b->pval);
+}
+
+static void op_dictionary_to_dict(t_bench* b)
+{
+    Py_DECREF(py_dictionary_to_dict(b->d, 0));
+}
+
+static void op_dictionary_to_arrays(t_bench* b)
+{
+    Py_DECREF(py_dictionary_to_dict(b->d, 1));
+}
+
+/**
+ * @brief Evaluate a setup expression in a scratch namespace
+ */
+static PyObject* bench_value(t_bench* b, const char* fmt, long n)
+{
+    char expr[256];
+    PyObject* pval = NULL;
+    PyObject* globals = NULL;
+    t_py_gil gil = py_gil_ensure(b->x);
+
+    snprintf(expr, sizeof(expr), fmt, n);
+    globals = PyDict_New();
+    if (globals)
+        pval = PyRun_String(expr, Py_eval_input, globals, globals);
+    if (pval == NULL)
+        PyErr_Print();
+    Py_XDECREF(globals);
+    py_gil_release(b->x, gil);
+    return pval;
+}
+
+static void bench_output(t_bench* b, const char* name, const char* fmt,
+                         long n)
+{
+    t_py_gil gil;
+
+    b->size = n;
+    b->pval = bench_value(b, fmt, n);
+    if (b->pval == NULL)
+        return;
+    gil = py_gil_ensure(b->x);
+    bench_run(b, name, op_output);
+    Py_CLEAR(b->pval);
+    py_gil_release(b->x, gil);
+}
+
+static void bench_with(t_bench* b, const char* name, const char* fmt, long n,
+                       t_bench_op op)
+{
+    t_py_gil gil;
+
+    b->size = n;
+    b->pval = bench_value(b, fmt, n);
+    if (b->pval == NULL)
+        return;
+    gil = py_gil_ensure(b->x);
+    bench_run(b, name, op);
+    Py_CLEAR(b->pval);
+    py_gil_release(b->x, gil);
+}
+
+static void bench_dictionary(t_bench* b, const char* name, const char* fmt,
+                             long n, t_bench_op op)
+{
+    t_py_gil gil;
+
+    b->size = n;
+    b->pval = bench_value(b, fmt, n);
+    if (b->pval == NULL)
+        return;
+    gil = py_gil_ensure(b->x);
+    b->d = dictionary_new();
+    if (py_dict_to_dictionary(b->x, b->pval, b->d) == MAX_ERR_NONE)
+        bench_run(b, name, op);
+    object_free(b->d);
+    b->d = NULL;
+    Py_CLEAR(b->pval);
+    py_gil_release(b->x, gil);
+}
+
+static void bench_all(t_py* x)
+{
+    t_bench b = { x, 0, 0, bench_atoms, NULL, NULL };
+    t_py_gil gil;
+
+    object_method_typed(x, gensym("exec"), 1,
+                        &(t_atom){ .a_type = A_SYM,
+                                   .a_w.w_sym = gensym(
+                                       "f = lambda *a: len(a)") },
+                        NULL);
+
+    printf("%-24s %8s %10s %14s %14s %10s %10s\n", "scenario", "size",
+           "iters", "ns/op", "ns/op (min)", "allocs/op", "rss (kb)");
+
+    // atom -> python list
+    gil = py_gil_ensure(x);
+    for (long i = 0; i < BENCH_COUNT(bench_sizes); i++) {
+        b.size = b.argc = bench_sizes[i];
+        bench_fill(0, b.argc);
+        bench_run(&b, "atoms_to_list", op_atoms_to_list);
+    }
+    py_gil_release(x, gil);
+
+    // python -> outlets, by type
+    bench_output(&b, "output_long", "%ld", 1);
+    bench_output(&b, "output_float", "%ld.5", 1);
+    bench_output(&b, "output_string", "'s%ld'", 1);
+    for (long i = 0; i < BENCH_COUNT(bench_sizes); i++) {
+        bench_output(&b, "output_list", "[i * 0.5 for i in range(%ld)]",
+                     bench_sizes[i]);
+        bench_output(&b, "output_dict",
+                     "{'k%%d' %% i: i for i in range(%ld)}", bench_sizes[i]);
+    }
+
+    // call f with increasing arity
+    for (long i = 0; i < BENCH_COUNT(bench_arities); i++) {
+        b.size = bench_arities[i];
+        b.argc = b.size + 1;
+        atom_setsym(bench_atoms, gensym("f"));
+        bench_fill(1, b.size);
+        bench_run(&b, "call", op_call);
+    }
+
+    // code: a small expression and a list result of each size
+    b.size = 1;
+    b.argc = 1;
+    atom_setsym(bench_atoms, gensym("1 + 2"));
+    bench_run(&b, "code", op_code);
+    for (long i = 0; i < BENCH_COUNT(bench_sizes); i++) {
+        char expr[64];
+        snprintf(expr, sizeof(expr), "list(range(%ld))", bench_sizes[i]);
+        b.size = bench_sizes[i];
+        atom_setsym(bench_atoms, gensym(expr));
+        bench_run(&b, "code_list", op_code);
+    }
+
+    // pipe: a list value through two functions
+    for (long i = 0; i < BENCH_COUNT(bench_sizes); i++) {
+        char expr[64];
+        snprintf(expr, sizeof(expr), "list(range(%ld))", bench_sizes[i]);
+        b.size = bench_sizes[i];
+        b.argc = 3;
+        atom_setsym(bench_atoms, gensym(expr));
+        atom_setsym(bench_atoms + 1, gensym("reversed"));
+        atom_setsym(bench_atoms + 2, gensym("list"));
+        bench_run(&b, "pipe", op_pipe);
+    }
+
+    // api list output through the atom arena
+    for (long i = 0; i < BENCH_COUNT(bench_sizes); i++) {
+        bench_with(&b, "api_out_list", "[i * 0.5 for i in range(%ld)]",
+                   bench_sizes[i], op_outlet_items);
+    }
+
+    // tables: a list or an int buffer in, a list out
+    for (long i = 0; i < BENCH_COUNT(bench_sizes); i++) {
+        maxstub_table_new(gensym("bench_table"), bench_sizes[i]);
+        bench_with(&b, "list_to_table", "list(range(%ld))", bench_sizes[i],
+                   op_list_to_table);
+        bench_with(&b, "buffer_to_table",
+                   "memoryview(__import__('array').array('l', range(%ld)))",
+                   bench_sizes[i], op_list_to_table);
+        bench_with(&b, "table_to_list", "None", bench_sizes[i],
+                   op_table_to_list);
+    }
+
+    // max dictionary -> python dict, with lists or typed arrays: many
+    // small entries (up to 1000, as the stub's key lookup is linear) and
+    // one long atomarray
+    for (long i = 0; i < BENCH_COUNT(bench_sizes); i++) {
+        const char* fmt = "{'k%%d' %% i: {'v': [i, i * 0.5, i + 1, 0.25]} "
+                          "for i in range(%ld)}";
+        if (bench_sizes[i] > 1000)
+            break;
+        bench_dictionary(&b, "dictionary_to_dict", fmt, bench_sizes[i],
+                         op_dictionary_to_dict);
+        bench_dictionary(&b, "dictionary_to_arrays", fmt, bench_sizes[i],
+                         op_dictionary_to_arrays);
+    }
+    for (long i = 0; i < BENCH_COUNT(bench_sizes); i++) {
+        const char* fmt = "{'v': [i * 0.5 for i in range(%ld)]}";
+        bench_dictionary(&b, "dictionary_array_to_list", fmt, bench_sizes[i],
+                         op_dictionary_to_dict);
+        bench_dictionary(&b, "dictionary_array_to_array", fmt,
+                         bench_sizes[i], op_dictionary_to_arrays);
+    }
+}
+
+static int bench_write_json(const char* path)
+{
+    FILE* fp = fopen(path, "w");
+
+    if (fp == NULL) {
+        fprintf(stderr, "bench_py: cannot write %s\n", path);
+        return 1;
+    }
+    fprintf(fp, "{\n  \"python\": \"%s\",\n", PY_VERSION);
+    fprintf(fp, "  \"repeats\": %d,\n  \"quick\": %s,\n", BENCH_REPEATS,
+            bench_quick ? "true" : "false");
+    fprintf(fp, "  \"results\": [\n");
+    for (long i = 0; i < bench_nresults; i++) {
+        t_bench_result* r = bench_results + i;
+        fprintf(fp,
+                "    {\"name\": \"%s\", \"size\": %ld, \"iters\": %ld, "
+                "\"ns_per_op\": %.1f, \"ns_per_op_min\": %.1f, "
+                "\"allocs_per_op\": %.3f, \"peak_rss_kb\": %ld}%s\n",
+                r->name, r->size, r->iters, r->ns_per_op, r->ns_min,
+                r->allocs_per_op, r->peak_rss_kb,
+                i + 1 < bench_nresults ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    fclose(fp);
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* json_path = NULL;
+    t_py* x = NULL;
+    int err = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--quick") == 0) {
+            bench_quick = 1;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: bench_py [-o file.json] [--quick] "
+                            "[filter]\n");
+            return 2;
+        } else {
+            bench_filter = argv[i];
+        }
+    }
+
+    maxstub_set_quiet(1);
+    ext_main(NULL);
+    x = object_new_typed(CLASS_BOX, gensym("py"), 0, NULL);
+    if (x == NULL) {
+        fprintf(stderr, "bench_py: could not create a py object\n");
+        return 1;
+    }
+
+    bench_hook(PYMEM_DOMAIN_RAW, &bench_raw);
+    bench_hook(PYMEM_DOMAIN_MEM, &bench_mem);
+    bench_hook(PYMEM_DOMAIN_OBJ, &bench_obj);
+
+    bench_all(x);
+
+    if (json_path)
+        err = bench_write_json(json_path);
+
+    object_free(x);
+    free(bench_results);
+    return err;
+}
@@ -0,0 +1,252 @@
+/* bench_translate.c
+
+micro-benchmark of atom -> python conversion as used by `py_atoms_to_list`,
+`py_atoms_to_tuple` and `py_call`.
+
+compares the previous approach (PyList_New(0) + PyList_Append with a new
+PyUnicode per symbol, then PyList_AsTuple for calls) with the current one
+(preallocated list/tuple filled with SET_ITEM, symbols mapped to interned
+strings through a pointer-keyed cache).
+
+build and run:
+
+    ./build.sh bench_translate.c && ./bench_translate
+
+*/
+
+/* python */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <stdint.h>
+#include <time.h>
+
+
+/* --------------------------------------- */
+// minimal max-like types
+
+enum { A_NOTHING = 0, A_LONG, A_FLOAT, A_SYM };
+
+typedef struct _symbol {
+    const char* s_name;
+    void* s_thing;
+} t_symbol;
+
+typedef struct _atom {
+    short a_type;
+    union {
+        long w_long;
+        double w_float;
+        t_symbol* w_sym;
+    } a_w;
+} t_atom;
+
+#define SYM_POOL_SIZE 16
+#define SYM_CACHE_SIZE 256
+#define MIN_ITERATIONS 2000
+
+static t_symbol sym_pool[SYM_POOL_SIZE];
+static char sym_names[SYM_POOL_SIZE][16];
+
+typedef struct _sym_entry {
+    t_symbol* sym;
+    PyObject* str;
+} t_sym_entry;
+
+static t_sym_entry sym_cache[SYM_CACHE_SIZE];
+
+
+/* --------------------------------------- */
+// previous implementation
+
+PyObject* old_atoms_to_list(long argc, t_atom* argv)
+{
+    PyObject* plist = PyList_New(0);
+    if (plist == NULL)
+        return NULL;
+
+    for (long i = 0; i < argc; i++) {
+        PyObject* item = NULL;
+        switch (argv[i].a_type) {
+        case A_FLOAT:
+            item = PyFloat_FromDouble(argv[i].a_w.w_float);
+            break;
+        case A_LONG:
+            item = PyLong_FromLong(argv[i].a_w.w_long);
+            break;
+        case A_SYM:
+            item = PyUnicode_FromString(argv[i].a_w.w_sym->s_name);
+            break;
+        default:
+            continue;
+        }
+        PyList_Append(plist, item);
+        Py_DECREF(item);
+    }
+    return plist;
+}
+
+PyObject* old_atoms_to_tuple(long argc, t_atom* argv)
+{
+    PyObject* plist = old_atoms_to_list(argc, argv);
+    PyObject* ptuple = PyList_AsTuple(plist);
+    Py_DECREF(plist);
+    return ptuple;
+}
+
+
+/* --------------------------------------- */
+// current implementation
+
+static inline PyObject* symbol_to_str(t_symbol* s)
+{
+    t_sym_entry* entry = sym_cache
+        + (((uint64_t)(uintptr_t)s * 0x9E3779B97F4A7C15ULL) >> 32
+           & (SYM_CACHE_SIZE - 1));
+
+    if (entry->sym != s || entry->str == NULL) {
+        PyObject* str = PyUnicode_InternFromString(s->s_name);
+        if (str == NULL)
+            return NULL;
+        Py_XSETREF(entry->str, str);
+        entry->sym = s;
+    }
+    Py_INCREF(entry->str);
+    return entry->str;
+}
+
+static inline PyObject* atom_to_object(t_atom* atom)
+{
+    switch (atom->a_type) {
+    case A_FLOAT:
+        return PyFloat_FromDouble(atom->a_w.w_float);
+    case A_LONG:
+        return PyLong_FromLong(atom->a_w.w_long);
+    default:
+        return symbol_to_str(atom->a_w.w_sym);
+    }
+}
+
+static inline long atoms_count(long argc, t_atom* argv)
+{
+    long n = 0;
+    for (long i = 0; i < argc; i++) {
+        short type = argv[i].a_type;
+        n += (type == A_FLOAT || type == A_LONG || type == A_SYM);
+    }
+    return n;
+}
+
+PyObject* new_atoms_to_list(long argc, t_atom* argv)
+{
+    long n = 0;
+    PyObject* plist = PyList_New(atoms_count(argc, argv));
+    if (plist == NULL)
+        return NULL;
+
+    for (long i = 0; i < argc; i++) {
+        short type = argv[i].a_type;
+        if (type != A_FLOAT && type != A_LONG && type != A_SYM)
+            continue;
+        PyList_SET_ITEM(plist, n++, atom_to_object(argv + i));
+    }
+    return plist;
+}
+
+PyObject* new_atoms_to_tuple(long argc, t_atom* argv)
+{
+    long n = 0;
+    PyObject* ptuple = PyTuple_New(atoms_count(argc, argv));
+    if (ptuple == NULL)
+        return NULL;
+
+    for (long i = 0; i < argc; i++) {
+        short type = argv[i].a_type;
+        if (type != A_FLOAT && type != A_LONG && type != A_SYM)
+            continue;
+        PyTuple_SET_ITEM(ptuple, n++, atom_to_object(argv + i));
+    }
+    return ptuple;
+}
+
+
+/* --------------------------------------- */
+// benchmark
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void fill_atoms(long argc, t_atom* argv)
+{
+    for (long i = 0; i < argc; i++) {
+        switch (i % 3) {
+        case 0:
+            argv[i].a_type = A_LONG;
+            argv[i].a_w.w_long = i;
+            break;
+        case 1:
+            argv[i].a_type = A_FLOAT;
+            argv[i].a_w.w_float = i * 0.5;
+            break;
+        default:
+            argv[i].a_type = A_SYM;
+            argv[i].a_w.w_sym = sym_pool + (i % SYM_POOL_SIZE);
+            break;
+        }
+    }
+}
+
+static double bench(PyObject* (*func)(long, t_atom*), long argc,
+                    t_atom* argv, long iterations)
+{
+    double start = now();
+    for (long i = 0; i < iterations; i++) {
+        PyObject* res = func(argc, argv);
+        Py_DECREF(res);
+    }
+    return (now() - start) / iterations * 1e9; // ns per conversion
+}
+
+int main(int argc, char* argv[])
+{
+    long sizes[] = { 8, 128, 4096 };
+
+    Py_Initialize();
+
+    for (int i = 0; i < SYM_POOL_SIZE; i++) {
+        snprintf(sym_names[i], sizeof(sym_names[i]), "sym%d", i);
+        sym_pool[i].s_name = sym_names[i];
+    }
+
+    printf("%8s %14s %14s %8s %14s %14s %8s\n", "atoms", "list old ns",
+           "list new ns", "speedup", "tuple old ns", "tuple new ns",
+           "speedup");
+
+    for (int i = 0; i < 3; i++) {
+        long n = sizes[i];
+        long iterations = MIN_ITERATIONS * (4096 / n);
+        t_atom* atoms = (t_atom*)malloc(n * sizeof(t_atom));
+        fill_atoms(n, atoms);
+
+        double list_old = bench(old_atoms_to_list, n, atoms, iterations);
+        double list_new = bench(new_atoms_to_list, n, atoms, iterations);
+        double tuple_old = bench(old_atoms_to_tuple, n, atoms, iterations);
+        double tuple_new = bench(new_atoms_to_tuple, n, atoms, iterations);
+
+        printf("%8ld %14.1f %14.1f %7.2fx %14.1f %14.1f %7.2fx\n", n,
+               list_old, list_new, list_old / list_new, tuple_old,
+               tuple_new, tuple_old / tuple_new);
+        free(atoms);
+    }
+
+    for (int i = 0; i < SYM_CACHE_SIZE; i++)
+        Py_CLEAR(sym_cache[i].str);
+
+    Py_FinalizeEx();
+    return 0;
+}
@@ -0,0 +1,14 @@
+/* api_stub.c -- empty `api` module for the headless runtime
+ *
+ * `api.c` is generated by cython from `api.pyx` and includes most of the
+ * Max SDK. The headless build links this instead so that `py.c` can
+ * register its builtin `api` module without the SDK or cython.
+ */
+
+#include <Python.h>
+
+static struct PyModuleDef api_module = {
+    PyModuleDef_HEAD_INIT, "api", "headless api stub", -1, NULL,
+};
+
+PyMODINIT_FUNC PyInit_api(void) { return PyModule_Create(&api_module); }
@@ -0,0 +1,613 @@
+/* ext.h -- headless max-api stub */
+
+#ifndef MAXSTUB_EXT_H
+#define MAXSTUB_EXT_H
+
+/** \file ext.h
+    \brief A small headless stand-in for the subset of the Max SDK used
+    by the `py` and `pyjs` externals.
+
+    The declarations follow the Max SDK closely enough for the externals to
+    compile unchanged. The implementation lives in `maxstub.c`. Time is
+    virtual: clocks only fire when `maxstub_advance` is called and deferred
+    calls only run on `maxstub_run_deferred`.
+*/
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*--------------------------------------------------------------------------*/
+/* Types */
+
+#define MAX_PATH_CHARS 2048
+#define MAX_FILENAME_CHARS 512
+
+typedef long t_atom_long;
+typedef double t_atom_float;
+typedef long t_max_err;
+typedef long t_bool;
+typedef unsigned int t_fourcc;
+typedef intptr_t t_ptr_int;
+typedef uintptr_t t_ptr_uint;
+typedef uintptr_t t_ptr_size;
+typedef int32_t t_int32;
+typedef uint32_t t_uint32;
+typedef int64_t t_int64;
+typedef char** t_handle;
+typedef void* t_filehandle;
+typedef void* t_qelem;
+
+typedef void* (*method)(void*, ...);
+typedef void* (*t_intmethod)(void*, ...);
+
+enum {
+    MAX_ERR_NONE = 0,
+    MAX_ERR_GENERIC = -1,
+    MAX_ERR_INVALID_PTR = -2,
+    MAX_ERR_DUPLICATE = -3,
+    MAX_ERR_OUT_OF_MEM = -4,
+};
+
+typedef enum {
+    A_NOTHING = 0,
+    A_LONG,
+    A_FLOAT,
+    A_SYM,
+    A_OBJ,
+    A_DEFLONG,
+    A_DEFFLOAT,
+    A_DEFSYM,
+    A_GIMME,
+    A_CANT,
+    A_SEMI,
+    A_COMMA,
+    A_DOLLAR,
+    A_DOLLSYM,
+    A_GIMMEBACK,
+    A_DEFER = 0x41,
+    A_USURP = 0x42,
+    A_DEFER_LOW = 0x43,
+    A_USURP_LOW = 0x44
+} e_max_atomtypes;
+
+struct object;
+
+typedef struct symbol {
+    char* s_name;
+    struct object* s_thing;
+} t_symbol;
+
+union word {
+    t_atom_long w_long;
+    double w_float;
+    t_symbol* w_sym;
+    struct object* w_obj;
+};
+
+typedef struct atom {
+    short a_type;
+    union word a_w;
+} t_atom;
+
+#define MSG_MAXARG 7
+
+typedef struct messlist {
+    t_symbol* m_sym;
+    method m_fun;
+    char m_type[MSG_MAXARG + 1];
+} t_messlist;
+
+typedef struct maxclass t_class;
+
+typedef struct object {
+    t_class* o_class;     /* stub: class of object */
+    void* o_obex;         /* stub: obex storage */
+    void* o_inlet;
+    void* o_outlet;       /* stub: linked list of outlets */
+} t_object;
+
+struct maxclass {
+    t_symbol* c_sym;
+    long c_size;
+    method c_new;
+    method c_free;
+    long c_flags;
+    void* c_methods;      /* stub: method table */
+    void* c_attrs;        /* stub: attribute table */
+};
+
+typedef t_object t_patcher;
+typedef t_object t_box;
+typedef t_object t_dictionary;
+typedef t_object t_hashtab;
+typedef t_object t_atomarray;
+typedef t_object t_linklist;
+typedef t_object t_string;
+typedef t_object t_dictionary_entry;
+typedef t_object t_hashtab_entry;
+typedef t_object t_clock;
+
+typedef struct _rect {
+    double x;
+    double y;
+    double width;
+    double height;
+} t_rect;
+
+#define FOUR_CHAR_CODE(x) ((t_fourcc)(x))
+
+#define NIL ((t_atom*)0)
+
+#define CLASS_BOX gensym("box")
+#define CLASS_NOBOX gensym("nobox")
+#define CLASS_FLAG_POLYGLOT 0x00002000L
+
+#define OBJ_FLAG_OBJ 0x00000000
+#define OBJ_FLAG_REF 0x00000001
+#define OBJ_FLAG_DATA 0x00000002
+#define OBJ_FLAG_MEMORY 0x00000004
+
+#define ASSIST_INLET 1
+#define ASSIST_OUTLET 2
+
+#define PI_DEEP 1
+#define PI_REQUIREFIRSTIN 2
+#define PI_WANTBOX 4
+#define PI_SPAN 8
+
+#define READ_PERM 1
+#define WRITE_PERM 2
+
+#define TEXT_LB_NATIVE 0x00000001L
+#define TEXT_LB_MAC 0x00000002L
+#define TEXT_LB_PC 0x00000004L
+#define TEXT_LB_UNIX 0x00000008L
+#define TEXT_NULL_TERMINATE 0x00000020L
+
+#define PATH_STYLE_NATIVE 1
+#define PATH_TYPE_PATH 2
+#define PATH_TYPE_TILDE 4
+#define PATH_TYPE_ABSOLUTE 1
+
+#define OBEX_UTIL_ATOM_GETTEXT_DEFAULT 0x00000000
+#define OBEX_UTIL_ATOM_GETTEXT_TRUNCATE_ZEROS 0x00000001
+#define OBEX_UTIL_ATOM_GETTEXT_SYM_NO_QUOTE 0x00000002
+
+#define DICTOBJ_ATOM_FLAGS_DEFAULT 0
+#define DICTOBJ_ATOM_FLAGS_REGISTER 1
+
+#define calcoffset(x, y) ((t_ptr_int)(&(((x*)0L)->y)))
+#define structmembersize(structname, membername) \
+    (sizeof(((structname*)0)->membername))
+
+/*--------------------------------------------------------------------------*/
+/* Symbols */
+
+t_symbol* gensym(const char* s);
+t_symbol* gensym_tr(const char* s);
+t_symbol* symbol_unique(void);
+
+/*--------------------------------------------------------------------------*/
+/* Console */
+
+void post(const char* fmt, ...);
+void cpost(const char* fmt, ...);
+void error(const char* fmt, ...);
+void object_post(t_object* x, const char* s, ...);
+void object_error(t_object* x, const char* s, ...);
+void object_warn(t_object* x, const char* s, ...);
+void postatom(t_atom* ap);
+void postdictionary(t_object* d);
+
+/*--------------------------------------------------------------------------*/
+/* Memory */
+
+void* sysmem_newptr(long size);
+void* sysmem_newptrclear(long size);
+void* sysmem_resizeptr(void* ptr, long newsize);
+void* sysmem_resizeptrclear(void* ptr, long newsize);
+long sysmem_ptrsize(void* ptr);
+void sysmem_freeptr(void* ptr);
+void sysmem_copyptr(const void* src, void* dst, long bytes);
+t_handle sysmem_newhandle(long size);
+t_handle sysmem_newhandleclear(unsigned long size);
+long sysmem_handlesize(t_handle handle);
+t_max_err sysmem_resizehandle(t_handle handle, long newsize);
+void sysmem_freehandle(t_handle handle);
+char* strncpy_zero(char* dst, const char* src, long size);
+char* strncat_zero(char* dst, const char* src, long size);
+int snprintf_zero(char* buffer, size_t count, const char* format, ...);
+
+/*--------------------------------------------------------------------------*/
+/* Atoms */
+
+t_max_err atom_setlong(t_atom* a, t_atom_long b);
+t_max_err atom_setfloat(t_atom* a, double b);
+t_max_err atom_setsym(t_atom* a, t_symbol* b);
+t_max_err atom_setobj(t_atom* a, void* b);
+t_atom_long atom_getlong(const t_atom* a);
+t_atom_float atom_getfloat(const t_atom* a);
+t_symbol* atom_getsym(const t_atom* a);
+void* atom_getobj(const t_atom* a);
+long atom_gettype(const t_atom* a);
+t_max_err atom_gettext(long ac, t_atom* av, long* textsize, char** text,
+                       long flags);
+t_max_err atom_setparse(long* ac, t_atom** av, const char* parsestr);
+t_max_err atom_alloc(long* ac, t_atom** av, char* alloc);
+t_max_err atom_alloc_array(long minsize, long* ac, t_atom** av, char* alloc);
+t_atom* atom_dynamic_start(const t_atom* local_buf, long local_count,
+                           long requested_count);
+void atom_dynamic_end(const t_atom* local_buf, t_atom* buf);
+t_max_err atom_arg_getsym(t_symbol** c, long idx, long ac, const t_atom* av);
+t_max_err atom_arg_getlong(t_atom_long* c, long idx, long ac,
+                           const t_atom* av);
+t_max_err atom_arg_getdouble(double* c, long idx, long ac, const t_atom* av);
+
+/*--------------------------------------------------------------------------*/
+/* Classes and objects */
+
+t_class* class_new(const char* name, const method mnew, const method mfree,
+                   long size, const method mmenu, short type, ...);
+t_max_err class_addmethod(t_class* c, const method m, const char* name, ...);
+t_max_err class_register(t_symbol* name_space, t_class* c);
+t_max_err class_addattr(t_class* c, t_object* attr);
+short class_getpath(t_class* c);
+void* object_alloc(t_class* c);
+void* object_new(t_symbol* name_space, t_symbol* classname, ...);
+void* object_new_typed(t_symbol* name_space, t_symbol* classname, long ac,
+                       t_atom* av);
+void* newinstance(const t_symbol* s, short argc, const t_atom* argv);
+t_max_err object_free(void* x);
+t_symbol* object_classname(void* x);
+void* object_method(void* x, t_symbol* s, ...);
+t_max_err object_method_typed(void* x, t_symbol* s, long ac, t_atom* av,
+                              t_atom* rv);
+method object_getmethod(void* x, t_symbol* s);
+t_messlist* object_mess(t_object* x, t_symbol* methodname);
+void* object_register(t_symbol* name_space, t_symbol* s, void* x);
+t_max_err object_unregister(void* x);
+void* object_findregistered(t_symbol* name_space, t_symbol* s);
+void* object_attach(t_symbol* name_space, t_symbol* s, void* x);
+t_max_err object_detach(t_symbol* name_space, t_symbol* s, void* x);
+void* object_attach_byptr(void* x, void* registeredobject);
+void* object_attach_byptr_register(void* x, void* object_to_attach,
+                                   t_symbol* reg_name_space);
+t_max_err object_detach_byptr(void* x, void* registeredobject);
+t_max_err object_notify(void* x, t_symbol* s, void* data);
+t_max_err object_obex_lookup(void* x, t_symbol* key, t_object** val);
+t_max_err object_obex_store(void* x, t_symbol* key, t_object* val);
+t_max_err object_retain(t_object* x);
+t_max_err object_release(t_object* x);
+
+/* attributes */
+#define ATTR_GET_OPAQUE 0x00000001
+#define ATTR_SET_OPAQUE 0x00000002
+#define ATTR_GET_OPAQUE_USER 0x00000100
+#define ATTR_SET_OPAQUE_USER 0x00000200
+t_object* attr_offset_new(const char* name, const t_symbol* type, long flags,
+                          const method mget, const method mset, long offset);
+long attr_args_offset(short ac, t_atom* av);
+void attr_args_process(void* x, short ac, t_atom* av);
+t_max_err object_attr_setsym(void* x, t_symbol* s, t_symbol* c);
+t_max_err object_attr_setlong(void* x, t_symbol* s, t_atom_long c);
+t_max_err object_attr_setfloat(void* x, t_symbol* s, double c);
+t_max_err object_attr_setchar(void* x, t_symbol* s, unsigned char c);
+t_max_err object_attr_setvalueof(void* x, t_symbol* s, long argc,
+                                 t_atom* argv);
+t_max_err object_attr_getvalueof(void* x, t_symbol* s, long* argc,
+                                 t_atom** argv);
+t_symbol* object_attr_getsym(void* x, t_symbol* s);
+t_atom_long object_attr_getlong(void* x, t_symbol* s);
+double object_attr_getfloat(void* x, t_symbol* s);
+
+#define CLASS_ATTR_SYM(c, attrname, flags, structname, structmember)        \
+    class_addattr((c), attr_offset_new(attrname, gensym("symbol"), (flags), \
+                                       (method)0L, (method)0L,              \
+                                       calcoffset(structname, structmember)))
+#define CLASS_ATTR_LONG(c, attrname, flags, structname, structmember)     \
+    class_addattr((c), attr_offset_new(attrname, gensym("long"), (flags), \
+                                       (method)0L, (method)0L,            \
+                                       calcoffset(structname, structmember)))
+#define CLASS_ATTR_CHAR(c, attrname, flags, structname, structmember)     \
+    class_addattr((c), attr_offset_new(attrname, gensym("char"), (flags), \
+                                       (method)0L, (method)0L,            \
+                                       calcoffset(structname, structmember)))
+#define CLASS_ATTR_FLOAT(c, attrname, flags, structname, structmember)     \
+    class_addattr((c), attr_offset_new(attrname, gensym("float32"), (flags), \
+                                       (method)0L, (method)0L,             \
+                                       calcoffset(structname, structmember)))
+#define CLASS_ATTR_DOUBLE(c, attrname, flags, structname, structmember)     \
+    class_addattr((c), attr_offset_new(attrname, gensym("float64"), (flags), \
+                                       (method)0L, (method)0L,              \
+                                       calcoffset(structname, structmember)))
+t_object* attr_offset_array_new(const char* name, t_symbol* type, long size,
+                                long flags, method mget, method mset,
+                                long offsetcount, long offset);
+#define CLASS_ATTR_ATOM_VARSIZE(c, attrname, flags, structname, structmember, \
+                                sizemember, maxsize)                          \
+    class_addattr((c), attr_offset_array_new(                                 \
+                           attrname, gensym("atom"), (maxsize), (flags),      \
+                           (method)0L, (method)0L,                            \
+                           calcoffset(structname, sizemember),                \
+                           calcoffset(structname, structmember)))
+#define CLASS_ATTR_SYM_VARSIZE(c, attrname, flags, structname, structmember, \
+                               sizemember, maxsize)                          \
+    class_addattr((c), attr_offset_array_new(                                \
+                           attrname, gensym("symbol"), (maxsize), (flags),   \
+                           (method)0L, (method)0L,                           \
+                           calcoffset(structname, sizemember),               \
+                           calcoffset(structname, structmember)))
+
+t_max_err maxstub_attr_accessors(t_class* c, const char* attrname,
+                                 method getter, method setter);
+
+#define CLASS_ATTR_ACCESSORS(c, attrname, getter, setter) \
+    maxstub_attr_accessors((c), (attrname), (method)(getter), (method)(setter))
+
+#define CLASS_ATTR_LABEL(c, attrname, flags, labelstr)
+#define CLASS_ATTR_STYLE(c, attrname, flags, stylestr)
+#define CLASS_ATTR_BASIC(c, attrname, flags)
+#define CLASS_ATTR_SAVE(c, attrname, flags)
+#define CLASS_ATTR_ORDER(c, attrname, flags, orderstr)
+#define CLASS_ATTR_ENUM(c, attrname, flags, parsestr)
+#define CLASS_ATTR_DEFAULT(c, attrname, flags, parsestr)
+#define CLASS_ATTR_FILTER_CLIP(c, attrname, minval, maxval)
+#define CLASS_ATTR_FILTER_MIN(c, attrname, minval)
+#define CLASS_ATTR_CATEGORY(c, attrname, flags, parsestr)
+
+/*--------------------------------------------------------------------------*/
+/* Outlets */
+
+void* outlet_new(void* x, const char* s);
+void* bangout(void* x);
+void* intout(void* x);
+void* floatout(void* x);
+void* listout(void* x);
+void* outlet_bang(void* o);
+void* outlet_int(void* o, t_atom_long n);
+void* outlet_float(void* o, double f);
+void* outlet_list(void* o, t_symbol* s, short ac, t_atom* av);
+void* outlet_anything(void* o, const t_symbol* s, short ac, const t_atom* av);
+
+/*--------------------------------------------------------------------------*/
+/* Scheduler, clocks and deferral */
+
+void* clock_new(void* obj, method fn);
+void clock_delay(void* x, long n);
+void clock_fdelay(void* c, double time);
+void clock_unset(void* x);
+void clock_getftime(double* time);
+void setclock_getftime(void* x, double* time);
+double gettime_forobject(t_object* x);
+long gettime(void);
+void scheduler_gettime(double* time);
+void* defer(void* ob, method fn, t_symbol* sym, short argc, t_atom* argv);
+void* defer_low(void* ob, method fn, t_symbol* sym, short argc, t_atom* argv);
+void* qelem_new(void* obj, method fn);
+void qelem_set(void* q);
+void qelem_unset(void* q);
+void qelem_free(void* q);
+void qelem_front(void* q);
+short isr(void);
+long systhread_ismainthread(void);
+long systhread_istimerthread(void);
+
+/*--------------------------------------------------------------------------*/
+/* Hashtab */
+
+t_hashtab* hashtab_new(long slotcount);
+t_max_err hashtab_store(t_hashtab* x, t_symbol* key, t_object* val);
+t_max_err hashtab_storelong(t_hashtab* x, t_symbol* key, t_atom_long val);
+t_max_err hashtab_storesym(t_hashtab* x, t_symbol* key, t_symbol* val);
+t_max_err hashtab_lookup(t_hashtab* x, t_symbol* key, t_object** val);
+t_max_err hashtab_lookuplong(t_hashtab* x, t_symbol* key, t_atom_long* val);
+t_max_err hashtab_lookupsym(t_hashtab* x, t_symbol* key, t_symbol** val);
+t_max_err hashtab_delete(t_hashtab* x, t_symbol* key);
+t_max_err hashtab_chuckkey(t_hashtab* x, t_symbol* key);
+t_max_err hashtab_clear(t_hashtab* x);
+t_max_err hashtab_chuck(t_hashtab* x);
+t_atom_long hashtab_getsize(t_hashtab* x);
+void hashtab_flags(t_hashtab* x, long flags);
+t_max_err hashtab_getkeys(t_hashtab* x, long* kc, t_symbol*** kv);
+t_max_err hashtab_funall(t_hashtab* x, method fun, void* arg);
+
+/*--------------------------------------------------------------------------*/
+/* Linklist */
+
+t_linklist* linklist_new(void);
+t_atom_long linklist_append(t_linklist* x, void* o);
+t_atom_long linklist_getsize(t_linklist* x);
+void* linklist_getindex(t_linklist* x, long index);
+t_atom_long linklist_deleteindex(t_linklist* x, long index);
+long linklist_chuckobject(t_linklist* x, void* o);
+void linklist_clear(t_linklist* x);
+void linklist_chuck(t_linklist* x);
+void linklist_flags(t_linklist* x, long flags);
+
+/*--------------------------------------------------------------------------*/
+/* Atomarray */
+
+t_atomarray* atomarray_new(long ac, t_atom* av);
+t_max_err atomarray_setatoms(t_atomarray* x, long ac, t_atom* av);
+t_max_err atomarray_getatoms(t_atomarray* x, long* ac, t_atom** av);
+t_max_err atomarray_copyatoms(t_atomarray* x, long* ac, t_atom** av);
+t_atom_long atomarray_getsize(t_atomarray* x);
+t_max_err atomarray_getindex(t_atomarray* x, long index, t_atom* av);
+void atomarray_appendatom(t_atomarray* x, t_atom* a);
+void atomarray_appendatoms(t_atomarray* x, long ac, t_atom* av);
+void atomarray_clear(t_atomarray* x);
+#define ATOMARRAY_FLAG_FREECHILDREN 1
+void atomarray_flags(t_atomarray* x, long flags);
+
+/*--------------------------------------------------------------------------*/
+/* Strings */
+
+t_string* string_new(const char* psz);
+const char* string_getptr(t_string* x);
+
+/*--------------------------------------------------------------------------*/
+/* Dictionary */
+
+t_dictionary* dictionary_new(void);
+t_max_err dictionary_appendlong(t_dictionary* d, t_symbol* key,
+                                t_atom_long value);
+t_max_err dictionary_appendfloat(t_dictionary* d, t_symbol* key,
+                                 double value);
+t_max_err dictionary_appendsym(t_dictionary* d, t_symbol* key,
+                               t_symbol* value);
+t_max_err dictionary_appendatom(t_dictionary* d, t_symbol* key,
+                                t_atom* value);
+t_max_err dictionary_appendstring(t_dictionary* d, t_symbol* key,
+                                  const char* value);
+t_max_err dictionary_appendatoms(t_dictionary* d, t_symbol* key, long argc,
+                                 t_atom* argv);
+t_max_err dictionary_appendatomarray(t_dictionary* d, t_symbol* key,
+                                     t_object* value);
+t_max_err dictionary_appenddictionary(t_dictionary* d, t_symbol* key,
+                                      t_object* value);
+t_max_err dictionary_appendobject(t_dictionary* d, t_symbol* key,
+                                  t_object* value);
+t_max_err dictionary_getlong(const t_dictionary* d, t_symbol* key,
+                             t_atom_long* value);
+t_max_err dictionary_getfloat(const t_dictionary* d, t_symbol* key,
+                              double* value);
+t_max_err dictionary_getsym(const t_dictionary* d, t_symbol* key,
+                            t_symbol** value);
+t_max_err dictionary_getatom(const t_dictionary* d, t_symbol* key,
+                             t_atom* value);
+t_max_err dictionary_getstring(const t_dictionary* d, t_symbol* key,
+                               const char** value);
+t_max_err dictionary_getatoms(const t_dictionary* d, t_symbol* key,
+                              long* argc, t_atom** argv);
+t_max_err dictionary_getatomarray(const t_dictionary* d, t_symbol* key,
+                                  t_object** value);
+t_max_err dictionary_getdictionary(const t_dictionary* d, t_symbol* key,
+                                   t_object** value);
+t_max_err dictionary_getobject(const t_dictionary* d, t_symbol* key,
+                               t_object** value);
+long dictionary_entryisstring(const t_dictionary* d, t_symbol* key);
+long dictionary_entryisatomarray(const t_dictionary* d, t_symbol* key);
+long dictionary_entryisdictionary(const t_dictionary* d, t_symbol* key);
+long dictionary_hasentry(const t_dictionary* d, t_symbol* key);
+t_atom_long dictionary_getentrycount(const t_dictionary* d);
+t_max_err dictionary_getkeys(const t_dictionary* d, long* numkeys,
+                             t_symbol*** keys);
+t_max_err dictionary_getkeys_ordered(const t_dictionary* d, long* numkeys,
+                                     t_symbol*** keys);
+void dictionary_freekeys(t_dictionary* d, long numkeys, t_symbol** keys);
+t_max_err dictionary_deleteentry(t_dictionary* d, t_symbol* key);
+t_max_err dictionary_clear(t_dictionary* d);
+
+/*--------------------------------------------------------------------------*/
+/* Paths and files */
+
+short path_getdefault(void);
+short path_getsupportpath(void);
+short path_tempfolder(void);
+short path_desktopfolder(void);
+short path_userdocfolder(void);
+short path_usermaxfolder(void);
+t_max_err path_toabsolutesystempath(const short in_path,
+                                    const char* in_filename,
+                                    char* out_filepath);
+short path_nameconform(const char* src, char* dst, long style, long type);
+short path_splitnames(const char* pathname, char* foldername,
+                      char* filename);
+short locatefile_extended(char* name, short* outvol, t_fourcc* outtype,
+                          const t_fourcc* filetypelist, short numtypes);
+short open_dialog(char* name, short* volptr, t_fourcc* typeptr,
+                  t_fourcc* types, short ntypes);
+short path_opensysfile(const char* name, const short path, t_filehandle* ref,
+                       short perm);
+t_max_err sysfile_readtextfile(t_filehandle f, t_handle htext, long maxlen,
+                               long flags);
+t_max_err sysfile_close(t_filehandle f);
+
+/*--------------------------------------------------------------------------*/
+/* Tables */
+
+short table_get(t_symbol* s, long*** hp, long* sp);
+short table_dirty(t_symbol* s);
+
+/*--------------------------------------------------------------------------*/
+/* Patcher and box */
+
+t_max_err jbox_set_varname(t_object* box, t_symbol* ps);
+t_symbol* jbox_get_varname(t_object* box);
+t_object* jbox_get_object(t_object* box);
+t_object* jbox_get_patcher(t_object* box);
+t_symbol* jbox_get_id(t_object* box);
+t_max_err jbox_get_patching_rect(t_object* box, t_rect* pr);
+t_symbol* jpatcher_get_name(t_object* p);
+t_object* jpatcher_get_firstobject(t_object* p);
+t_object* jpatcher_get_lastobject(t_object* p);
+t_object* jpatcher_get_toppatcher(t_object* p);
+t_object* maxstub_patcher(void);
+t_object* jbox_get_nextobject(t_object* b);
+t_object* object_subpatcher(t_object* o, long* index, void* arg);
+
+/*--------------------------------------------------------------------------*/
+/* Threads */
+
+typedef void* t_systhread;
+typedef void* t_systhread_mutex;
+typedef void* t_systhread_cond;
+
+#define SYSTHREAD_MUTEX_NORMAL 0x00000000
+#define SYSTHREAD_PRIORITY_DEFAULT 0
+
+long systhread_create(method entryproc, void* arg, long stacksize,
+                      long priority, long flags, t_systhread* thread);
+long systhread_join(t_systhread thread, unsigned int* retval);
+void systhread_exit(long status);
+void systhread_sleep(long milliseconds);
+t_systhread systhread_self(void);
+long systhread_mutex_new(t_systhread_mutex* pmutex, long flags);
+long systhread_mutex_free(t_systhread_mutex pmutex);
+long systhread_mutex_lock(t_systhread_mutex pmutex);
+long systhread_mutex_unlock(t_systhread_mutex pmutex);
+long systhread_cond_new(t_systhread_cond* pcond, long flags);
+long systhread_cond_free(t_systhread_cond pcond);
+long systhread_cond_wait(t_systhread_cond pcond, t_systhread_mutex pmutex);
+long systhread_cond_signal(t_systhread_cond pcond);
+long systhread_cond_broadcast(t_systhread_cond pcond);
+
+/*--------------------------------------------------------------------------*/
+/* System time */
+
+t_uint32 systime_ms(void);
+t_int64 systime_ticks(void);
+double systimer_gettime(void);
+
+/*--------------------------------------------------------------------------*/
+/* Stub control (headless runtime only) */
+
+typedef void (*maxstub_outlet_fn)(void* outlet, t_symbol* s, long ac,
+                                  t_atom* av, void* arg);
+
+void maxstub_set_outlet_hook(maxstub_outlet_fn fn, void* arg);
+void maxstub_set_quiet(int quiet);
+void maxstub_advance(double ms);
+double maxstub_now(void);
+long maxstub_run_deferred(void);
+void* maxstub_outlet(void* x, long index);
+void maxstub_table_new(t_symbol* s, long size);
+void maxstub_reset_stats(void);
+long maxstub_gensym_count(void);
+long maxstub_alloc_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAXSTUB_EXT_H
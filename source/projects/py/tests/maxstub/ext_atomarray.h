@@ -0,0 +1,8 @@
+/* ext_atomarray.h -- headless max-api stub */
+
+#ifndef MAXSTUB_EXT_ATOMARRAY_H
+#define MAXSTUB_EXT_ATOMARRAY_H
+
+#include "ext.h"
+
+#endif // MAXSTUB_EXT_ATOMARRAY_H
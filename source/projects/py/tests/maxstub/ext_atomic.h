@@ -0,0 +1,11 @@
+/* ext_atomic.h -- headless stub */
+#ifndef EXT_ATOMIC_H
+#define EXT_ATOMIC_H
+#include "ext.h"
+typedef volatile int32_t t_int32_atomic;
+typedef volatile uint32_t t_uint32_atomic;
+#define ATOMIC_INCREMENT(p) __atomic_add_fetch((p), 1, __ATOMIC_RELAXED)
+#define ATOMIC_DECREMENT(p) __atomic_sub_fetch((p), 1, __ATOMIC_RELAXED)
+#define ATOMIC_INCREMENT_BARRIER(p) __atomic_add_fetch((p), 1, __ATOMIC_SEQ_CST)
+#define ATOMIC_DECREMENT_BARRIER(p) __atomic_sub_fetch((p), 1, __ATOMIC_SEQ_CST)
+#endif
@@ -0,0 +1,36 @@
+/* ext_buffer.h -- headless max-api stub */
+
+#ifndef MAXSTUB_EXT_BUFFER_H
+#define MAXSTUB_EXT_BUFFER_H
+
+#include "ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef t_object t_buffer_obj;
+typedef t_object t_buffer_ref;
+
+t_buffer_ref* buffer_ref_new(t_object* self, t_symbol* name);
+void buffer_ref_set(t_buffer_ref* x, t_symbol* name);
+t_atom_long buffer_ref_exists(t_buffer_ref* x);
+t_buffer_obj* buffer_ref_getobject(t_buffer_ref* x);
+t_buffer_obj* maxstub_buffer_new(t_symbol* name, long frames, long channels,
+                                 double sr);
+float* buffer_locksamples(t_buffer_obj* buffer_object);
+void buffer_unlocksamples(t_buffer_obj* buffer_object);
+t_atom_long buffer_getchannelcount(t_buffer_obj* buffer_object);
+t_atom_long buffer_getframecount(t_buffer_obj* buffer_object);
+t_atom_float buffer_getsamplerate(t_buffer_obj* buffer_object);
+t_atom_float buffer_getmillisamplerate(t_buffer_obj* buffer_object);
+t_max_err buffer_setdirty(t_buffer_obj* buffer_object);
+t_max_err buffer_setpadding(t_buffer_obj* buffer_object, t_atom_long samplecount);
+t_max_err buffer_view(t_buffer_obj* buffer_object);
+t_symbol* buffer_getfilename(t_buffer_obj* buffer_object);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAXSTUB_EXT_BUFFER_H
@@ -0,0 +1,8 @@
+/* ext_common.h -- headless max-api stub */
+
+#ifndef MAXSTUB_EXT_COMMON_H
+#define MAXSTUB_EXT_COMMON_H
+
+#include "ext.h"
+
+#endif // MAXSTUB_EXT_COMMON_H
@@ -0,0 +1,23 @@
+/* ext_critical.h -- headless max-api stub */
+
+#ifndef MAXSTUB_EXT_CRITICAL_H
+#define MAXSTUB_EXT_CRITICAL_H
+
+#include "ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void* t_critical;
+
+void critical_new(t_critical* x);
+void critical_enter(t_critical x);
+void critical_exit(t_critical x);
+void critical_free(t_critical x);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAXSTUB_EXT_CRITICAL_H
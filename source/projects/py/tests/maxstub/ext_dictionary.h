@@ -0,0 +1,8 @@
+/* ext_dictionary.h -- headless max-api stub */
+
+#ifndef MAXSTUB_EXT_DICTIONARY_H
+#define MAXSTUB_EXT_DICTIONARY_H
+
+#include "ext.h"
+
+#endif // MAXSTUB_EXT_DICTIONARY_H
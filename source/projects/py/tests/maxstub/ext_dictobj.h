@@ -0,0 +1,25 @@
+/* ext_dictobj.h -- headless max-api stub */
+
+#ifndef MAXSTUB_EXT_DICTOBJ_H
+#define MAXSTUB_EXT_DICTOBJ_H
+
+#include "ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+t_dictionary* dictobj_register(t_dictionary* d, t_symbol** name);
+t_max_err dictobj_unregister(t_dictionary* d);
+t_dictionary* dictobj_findregistered_retain(t_symbol* name);
+t_symbol* maxstub_last_dictionary_name(void); // harness helper
+t_dictionary* dictobj_findregistered_clone(t_symbol* name);
+t_max_err dictobj_release(t_dictionary* d);
+t_symbol* dictobj_namefromptr(t_dictionary* d);
+void dictobj_outlet_atoms(void* out, long argc, t_atom* argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAXSTUB_EXT_DICTOBJ_H
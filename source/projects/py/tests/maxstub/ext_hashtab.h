@@ -0,0 +1,8 @@
+/* ext_hashtab.h -- headless max-api stub */
+
+#ifndef MAXSTUB_EXT_HASHTAB_H
+#define MAXSTUB_EXT_HASHTAB_H
+
+#include "ext.h"
+
+#endif // MAXSTUB_EXT_HASHTAB_H
@@ -0,0 +1,8 @@
+/* ext_linklist.h -- headless max-api stub */
+
+#ifndef MAXSTUB_EXT_LINKLIST_H
+#define MAXSTUB_EXT_LINKLIST_H
+
+#include "ext.h"
+
+#endif // MAXSTUB_EXT_LINKLIST_H
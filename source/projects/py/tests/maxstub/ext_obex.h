@@ -0,0 +1,8 @@
+/* ext_obex.h -- headless max-api stub */
+
+#ifndef MAXSTUB_EXT_OBEX_H
+#define MAXSTUB_EXT_OBEX_H
+
+#include "ext.h"
+
+#endif // MAXSTUB_EXT_OBEX_H
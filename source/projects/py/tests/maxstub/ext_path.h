@@ -0,0 +1,8 @@
+/* ext_path.h -- headless max-api stub */
+
+#ifndef MAXSTUB_EXT_PATH_H
+#define MAXSTUB_EXT_PATH_H
+
+#include "ext.h"
+
+#endif // MAXSTUB_EXT_PATH_H
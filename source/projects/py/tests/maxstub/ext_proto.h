@@ -0,0 +1,8 @@
+/* ext_proto.h -- headless max-api stub */
+
+#ifndef MAXSTUB_EXT_PROTO_H
+#define MAXSTUB_EXT_PROTO_H
+
+#include "ext.h"
+
+#endif // MAXSTUB_EXT_PROTO_H
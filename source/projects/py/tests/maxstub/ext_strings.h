@@ -0,0 +1,8 @@
+/* ext_strings.h -- headless max-api stub */
+
+#ifndef MAXSTUB_EXT_STRINGS_H
+#define MAXSTUB_EXT_STRINGS_H
+
+#include "ext.h"
+
+#endif // MAXSTUB_EXT_STRINGS_H
@@ -0,0 +1,8 @@
+/* ext_sysfile.h -- headless max-api stub */
+
+#ifndef MAXSTUB_EXT_SYSFILE_H
+#define MAXSTUB_EXT_SYSFILE_H
+
+#include "ext.h"
+
+#endif // MAXSTUB_EXT_SYSFILE_H
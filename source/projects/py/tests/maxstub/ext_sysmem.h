@@ -0,0 +1,8 @@
+/* ext_sysmem.h -- headless max-api stub */
+
+#ifndef MAXSTUB_EXT_SYSMEM_H
+#define MAXSTUB_EXT_SYSMEM_H
+
+#include "ext.h"
+
+#endif // MAXSTUB_EXT_SYSMEM_H
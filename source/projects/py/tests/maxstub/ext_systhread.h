@@ -0,0 +1,8 @@
+/* ext_systhread.h -- headless max-api stub */
+
+#ifndef MAXSTUB_EXT_SYSTHREAD_H
+#define MAXSTUB_EXT_SYSTHREAD_H
+
+#include "ext.h"
+
+#endif // MAXSTUB_EXT_SYSTHREAD_H
@@ -0,0 +1,8 @@
+/* jpatcher_api.h -- headless max-api stub */
+
+#ifndef MAXSTUB_JPATCHER_API_H
+#define MAXSTUB_JPATCHER_API_H
+
+#include "ext.h"
+
+#endif // MAXSTUB_JPATCHER_API_H
@@ -0,0 +1,2953 @@
+/* maxstub.c -- headless max-api stub runtime */
+
+/** \file maxstub.c
+    \brief Implementation of the headless Max SDK subset declared in `ext.h`.
+
+    Everything here is deliberately simple: tables are linear or chained,
+    time is virtual and there is a single (main) thread as far as the
+    scheduler is concerned. The goal is to run the externals unchanged on
+    Linux so that their behaviour and performance can be measured, not to
+    emulate Max faithfully.
+*/
+
+#define _GNU_SOURCE
+#include "ext.h"
+#include "ext_buffer.h"
+#include "ext_critical.h"
+#include "ext_dictobj.h"
+
+#include <ctype.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------------*/
+/* Globals */
+
+static int stub_quiet = 0;
+static double stub_now = 0.0;
+static long stub_alloc_count = 0;
+static maxstub_outlet_fn stub_outlet_hook = NULL;
+static void* stub_outlet_hook_arg = NULL;
+
+/*--------------------------------------------------------------------------*/
+/* Internal classes */
+
+static t_class* stub_class_make(const char* name, method mfree, long size);
+
+static t_class* stub_hashtab_class = NULL;
+static t_class* stub_linklist_class = NULL;
+static t_class* stub_atomarray_class = NULL;
+static t_class* stub_dictionary_class = NULL;
+static t_class* stub_string_class = NULL;
+static t_class* stub_clock_class = NULL;
+static t_class* stub_qelem_class = NULL;
+static t_class* stub_outlet_class = NULL;
+static t_class* stub_attr_class = NULL;
+static t_class* stub_patcher_class = NULL;
+static t_class* stub_box_class = NULL;
+static t_class* stub_buffer_class = NULL;
+static t_class* stub_bufref_class = NULL;
+
+static void stub_init(void);
+
+/*--------------------------------------------------------------------------*/
+/* Console */
+
+static void stub_vpost(FILE* f, const char* prefix, const char* fmt,
+                       va_list va)
+{
+    if (stub_quiet)
+        return;
+    fputs(prefix, f);
+    vfprintf(f, fmt, va);
+    fputc('\n', f);
+}
+
+void post(const char* fmt, ...)
+{
+    va_list va;
+    va_start(va, fmt);
+    stub_vpost(stdout, "", fmt, va);
+    va_end(va);
+}
+
+void cpost(const char* fmt, ...)
+{
+    va_list va;
+    va_start(va, fmt);
+    stub_vpost(stdout, "", fmt, va);
+    va_end(va);
+}
+
+void error(const char* fmt, ...)
+{
+    va_list va;
+    va_start(va, fmt);
+    stub_vpost(stderr, "error: ", fmt, va);
+    va_end(va);
+}
+
+void object_post(t_object* x, const char* s, ...)
+{
+    va_list va;
+    va_start(va, s);
+    stub_vpost(stdout, "", s, va);
+    va_end(va);
+}
+
+void object_error(t_object* x, const char* s, ...)
+{
+    va_list va;
+    va_start(va, s);
+    stub_vpost(stderr, "error: ", s, va);
+    va_end(va);
+}
+
+void object_warn(t_object* x, const char* s, ...)
+{
+    va_list va;
+    va_start(va, s);
+    stub_vpost(stderr, "warning: ", s, va);
+    va_end(va);
+}
+
+void postatom(t_atom* ap)
+{
+    long size = 0;
+    char* text = NULL;
+    atom_gettext(1, ap, &size, &text, OBEX_UTIL_ATOM_GETTEXT_DEFAULT);
+    post("%s", text ? text : "");
+    sysmem_freeptr(text);
+}
+
+void postdictionary(t_object* d)
+{
+    post("dictionary: %ld entries", (long)dictionary_getentrycount(d));
+}
+
+void maxstub_set_quiet(int quiet) { stub_quiet = quiet; }
+
+/*--------------------------------------------------------------------------*/
+/* Memory */
+
+typedef struct _stub_mem {
+    long size;
+    long pad;
+} t_stub_mem;
+
+void* sysmem_newptr(long size)
+{
+    t_stub_mem* m = malloc(sizeof(t_stub_mem) + (size_t)(size > 0 ? size : 1));
+    if (m == NULL)
+        return NULL;
+    m->size = size;
+    __atomic_fetch_add(&stub_alloc_count, 1, __ATOMIC_RELAXED);
+    return m + 1;
+}
+
+void* sysmem_newptrclear(long size)
+{
+    void* p = sysmem_newptr(size);
+    if (p)
+        memset(p, 0, (size_t)size);
+    return p;
+}
+
+void* sysmem_resizeptr(void* ptr, long newsize)
+{
+    if (ptr == NULL)
+        return sysmem_newptr(newsize);
+    t_stub_mem* m = ((t_stub_mem*)ptr) - 1;
+    m = realloc(m, sizeof(t_stub_mem) + (size_t)(newsize > 0 ? newsize : 1));
+    if (m == NULL)
+        return NULL;
+    m->size = newsize;
+    __atomic_fetch_add(&stub_alloc_count, 1, __ATOMIC_RELAXED);
+    return m + 1;
+}
+
+void* sysmem_resizeptrclear(void* ptr, long newsize)
+{
+    long oldsize = ptr ? sysmem_ptrsize(ptr) : 0;
+    char* p = sysmem_resizeptr(ptr, newsize);
+    if (p && newsize > oldsize)
+        memset(p + oldsize, 0, (size_t)(newsize - oldsize));
+    return p;
+}
+
+long sysmem_ptrsize(void* ptr)
+{
+    return ptr ? (((t_stub_mem*)ptr) - 1)->size : 0;
+}
+
+void sysmem_freeptr(void* ptr)
+{
+    if (ptr)
+        free(((t_stub_mem*)ptr) - 1);
+}
+
+void sysmem_copyptr(const void* src, void* dst, long bytes)
+{
+    memmove(dst, src, (size_t)bytes);
+}
+
+t_handle sysmem_newhandle(long size)
+{
+    t_handle h = malloc(sizeof(char*));
+    *h = sysmem_newptr(size);
+    return h;
+}
+
+t_handle sysmem_newhandleclear(unsigned long size)
+{
+    t_handle h = malloc(sizeof(char*));
+    *h = sysmem_newptrclear((long)size);
+    return h;
+}
+
+long sysmem_handlesize(t_handle handle)
+{
+    return handle ? sysmem_ptrsize(*handle) : 0;
+}
+
+t_max_err sysmem_resizehandle(t_handle handle, long newsize)
+{
+    char* p = sysmem_resizeptr(*handle, newsize);
+    if (p == NULL)
+        return MAX_ERR_OUT_OF_MEM;
+    *handle = p;
+    return MAX_ERR_NONE;
+}
+
+void sysmem_freehandle(t_handle handle)
+{
+    if (handle) {
+        sysmem_freeptr(*handle);
+        free(handle);
+    }
+}
+
+char* strncpy_zero(char* dst, const char* src, long size)
+{
+    if (size <= 0)
+        return dst;
+    strncpy(dst, src, (size_t)size - 1);
+    dst[size - 1] = '\0';
+    return dst;
+}
+
+char* strncat_zero(char* dst, const char* src, long size)
+{
+    size_t len = strlen(dst);
+    if ((long)len >= size - 1)
+        return dst;
+    strncpy_zero(dst + len, src, size - (long)len);
+    return dst;
+}
+
+int snprintf_zero(char* buffer, size_t count, const char* format, ...)
+{
+    va_list va;
+    va_start(va, format);
+    int n = vsnprintf(buffer, count, format, va);
+    va_end(va);
+    if (count)
+        buffer[count - 1] = '\0';
+    return n;
+}
+
+long maxstub_alloc_count(void) { return stub_alloc_count; }
+
+void maxstub_reset_stats(void) { stub_alloc_count = 0; }
+
+/*--------------------------------------------------------------------------*/
+/* Symbols */
+
+#define STUB_SYMTAB_INIT 4096
+
+static t_symbol** stub_symtab = NULL;
+static long stub_symtab_size = 0;
+static long stub_symtab_count = 0;
+static pthread_mutex_t stub_sym_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned long stub_strhash(const char* s)
+{
+    unsigned long h = 5381;
+    while (*s)
+        h = ((h << 5) + h) ^ (unsigned char)*s++;
+    return h;
+}
+
+static void stub_symtab_grow(void)
+{
+    long newsize = stub_symtab_size ? stub_symtab_size * 2 : STUB_SYMTAB_INIT;
+    t_symbol** table = calloc((size_t)newsize, sizeof(t_symbol*));
+    for (long i = 0; i < stub_symtab_size; i++) {
+        t_symbol* sym = stub_symtab[i];
+        if (sym) {
+            unsigned long j = stub_strhash(sym->s_name) & (newsize - 1);
+            while (table[j])
+                j = (j + 1) & (newsize - 1);
+            table[j] = sym;
+        }
+    }
+    free(stub_symtab);
+    stub_symtab = table;
+    stub_symtab_size = newsize;
+}
+
+t_symbol* gensym(const char* s)
+{
+    if (s == NULL)
+        s = "";
+    pthread_mutex_lock(&stub_sym_lock);
+    if (stub_symtab_count * 2 >= stub_symtab_size)
+        stub_symtab_grow();
+    unsigned long j = stub_strhash(s) & (stub_symtab_size - 1);
+    while (stub_symtab[j]) {
+        if (strcmp(stub_symtab[j]->s_name, s) == 0) {
+            t_symbol* found = stub_symtab[j];
+            pthread_mutex_unlock(&stub_sym_lock);
+            return found;
+        }
+        j = (j + 1) & (stub_symtab_size - 1);
+    }
+    t_symbol* sym = malloc(sizeof(t_symbol));
+    sym->s_name = strdup(s);
+    sym->s_thing = NULL;
+    stub_symtab[j] = sym;
+    stub_symtab_count++;
+    pthread_mutex_unlock(&stub_sym_lock);
+    return sym;
+}
+
+t_symbol* gensym_tr(const char* s) { return gensym(s); }
+
+t_symbol* symbol_unique(void)
+{
+    static long counter = 0;
+    char name[32];
+    snprintf(name, sizeof(name), "u%09ld", ++counter);
+    return gensym(name);
+}
+
+long maxstub_gensym_count(void) { return stub_symtab_count; }
+
+/*--------------------------------------------------------------------------*/
+/* Atoms */
+
+t_max_err atom_setlong(t_atom* a, t_atom_long b)
+{
+    a->a_type = A_LONG;
+    a->a_w.w_long = b;
+    return MAX_ERR_NONE;
+}
+
+t_max_err atom_setfloat(t_atom* a, double b)
+{
+    a->a_type = A_FLOAT;
+    a->a_w.w_float = b;
+    return MAX_ERR_NONE;
+}
+
+t_max_err atom_setsym(t_atom* a, t_symbol* b)
+{
+    a->a_type = A_SYM;
+    a->a_w.w_sym = b;
+    return MAX_ERR_NONE;
+}
+
+t_max_err atom_setobj(t_atom* a, void* b)
+{
+    a->a_type = A_OBJ;
+    a->a_w.w_obj = b;
+    return MAX_ERR_NONE;
+}
+
+t_atom_long atom_getlong(const t_atom* a)
+{
+    switch (a->a_type) {
+    case A_LONG:
+        return a->a_w.w_long;
+    case A_FLOAT:
+        return (t_atom_long)a->a_w.w_float;
+    default:
+        return 0;
+    }
+}
+
+t_atom_float atom_getfloat(const t_atom* a)
+{
+    switch (a->a_type) {
+    case A_LONG:
+        return (t_atom_float)a->a_w.w_long;
+    case A_FLOAT:
+        return a->a_w.w_float;
+    default:
+        return 0.0;
+    }
+}
+
+t_symbol* atom_getsym(const t_atom* a)
+{
+    return (a && a->a_type == A_SYM) ? a->a_w.w_sym : gensym("");
+}
+
+void* atom_getobj(const t_atom* a)
+{
+    return (a->a_type == A_OBJ) ? a->a_w.w_obj : NULL;
+}
+
+long atom_gettype(const t_atom* a) { return a->a_type; }
+
+static void stub_text_append(char** buf, long* len, long* cap, const char* s)
+{
+    long n = (long)strlen(s);
+    if (*len + n + 2 > *cap) {
+        *cap = (*len + n + 2) * 2;
+        *buf = sysmem_resizeptr(*buf, *cap);
+    }
+    memcpy(*buf + *len, s, (size_t)n);
+    *len += n;
+    (*buf)[*len] = '\0';
+}
+
+t_max_err atom_gettext(long ac, t_atom* av, long* textsize, char** text,
+                       long flags)
+{
+    long len = 0;
+    long cap = 64;
+    char* buf = sysmem_newptr(cap);
+    char tmp[64];
+
+    buf[0] = '\0';
+    for (long i = 0; i < ac; i++) {
+        if (i > 0)
+            stub_text_append(&buf, &len, &cap, " ");
+        switch (av[i].a_type) {
+        case A_LONG:
+            snprintf(tmp, sizeof(tmp), "%ld", (long)av[i].a_w.w_long);
+            stub_text_append(&buf, &len, &cap, tmp);
+            break;
+        case A_FLOAT:
+            snprintf(tmp, sizeof(tmp), "%f", av[i].a_w.w_float);
+            if (flags & OBEX_UTIL_ATOM_GETTEXT_TRUNCATE_ZEROS) {
+                char* p = tmp + strlen(tmp) - 1;
+                while (p > tmp && *p == '0' && *(p - 1) != '.')
+                    *p-- = '\0';
+            }
+            stub_text_append(&buf, &len, &cap, tmp);
+            break;
+        case A_SYM: {
+            const char* s = av[i].a_w.w_sym->s_name;
+            int quote = !(flags & OBEX_UTIL_ATOM_GETTEXT_SYM_NO_QUOTE)
+                && (strchr(s, ' ') != NULL);
+            if (quote)
+                stub_text_append(&buf, &len, &cap, "\"");
+            stub_text_append(&buf, &len, &cap, s);
+            if (quote)
+                stub_text_append(&buf, &len, &cap, "\"");
+            break;
+        }
+        case A_SEMI:
+            stub_text_append(&buf, &len, &cap, ";");
+            break;
+        case A_COMMA:
+            stub_text_append(&buf, &len, &cap, ",");
+            break;
+        default:
+            stub_text_append(&buf, &len, &cap, "?");
+            break;
+        }
+    }
+    *text = buf;
+    *textsize = len + 1;
+    return MAX_ERR_NONE;
+}
+
+static void stub_parse_token(t_atom* a, const char* tok, int quoted)
+{
+    char* end = NULL;
+
+    if (!quoted && *tok) {
+        long l = strtol(tok, &end, 10);
+        if (*end == '\0') {
+            atom_setlong(a, l);
+            return;
+        }
+        double d = strtod(tok, &end);
+        if (*end == '\0') {
+            atom_setfloat(a, d);
+            return;
+        }
+    }
+    atom_setsym(a, gensym(tok));
+}
+
+t_max_err atom_setparse(long* ac, t_atom** av, const char* parsestr)
+{
+    long count = 0;
+    long cap = 8;
+    t_atom* atoms = sysmem_newptr(cap * (long)sizeof(t_atom));
+    const char* p = parsestr;
+    char tok[4096];
+
+    while (*p) {
+        while (*p && isspace((unsigned char)*p))
+            p++;
+        if (!*p)
+            break;
+        int quoted = 0;
+        long n = 0;
+        if (*p == '"') {
+            quoted = 1;
+            p++;
+            while (*p && *p != '"' && n < (long)sizeof(tok) - 1)
+                tok[n++] = *p++;
+            if (*p == '"')
+                p++;
+        } else {
+            while (*p && !isspace((unsigned char)*p)
+                   && n < (long)sizeof(tok) - 1)
+                tok[n++] = *p++;
+        }
+        tok[n] = '\0';
+        if (count == cap) {
+            cap *= 2;
+            atoms = sysmem_resizeptr(atoms, cap * (long)sizeof(t_atom));
+        }
+        stub_parse_token(atoms + count, tok, quoted);
+        count++;
+    }
+    if (*av && *ac >= count) {
+        memcpy(*av, atoms, (size_t)count * sizeof(t_atom));
+        sysmem_freeptr(atoms);
+    } else {
+        *av = atoms;
+    }
+    *ac = count;
+    return MAX_ERR_NONE;
+}
+
+t_max_err atom_alloc(long* ac, t_atom** av, char* alloc)
+{
+    return atom_alloc_array(1, ac, av, alloc);
+}
+
+t_max_err atom_alloc_array(long minsize, long* ac, t_atom** av, char* alloc)
+{
+    if (*ac && *av) {
+        *alloc = 0;
+        return MAX_ERR_NONE;
+    }
+    *av = sysmem_newptrclear(minsize * (long)sizeof(t_atom));
+    *ac = minsize;
+    *alloc = 1;
+    return *av ? MAX_ERR_NONE : MAX_ERR_OUT_OF_MEM;
+}
+
+t_atom* atom_dynamic_start(const t_atom* local_buf, long local_count,
+                           long requested_count)
+{
+    if (requested_count <= local_count)
+        return (t_atom*)local_buf;
+    return sysmem_newptr(requested_count * (long)sizeof(t_atom));
+}
+
+void atom_dynamic_end(const t_atom* local_buf, t_atom* buf)
+{
+    if (buf != local_buf)
+        sysmem_freeptr(buf);
+}
+
+t_max_err atom_arg_getsym(t_symbol** c, long idx, long ac, const t_atom* av)
+{
+    if (idx >= ac || av[idx].a_type != A_SYM)
+        return MAX_ERR_GENERIC;
+    *c = av[idx].a_w.w_sym;
+    return MAX_ERR_NONE;
+}
+
+t_max_err atom_arg_getlong(t_atom_long* c, long idx, long ac,
+                           const t_atom* av)
+{
+    if (idx >= ac)
+        return MAX_ERR_GENERIC;
+    *c = atom_getlong(av + idx);
+    return MAX_ERR_NONE;
+}
+
+t_max_err atom_arg_getdouble(double* c, long idx, long ac, const t_atom* av)
+{
+    if (idx >= ac)
+        return MAX_ERR_GENERIC;
+    *c = atom_getfloat(av + idx);
+    return MAX_ERR_NONE;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Classes */
+
+#define STUB_MAX_METHODS 128
+#define STUB_MAX_ATTRS 64
+
+typedef struct _stub_methods {
+    long count;
+    t_messlist list[STUB_MAX_METHODS];
+} t_stub_methods;
+
+typedef struct _stub_attr {
+    t_object ob;
+    t_symbol* name;
+    t_symbol* type;
+    long offset;
+    method getter;
+    method setter;
+    long offsetcount; /* -1 for scalar attributes */
+    long size;
+} t_stub_attr;
+
+typedef struct _stub_attrs {
+    long count;
+    t_stub_attr* list[STUB_MAX_ATTRS];
+} t_stub_attrs;
+
+typedef struct _stub_obex {
+    t_linklist* clients;   /* attached objects receiving notifications */
+    t_object* patcher;     /* #P */
+    t_object* box;         /* #B */
+    long refcount;
+} t_stub_obex;
+
+static t_hashtab* stub_classes = NULL;
+
+static t_class* stub_class_make(const char* name, method mfree, long size)
+{
+    t_class* c = calloc(1, sizeof(t_class));
+    c->c_sym = gensym(name);
+    c->c_size = size;
+    c->c_free = mfree;
+    c->c_methods = calloc(1, sizeof(t_stub_methods));
+    c->c_attrs = calloc(1, sizeof(t_stub_attrs));
+    return c;
+}
+
+t_class* class_new(const char* name, const method mnew, const method mfree,
+                   long size, const method mmenu, short type, ...)
+{
+    stub_init();
+    t_class* c = stub_class_make(name, mfree, size);
+    c->c_new = mnew;
+    return c;
+}
+
+t_max_err class_addmethod(t_class* c, const method m, const char* name, ...)
+{
+    t_stub_methods* ms = c->c_methods;
+    va_list va;
+    int type;
+    int n = 0;
+
+    if (ms->count == STUB_MAX_METHODS)
+        return MAX_ERR_GENERIC;
+
+    t_messlist* ml = &ms->list[ms->count++];
+    ml->m_sym = gensym(name);
+    ml->m_fun = m;
+    va_start(va, name);
+    while ((type = va_arg(va, int)) != A_NOTHING && n < MSG_MAXARG)
+        ml->m_type[n++] = (char)type;
+    va_end(va);
+    ml->m_type[n] = A_NOTHING;
+    return MAX_ERR_NONE;
+}
+
+t_max_err class_register(t_symbol* name_space, t_class* c)
+{
+    stub_init();
+    hashtab_store(stub_classes, c->c_sym, (t_object*)c);
+    return MAX_ERR_NONE;
+}
+
+t_max_err class_addattr(t_class* c, t_object* attr)
+{
+    t_stub_attrs* as = c->c_attrs;
+    if (as->count == STUB_MAX_ATTRS)
+        return MAX_ERR_GENERIC;
+    as->list[as->count++] = (t_stub_attr*)attr;
+    return MAX_ERR_NONE;
+}
+
+short class_getpath(t_class* c) { return 0; }
+
+static t_stub_attr* stub_class_findattr(t_class* c, t_symbol* name)
+{
+    t_stub_attrs* as = c ? c->c_attrs : NULL;
+    if (as == NULL)
+        return NULL;
+    for (long i = 0; i < as->count; i++) {
+        if (as->list[i]->name == name)
+            return as->list[i];
+    }
+    return NULL;
+}
+
+t_max_err maxstub_attr_accessors(t_class* c, const char* attrname,
+                                 method getter, method setter)
+{
+    t_stub_attr* attr = stub_class_findattr(c, gensym(attrname));
+    if (attr == NULL)
+        return MAX_ERR_GENERIC;
+    attr->getter = getter;
+    attr->setter = setter;
+    return MAX_ERR_NONE;
+}
+
+static t_messlist* stub_class_findmethod(t_class* c, t_symbol* s)
+{
+    t_stub_methods* ms = c ? c->c_methods : NULL;
+    if (ms == NULL)
+        return NULL;
+    for (long i = 0; i < ms->count; i++) {
+        if (ms->list[i].m_sym == s)
+            return &ms->list[i];
+    }
+    return NULL;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Objects */
+
+static t_stub_obex* stub_obex(void* x)
+{
+    t_object* ob = (t_object*)x;
+    if (ob->o_obex == NULL)
+        ob->o_obex = calloc(1, sizeof(t_stub_obex));
+    return ob->o_obex;
+}
+
+void* object_alloc(t_class* c)
+{
+    t_object* x = calloc(1, (size_t)c->c_size);
+    if (x)
+        x->o_class = c;
+    return x;
+}
+
+static void* stub_object_new_imp(t_symbol* classname, long ac, t_atom* av)
+{
+    stub_init();
+    if (classname == gensym("atomarray"))
+        return atomarray_new(ac, av);
+    if (classname == gensym("dictionary"))
+        return dictionary_new();
+    if (classname == gensym("linklist"))
+        return linklist_new();
+    if (classname == gensym("hashtab"))
+        return hashtab_new(0);
+    if (classname == gensym("string"))
+        return string_new(ac ? atom_getsym(av)->s_name : "");
+
+    t_class* c = NULL;
+    if (hashtab_lookup(stub_classes, classname, (t_object**)&c) == MAX_ERR_NONE
+        && c && c->c_new) {
+        return ((void* (*)(t_symbol*, long, t_atom*))c->c_new)(classname, ac,
+                                                               av);
+    }
+    return NULL;
+}
+
+void* object_new(t_symbol* name_space, t_symbol* classname, ...)
+{
+    va_list va;
+    long ac = 0;
+    t_atom* av = NULL;
+
+    /* only the (long ac, t_atom* av) form used by atomarray is understood */
+    if (classname == gensym("atomarray")) {
+        va_start(va, classname);
+        ac = va_arg(va, long);
+        av = va_arg(va, t_atom*);
+        va_end(va);
+    }
+    return stub_object_new_imp(classname, ac, av);
+}
+
+void* object_new_typed(t_symbol* name_space, t_symbol* classname, long ac,
+                       t_atom* av)
+{
+    return stub_object_new_imp(classname, ac, av);
+}
+
+void* newinstance(const t_symbol* s, short argc, const t_atom* argv)
+{
+    return stub_object_new_imp((t_symbol*)s, argc, (t_atom*)argv);
+}
+
+t_max_err object_free(void* x)
+{
+    t_object* ob = (t_object*)x;
+    t_object* box = NULL;
+    if (ob == NULL)
+        return MAX_ERR_INVALID_PTR;
+    /* like deleting a box in max: the box goes with its object */
+    box = ob->o_obex ? ((t_stub_obex*)ob->o_obex)->box : NULL;
+    if (box) {
+        t_stub_obex* bobex = stub_obex(box);
+        object_notify(box, gensym("willfree"), NULL);
+        if (bobex->clients)
+            linklist_chuck(bobex->clients);
+        bobex->clients = NULL;
+    }
+    object_notify(ob, gensym("free"), NULL);
+    if (ob->o_class && ob->o_class->c_free)
+        ((void (*)(void*))ob->o_class->c_free)(ob);
+    if (ob->o_obex) {
+        t_stub_obex* obex = ob->o_obex;
+        if (obex->clients)
+            linklist_chuck(obex->clients);
+        free(obex);
+    }
+    object_unregister(ob);
+    free(ob);
+    if (box)
+        object_free(box);
+    return MAX_ERR_NONE;
+}
+
+t_max_err object_retain(t_object* x)
+{
+    stub_obex(x)->refcount++;
+    return MAX_ERR_NONE;
+}
+
+t_max_err object_release(t_object* x)
+{
+    t_stub_obex* obex = stub_obex(x);
+    if (--obex->refcount < 0)
+        object_free(x);
+    return MAX_ERR_NONE;
+}
+
+t_symbol* object_classname(void* x)
+{
+    t_object* ob = (t_object*)x;
+    return (ob && ob->o_class) ? ob->o_class->c_sym : gensym("");
+}
+
+method object_getmethod(void* x, t_symbol* s)
+{
+    t_messlist* ml = object_mess((t_object*)x, s);
+    return ml ? ml->m_fun : NULL;
+}
+
+t_messlist* object_mess(t_object* x, t_symbol* methodname)
+{
+    if (x == NULL)
+        return NULL;
+    return stub_class_findmethod(x->o_class, methodname);
+}
+
+void* object_method(void* x, t_symbol* s, ...)
+{
+    va_list va;
+    void* p[8];
+    method m = x ? object_getmethod(x, s) : NULL;
+
+    if (m == NULL)
+        return NULL;
+    va_start(va, s);
+    for (int i = 0; i < 8; i++)
+        p[i] = va_arg(va, void*);
+    va_end(va);
+    return m(x, p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7]);
+}
+
+typedef void* (*t_stub_gimme)(void*, t_symbol*, long, t_atom*);
+typedef void* (*t_stub_gimmeback)(void*, t_symbol*, long, t_atom*, t_atom*);
+typedef void* (*t_stub_long)(void*, t_atom_long);
+typedef void* (*t_stub_double)(void*, double);
+typedef void* (*t_stub_ptr)(void*, void*);
+typedef void* (*t_stub_none)(void*);
+
+t_max_err object_method_typed(void* x, t_symbol* s, long ac, t_atom* av,
+                              t_atom* rv)
+{
+    t_messlist* ml = object_mess((t_object*)x, s);
+
+    if (ml == NULL) {
+        /* fall back on the anything method as Max does */
+        ml = object_mess((t_object*)x, gensym("anything"));
+        if (ml == NULL || ml->m_type[0] != A_GIMME)
+            return MAX_ERR_GENERIC;
+        ((t_stub_gimme)ml->m_fun)(x, s, ac, av);
+        return MAX_ERR_NONE;
+    }
+
+    switch (ml->m_type[0]) {
+    case A_GIMME:
+        ((t_stub_gimme)ml->m_fun)(x, s, ac, av);
+        break;
+    case A_GIMMEBACK:
+        ((t_stub_gimmeback)ml->m_fun)(x, s, ac, av, rv);
+        break;
+    case A_NOTHING:
+        ((t_stub_none)ml->m_fun)(x);
+        break;
+    case A_LONG:
+    case A_DEFLONG:
+        ((t_stub_long)ml->m_fun)(x, ac ? atom_getlong(av) : 0);
+        break;
+    case A_FLOAT:
+    case A_DEFFLOAT:
+        ((t_stub_double)ml->m_fun)(x, ac ? atom_getfloat(av) : 0.0);
+        break;
+    case A_SYM:
+    case A_DEFSYM:
+        ((t_stub_ptr)ml->m_fun)(x, ac ? atom_getsym(av) : gensym(""));
+        break;
+    default:
+        return MAX_ERR_GENERIC;
+    }
+    return MAX_ERR_NONE;
+}
+
+/* registration */
+
+typedef struct _stub_reg {
+    t_symbol* name_space;
+    t_symbol* name;
+    void* obj;
+    struct _stub_reg* next;
+} t_stub_reg;
+
+static t_stub_reg* stub_registry = NULL;
+
+void* object_register(t_symbol* name_space, t_symbol* s, void* x)
+{
+    t_stub_reg* r = calloc(1, sizeof(t_stub_reg));
+    r->name_space = name_space;
+    r->name = s;
+    r->obj = x;
+    r->next = stub_registry;
+    stub_registry = r;
+    return x;
+}
+
+t_max_err object_unregister(void* x)
+{
+    t_stub_reg** pr = &stub_registry;
+    while (*pr) {
+        if ((*pr)->obj == x) {
+            t_stub_reg* dead = *pr;
+            *pr = dead->next;
+            free(dead);
+        } else {
+            pr = &(*pr)->next;
+        }
+    }
+    return MAX_ERR_NONE;
+}
+
+void* object_findregistered(t_symbol* name_space, t_symbol* s)
+{
+    for (t_stub_reg* r = stub_registry; r; r = r->next) {
+        if (r->name_space == name_space && r->name == s)
+            return r->obj;
+    }
+    return NULL;
+}
+
+/* notifications */
+
+void* object_attach_byptr(void* x, void* registeredobject)
+{
+    t_stub_obex* obex = stub_obex(registeredobject);
+    if (obex->clients == NULL)
+        obex->clients = linklist_new();
+    linklist_append(obex->clients, x);
+    return registeredobject;
+}
+
+void* object_attach_byptr_register(void* x, void* object_to_attach,
+                                   t_symbol* reg_name_space)
+{
+    return object_attach_byptr(x, object_to_attach);
+}
+
+t_max_err object_detach_byptr(void* x, void* registeredobject)
+{
+    t_object* ob = (t_object*)registeredobject;
+    t_stub_obex* obex = ob ? ob->o_obex : NULL;
+    if (obex && obex->clients)
+        linklist_chuckobject(obex->clients, x);
+    return MAX_ERR_NONE;
+}
+
+void* object_attach(t_symbol* name_space, t_symbol* s, void* x)
+{
+    void* ob = object_findregistered(name_space, s);
+    return ob ? object_attach_byptr(x, ob) : NULL;
+}
+
+t_max_err object_detach(t_symbol* name_space, t_symbol* s, void* x)
+{
+    void* ob = object_findregistered(name_space, s);
+    return ob ? object_detach_byptr(x, ob) : MAX_ERR_GENERIC;
+}
+
+typedef t_max_err (*t_stub_notify)(void*, t_symbol*, t_symbol*, void*, void*);
+
+t_max_err object_notify(void* x, t_symbol* s, void* data)
+{
+    t_object* ob = (t_object*)x;
+    t_stub_obex* obex = ob ? ob->o_obex : NULL;
+
+    if (obex == NULL || obex->clients == NULL)
+        return MAX_ERR_NONE;
+    for (long i = 0; i < linklist_getsize(obex->clients); i++) {
+        void* client = linklist_getindex(obex->clients, i);
+        method m = object_getmethod(client, gensym("notify"));
+        if (m)
+            ((t_stub_notify)m)(client, gensym(""), s, x, data);
+    }
+    return MAX_ERR_NONE;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Attributes */
+
+static void stub_attr_free(t_stub_attr* x) { }
+
+t_object* attr_offset_new(const char* name, const t_symbol* type, long flags,
+                          const method mget, const method mset, long offset)
+{
+    stub_init();
+    t_stub_attr* a = (t_stub_attr*)object_alloc(stub_attr_class);
+    a->name = gensym(name);
+    a->type = (t_symbol*)type;
+    a->offset = offset;
+    a->getter = mget;
+    a->setter = mset;
+    a->offsetcount = -1;
+    a->size = 1;
+    return (t_object*)a;
+}
+
+t_object* attr_offset_array_new(const char* name, t_symbol* type, long size,
+                                long flags, method mget, method mset,
+                                long offsetcount, long offset)
+{
+    t_stub_attr* a = (t_stub_attr*)attr_offset_new(name, type, flags, mget,
+                                                   mset, offset);
+    a->offsetcount = offsetcount;
+    a->size = size;
+    return (t_object*)a;
+}
+
+static long stub_attr_elemsize(t_symbol* type)
+{
+    if (type == gensym("symbol")) return sizeof(t_symbol*);
+    if (type == gensym("long")) return sizeof(t_atom_long);
+    if (type == gensym("char")) return sizeof(char);
+    if (type == gensym("float32")) return sizeof(float);
+    if (type == gensym("float64")) return sizeof(double);
+    if (type == gensym("atom")) return sizeof(t_atom);
+    return 0;
+}
+
+static void stub_attr_store(t_symbol* type, char* p, t_atom* av)
+{
+    if (type == gensym("symbol"))
+        *(t_symbol**)p = atom_getsym(av);
+    else if (type == gensym("long"))
+        *(t_atom_long*)p = atom_getlong(av);
+    else if (type == gensym("char"))
+        *(char*)p = (char)atom_getlong(av);
+    else if (type == gensym("float32"))
+        *(float*)p = (float)atom_getfloat(av);
+    else if (type == gensym("float64"))
+        *(double*)p = atom_getfloat(av);
+    else if (type == gensym("atom"))
+        *(t_atom*)p = *av;
+}
+
+static void stub_attr_load(t_symbol* type, char* p, t_atom* av)
+{
+    if (type == gensym("symbol"))
+        atom_setsym(av, *(t_symbol**)p);
+    else if (type == gensym("long"))
+        atom_setlong(av, *(t_atom_long*)p);
+    else if (type == gensym("char"))
+        atom_setlong(av, *(char*)p);
+    else if (type == gensym("float32"))
+        atom_setfloat(av, *(float*)p);
+    else if (type == gensym("float64"))
+        atom_setfloat(av, *(double*)p);
+    else if (type == gensym("atom"))
+        *av = *(t_atom*)p;
+}
+
+long attr_args_offset(short ac, t_atom* av)
+{
+    for (long i = 0; i < ac; i++) {
+        if (av[i].a_type == A_SYM && av[i].a_w.w_sym->s_name[0] == '@')
+            return i;
+    }
+    return ac;
+}
+
+void attr_args_process(void* x, short ac, t_atom* av)
+{
+    long i = attr_args_offset(ac, av);
+    while (i < ac) {
+        t_symbol* name = gensym(atom_getsym(av + i)->s_name + 1);
+        long j = i + 1;
+        while (j < ac
+               && !(av[j].a_type == A_SYM
+                    && av[j].a_w.w_sym->s_name[0] == '@'))
+            j++;
+        object_attr_setvalueof(x, name, j - i - 1, av + i + 1);
+        i = j;
+    }
+}
+
+typedef t_max_err (*t_stub_attr_set)(void*, void*, long, t_atom*);
+typedef t_max_err (*t_stub_attr_get)(void*, void*, long*, t_atom**);
+
+t_max_err object_attr_setvalueof(void* x, t_symbol* s, long argc,
+                                 t_atom* argv)
+{
+    t_object* ob = (t_object*)x;
+    t_stub_attr* a = stub_class_findattr(ob->o_class, s);
+    char* base = (char*)x;
+
+    if (a == NULL)
+        return MAX_ERR_GENERIC;
+    if (a->setter)
+        return ((t_stub_attr_set)a->setter)(x, a, argc, argv);
+    if (a->offsetcount >= 0) {
+        long n = argc < a->size ? argc : a->size;
+        long es = stub_attr_elemsize(a->type);
+        for (long i = 0; i < n; i++)
+            stub_attr_store(a->type, base + a->offset + i * es, argv + i);
+        *(long*)(base + a->offsetcount) = n;
+        return MAX_ERR_NONE;
+    }
+    if (argc < 1)
+        return MAX_ERR_GENERIC;
+
+    if (a->type == gensym("symbol"))
+        *(t_symbol**)(base + a->offset) = atom_getsym(argv);
+    else if (a->type == gensym("long"))
+        *(t_atom_long*)(base + a->offset) = atom_getlong(argv);
+    else if (a->type == gensym("char"))
+        *(char*)(base + a->offset) = (char)atom_getlong(argv);
+    else if (a->type == gensym("float32"))
+        *(float*)(base + a->offset) = (float)atom_getfloat(argv);
+    else if (a->type == gensym("float64"))
+        *(double*)(base + a->offset) = atom_getfloat(argv);
+    else
+        return MAX_ERR_GENERIC;
+    return MAX_ERR_NONE;
+}
+
+t_max_err object_attr_getvalueof(void* x, t_symbol* s, long* argc,
+                                 t_atom** argv)
+{
+    t_object* ob = (t_object*)x;
+    t_stub_attr* a = stub_class_findattr(ob->o_class, s);
+    char* base = (char*)x;
+    char alloc;
+
+    if (a == NULL)
+        return MAX_ERR_GENERIC;
+    if (a->getter)
+        return ((t_stub_attr_get)a->getter)(x, a, argc, argv);
+    if (a->offsetcount >= 0) {
+        long n = *(long*)(base + a->offsetcount);
+        long es = stub_attr_elemsize(a->type);
+        atom_alloc_array(n, argc, argv, &alloc);
+        for (long i = 0; i < n; i++)
+            stub_attr_load(a->type, base + a->offset + i * es, *argv + i);
+        *argc = n;
+        return MAX_ERR_NONE;
+    }
+
+    atom_alloc(argc, argv, &alloc);
+    if (a->type == gensym("symbol"))
+        atom_setsym(*argv, *(t_symbol**)(base + a->offset));
+    else if (a->type == gensym("long"))
+        atom_setlong(*argv, *(t_atom_long*)(base + a->offset));
+    else if (a->type == gensym("char"))
+        atom_setlong(*argv, *(char*)(base + a->offset));
+    else if (a->type == gensym("float32"))
+        atom_setfloat(*argv, *(float*)(base + a->offset));
+    else if (a->type == gensym("float64"))
+        atom_setfloat(*argv, *(double*)(base + a->offset));
+    else
+        return MAX_ERR_GENERIC;
+    return MAX_ERR_NONE;
+}
+
+t_max_err object_attr_setsym(void* x, t_symbol* s, t_symbol* c)
+{
+    t_atom a;
+    atom_setsym(&a, c);
+    return object_attr_setvalueof(x, s, 1, &a);
+}
+
+t_max_err object_attr_setlong(void* x, t_symbol* s, t_atom_long c)
+{
+    t_atom a;
+    atom_setlong(&a, c);
+    return object_attr_setvalueof(x, s, 1, &a);
+}
+
+t_max_err object_attr_setfloat(void* x, t_symbol* s, double c)
+{
+    t_atom a;
+    atom_setfloat(&a, c);
+    return object_attr_setvalueof(x, s, 1, &a);
+}
+
+t_max_err object_attr_setchar(void* x, t_symbol* s, unsigned char c)
+{
+    return object_attr_setlong(x, s, c);
+}
+
+t_symbol* object_attr_getsym(void* x, t_symbol* s)
+{
+    long ac = 0;
+    t_atom* av = NULL;
+    t_symbol* result = gensym("");
+    if (object_attr_getvalueof(x, s, &ac, &av) == MAX_ERR_NONE && ac)
+        result = atom_getsym(av);
+    sysmem_freeptr(av);
+    return result;
+}
+
+t_atom_long object_attr_getlong(void* x, t_symbol* s)
+{
+    long ac = 0;
+    t_atom* av = NULL;
+    t_atom_long result = 0;
+    if (object_attr_getvalueof(x, s, &ac, &av) == MAX_ERR_NONE && ac)
+        result = atom_getlong(av);
+    sysmem_freeptr(av);
+    return result;
+}
+
+double object_attr_getfloat(void* x, t_symbol* s)
+{
+    long ac = 0;
+    t_atom* av = NULL;
+    double result = 0;
+    if (object_attr_getvalueof(x, s, &ac, &av) == MAX_ERR_NONE && ac)
+        result = atom_getfloat(av);
+    sysmem_freeptr(av);
+    return result;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Outlets */
+
+typedef struct _stub_outlet {
+    t_object ob;
+    void* owner;
+    long index;
+    struct _stub_outlet* next;
+} t_stub_outlet;
+
+static void stub_outlet_free(t_stub_outlet* x) { }
+
+void maxstub_set_outlet_hook(maxstub_outlet_fn fn, void* arg)
+{
+    stub_outlet_hook = fn;
+    stub_outlet_hook_arg = arg;
+}
+
+void* outlet_new(void* x, const char* s)
+{
+    stub_init();
+    t_object* owner = (t_object*)x;
+    t_stub_outlet* o = (t_stub_outlet*)object_alloc(stub_outlet_class);
+    long n = 0;
+
+    o->owner = x;
+    /* outlets are created right to left, so prepend */
+    for (t_stub_outlet* it = owner->o_outlet; it; it = it->next)
+        n++;
+    o->index = n;
+    o->next = owner->o_outlet;
+    owner->o_outlet = o;
+    return o;
+}
+
+void* bangout(void* x) { return outlet_new(x, "bang"); }
+void* intout(void* x) { return outlet_new(x, "int"); }
+void* floatout(void* x) { return outlet_new(x, "float"); }
+void* listout(void* x) { return outlet_new(x, "list"); }
+
+void* maxstub_outlet(void* x, long index)
+{
+    t_object* owner = (t_object*)x;
+    for (t_stub_outlet* it = owner->o_outlet; it; it = it->next) {
+        if (index-- == 0)
+            return it;
+    }
+    return NULL;
+}
+
+static void* stub_outlet_emit(void* o, t_symbol* s, long ac, t_atom* av)
+{
+    if (o == NULL)
+        return NULL;
+    if (stub_outlet_hook) {
+        stub_outlet_hook(o, s, ac, av, stub_outlet_hook_arg);
+    } else if (!stub_quiet) {
+        long size = 0;
+        char* text = NULL;
+        atom_gettext(ac, av, &size, &text, OBEX_UTIL_ATOM_GETTEXT_DEFAULT);
+        printf("outlet %ld: %s %s\n", ((t_stub_outlet*)o)->index, s->s_name,
+               text);
+        sysmem_freeptr(text);
+    }
+    return o;
+}
+
+void* outlet_bang(void* o)
+{
+    return stub_outlet_emit(o, gensym("bang"), 0, NULL);
+}
+
+void* outlet_int(void* o, t_atom_long n)
+{
+    t_atom a;
+    atom_setlong(&a, n);
+    return stub_outlet_emit(o, gensym("int"), 1, &a);
+}
+
+void* outlet_float(void* o, double f)
+{
+    t_atom a;
+    atom_setfloat(&a, f);
+    return stub_outlet_emit(o, gensym("float"), 1, &a);
+}
+
+void* outlet_list(void* o, t_symbol* s, short ac, t_atom* av)
+{
+    return stub_outlet_emit(o, gensym("list"), ac, av);
+}
+
+void* outlet_anything(void* o, const t_symbol* s, short ac, const t_atom* av)
+{
+    return stub_outlet_emit(o, (t_symbol*)s, ac, (t_atom*)av);
+}
+
+/*--------------------------------------------------------------------------*/
+/* Clocks, qelems and deferral (virtual time) */
+
+typedef struct _stub_clock {
+    t_object ob;
+    void* owner;
+    method fn;
+    double when;
+    int is_set;
+    struct _stub_clock* next;
+} t_stub_clock;
+
+static t_stub_clock* stub_clocks = NULL;
+
+static void stub_clock_free(t_stub_clock* x)
+{
+    t_stub_clock** pc = &stub_clocks;
+    while (*pc) {
+        if (*pc == x) {
+            *pc = x->next;
+            break;
+        }
+        pc = &(*pc)->next;
+    }
+}
+
+void* clock_new(void* obj, method fn)
+{
+    stub_init();
+    t_stub_clock* c = (t_stub_clock*)object_alloc(stub_clock_class);
+    c->owner = obj;
+    c->fn = fn;
+    c->next = stub_clocks;
+    stub_clocks = c;
+    return c;
+}
+
+void clock_delay(void* x, long n) { clock_fdelay(x, (double)n); }
+
+void clock_fdelay(void* c, double time)
+{
+    t_stub_clock* x = c;
+    x->when = stub_now + (time > 0 ? time : 0);
+    x->is_set = 1;
+}
+
+void clock_unset(void* x) { ((t_stub_clock*)x)->is_set = 0; }
+
+void clock_getftime(double* time) { *time = stub_now; }
+
+void setclock_getftime(void* x, double* time) { *time = stub_now; }
+
+double gettime_forobject(t_object* x) { return stub_now; }
+
+long gettime(void) { return (long)stub_now; }
+
+void scheduler_gettime(double* time) { *time = stub_now; }
+
+double maxstub_now(void) { return stub_now; }
+
+void maxstub_advance(double ms)
+{
+    double target = stub_now + ms;
+    for (;;) {
+        t_stub_clock* next = NULL;
+        for (t_stub_clock* c = stub_clocks; c; c = c->next) {
+            if (c->is_set && c->when <= target
+                && (next == NULL || c->when < next->when))
+                next = c;
+        }
+        if (next == NULL)
+            break;
+        stub_now = next->when;
+        next->is_set = 0;
+        ((t_stub_none)next->fn)(next->owner);
+    }
+    stub_now = target;
+}
+
+typedef struct _stub_deferred {
+    void* ob;
+    method fn;
+    t_symbol* sym;
+    short argc;
+    t_atom* argv;
+    void* qelem;
+    struct _stub_deferred* next;
+} t_stub_deferred;
+
+typedef struct _stub_qelem {
+    t_object ob;
+    void* owner;
+    method fn;
+    int is_set;
+} t_stub_qelem;
+
+static t_stub_deferred* stub_deferred_head = NULL;
+static t_stub_deferred* stub_deferred_tail = NULL;
+static pthread_mutex_t stub_defer_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void stub_defer_push(t_stub_deferred* d)
+{
+    pthread_mutex_lock(&stub_defer_lock);
+    if (stub_deferred_tail)
+        stub_deferred_tail->next = d;
+    else
+        stub_deferred_head = d;
+    stub_deferred_tail = d;
+    pthread_mutex_unlock(&stub_defer_lock);
+}
+
+typedef void* (*t_stub_defer_fn)(void*, t_symbol*, short, t_atom*);
+
+void* defer(void* ob, method fn, t_symbol* sym, short argc, t_atom* argv)
+{
+    /* the stub has no separate low-priority thread: run immediately */
+    ((t_stub_defer_fn)fn)(ob, sym, argc, argv);
+    return NULL;
+}
+
+void* defer_low(void* ob, method fn, t_symbol* sym, short argc, t_atom* argv)
+{
+    t_stub_deferred* d = calloc(1, sizeof(t_stub_deferred));
+    d->ob = ob;
+    d->fn = fn;
+    d->sym = sym;
+    d->argc = argc;
+    if (argc) {
+        d->argv = malloc(sizeof(t_atom) * (size_t)argc);
+        memcpy(d->argv, argv, sizeof(t_atom) * (size_t)argc);
+    }
+    stub_defer_push(d);
+    return NULL;
+}
+
+static void stub_qelem_free(t_stub_qelem* x)
+{
+    pthread_mutex_lock(&stub_defer_lock);
+    for (t_stub_deferred* d = stub_deferred_head; d; d = d->next) {
+        if (d->qelem == x)
+            d->qelem = NULL, d->fn = NULL;
+    }
+    pthread_mutex_unlock(&stub_defer_lock);
+}
+
+void* qelem_new(void* obj, method fn)
+{
+    stub_init();
+    t_stub_qelem* q = (t_stub_qelem*)object_alloc(stub_qelem_class);
+    q->owner = obj;
+    q->fn = fn;
+    return q;
+}
+
+void qelem_set(void* q)
+{
+    t_stub_qelem* x = q;
+    pthread_mutex_lock(&stub_defer_lock);
+    int was_set = x->is_set;
+    x->is_set = 1;
+    pthread_mutex_unlock(&stub_defer_lock);
+    if (!was_set) {
+        t_stub_deferred* d = calloc(1, sizeof(t_stub_deferred));
+        d->qelem = x;
+        d->fn = x->fn;
+        d->ob = x->owner;
+        stub_defer_push(d);
+    }
+}
+
+void qelem_unset(void* q) { ((t_stub_qelem*)q)->is_set = 0; }
+
+void qelem_front(void* q) { qelem_set(q); }
+
+void qelem_free(void* q) { object_free(q); }
+
+long maxstub_run_deferred(void)
+{
+    long count = 0;
+    for (;;) {
+        pthread_mutex_lock(&stub_defer_lock);
+        t_stub_deferred* d = stub_deferred_head;
+        if (d) {
+            stub_deferred_head = d->next;
+            if (stub_deferred_head == NULL)
+                stub_deferred_tail = NULL;
+        }
+        pthread_mutex_unlock(&stub_defer_lock);
+        if (d == NULL)
+            break;
+        if (d->qelem) {
+            t_stub_qelem* q = d->qelem;
+            if (q->is_set) {
+                q->is_set = 0;
+                ((t_stub_none)d->fn)(d->ob);
+                count++;
+            }
+        } else if (d->fn) {
+            ((t_stub_defer_fn)d->fn)(d->ob, d->sym, d->argc, d->argv);
+            count++;
+        }
+        free(d->argv);
+        free(d);
+    }
+    return count;
+}
+
+short isr(void) { return 0; }
+
+long systhread_ismainthread(void) { return 1; }
+
+long systhread_istimerthread(void) { return 0; }
+
+/*--------------------------------------------------------------------------*/
+/* Hashtab */
+
+typedef struct _stub_hentry {
+    t_symbol* key;
+    t_atom value;
+    struct _stub_hentry* next;
+} t_stub_hentry;
+
+typedef struct _stub_hashtab {
+    t_object ob;
+    long slotcount;
+    long size;
+    long flags;
+    t_stub_hentry** slots;
+} t_stub_hashtab;
+
+static void stub_hashtab_free(t_stub_hashtab* x)
+{
+    hashtab_clear((t_hashtab*)x);
+    free(x->slots);
+}
+
+t_hashtab* hashtab_new(long slotcount)
+{
+    stub_init();
+    t_stub_hashtab* x = (t_stub_hashtab*)object_alloc(stub_hashtab_class);
+    x->slotcount = slotcount > 0 ? slotcount : 59;
+    x->slots = calloc((size_t)x->slotcount, sizeof(t_stub_hentry*));
+    return (t_hashtab*)x;
+}
+
+static t_stub_hentry** stub_hashtab_find(t_stub_hashtab* x, t_symbol* key)
+{
+    t_stub_hentry** pe
+        = &x->slots[((uintptr_t)key >> 4) % (uintptr_t)x->slotcount];
+    while (*pe && (*pe)->key != key)
+        pe = &(*pe)->next;
+    return pe;
+}
+
+static void stub_hentry_release(t_stub_hashtab* x, t_stub_hentry* e)
+{
+    if (e->value.a_type == A_OBJ && !(x->flags & OBJ_FLAG_REF)
+        && e->value.a_w.w_obj)
+        object_free(e->value.a_w.w_obj);
+}
+
+static t_max_err stub_hashtab_put(t_hashtab* ht, t_symbol* key, t_atom* a)
+{
+    t_stub_hashtab* x = (t_stub_hashtab*)ht;
+    t_stub_hentry** pe = stub_hashtab_find(x, key);
+    if (*pe) {
+        if (!((*pe)->value.a_type == A_OBJ
+              && (*pe)->value.a_w.w_obj == a->a_w.w_obj))
+            stub_hentry_release(x, *pe);
+        (*pe)->value = *a;
+        return MAX_ERR_NONE;
+    }
+    t_stub_hentry* e = calloc(1, sizeof(t_stub_hentry));
+    e->key = key;
+    e->value = *a;
+    *pe = e;
+    x->size++;
+    return MAX_ERR_NONE;
+}
+
+t_max_err hashtab_store(t_hashtab* x, t_symbol* key, t_object* val)
+{
+    t_atom a;
+    atom_setobj(&a, val);
+    return stub_hashtab_put(x, key, &a);
+}
+
+t_max_err hashtab_storelong(t_hashtab* x, t_symbol* key, t_atom_long val)
+{
+    t_atom a;
+    atom_setlong(&a, val);
+    return stub_hashtab_put(x, key, &a);
+}
+
+t_max_err hashtab_storesym(t_hashtab* x, t_symbol* key, t_symbol* val)
+{
+    t_atom a;
+    atom_setsym(&a, val);
+    return stub_hashtab_put(x, key, &a);
+}
+
+t_max_err hashtab_lookup(t_hashtab* ht, t_symbol* key, t_object** val)
+{
+    t_stub_hentry* e = *stub_hashtab_find((t_stub_hashtab*)ht, key);
+    if (e == NULL || e->value.a_type != A_OBJ) {
+        *val = NULL;
+        return MAX_ERR_GENERIC;
+    }
+    *val = e->value.a_w.w_obj;
+    return MAX_ERR_NONE;
+}
+
+t_max_err hashtab_lookuplong(t_hashtab* ht, t_symbol* key, t_atom_long* val)
+{
+    t_stub_hentry* e = *stub_hashtab_find((t_stub_hashtab*)ht, key);
+    if (e == NULL)
+        return MAX_ERR_GENERIC;
+    *val = atom_getlong(&e->value);
+    return MAX_ERR_NONE;
+}
+
+t_max_err hashtab_lookupsym(t_hashtab* ht, t_symbol* key, t_symbol** val)
+{
+    t_stub_hentry* e = *stub_hashtab_find((t_stub_hashtab*)ht, key);
+    if (e == NULL)
+        return MAX_ERR_GENERIC;
+    *val = atom_getsym(&e->value);
+    return MAX_ERR_NONE;
+}
+
+static t_max_err stub_hashtab_remove(t_hashtab* ht, t_symbol* key, int release)
+{
+    t_stub_hashtab* x = (t_stub_hashtab*)ht;
+    t_stub_hentry** pe = stub_hashtab_find(x, key);
+    t_stub_hentry* e = *pe;
+    if (e == NULL)
+        return MAX_ERR_GENERIC;
+    *pe = e->next;
+    if (release)
+        stub_hentry_release(x, e);
+    free(e);
+    x->size--;
+    return MAX_ERR_NONE;
+}
+
+t_max_err hashtab_delete(t_hashtab* x, t_symbol* key)
+{
+    return stub_hashtab_remove(x, key, 1);
+}
+
+t_max_err hashtab_chuckkey(t_hashtab* x, t_symbol* key)
+{
+    return stub_hashtab_remove(x, key, 0);
+}
+
+t_max_err hashtab_clear(t_hashtab* ht)
+{
+    t_stub_hashtab* x = (t_stub_hashtab*)ht;
+    for (long i = 0; i < x->slotcount; i++) {
+        t_stub_hentry* e = x->slots[i];
+        while (e) {
+            t_stub_hentry* next = e->next;
+            stub_hentry_release(x, e);
+            free(e);
+            e = next;
+        }
+        x->slots[i] = NULL;
+    }
+    x->size = 0;
+    return MAX_ERR_NONE;
+}
+
+t_max_err hashtab_chuck(t_hashtab* ht)
+{
+    if (ht == NULL)
+        return MAX_ERR_INVALID_PTR;
+    ((t_stub_hashtab*)ht)->flags |= OBJ_FLAG_REF;
+    return object_free(ht);
+}
+
+t_atom_long hashtab_getsize(t_hashtab* x)
+{
+    return x ? ((t_stub_hashtab*)x)->size : 0;
+}
+
+void hashtab_flags(t_hashtab* x, long flags)
+{
+    ((t_stub_hashtab*)x)->flags = flags;
+}
+
+t_max_err hashtab_getkeys(t_hashtab* ht, long* kc, t_symbol*** kv)
+{
+    t_stub_hashtab* x = (t_stub_hashtab*)ht;
+    long n = 0;
+    *kv = sysmem_newptr((x->size ? x->size : 1) * (long)sizeof(t_symbol*));
+    for (long i = 0; i < x->slotcount; i++)
+        for (t_stub_hentry* e = x->slots[i]; e; e = e->next)
+            (*kv)[n++] = e->key;
+    *kc = n;
+    return MAX_ERR_NONE;
+}
+
+typedef void (*t_stub_hashfun)(t_stub_hentry*, void*);
+
+t_max_err hashtab_funall(t_hashtab* ht, method fun, void* arg)
+{
+    t_stub_hashtab* x = (t_stub_hashtab*)ht;
+    for (long i = 0; i < x->slotcount; i++)
+        for (t_stub_hentry* e = x->slots[i]; e; e = e->next)
+            ((t_stub_hashfun)fun)(e, arg);
+    return MAX_ERR_NONE;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Linklist */
+
+typedef struct _stub_linklist {
+    t_object ob;
+    long size;
+    long cap;
+    long flags;
+    void** items;
+} t_stub_linklist;
+
+static void stub_linklist_free(t_stub_linklist* x)
+{
+    if (!(x->flags & OBJ_FLAG_REF)) {
+        for (long i = 0; i < x->size; i++)
+            object_free(x->items[i]);
+    }
+    free(x->items);
+}
+
+t_linklist* linklist_new(void)
+{
+    stub_init();
+    return (t_linklist*)object_alloc(stub_linklist_class);
+}
+
+t_atom_long linklist_append(t_linklist* ll, void* o)
+{
+    t_stub_linklist* x = (t_stub_linklist*)ll;
+    if (x->size == x->cap) {
+        x->cap = x->cap ? x->cap * 2 : 8;
+        x->items = realloc(x->items, sizeof(void*) * (size_t)x->cap);
+    }
+    x->items[x->size] = o;
+    return x->size++;
+}
+
+t_atom_long linklist_getsize(t_linklist* x)
+{
+    return ((t_stub_linklist*)x)->size;
+}
+
+void* linklist_getindex(t_linklist* ll, long index)
+{
+    t_stub_linklist* x = (t_stub_linklist*)ll;
+    return (index >= 0 && index < x->size) ? x->items[index] : NULL;
+}
+
+t_atom_long linklist_deleteindex(t_linklist* ll, long index)
+{
+    t_stub_linklist* x = (t_stub_linklist*)ll;
+    if (index < 0 || index >= x->size)
+        return -1;
+    memmove(x->items + index, x->items + index + 1,
+            sizeof(void*) * (size_t)(x->size - index - 1));
+    x->size--;
+    return index;
+}
+
+long linklist_chuckobject(t_linklist* ll, void* o)
+{
+    t_stub_linklist* x = (t_stub_linklist*)ll;
+    for (long i = 0; i < x->size; i++) {
+        if (x->items[i] == o) {
+            linklist_deleteindex(ll, i);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void linklist_clear(t_linklist* x) { ((t_stub_linklist*)x)->size = 0; }
+
+void linklist_chuck(t_linklist* ll)
+{
+    ((t_stub_linklist*)ll)->flags |= OBJ_FLAG_REF;
+    object_free(ll);
+}
+
+void linklist_flags(t_linklist* x, long flags)
+{
+    ((t_stub_linklist*)x)->flags = flags;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Atomarray */
+
+typedef struct _stub_atomarray {
+    t_object ob;
+    long ac;
+    t_atom* av;
+    long flags;
+} t_stub_atomarray;
+
+static void stub_atomarray_free(t_stub_atomarray* x)
+{
+    if (x->flags & ATOMARRAY_FLAG_FREECHILDREN) {
+        for (long i = 0; i < x->ac; i++) {
+            if (x->av[i].a_type == A_OBJ && x->av[i].a_w.w_obj)
+                object_free(x->av[i].a_w.w_obj);
+        }
+    }
+    sysmem_freeptr(x->av);
+}
+
+t_atomarray* atomarray_new(long ac, t_atom* av)
+{
+    stub_init();
+    t_atomarray* x = (t_atomarray*)object_alloc(stub_atomarray_class);
+    atomarray_setatoms(x, ac, av);
+    return x;
+}
+
+t_max_err atomarray_setatoms(t_atomarray* aa, long ac, t_atom* av)
+{
+    t_stub_atomarray* x = (t_stub_atomarray*)aa;
+    sysmem_freeptr(x->av);
+    x->av = NULL;
+    x->ac = 0;
+    if (ac > 0 && av) {
+        x->av = sysmem_newptr(ac * (long)sizeof(t_atom));
+        memcpy(x->av, av, sizeof(t_atom) * (size_t)ac);
+        x->ac = ac;
+    }
+    return MAX_ERR_NONE;
+}
+
+t_max_err atomarray_getatoms(t_atomarray* aa, long* ac, t_atom** av)
+{
+    t_stub_atomarray* x = (t_stub_atomarray*)aa;
+    if (x == NULL)
+        return MAX_ERR_INVALID_PTR;
+    *ac = x->ac;
+    *av = x->av;
+    return MAX_ERR_NONE;
+}
+
+t_max_err atomarray_copyatoms(t_atomarray* aa, long* ac, t_atom** av)
+{
+    t_stub_atomarray* x = (t_stub_atomarray*)aa;
+    *ac = x->ac;
+    *av = sysmem_newptr((x->ac ? x->ac : 1) * (long)sizeof(t_atom));
+    memcpy(*av, x->av, sizeof(t_atom) * (size_t)x->ac);
+    return MAX_ERR_NONE;
+}
+
+t_atom_long atomarray_getsize(t_atomarray* x)
+{
+    return ((t_stub_atomarray*)x)->ac;
+}
+
+t_max_err atomarray_getindex(t_atomarray* aa, long index, t_atom* av)
+{
+    t_stub_atomarray* x = (t_stub_atomarray*)aa;
+    if (index < 0 || index >= x->ac)
+        return MAX_ERR_GENERIC;
+    *av = x->av[index];
+    return MAX_ERR_NONE;
+}
+
+void atomarray_appendatoms(t_atomarray* aa, long ac, t_atom* av)
+{
+    t_stub_atomarray* x = (t_stub_atomarray*)aa;
+    x->av = sysmem_resizeptr(x->av, (x->ac + ac) * (long)sizeof(t_atom));
+    memcpy(x->av + x->ac, av, sizeof(t_atom) * (size_t)ac);
+    x->ac += ac;
+}
+
+void atomarray_appendatom(t_atomarray* x, t_atom* a)
+{
+    atomarray_appendatoms(x, 1, a);
+}
+
+void atomarray_clear(t_atomarray* x)
+{
+    atomarray_setatoms(x, 0, NULL);
+}
+
+void atomarray_flags(t_atomarray* x, long flags)
+{
+    ((t_stub_atomarray*)x)->flags = flags;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Strings */
+
+typedef struct _stub_string {
+    t_object ob;
+    char* s;
+} t_stub_string;
+
+static void stub_string_free(t_stub_string* x) { free(x->s); }
+
+t_string* string_new(const char* psz)
+{
+    stub_init();
+    t_stub_string* x = (t_stub_string*)object_alloc(stub_string_class);
+    x->s = strdup(psz ? psz : "");
+    return (t_string*)x;
+}
+
+const char* string_getptr(t_string* x) { return ((t_stub_string*)x)->s; }
+
+/*--------------------------------------------------------------------------*/
+/* Dictionary */
+
+typedef struct _stub_dentry {
+    t_symbol* key;
+    t_atom value; /* A_OBJ for atomarray, dictionary, string and objects */
+} t_stub_dentry;
+
+typedef struct _stub_dictionary {
+    t_object ob;
+    long size;
+    long cap;
+    t_stub_dentry* entries;
+    t_symbol* regname;
+    long refcount;
+} t_stub_dictionary;
+
+static void stub_dentry_release(t_stub_dentry* e)
+{
+    if (e->value.a_type == A_OBJ && e->value.a_w.w_obj)
+        object_free(e->value.a_w.w_obj);
+}
+
+static void stub_dictionary_free(t_stub_dictionary* x)
+{
+    dictionary_clear((t_dictionary*)x);
+    free(x->entries);
+    if (x->regname)
+        dictobj_unregister((t_dictionary*)x);
+}
+
+t_dictionary* dictionary_new(void)
+{
+    stub_init();
+    return (t_dictionary*)object_alloc(stub_dictionary_class);
+}
+
+static t_stub_dentry* stub_dict_find(const t_dictionary* d, t_symbol* key)
+{
+    t_stub_dictionary* x = (t_stub_dictionary*)d;
+    for (long i = 0; i < x->size; i++) {
+        if (x->entries[i].key == key)
+            return &x->entries[i];
+    }
+    return NULL;
+}
+
+static t_max_err stub_dict_put(t_dictionary* d, t_symbol* key, t_atom* a)
+{
+    t_stub_dictionary* x = (t_stub_dictionary*)d;
+    t_stub_dentry* e = stub_dict_find(d, key);
+    if (e) {
+        stub_dentry_release(e);
+        e->value = *a;
+        return MAX_ERR_NONE;
+    }
+    if (x->size == x->cap) {
+        x->cap = x->cap ? x->cap * 2 : 8;
+        x->entries = realloc(x->entries, sizeof(t_stub_dentry) * (size_t)x->cap);
+    }
+    x->entries[x->size].key = key;
+    x->entries[x->size].value = *a;
+    x->size++;
+    return MAX_ERR_NONE;
+}
+
+t_max_err dictionary_appendlong(t_dictionary* d, t_symbol* key,
+                                t_atom_long value)
+{
+    t_atom a;
+    atom_setlong(&a, value);
+    return stub_dict_put(d, key, &a);
+}
+
+t_max_err dictionary_appendfloat(t_dictionary* d, t_symbol* key, double value)
+{
+    t_atom a;
+    atom_setfloat(&a, value);
+    return stub_dict_put(d, key, &a);
+}
+
+t_max_err dictionary_appendsym(t_dictionary* d, t_symbol* key,
+                               t_symbol* value)
+{
+    t_atom a;
+    atom_setsym(&a, value);
+    return stub_dict_put(d, key, &a);
+}
+
+t_max_err dictionary_appendatom(t_dictionary* d, t_symbol* key, t_atom* value)
+{
+    return stub_dict_put(d, key, value);
+}
+
+t_max_err dictionary_appendstring(t_dictionary* d, t_symbol* key,
+                                  const char* value)
+{
+    t_atom a;
+    atom_setobj(&a, string_new(value));
+    return stub_dict_put(d, key, &a);
+}
+
+t_max_err dictionary_appendatoms(t_dictionary* d, t_symbol* key, long argc,
+                                 t_atom* argv)
+{
+    if (argc == 1 && argv[0].a_type != A_OBJ)
+        return stub_dict_put(d, key, argv);
+    t_atom a;
+    atom_setobj(&a, atomarray_new(argc, argv));
+    return stub_dict_put(d, key, &a);
+}
+
+t_max_err dictionary_appendatomarray(t_dictionary* d, t_symbol* key,
+                                     t_object* value)
+{
+    t_atom a;
+    atom_setobj(&a, value);
+    return stub_dict_put(d, key, &a);
+}
+
+t_max_err dictionary_appenddictionary(t_dictionary* d, t_symbol* key,
+                                      t_object* value)
+{
+    t_atom a;
+    atom_setobj(&a, value);
+    return stub_dict_put(d, key, &a);
+}
+
+t_max_err dictionary_appendobject(t_dictionary* d, t_symbol* key,
+                                  t_object* value)
+{
+    t_atom a;
+    atom_setobj(&a, value);
+    return stub_dict_put(d, key, &a);
+}
+
+t_max_err dictionary_getlong(const t_dictionary* d, t_symbol* key,
+                             t_atom_long* value)
+{
+    t_stub_dentry* e = stub_dict_find(d, key);
+    if (e == NULL || (e->value.a_type != A_LONG && e->value.a_type != A_FLOAT))
+        return MAX_ERR_GENERIC;
+    *value = atom_getlong(&e->value);
+    return MAX_ERR_NONE;
+}
+
+t_max_err dictionary_getfloat(const t_dictionary* d, t_symbol* key,
+                              double* value)
+{
+    t_stub_dentry* e = stub_dict_find(d, key);
+    if (e == NULL || (e->value.a_type != A_LONG && e->value.a_type != A_FLOAT))
+        return MAX_ERR_GENERIC;
+    *value = atom_getfloat(&e->value);
+    return MAX_ERR_NONE;
+}
+
+t_max_err dictionary_getsym(const t_dictionary* d, t_symbol* key,
+                            t_symbol** value)
+{
+    t_stub_dentry* e = stub_dict_find(d, key);
+    if (e == NULL || e->value.a_type != A_SYM)
+        return MAX_ERR_GENERIC;
+    *value = e->value.a_w.w_sym;
+    return MAX_ERR_NONE;
+}
+
+t_max_err dictionary_getatom(const t_dictionary* d, t_symbol* key,
+                             t_atom* value)
+{
+    t_stub_dentry* e = stub_dict_find(d, key);
+    if (e == NULL)
+        return MAX_ERR_GENERIC;
+    *value = e->value;
+    return MAX_ERR_NONE;
+}
+
+t_max_err dictionary_getstring(const t_dictionary* d, t_symbol* key,
+                               const char** value)
+{
+    t_stub_dentry* e = stub_dict_find(d, key);
+    if (e == NULL || !dictionary_entryisstring(d, key))
+        return MAX_ERR_GENERIC;
+    *value = string_getptr(e->value.a_w.w_obj);
+    return MAX_ERR_NONE;
+}
+
+t_max_err dictionary_getatoms(const t_dictionary* d, t_symbol* key,
+                              long* argc, t_atom** argv)
+{
+    t_stub_dentry* e = stub_dict_find(d, key);
+    if (e == NULL)
+        return MAX_ERR_GENERIC;
+    if (dictionary_entryisatomarray(d, key))
+        return atomarray_getatoms(e->value.a_w.w_obj, argc, argv);
+    *argc = 1;
+    *argv = &e->value;
+    return MAX_ERR_NONE;
+}
+
+static t_max_err stub_dict_getobj(const t_dictionary* d, t_symbol* key,
+                                  t_class* c, t_object** value)
+{
+    t_stub_dentry* e = stub_dict_find(d, key);
+    if (e == NULL || e->value.a_type != A_OBJ)
+        return MAX_ERR_GENERIC;
+    if (c && e->value.a_w.w_obj->o_class != c)
+        return MAX_ERR_GENERIC;
+    *value = e->value.a_w.w_obj;
+    return MAX_ERR_NONE;
+}
+
+t_max_err dictionary_getatomarray(const t_dictionary* d, t_symbol* key,
+                                  t_object** value)
+{
+    return stub_dict_getobj(d, key, stub_atomarray_class, value);
+}
+
+t_max_err dictionary_getdictionary(const t_dictionary* d, t_symbol* key,
+                                   t_object** value)
+{
+    return stub_dict_getobj(d, key, stub_dictionary_class, value);
+}
+
+t_max_err dictionary_getobject(const t_dictionary* d, t_symbol* key,
+                               t_object** value)
+{
+    return stub_dict_getobj(d, key, NULL, value);
+}
+
+static long stub_dict_entryis(const t_dictionary* d, t_symbol* key,
+                              t_class* c)
+{
+    t_stub_dentry* e = stub_dict_find(d, key);
+    return e && e->value.a_type == A_OBJ && e->value.a_w.w_obj
+        && e->value.a_w.w_obj->o_class == c;
+}
+
+long dictionary_entryisstring(const t_dictionary* d, t_symbol* key)
+{
+    return stub_dict_entryis(d, key, stub_string_class);
+}
+
+long dictionary_entryisatomarray(const t_dictionary* d, t_symbol* key)
+{
+    return stub_dict_entryis(d, key, stub_atomarray_class);
+}
+
+long dictionary_entryisdictionary(const t_dictionary* d, t_symbol* key)
+{
+    return stub_dict_entryis(d, key, stub_dictionary_class);
+}
+
+long dictionary_hasentry(const t_dictionary* d, t_symbol* key)
+{
+    return stub_dict_find(d, key) != NULL;
+}
+
+t_atom_long dictionary_getentrycount(const t_dictionary* d)
+{
+    return ((t_stub_dictionary*)d)->size;
+}
+
+t_max_err dictionary_getkeys(const t_dictionary* d, long* numkeys,
+                             t_symbol*** keys)
+{
+    t_stub_dictionary* x = (t_stub_dictionary*)d;
+    *keys = sysmem_newptr((x->size ? x->size : 1) * (long)sizeof(t_symbol*));
+    for (long i = 0; i < x->size; i++)
+        (*keys)[i] = x->entries[i].key;
+    *numkeys = x->size;
+    return MAX_ERR_NONE;
+}
+
+t_max_err dictionary_getkeys_ordered(const t_dictionary* d, long* numkeys,
+                                     t_symbol*** keys)
+{
+    return dictionary_getkeys(d, numkeys, keys);
+}
+
+void dictionary_freekeys(t_dictionary* d, long numkeys, t_symbol** keys)
+{
+    sysmem_freeptr(keys);
+}
+
+t_max_err dictionary_deleteentry(t_dictionary* d, t_symbol* key)
+{
+    t_stub_dictionary* x = (t_stub_dictionary*)d;
+    t_stub_dentry* e = stub_dict_find(d, key);
+    if (e == NULL)
+        return MAX_ERR_GENERIC;
+    stub_dentry_release(e);
+    long i = e - x->entries;
+    memmove(e, e + 1, sizeof(t_stub_dentry) * (size_t)(x->size - i - 1));
+    x->size--;
+    return MAX_ERR_NONE;
+}
+
+t_max_err dictionary_clear(t_dictionary* d)
+{
+    t_stub_dictionary* x = (t_stub_dictionary*)d;
+    for (long i = 0; i < x->size; i++)
+        stub_dentry_release(&x->entries[i]);
+    x->size = 0;
+    return MAX_ERR_NONE;
+}
+
+/* dictobj */
+
+static t_hashtab* stub_dictobj_registry = NULL;
+
+static t_symbol* stub_last_dictionary_name = NULL;
+
+t_symbol* maxstub_last_dictionary_name(void)
+{
+    return stub_last_dictionary_name;
+}
+
+t_dictionary* dictobj_register(t_dictionary* d, t_symbol** name)
+{
+    t_stub_dictionary* x = (t_stub_dictionary*)d;
+    stub_init();
+    if (*name == NULL)
+        *name = symbol_unique();
+    stub_last_dictionary_name = *name;
+    hashtab_store(stub_dictobj_registry, *name, d);
+    x->regname = *name;
+    return d;
+}
+
+t_max_err dictobj_unregister(t_dictionary* d)
+{
+    t_stub_dictionary* x = (t_stub_dictionary*)d;
+    if (x->regname) {
+        hashtab_chuckkey(stub_dictobj_registry, x->regname);
+        x->regname = NULL;
+    }
+    return MAX_ERR_NONE;
+}
+
+t_dictionary* dictobj_findregistered_retain(t_symbol* name)
+{
+    t_object* d = NULL;
+    stub_init();
+    hashtab_lookup(stub_dictobj_registry, name, &d);
+    if (d)
+        ((t_stub_dictionary*)d)->refcount++;
+    return d;
+}
+
+t_dictionary* dictobj_findregistered_clone(t_symbol* name)
+{
+    /* a shallow stand-in: the stub never mutates registered dictionaries */
+    t_object* d = NULL;
+    stub_init();
+    hashtab_lookup(stub_dictobj_registry, name, &d);
+    return d;
+}
+
+t_max_err dictobj_release(t_dictionary* d)
+{
+    t_stub_dictionary* x = (t_stub_dictionary*)d;
+    if (x && --x->refcount < 0)
+        object_free(d);
+    return MAX_ERR_NONE;
+}
+
+t_symbol* dictobj_namefromptr(t_dictionary* d)
+{
+    return ((t_stub_dictionary*)d)->regname;
+}
+
+void dictobj_outlet_atoms(void* out, long argc, t_atom* argv)
+{
+    if (argc && argv[0].a_type == A_SYM)
+        outlet_anything(out, argv[0].a_w.w_sym, (short)(argc - 1), argv + 1);
+    else
+        outlet_list(out, NULL, (short)argc, argv);
+}
+
+/*--------------------------------------------------------------------------*/
+/* Paths and files */
+
+short path_getdefault(void) { return 0; }
+short path_getsupportpath(void) { return 0; }
+short path_tempfolder(void) { return 0; }
+short path_desktopfolder(void) { return 0; }
+short path_userdocfolder(void) { return 0; }
+short path_usermaxfolder(void) { return 0; }
+
+t_max_err path_toabsolutesystempath(const short in_path,
+                                    const char* in_filename,
+                                    char* out_filepath)
+{
+    if (in_filename[0] == '/' || in_filename[0] == '\0') {
+        strncpy_zero(out_filepath, in_filename, MAX_PATH_CHARS);
+    } else {
+        char cwd[MAX_PATH_CHARS];
+        if (getcwd(cwd, sizeof(cwd)) == NULL)
+            return MAX_ERR_GENERIC;
+        snprintf(out_filepath, MAX_PATH_CHARS, "%s/%s", cwd, in_filename);
+    }
+    return MAX_ERR_NONE;
+}
+
+short path_nameconform(const char* src, char* dst, long style, long type)
+{
+    strncpy_zero(dst, src, MAX_PATH_CHARS);
+    return 0;
+}
+
+short path_splitnames(const char* pathname, char* foldername, char* filename)
+{
+    const char* slash = strrchr(pathname, '/');
+    if (slash == NULL) {
+        foldername[0] = '\0';
+        strncpy_zero(filename, pathname, MAX_FILENAME_CHARS);
+    } else {
+        long n = slash - pathname;
+        memcpy(foldername, pathname, (size_t)n);
+        foldername[n] = '\0';
+        strncpy_zero(filename, slash + 1, MAX_FILENAME_CHARS);
+    }
+    return 0;
+}
+
+short locatefile_extended(char* name, short* outvol, t_fourcc* outtype,
+                          const t_fourcc* filetypelist, short numtypes)
+{
+    FILE* f = fopen(name, "r");
+    if (f == NULL)
+        return 1;
+    fclose(f);
+    *outvol = 0;
+    return 0;
+}
+
+short open_dialog(char* name, short* volptr, t_fourcc* typeptr,
+                  t_fourcc* types, short ntypes)
+{
+    return 1; /* always cancelled */
+}
+
+short path_opensysfile(const char* name, const short path, t_filehandle* ref,
+                       short perm)
+{
+    FILE* f = fopen(name, perm == WRITE_PERM ? "w" : "r");
+    *ref = f;
+    return f == NULL;
+}
+
+t_max_err sysfile_readtextfile(t_filehandle fh, t_handle htext, long maxlen,
+                               long flags)
+{
+    FILE* f = fh;
+    long size;
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (maxlen > 0 && size > maxlen)
+        size = maxlen;
+    sysmem_resizehandle(htext, size + 1);
+    size = (long)fread(*htext, 1, (size_t)size, f);
+    (*htext)[size] = '\0';
+    return MAX_ERR_NONE;
+}
+
+t_max_err sysfile_close(t_filehandle f)
+{
+    fclose((FILE*)f);
+    return MAX_ERR_NONE;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Tables */
+
+typedef struct _stub_table {
+    long size;
+    long* data;
+} t_stub_table;
+
+void maxstub_table_new(t_symbol* s, long size)
+{
+    t_stub_table* t = calloc(1, sizeof(t_stub_table));
+    t->size = size;
+    t->data = calloc((size_t)size, sizeof(long));
+    s->s_thing = (t_object*)t;
+}
+
+short table_get(t_symbol* s, long*** hp, long* sp)
+{
+    t_stub_table* t = (t_stub_table*)s->s_thing;
+    if (t == NULL)
+        return 1;
+    *hp = &t->data;
+    *sp = t->size;
+    return 0;
+}
+
+short table_dirty(t_symbol* s) { return 0; }
+
+/*--------------------------------------------------------------------------*/
+/* Buffers */
+
+typedef struct _stub_buffer {
+    t_object ob;
+    t_symbol* name;
+    long frames;
+    long channels;
+    double sr;
+    float* samples;
+    long locked;
+    long dirty;
+} t_stub_buffer;
+
+typedef struct _stub_bufref {
+    t_object ob;
+    t_symbol* name;
+} t_stub_bufref;
+
+static void stub_buffer_free(t_stub_buffer* x)
+{
+    if (x->name && x->name->s_thing == (t_object*)x)
+        x->name->s_thing = NULL;
+    free(x->samples);
+}
+
+static void stub_bufref_free(t_stub_bufref* x) { }
+
+t_buffer_obj* maxstub_buffer_new(t_symbol* name, long frames, long channels,
+                                 double sr)
+{
+    stub_init();
+    t_stub_buffer* x = (t_stub_buffer*)object_alloc(stub_buffer_class);
+    x->name = name;
+    x->frames = frames;
+    x->channels = channels;
+    x->sr = sr;
+    x->samples = calloc((size_t)(frames * channels), sizeof(float));
+    object_register(gensym("buffer~"), name, x);
+    return (t_buffer_obj*)x;
+}
+
+t_buffer_ref* buffer_ref_new(t_object* self, t_symbol* name)
+{
+    stub_init();
+    t_stub_bufref* x = (t_stub_bufref*)object_alloc(stub_bufref_class);
+    x->name = name;
+    return (t_buffer_ref*)x;
+}
+
+void buffer_ref_set(t_buffer_ref* x, t_symbol* name)
+{
+    ((t_stub_bufref*)x)->name = name;
+}
+
+t_buffer_obj* buffer_ref_getobject(t_buffer_ref* x)
+{
+    return object_findregistered(gensym("buffer~"), ((t_stub_bufref*)x)->name);
+}
+
+t_atom_long buffer_ref_exists(t_buffer_ref* x)
+{
+    return buffer_ref_getobject(x) != NULL;
+}
+
+float* buffer_locksamples(t_buffer_obj* b)
+{
+    t_stub_buffer* x = (t_stub_buffer*)b;
+    if (x == NULL)
+        return NULL;
+    x->locked++;
+    return x->samples;
+}
+
+void buffer_unlocksamples(t_buffer_obj* b)
+{
+    if (b)
+        ((t_stub_buffer*)b)->locked--;
+}
+
+t_atom_long buffer_getchannelcount(t_buffer_obj* b)
+{
+    return b ? ((t_stub_buffer*)b)->channels : 0;
+}
+
+t_atom_long buffer_getframecount(t_buffer_obj* b)
+{
+    return b ? ((t_stub_buffer*)b)->frames : 0;
+}
+
+t_atom_float buffer_getsamplerate(t_buffer_obj* b)
+{
+    return b ? ((t_stub_buffer*)b)->sr : 0;
+}
+
+t_atom_float buffer_getmillisamplerate(t_buffer_obj* b)
+{
+    return b ? ((t_stub_buffer*)b)->sr / 1000.0 : 0;
+}
+
+t_max_err buffer_setdirty(t_buffer_obj* b)
+{
+    if (b)
+        ((t_stub_buffer*)b)->dirty++;
+    return MAX_ERR_NONE;
+}
+
+t_max_err buffer_setpadding(t_buffer_obj* b, t_atom_long samplecount)
+{
+    return MAX_ERR_NONE;
+}
+
+t_max_err buffer_view(t_buffer_obj* b) { return MAX_ERR_NONE; }
+
+t_symbol* buffer_getfilename(t_buffer_obj* b) { return gensym(""); }
+
+/*--------------------------------------------------------------------------*/
+/* Patcher and boxes */
+
+typedef struct _stub_patcher {
+    t_object ob;
+    t_symbol* name;
+    t_linklist* boxes;
+} t_stub_patcher;
+
+typedef struct _stub_box {
+    t_object ob;
+    t_object* patcher;
+    t_object* obj;
+    t_symbol* varname;
+    t_symbol* id;
+} t_stub_box;
+
+static t_stub_patcher* stub_toppatcher = NULL;
+
+static void stub_patcher_free(t_stub_patcher* x)
+{
+    linklist_chuck(x->boxes);
+}
+
+static void stub_box_free(t_stub_box* x)
+{
+    t_stub_patcher* p = (t_stub_patcher*)x->patcher;
+    if (p && p->boxes)
+        linklist_chuckobject(p->boxes, x);
+}
+
+typedef long (*t_stub_iterfn)(void*, t_object*);
+
+static void* stub_patcher_iterate(t_stub_patcher* x, method fn, void* arg,
+                                  long flags, long* result)
+{
+    for (long i = 0; i < linklist_getsize(x->boxes); i++) {
+        t_stub_box* b = linklist_getindex(x->boxes, i);
+        if (((t_stub_iterfn)fn)(arg, (flags & PI_WANTBOX)
+                                         ? (t_object*)b
+                                         : b->obj)) {
+            if (result)
+                *result = 1;
+            break;
+        }
+    }
+    return NULL;
+}
+
+static t_stub_patcher* stub_patcher_get(void)
+{
+    if (stub_toppatcher == NULL) {
+        stub_toppatcher = (t_stub_patcher*)object_alloc(stub_patcher_class);
+        stub_toppatcher->name = gensym("maxstub");
+        stub_toppatcher->boxes = linklist_new();
+        linklist_flags(stub_toppatcher->boxes, OBJ_FLAG_REF);
+    }
+    return stub_toppatcher;
+}
+
+static t_stub_box* stub_box_for(t_object* obj)
+{
+    t_stub_obex* obex = stub_obex(obj);
+    if (obex->box == NULL) {
+        static long counter = 0;
+        char id[32];
+        t_stub_patcher* p = stub_patcher_get();
+        t_stub_box* b = (t_stub_box*)object_alloc(stub_box_class);
+        b->patcher = (t_object*)p;
+        b->obj = obj;
+        b->varname = gensym("");
+        snprintf(id, sizeof(id), "obj-%ld", ++counter);
+        b->id = gensym(id);
+        linklist_append(p->boxes, b);
+        object_notify(p, gensym("attr_modified"), b);
+        obex->box = (t_object*)b;
+        obex->patcher = (t_object*)p;
+    }
+    return (t_stub_box*)obex->box;
+}
+
+t_max_err object_obex_lookup(void* x, t_symbol* key, t_object** val)
+{
+    t_object* ob = (t_object*)x;
+
+    stub_init();
+    if (key == gensym("#P")) {
+        stub_box_for(ob);
+        *val = stub_obex(ob)->patcher;
+        return MAX_ERR_NONE;
+    }
+    if (key == gensym("#B")) {
+        *val = (t_object*)stub_box_for(ob);
+        return MAX_ERR_NONE;
+    }
+    *val = NULL;
+    return MAX_ERR_GENERIC;
+}
+
+t_max_err object_obex_store(void* x, t_symbol* key, t_object* val)
+{
+    return MAX_ERR_NONE;
+}
+
+t_max_err jbox_set_varname(t_object* box, t_symbol* ps)
+{
+    if (box == NULL)
+        return MAX_ERR_INVALID_PTR;
+    ((t_stub_box*)box)->varname = ps;
+    object_notify(box, gensym("attr_modified"), NULL);
+    return MAX_ERR_NONE;
+}
+
+t_symbol* jbox_get_varname(t_object* box)
+{
+    return box ? ((t_stub_box*)box)->varname : gensym("");
+}
+
+t_object* jbox_get_object(t_object* box)
+{
+    return box ? ((t_stub_box*)box)->obj : NULL;
+}
+
+t_object* jbox_get_patcher(t_object* box)
+{
+    return box ? ((t_stub_box*)box)->patcher : NULL;
+}
+
+t_symbol* jbox_get_id(t_object* box)
+{
+    return box ? ((t_stub_box*)box)->id : gensym("");
+}
+
+t_max_err jbox_get_patching_rect(t_object* box, t_rect* pr)
+{
+    memset(pr, 0, sizeof(t_rect));
+    return MAX_ERR_NONE;
+}
+
+t_symbol* jpatcher_get_name(t_object* p)
+{
+    return p ? ((t_stub_patcher*)p)->name : gensym("");
+}
+
+t_object* jpatcher_get_firstobject(t_object* p)
+{
+    t_stub_patcher* x = (t_stub_patcher*)p;
+    return x ? linklist_getindex(x->boxes, 0) : NULL;
+}
+
+t_object* jpatcher_get_lastobject(t_object* p)
+{
+    t_stub_patcher* x = (t_stub_patcher*)p;
+    long n = x ? linklist_getsize(x->boxes) : 0;
+    return n ? linklist_getindex(x->boxes, n - 1) : NULL;
+}
+
+t_object* jpatcher_get_toppatcher(t_object* p) { return p; }
+
+t_object* maxstub_patcher(void)
+{
+    stub_init();
+    return (t_object*)stub_patcher_get();
+}
+
+t_object* jbox_get_nextobject(t_object* b)
+{
+    t_stub_box* box = (t_stub_box*)b;
+    t_stub_patcher* p = (t_stub_patcher*)box->patcher;
+    for (long i = 0; i < linklist_getsize(p->boxes); i++) {
+        if (linklist_getindex(p->boxes, i) == box)
+            return linklist_getindex(p->boxes, i + 1);
+    }
+    return NULL;
+}
+
+t_object* object_subpatcher(t_object* o, long* index, void* arg)
+{
+    return NULL;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Threads */
+
+typedef struct _stub_thread_arg {
+    method fn;
+    void* arg;
+} t_stub_thread_arg;
+
+static void* stub_thread_main(void* p)
+{
+    t_stub_thread_arg a = *(t_stub_thread_arg*)p;
+    free(p);
+    a.fn(a.arg);
+    return NULL;
+}
+
+long systhread_create(method entryproc, void* arg, long stacksize,
+                      long priority, long flags, t_systhread* thread)
+{
+    pthread_t* t = malloc(sizeof(pthread_t));
+    t_stub_thread_arg* a = malloc(sizeof(t_stub_thread_arg));
+    a->fn = entryproc;
+    a->arg = arg;
+    if (pthread_create(t, NULL, stub_thread_main, a) != 0) {
+        free(t);
+        free(a);
+        return 1;
+    }
+    *thread = t;
+    return 0;
+}
+
+long systhread_join(t_systhread thread, unsigned int* retval)
+{
+    pthread_t* t = thread;
+    int err = pthread_join(*t, NULL);
+    free(t);
+    if (retval)
+        *retval = 0;
+    return err;
+}
+
+void systhread_exit(long status) { pthread_exit(NULL); }
+
+void systhread_sleep(long milliseconds) { usleep((useconds_t)milliseconds * 1000); }
+
+t_systhread systhread_self(void) { return (t_systhread)pthread_self(); }
+
+long systhread_mutex_new(t_systhread_mutex* pmutex, long flags)
+{
+    pthread_mutex_t* m = malloc(sizeof(pthread_mutex_t));
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(m, &attr);
+    pthread_mutexattr_destroy(&attr);
+    *pmutex = m;
+    return 0;
+}
+
+long systhread_mutex_free(t_systhread_mutex pmutex)
+{
+    pthread_mutex_destroy(pmutex);
+    free(pmutex);
+    return 0;
+}
+
+long systhread_mutex_lock(t_systhread_mutex pmutex)
+{
+    return pthread_mutex_lock(pmutex);
+}
+
+long systhread_mutex_unlock(t_systhread_mutex pmutex)
+{
+    return pthread_mutex_unlock(pmutex);
+}
+
+long systhread_cond_new(t_systhread_cond* pcond, long flags)
+{
+    pthread_cond_t* c = malloc(sizeof(pthread_cond_t));
+    pthread_cond_init(c, NULL);
+    *pcond = c;
+    return 0;
+}
+
+long systhread_cond_free(t_systhread_cond pcond)
+{
+    pthread_cond_destroy(pcond);
+    free(pcond);
+    return 0;
+}
+
+long systhread_cond_wait(t_systhread_cond pcond, t_systhread_mutex pmutex)
+{
+    return pthread_cond_wait(pcond, pmutex);
+}
+
+long systhread_cond_signal(t_systhread_cond pcond)
+{
+    return pthread_cond_signal(pcond);
+}
+
+long systhread_cond_broadcast(t_systhread_cond pcond)
+{
+    return pthread_cond_broadcast(pcond);
+}
+
+void critical_new(t_critical* x)
+{
+    systhread_mutex_new((t_systhread_mutex*)x, 0);
+}
+
+void critical_enter(t_critical x)
+{
+    static t_systhread_mutex global = NULL;
+    if (x == NULL) {
+        if (global == NULL)
+            systhread_mutex_new(&global, 0);
+        x = global;
+    }
+    systhread_mutex_lock(x);
+}
+
+void critical_exit(t_critical x)
+{
+    static t_systhread_mutex global = NULL;
+    (void)global;
+    if (x)
+        systhread_mutex_unlock(x);
+}
+
+void critical_free(t_critical x) { systhread_mutex_free(x); }
+
+/*--------------------------------------------------------------------------*/
+/* System time */
+
+t_int64 systime_ticks(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (t_int64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+t_uint32 systime_ms(void) { return (t_uint32)(systime_ticks() / 1000000LL); }
+
+double systimer_gettime(void) { return (double)systime_ticks() / 1.0e6; }
+
+/*--------------------------------------------------------------------------*/
+/* Initialization */
+
+static void stub_init(void)
+{
+    static int initialized = 0;
+
+    if (initialized)
+        return;
+    initialized = 1;
+
+    stub_hashtab_class = stub_class_make(
+        "hashtab", (method)stub_hashtab_free, sizeof(t_stub_hashtab));
+    stub_classes = hashtab_new(0);
+    hashtab_flags(stub_classes, OBJ_FLAG_REF);
+    stub_linklist_class = stub_class_make(
+        "linklist", (method)stub_linklist_free, sizeof(t_stub_linklist));
+    stub_atomarray_class = stub_class_make(
+        "atomarray", (method)stub_atomarray_free, sizeof(t_stub_atomarray));
+    stub_dictionary_class = stub_class_make("dictionary",
+                                            (method)stub_dictionary_free,
+                                            sizeof(t_stub_dictionary));
+    stub_string_class = stub_class_make(
+        "string", (method)stub_string_free, sizeof(t_stub_string));
+    stub_clock_class = stub_class_make(
+        "clock", (method)stub_clock_free, sizeof(t_stub_clock));
+    stub_qelem_class = stub_class_make(
+        "qelem", (method)stub_qelem_free, sizeof(t_stub_qelem));
+    stub_outlet_class = stub_class_make(
+        "outlet", (method)stub_outlet_free, sizeof(t_stub_outlet));
+    stub_attr_class = stub_class_make(
+        "attr", (method)stub_attr_free, sizeof(t_stub_attr));
+    stub_patcher_class = stub_class_make(
+        "jpatcher", (method)stub_patcher_free, sizeof(t_stub_patcher));
+    class_addmethod(stub_patcher_class, (method)stub_patcher_iterate,
+                    "iterate", A_CANT, 0);
+    stub_box_class = stub_class_make("jbox", (method)stub_box_free,
+                                     sizeof(t_stub_box));
+    stub_buffer_class = stub_class_make(
+        "buffer~", (method)stub_buffer_free, sizeof(t_stub_buffer));
+    stub_bufref_class = stub_class_make(
+        "buffer_ref", (method)stub_bufref_free, sizeof(t_stub_bufref));
+    stub_dictobj_registry = hashtab_new(0);
+    hashtab_flags(stub_dictobj_registry, OBJ_FLAG_REF);
+}
@@ -0,0 +1,285 @@
+/* replay_py.c -- replay a `record` log on a headless py object
+
+plays the messages of a log written by `record <file>` back through the
+method table of a new `py` object running on the headless max stub (see
+`maxstub/`). the stub's virtual clock is advanced by each message's
+recorded delay first, so scheduled calls fire at their original logical
+times. the format is described with PY_RECORD_MAGIC in `py.h`.
+
+usage:
+
+    ./replay_py [--speed <factor>] [-v] <file> [@attr value ...]
+
+    --speed 1   pace messages in real time as recorded (default)
+    --speed 10  ten times faster
+    --speed 0   as fast as possible
+    -v          print outlet output and console posts
+
+trailing arguments are passed to the new object like box arguments, so
+attributes set in the patcher (e.g. `@threaded 1`) can be restored.
+
+*/
+
+#include "ext.h"
+#include "ext_obex.h"
+
+#include "py.h"
+
+#include <time.h>
+#include <unistd.h>
+
+void ext_main(void* r);
+
+
+/* --------------------------------------- */
+// reading
+
+typedef struct t_replay {
+    FILE* f;
+    t_symbol** syms;
+    long nsyms;
+    t_atom* argv;
+    long size;
+} t_replay;
+
+static int replay_varint(t_replay* r, unsigned long long* n)
+{
+    int c = 0;
+    int shift = 0;
+
+    *n = 0;
+    do {
+        if ((c = getc(r->f)) == EOF || shift > 63)
+            return -1;
+        *n |= (unsigned long long)(c & 0x7f) << shift;
+        shift += 7;
+    } while (c & 0x80);
+    return 0;
+}
+
+static int replay_zigzag(t_replay* r, long long* n)
+{
+    unsigned long long u = 0;
+
+    if (replay_varint(r, &u))
+        return -1;
+    *n = (long long)(u >> 1) ^ -(long long)(u & 1);
+    return 0;
+}
+
+static t_symbol* replay_sym(t_replay* r)
+{
+    unsigned long long id = 0;
+
+    if (replay_varint(r, &id) || id >= (unsigned long long)r->nsyms)
+        return NULL;
+    return r->syms[id];
+}
+
+static int replay_define(t_replay* r)
+{
+    unsigned long long id = 0;
+    unsigned long long len = 0;
+    char* name = NULL;
+    int err = 0;
+
+    if (replay_varint(r, &id) || id != (unsigned long long)r->nsyms
+        || replay_varint(r, &len) || len > 1 << 20)
+        return -1;
+    name = malloc(len + 1);
+    if (fread(name, 1, len, r->f) != len) {
+        err = -1;
+    } else {
+        name[len] = '\0';
+        r->syms = realloc(r->syms, (r->nsyms + 1) * sizeof(t_symbol*));
+        r->syms[r->nsyms++] = gensym(name);
+    }
+    free(name);
+    return err;
+}
+
+/**
+ * @brief Read the next message, defining symbols on the way
+ *
+ * @return 1 for a message, 0 at the end of the log, -1 if it is malformed
+ */
+static int replay_next(t_replay* r, double* dt, t_symbol** sel, long* argc)
+{
+    unsigned long long n = 0;
+    long long value = 0;
+    double f = 0.0;
+    int c = 0;
+
+    while ((c = getc(r->f)) == PY_RECORD_SYMBOL) {
+        if (replay_define(r))
+            return -1;
+    }
+    if (c == EOF)
+        return 0;
+    if (c != PY_RECORD_MESSAGE || replay_zigzag(r, &value)
+        || (*sel = replay_sym(r)) == NULL || replay_varint(r, &n)
+        || n > 1 << 24)
+        return -1;
+    *dt = value / 1000.0;
+    *argc = (long)n;
+
+    if (*argc > r->size) {
+        r->argv = realloc(r->argv, *argc * sizeof(t_atom));
+        r->size = *argc;
+    }
+    for (long i = 0; i < *argc; i++) {
+        t_symbol* s = NULL;
+        switch (getc(r->f)) {
+        case PY_RECORD_LONG:
+            if (replay_zigzag(r, &value))
+                return -1;
+            atom_setlong(r->argv + i, (t_atom_long)value);
+            break;
+        case PY_RECORD_FLOAT:
+            if (fread(&f, sizeof(double), 1, r->f) != 1)
+                return -1;
+            atom_setfloat(r->argv + i, f);
+            break;
+        case PY_RECORD_SYM:
+            if ((s = replay_sym(r)) == NULL)
+                return -1;
+            atom_setsym(r->argv + i, s);
+            break;
+        default:
+            return -1;
+        }
+    }
+    return 1;
+}
+
+
+/* --------------------------------------- */
+// playback
+
+static double replay_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void replay_wait_until(double ms)
+{
+    double delay = ms - replay_now_ms();
+
+    if (delay > 0)
+        usleep((useconds_t)(delay * 1000.0));
+}
+
+static void replay_ignore(void* outlet, t_symbol* s, long ac, t_atom* av,
+                          void* arg)
+{
+}
+
+static void* replay_object(int argc, char* argv[])
+{
+    char text[4096] = "";
+    long ac = 0;
+    t_atom* av = NULL;
+    void* x = NULL;
+
+    for (int i = 0; i < argc; i++) {
+        strncat(text, argv[i], sizeof(text) - strlen(text) - 2);
+        strcat(text, " ");
+    }
+    if (argc > 0)
+        atom_setparse(&ac, &av, text);
+    x = object_new_typed(CLASS_BOX, gensym("py"), ac, av);
+    sysmem_freeptr(av);
+    return x;
+}
+
+int main(int argc, char* argv[])
+{
+    t_replay r = { NULL, NULL, 0, NULL, 0 };
+    char magic[4];
+    unsigned char version = 0;
+    double start = 0.0;
+    double speed = 1.0;
+    double elapsed = 0.0;
+    double wall = 0.0;
+    double dt = 0.0;
+    t_symbol* sel = NULL;
+    long ac = 0;
+    long count = 0;
+    int verbose = 0;
+    int res = 0;
+    int i = 1;
+    void* x = NULL;
+
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-v") == 0) {
+            verbose = 1;
+        } else {
+            break;
+        }
+    }
+    if (i >= argc || speed < 0) {
+        fprintf(stderr, "usage: replay_py [--speed <factor>] [-v] <file> "
+                        "[@attr value ...]\n");
+        return 2;
+    }
+
+    r.f = fopen(argv[i], "rb");
+    if (r.f == NULL) {
+        fprintf(stderr, "replay_py: cannot open %s\n", argv[i]);
+        return 1;
+    }
+    if (fread(magic, 1, 4, r.f) != 4 || memcmp(magic, PY_RECORD_MAGIC, 4)
+        || fread(&version, 1, 1, r.f) != 1 || version != PY_RECORD_VERSION
+        || fread(&start, sizeof(double), 1, r.f) != 1) {
+        fprintf(stderr, "replay_py: %s is not a version %d record log\n",
+                argv[i], PY_RECORD_VERSION);
+        fclose(r.f);
+        return 1;
+    }
+
+    maxstub_set_quiet(!verbose);
+    if (!verbose)
+        maxstub_set_outlet_hook(replay_ignore, NULL);
+    ext_main(NULL);
+    x = replay_object(argc - i - 1, argv + i + 1);
+    if (x == NULL) {
+        fprintf(stderr, "replay_py: could not create a py object\n");
+        fclose(r.f);
+        return 1;
+    }
+
+    wall = replay_now_ms();
+    while ((res = replay_next(&r, &dt, &sel, &ac)) == 1) {
+        elapsed += dt;
+        if (speed > 0)
+            replay_wait_until(wall + elapsed / speed);
+        if (dt > 0)
+            maxstub_advance(dt);
+        maxstub_run_deferred();
+        object_method_typed(x, sel, ac, r.argv, NULL);
+        count++;
+    }
+    // let threaded jobs and deferred output finish
+    for (int idle = 0, n = 0; idle < 10 && n < 1000; n++) {
+        idle = maxstub_run_deferred() ? 0 : idle + 1;
+        usleep(1000);
+    }
+    wall = replay_now_ms() - wall;
+
+    if (res < 0)
+        fprintf(stderr, "replay_py: malformed record after %ld messages\n",
+                count);
+    printf("replayed %ld messages spanning %.1f ms in %.1f ms "
+           "(%.0f messages/s)\n",
+           count, elapsed, wall, wall > 0 ? count / (wall / 1000.0) : 0.0);
+
+    object_free(x);
+    fclose(r.f);
+    free(r.syms);
+    free(r.argv);
+    return res < 0 ? 1 : 0;
+}
@@ -0,0 +1,936 @@
+/* test_headless.c -- smoke test for py running on the headless max stub
+ *
+ * Creates a `py` object through the stub, sends it messages and checks
+ * what comes out of its outlets. Scheduled calls run on virtual time.
+ * The buffer kernels are checked against scalar arithmetic first.
+ * Table conversions are checked with lists and buffers of ints, and
+ * dictionaries are converted to python and back. Dicts are also output as
+ * registered dictionaries with `@dictionary`. The atom arena used by
+ * `api` output is checked for reuse, nesting and chunked output. Bound
+ * send handles are checked to go stale when their receiver is renamed or
+ * deleted. Cached code, callables and pipes are checked to be reused and
+ * to follow the namespace.
+ */
+
+#include "ext.h"
+#include "ext_dictobj.h"
+#include "ext_obex.h"
+
+#include "py.h"
+
+#include <math.h>
+
+void ext_main(void* r);
+
+typedef struct {
+    void* left;
+    void* middle;
+    t_symbol* sel;
+    long argc;
+    t_atom argv[8];
+    long count;
+    long failed;
+} t_capture;
+
+static t_capture cap;
+static int failures = 0;
+
+static void capture(void* outlet, t_symbol* s, long ac, t_atom* av,
+                    void* arg)
+{
+    if (outlet == cap.middle)
+        cap.failed++;
+    if (outlet != cap.left)
+        return;
+    cap.sel = s;
+    cap.argc = ac < 8 ? ac : 8;
+    memcpy(cap.argv, av, cap.argc * sizeof(t_atom));
+    cap.count++;
+}
+
+static void send(void* x, const char* sel, const char* text)
+{
+    long ac = 0;
+    t_atom* av = NULL;
+
+    atom_setparse(&ac, &av, text);
+    object_method_typed(x, gensym(sel), ac, av, NULL);
+    sysmem_freeptr(av);
+}
+
+static void check(int cond, const char* what)
+{
+    if (!cond) {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static void check_kernels(void)
+{
+    enum { N = 1003 }; // not a multiple of any vector width
+    static float a[N], b[N], out[N], win[16];
+    double sumsq = 0.0;
+    float peak = 0.0f;
+    int ok = 1;
+
+    for (long i = 0; i < N; i++) {
+        a[i] = (float)sin(i * 0.01) * (i == 700 ? 3.0f : 1.0f);
+        b[i] = (float)(i % 7) - 3.0f;
+        sumsq += (double)a[i] * a[i];
+        peak = fabsf(a[i]) > peak ? fabsf(a[i]) : peak;
+    }
+
+    py_kernel_gain(out, a, N, 0.5f);
+    for (long i = 0; i < N; i++)
+        ok &= out[i] == a[i] * 0.5f;
+    check(ok, "gain kernel");
+
+    py_kernel_mix(out, a, 0.25f, b, 2.0f, N);
+    ok = 1;
+    for (long i = 0; i < N; i++)
+        ok &= fabsf(out[i] - (a[i] * 0.25f + b[i] * 2.0f)) < 1e-5f;
+    check(ok, "mix kernel");
+
+    py_kernel_crossfade(out, a, b, N, 1);
+    check(out[0] == a[0] && fabsf(out[N - 1] - b[N - 1]) < 1e-4f
+              && fabsf(out[501] - (a[501] + (b[501] - a[501]) * 0.5f))
+                     < 1e-4f,
+          "crossfade kernel");
+
+    check(py_kernel_peak(a, N) == peak, "peak kernel");
+    check(fabs(py_kernel_sumsq(a, N) - sumsq) < 1e-3 * sumsq,
+          "sumsq kernel");
+
+    py_kernel_resample(out, 5, 1, b, 3, 1); // -3 -2 -1 -> 5 frames
+    check(out[0] == -3.0f && out[1] == -2.5f && out[4] == -1.0f,
+          "resample kernel");
+
+    py_kernel_hann(win, 16);
+    py_kernel_window(out, b + 1, 2, win, 16);
+    check(win[0] == 0.0f && fabsf(win[8] - 1.0f) < 1e-6f
+              && out[8] == b[17] * win[8],
+          "window kernel");
+}
+
+typedef struct {
+    void* x;
+    int ran;
+    int intact;
+} t_reenter;
+
+static void reenter(void* outlet, t_symbol* s, long ac, t_atom* av,
+                    void* arg)
+{
+    t_reenter* r = (t_reenter*)arg;
+    t_atom saved[3];
+
+    if (outlet != cap.left || r->ran || ac < 3)
+        return;
+    r->ran = 1;
+    memcpy(saved, av, sizeof(saved));
+    // a feedback cord: the object outputs a longer list in the meantime
+    send(r->x, "eval", "\"__import__('array').array('l', range(9, 5009))\"");
+    r->intact = memcmp(saved, av, sizeof(saved)) == 0;
+}
+
+static long call_long(void* x, const char* text)
+{
+    send(x, "call", text);
+    return (long)atom_getlong(cap.argv);
+}
+
+static void check_call_cache(void* x)
+{
+    // a rebound name is resolved again, with its arity
+    send(x, "exec", "\"h = lambda *a: sum(a)\"");
+    check(call_long(x, "h 1 2 3") == 6, "call through the call cache");
+    send(x, "exec", "\"h = lambda xs: len(xs)\"");
+    check(call_long(x, "h 1 2 3") == 3, "rebound callable takes a list");
+    send(x, "exec", "\"h = lambda *a: max(a)\"");
+    check(call_long(x, "h 1 2 3") == 3 && call_long(x, "h 4 9") == 9,
+          "rebound callable takes arguments again");
+
+    // globals shadow builtins until deleted, and builtins can change too
+    check(call_long(x, "abs -3") == 3, "call a builtin");
+    send(x, "exec", "\"abs = lambda v: 99\"");
+    check(call_long(x, "abs -3") == 99, "global shadows a cached builtin");
+    send(x, "exec", "\"del abs\"");
+    check(call_long(x, "abs -3") == 3, "deleted global uncovers the builtin");
+    send(x, "exec", "\"import builtins; builtins.twice = lambda v: 2 * v\"");
+    check(call_long(x, "twice 4") == 8, "call a new builtin");
+    send(x, "exec", "\"builtins.twice = lambda v: 3 * v\"");
+    check(call_long(x, "twice 4") == 12, "rebound builtin");
+    send(x, "exec", "\"del builtins.twice\"");
+
+    // dotted names follow their attributes
+    send(x, "exec", "\"import types; ns = types.SimpleNamespace()\"");
+    send(x, "exec", "\"ns.g = lambda v: v + 1\"");
+    check(call_long(x, "ns.g 1") == 2, "call a dotted name");
+    send(x, "exec", "\"ns.g = lambda v: v + 2\"");
+    check(call_long(x, "ns.g 1") == 3, "dotted name follows its attribute");
+}
+
+static void check_pipe(void* x)
+{
+    t_atom stages[2];
+
+    send(x, "exec", "\"inc = lambda v: v + 1; dbl = lambda v: v * 2\"");
+    send(x, "pipe", "3 inc dbl");
+    check(cap.sel == gensym("int") && atom_getlong(cap.argv) == 8, "pipe");
+    send(x, "pipe", "3 dbl inc");
+    check(atom_getlong(cap.argv) == 7, "pipe stages run in order");
+
+    // cached chains follow the namespace
+    send(x, "exec", "\"inc = lambda v: v + 10; k = 5\"");
+    send(x, "pipe", "3 inc dbl");
+    check(atom_getlong(cap.argv) == 26, "pipe follows a rebound stage");
+    send(x, "pipe", "k inc dbl");
+    check(atom_getlong(cap.argv) == 30, "pipe evaluates a symbol seed");
+    send(x, "pipe", "-4 abs inc");
+    check(atom_getlong(cap.argv) == 14, "pipe through a builtin");
+    cap.failed = 0;
+    send(x, "pipe", "1 inc nosuch");
+    check(cap.failed == 1, "pipe with an unknown stage fails");
+    cap.failed = 0;
+
+    // bare values go through the default pipeline
+    atom_setsym(stages, gensym("inc"));
+    atom_setsym(stages + 1, gensym("dbl"));
+    object_attr_setvalueof(x, gensym("pipe"), 2, stages);
+    send(x, "int", "3");
+    check(cap.sel == gensym("int") && atom_getlong(cap.argv) == 26,
+          "@pipe int");
+    send(x, "float", "0.5");
+    check(cap.sel == gensym("float") && atom_getfloat(cap.argv) == 21.0,
+          "@pipe float");
+    atom_setsym(stages, gensym("sum"));
+    object_attr_setvalueof(x, gensym("pipe"), 2, stages);
+    send(x, "list", "1 2 3");
+    check(cap.sel == gensym("int") && atom_getlong(cap.argv) == 12,
+          "@pipe passes a list");
+    object_attr_setvalueof(x, gensym("pipe"), 0, NULL);
+}
+
+static void check_reentrant_output(void* x)
+{
+    t_reenter r = { x, 0, 0 };
+
+    maxstub_set_outlet_hook(reenter, &r);
+    send(x, "eval", "\"__import__('array').array('l', range(4))\"");
+    check(r.ran && r.intact, "re-entrant buffer output");
+    r.ran = r.intact = 0;
+    send(x, "eval", "\"{'a': 1, 'b': 2}\"");
+    check(r.ran && r.intact, "re-entrant dict output");
+    maxstub_set_outlet_hook(capture, NULL);
+}
+
+static long eval_long(void* x, const char* expr)
+{
+    char text[256];
+
+    snprintf(text, sizeof(text), "\"%s\"", expr);
+    send(x, "eval", text);
+    return (long)atom_getlong(cap.argv);
+}
+
+static void sched_elsewhere(void* x)
+{
+    send(x, "sched", "10 hit 9");
+}
+
+static void check_sched(void* x)
+{
+    char text[64];
+    long id = 0;
+    long other = 0;
+    t_systhread thread = NULL;
+    t_atom av[2];
+
+    send(x, "exec", "\"hits = []\"");
+    send(x, "exec", "\"hit = lambda n: hits.append(n)\"");
+
+    // several pending calls fire in time order, whatever the send order
+    cap.count = 0;
+    send(x, "sched", "30 hit 3");
+    send(x, "sched", "10 hit 1");
+    send(x, "sched", "20 hit 2");
+    check(cap.count == 0, "sched outputs nothing itself");
+    maxstub_advance(35);
+    send(x, "eval", "\"hits\"");
+    check(cap.argc == 3 && atom_getlong(cap.argv) == 1
+              && atom_getlong(cap.argv + 1) == 2
+              && atom_getlong(cap.argv + 2) == 3,
+          "pending calls fire in time order");
+
+    // a repeating call, cancelled by its id
+    send(x, "exec", "\"hits = []\"");
+    send(x, "sched_every", "10 hit 7");
+    send(x, "sched_id", "");
+    id = (long)atom_getlong(cap.argv);
+    check(cap.sel == gensym("sched_id") && id > 0, "sched_id");
+    maxstub_advance(35);
+    check(eval_long(x, "len(hits)") == 3, "sched_every repeats");
+    snprintf(text, sizeof(text), "%ld", id);
+    send(x, "unsched", text);
+    maxstub_advance(50);
+    check(eval_long(x, "len(hits)") == 3, "unsched stops a repeating call");
+
+    // cancel one of two pending calls, then all of them
+    send(x, "exec", "\"hits = []\"");
+    send(x, "sched", "10 hit 1");
+    send(x, "sched_id", "");
+    snprintf(text, sizeof(text), "%ld", (long)atom_getlong(cap.argv));
+    send(x, "sched", "20 hit 2");
+    send(x, "unsched", text);
+    maxstub_advance(30);
+    check(eval_long(x, "len(hits) * 10 + hits[0]") == 12, "unsched <id>");
+    send(x, "sched", "10 hit 3");
+    send(x, "sched_every", "5 hit 4");
+    send(x, "unsched", "");
+    maxstub_advance(30);
+    check(eval_long(x, "len(hits)") == 1, "unsched cancels all calls");
+
+    // a sched message on another thread leaves this thread's sched_id
+    send(x, "exec", "\"hits = []\"");
+    send(x, "sched", "10 hit 1");
+    send(x, "sched_id", "");
+    id = (long)atom_getlong(cap.argv);
+    systhread_create((method)sched_elsewhere, x, 0, 0, 0, &thread);
+    systhread_join(thread, NULL);
+    send(x, "sched_id", "");
+    check(atom_getlong(cap.argv) == id, "sched_id is per thread");
+    send(x, "unsched", "");
+
+    // ids returned directly, as by api.sched
+    atom_setsym(av, gensym("hit"));
+    atom_setlong(av + 1, 5);
+    id = py_sched_call((t_py*)x, 10, 0, 2, av);
+    atom_setlong(av + 1, 6);
+    other = py_sched_call((t_py*)x, 10, 0, 2, av);
+    check(id > 0 && other > 0 && id != other, "py_sched_call returns ids");
+    atom_setlong(av, id);
+    check(py_unsched_call((t_py*)x, 1, av) == MAX_ERR_NONE,
+          "py_unsched_call");
+    maxstub_advance(20);
+    check(eval_long(x, "len(hits) * 10 + hits[0]") == 16,
+          "py_unsched_call cancels by id");
+}
+
+static void check_code_cache(void* x)
+{
+    // counts the distinct code objects that have evaluated it
+    const char* seen = "len(seen.append(__import__('sys')._getframe()"
+                       ".f_code) or set(map(id, seen)))";
+    char text[64];
+
+    // a cached code object is evaluated again, not its result
+    send(x, "exec", "\"n = 1; seen = []\"");
+    check(eval_long(x, "n * 10") == 10, "eval through the code cache");
+    send(x, "exec", "\"n = 2\"");
+    check(eval_long(x, "n * 10") == 20, "cached code sees a rebound name");
+    eval_long(x, seen);
+    check(eval_long(x, seen) == 1, "eval reuses its compiled code");
+
+    // the text is compiled again once it has been evicted
+    for (int i = 0; i < PY_CODE_CACHE_SIZE; i++) {
+        snprintf(text, sizeof(text), "n + %d", i);
+        eval_long(x, text);
+    }
+    check(eval_long(x, seen) == 2, "evicted code is compiled again");
+
+    // reset clears the namespace, which cached code must not bring back
+    send(x, "reset", "");
+    cap.count = 0;
+    cap.failed = 0;
+    send(x, "eval", "\"n * 10\"");
+    check(cap.count == 0 && cap.failed == 1, "reset code sees no old names");
+    cap.failed = 0;
+    send(x, "exec", "\"f = lambda *a: sum(a)\"");
+}
+
+static void check_strings(void* x)
+{
+    t_atom_long gensyms = 0;
+
+    object_attr_setsym(x, gensym("strings"), gensym("bytes"));
+    send(x, "eval", "\"'h\\u00e9'\"");
+    check(cap.sel == gensym("list") && cap.argc == 3
+              && atom_getlong(cap.argv) == 'h'
+              && atom_getlong(cap.argv + 1) == 0xc3
+              && atom_getlong(cap.argv + 2) == 0xa9,
+          "strings bytes");
+
+    // strings inside a list never leave as objects
+    send(x, "eval", "\"[1, 'two']\"");
+    check(cap.sel == gensym("list") && cap.argc == 2
+              && atom_gettype(cap.argv + 1) == A_SYM
+              && atom_getsym(cap.argv + 1) == gensym("two"),
+          "strings in a list are symbols");
+    object_attr_setsym(x, gensym("strings"), gensym("symbol"));
+
+    // only symbols the object has not made before are counted
+    gensyms = object_attr_getlong(x, gensym("gensyms"));
+    for (int i = 0; i < 3; i++)
+        send(x, "eval", "\"'gensyms-a'\"");
+    send(x, "eval", "\"['gensyms-a', 'gensyms-b']\"");
+    check(object_attr_getlong(x, gensym("gensyms")) == gensyms + 2,
+          "gensyms counts distinct symbols");
+    send(x, "exec", "\"many = ['gensyms-%d' % i for i in range(100)]\"");
+    send(x, "eval", "\"many\"");
+    send(x, "eval", "\"many\"");
+    check(object_attr_getlong(x, gensym("gensyms")) == gensyms + 102,
+          "gensyms grows its set");
+}
+
+static void check_pythonpath(void* x)
+{
+    void* y = NULL;
+    void* left = cap.left;
+    t_atom av[2];
+
+    atom_setsym(av, gensym("@pythonpath"));
+    atom_setsym(av + 1, gensym("/tmp/py-headless-path"));
+    y = object_new_typed(CLASS_BOX, gensym("py"), 2, av);
+    check(y != NULL, "py object with @pythonpath");
+    if (y == NULL)
+        return;
+    cap.left = maxstub_outlet(y, 0);
+    check(eval_long(y, "__import__('sys').path.count("
+                       "'/tmp/py-headless-path')")
+              == 1,
+          "@pythonpath is added to sys.path");
+    cap.left = left;
+    object_free(y);
+}
+
+#if PY_VERSION_HEX >= 0x030C0000
+static void check_interpreter(void* x)
+{
+    void* y = NULL;
+    void* left = cap.left;
+    t_atom av[4];
+
+    // the stub api module has single-phase init, so the subinterpreter
+    // falls back to sharing the main GIL instead of failing the import
+    send(x, "exec", "\"import builtins; builtins.py_marker = 1\"");
+    atom_setsym(av, gensym("@interpreter"));
+    atom_setsym(av + 1, gensym("own"));
+    atom_setsym(av + 2, gensym("@pythonpath"));
+    atom_setsym(av + 3, gensym("/tmp/py-headless-own"));
+    y = object_new_typed(CLASS_BOX, gensym("py"), 4, av);
+    check(y != NULL, "py object with a subinterpreter");
+    if (y == NULL)
+        return;
+    cap.left = maxstub_outlet(y, 0);
+    send(y, "exec", "\"import api\"");
+    check(eval_long(y, "'api' in __import__('sys').modules") == 1,
+          "api imported in a shared GIL subinterpreter");
+    check(eval_long(y, "hasattr(__import__('builtins'), 'py_marker')")
+              == 0,
+          "subinterpreter has its own builtins");
+    check(eval_long(y, "'/tmp/py-headless-own' in __import__('sys').path")
+              == 1,
+          "@pythonpath goes to the subinterpreter");
+    cap.left = left;
+    check(eval_long(x, "'/tmp/py-headless-own' in __import__('sys').path")
+              == 0,
+          "@pythonpath leaves the main interpreter alone");
+    object_free(y);
+}
+#endif
+
+static void check_registry(void* x)
+{
+    t_py_send_handle handle;
+    t_object* box = NULL;
+    void* y = NULL;
+    void* left = cap.left;
+    long generation = 0;
+    t_atom av[1];
+
+    y = object_new_typed(CLASS_BOX, gensym("py"), 0, NULL);
+    check(y != NULL, "py object to send to");
+    if (y == NULL)
+        return;
+    cap.left = maxstub_outlet(y, 0);
+    send(y, "exec", "\"n = 0\"");
+    object_obex_lookup(y, gensym("#B"), &box);
+    jbox_set_varname(box, gensym("target"));
+
+    // a bound handle reaches its receiver until the box is renamed
+    atom_setsym(av, gensym("n += 1"));
+    check(py_send_bind((t_py*)x, &handle, gensym("target"), gensym("exec"))
+              == MAX_ERR_NONE
+              && handle.obj == (t_object*)y,
+          "send handle bound by name");
+    check(py_send_dispatch(&handle, 1, av) == MAX_ERR_NONE
+              && eval_long(y, "n") == 1,
+          "send through a bound handle");
+    jbox_set_varname(box, gensym("renamed"));
+    check(py_send_dispatch(&handle, 1, av) == MAX_ERR_INVALID_PTR
+              && eval_long(y, "n") == 1,
+          "renamed receiver invalidates the handle");
+    check(py_registry_lookup((t_py*)x, gensym("target"), NULL) == NULL
+              && py_registry_lookup((t_py*)x, gensym("renamed"), NULL)
+                     == (t_object*)y,
+          "lookup follows a rename");
+
+    // naming it back is a new binding, so the old handle stays stale
+    jbox_set_varname(box, gensym("target"));
+    check(py_send_dispatch(&handle, 1, av) == MAX_ERR_INVALID_PTR,
+          "handle stays stale after naming back");
+    check(py_send_bind((t_py*)x, &handle, gensym("target"), gensym("exec"))
+              == MAX_ERR_NONE
+              && py_send_dispatch(&handle, 1, av) == MAX_ERR_NONE
+              && eval_long(y, "n") == 2,
+          "handle bound again after a rename");
+
+    // deleting the box unbinds its name
+    py_registry_lookup((t_py*)x, gensym("target"), &generation);
+    cap.left = left;
+    object_free(y);
+    check(py_registry_lookup((t_py*)x, gensym("target"), NULL) == NULL
+              && py_registry_resolve(gensym("target"), generation) == NULL,
+          "lookup after a delete");
+    check(py_send_dispatch(&handle, 1, av) == MAX_ERR_INVALID_PTR,
+          "deleted receiver invalidates the handle");
+}
+
+static void check_threaded(void* x)
+{
+    t_atom_long dropped = 0;
+
+    send(x, "exec", "\"import time; f = lambda v: v; k = 0\"");
+    object_attr_setlong(x, gensym("threaded"), 1);
+
+    // every namespace message is queued in order with eval
+    cap.count = 0;
+    for (long i = 1; i <= 5; i++) {
+        send(x, "code", "k = k + 1");
+        send(x, "eval", "\"k\"");
+    }
+    send(x, "=", "m 5");
+    send(x, "import", "math");
+    send(x, "eval", "\"m[0] + math.floor(k / 2)\"");
+    check(cap.count == 0, "threaded output waits for the qelem");
+    py_job_flush((t_py*)x);
+    check(cap.count == 6 && atom_getlong(cap.argv) == 7, "threaded order");
+
+    // messages run inline wait for the queue, and its output comes first
+    cap.count = 0;
+    send(x, "exec", "\"time.sleep(0.05)\"");
+    send(x, "eval", "\"k * 10\"");
+    send(x, "reset", "");
+    check(cap.count == 1 && atom_getlong(cap.argv) == 50,
+          "reset waits for queued jobs");
+    send(x, "exec", "\"import time; f = lambda v: v\"");
+    py_job_flush((t_py*)x);
+
+    // a running job still counts against @queue
+    object_attr_setlong(x, gensym("queue"), 2);
+    dropped = object_attr_getlong(x, gensym("dropped"));
+    cap.count = 0;
+    send(x, "exec", "\"time.sleep(0.2)\"");
+    send(x, "call", "f 1");
+    send(x, "call", "f 2");
+    send(x, "call", "f 3");
+    py_job_flush((t_py*)x);
+    check(object_attr_getlong(x, gensym("dropped")) == dropped + 2
+              && cap.count == 1 && atom_getlong(cap.argv) == 1,
+          "overflow drop");
+
+    object_attr_setsym(x, gensym("overflow"), gensym("coalesce"));
+    dropped = object_attr_getlong(x, gensym("dropped"));
+    cap.count = 0;
+    send(x, "exec", "\"time.sleep(0.2)\"");
+    send(x, "call", "f 1");
+    send(x, "call", "f 2");
+    send(x, "call", "f 3");
+    py_job_flush((t_py*)x);
+    check(object_attr_getlong(x, gensym("dropped")) == dropped
+              && cap.count == 1 && atom_getlong(cap.argv) == 3,
+          "overflow coalesce");
+
+    object_attr_setsym(x, gensym("overflow"), gensym("drop"));
+    object_attr_setlong(x, gensym("queue"), PY_JOB_QUEUE_SIZE);
+    object_attr_setlong(x, gensym("threaded"), 0);
+}
+
+static void check_numbers(void* x)
+{
+    // a 0-d buffer inside a list is a scalar, not an empty sequence
+    send(x, "exec", "\"import array; zd = memoryview(array.array('d', "
+                    "[2.5])).cast('B').cast('d', shape=[])\"");
+    send(x, "eval", "\"[1, zd, 3]\"");
+    check(cap.sel == gensym("list") && cap.argc == 3
+              && atom_getfloat(cap.argv + 1) == 2.5
+              && atom_getlong(cap.argv + 2) == 3,
+          "0-d buffer in a list");
+
+    // unsigned 64-bit values above the int range do not wrap
+    send(x, "eval", "\"array.array('Q', [2**64 - 1, 7])\"");
+    check(cap.sel == gensym("list") && cap.argc == 2
+              && atom_gettype(cap.argv) == A_FLOAT
+              && atom_getfloat(cap.argv) > 1.8e19
+              && atom_getlong(cap.argv + 1) == 7,
+          "uint64 buffer above the int range");
+    send(x, "eval", "\"[2**63, -1]\"");
+    check(cap.sel == gensym("list") && cap.argc == 2
+              && atom_gettype(cap.argv) == A_FLOAT
+              && atom_getfloat(cap.argv) > 9.2e18
+              && atom_getlong(cap.argv + 1) == -1,
+          "int above the int range in a list");
+
+    // buffers of other formats go through the sequence path or fail
+    send(x, "exec", "\"import ctypes; P = type('P', (ctypes.Structure,), "
+                    "{'_fields_': [('a', ctypes.c_double)]})\"");
+    send(x, "eval", "\"(ctypes.c_double.__ctype_be__ * 2)(1.5, 2.5)\"");
+    check(cap.sel == gensym("list") && cap.argc == 2
+              && atom_getfloat(cap.argv + 1) == 2.5,
+          "non-native buffer through the sequence path");
+    cap.count = 0;
+    cap.failed = 0;
+    send(x, "eval", "\"P(1.5)\"");
+    check(cap.count == 0 && cap.failed == 1, "struct buffer fails");
+    cap.failed = 0;
+    send(x, "eval", "\"(P * 2)()\"");
+    check(cap.count == 0 && cap.failed == 1, "struct buffer array fails");
+}
+
+static void check_async(void* x)
+{
+    send(x, "exec", "\"import asyncio\"");
+    // exec() compiles a whole file, so a compound statement fits a line
+    send(x, "exec", "\"exec('async def later(v, d): "
+                    "await asyncio.sleep(d); return v')\"");
+    send(x, "exec", "\"exec('async def boom(): "
+                    "await asyncio.sleep(0); raise ValueError(1)')\"");
+
+    // tasks run concurrently in logical time and output when done
+    cap.count = 0;
+    send(x, "async", "later(1, 0.2)");
+    send(x, "async", "later(2, 0.1)");
+    maxstub_advance(50);
+    check(cap.count == 0, "async waits");
+    maxstub_advance(60);
+    check(cap.count == 1 && atom_getlong(cap.argv) == 2, "async sleep");
+    maxstub_advance(100);
+    check(cap.count == 2 && atom_getlong(cap.argv) == 1,
+          "async tasks run concurrently");
+
+    // callbacks that schedule further callbacks are stepped to the end
+    send(x, "exec", "\"exec('async def chain(n): [await asyncio.sleep(0) "
+                    "for _ in range(n)]; return n')\"");
+    send(x, "async", "chain(100)");
+    maxstub_advance(1);
+    check(cap.count == 3 && atom_getlong(cap.argv) == 100, "async chain");
+
+    // a task which raises bangs the failure outlet
+    cap.failed = 0;
+    send(x, "async", "boom()");
+    maxstub_advance(1);
+    check(cap.count == 3 && cap.failed == 1, "async task error");
+}
+
+static void check_tables(t_py* x)
+{
+    PyGILState_STATE state = PyGILState_Ensure();
+    PyObject* plist = Py_BuildValue("[iii]", 3, -1, 7);
+    PyObject* pbytes = PyByteArray_FromStringAndSize("\x01\x02\xff", 3);
+    PyObject* pout = NULL;
+    long **storage, size;
+
+    maxstub_table_new(gensym("lut"), 4);
+    table_get(gensym("lut"), &storage, &size);
+
+    check(py_list_to_table(x, "lut", plist) == MAX_ERR_NONE
+              && (*storage)[0] == 3 && (*storage)[1] == -1
+              && (*storage)[2] == 7 && (*storage)[3] == 0,
+          "list to table");
+    check(py_list_to_table(x, "lut", pbytes) == MAX_ERR_NONE
+              && (*storage)[2] == 255 && (*storage)[3] == 0,
+          "int buffer to table");
+
+    pout = py_table_to_list(x, "lut");
+    check(PyList_Check(pout) && PyList_GET_SIZE(pout) == 4
+              && PyLong_AsLong(PyList_GET_ITEM(pout, 2)) == 255,
+          "table to list");
+    Py_DECREF(pout);
+
+    PyList_Append(plist, pbytes); // not an int
+    check(py_list_to_table(x, "lut", plist) == MAX_ERR_GENERIC
+              && !PyErr_Occurred() && (*storage)[0] == 3,
+          "list with a non-int");
+    PyList_Append(plist, plist);
+    (*storage)[0] = 42;
+    check(py_list_to_table(x, "lut", plist) == MAX_ERR_GENERIC
+              && (*storage)[0] == 42,
+          "list too long for table is not copied");
+    check(py_list_to_table(x, "nope", plist) == MAX_ERR_GENERIC,
+          "missing table");
+
+    Py_DECREF(plist);
+    Py_DECREF(pbytes);
+    PyGILState_Release(state);
+}
+
+static void check_dictionaries(t_py* x)
+{
+    PyGILState_STATE state = PyGILState_Ensure();
+    t_dictionary* d = dictionary_new();
+    t_dictionary* child = dictionary_new();
+    t_dictionary* back = dictionary_new();
+    t_atom atoms[3];
+    PyObject* pdict = NULL;
+    PyObject* pagain = NULL;
+    PyObject* parray = NULL;
+    PyObject* pexpect = NULL;
+
+    atom_setlong(atoms, 1);
+    atom_setfloat(atoms + 1, 2.5);
+    atom_setsym(atoms + 2, gensym("three"));
+    dictionary_appendatoms(d, gensym("mixed"), 3, atoms);
+    dictionary_appendatoms(d, gensym("numbers"), 2, atoms);
+    dictionary_appendstring(d, gensym("text"), "a string");
+    dictionary_appendlong(child, gensym("depth"), 2);
+    dictionary_appenddictionary(d, gensym("child"), (t_object*)child);
+
+    pdict = py_dictionary_to_dict(d, 0);
+    pexpect = PyRun_String("{'mixed': [1, 2.5, 'three'], 'numbers': [1, 2.5], "
+                           "'text': 'a string', 'child': {'depth': 2}}",
+                           Py_eval_input, PyEval_GetBuiltins(),
+                           PyEval_GetBuiltins());
+    check(pdict && pexpect
+              && PyObject_RichCompareBool(pdict, pexpect, Py_EQ) == 1,
+          "dictionary to dict");
+
+    // and back through the output conversion
+    check(pdict && py_dict_to_dictionary(x, pdict, back) == MAX_ERR_NONE,
+          "dict to dictionary");
+    pagain = py_dictionary_to_dict(back, 0);
+    check(pagain && PyObject_RichCompareBool(pagain, pdict, Py_EQ) == 1
+              && PyList_Check(PyDict_GetItemString(pagain, "numbers")),
+          "dictionary round trip");
+
+    Py_XDECREF(pdict);
+    pdict = py_dictionary_to_dict(d, 1);
+    parray = pdict ? PyDict_GetItemString(pdict, "numbers") : NULL;
+    check(parray && strcmp(Py_TYPE(parray)->tp_name, "array.array") == 0
+              && PyList_Check(PyDict_GetItemString(pdict, "mixed")),
+          "dictionary numbers to typed arrays");
+
+    check(py_dictionary_entry_to_value(d, gensym("missing"), 0) == NULL
+              && PyErr_ExceptionMatches(PyExc_KeyError),
+          "missing dictionary entry");
+    PyErr_Clear();
+
+    Py_XDECREF(pdict);
+    Py_XDECREF(pagain);
+    Py_XDECREF(pexpect);
+    object_free(d);
+    object_free(back);
+    PyGILState_Release(state);
+}
+
+static void check_dictionary_output(void* x)
+{
+    t_dictionary* d = NULL;
+    t_dictionary* child = NULL;
+    t_symbol* name = NULL;
+    t_symbol* text = NULL;
+    t_atom_long n = 0;
+    double f = 0;
+    long ac = 0;
+    t_atom* av = NULL;
+
+    object_attr_setlong(x, gensym("dictionary"), 1);
+    send(x, "eval", "\"{'a': 1, 'b': {'c': [1, 2.5]}, 's': 'text'}\"");
+    check(cap.sel == gensym("dictionary") && cap.argc == 1
+              && atom_gettype(cap.argv) == A_SYM,
+          "@dictionary outputs a dictionary name");
+    name = atom_getsym(cap.argv);
+    d = dictobj_findregistered_retain(name);
+    check(d != NULL, "@dictionary output is registered");
+    if (d == NULL)
+        goto finally;
+    check(dictionary_getlong(d, gensym("a"), &n) == MAX_ERR_NONE && n == 1
+              && dictionary_getsym(d, gensym("s"), &text) == MAX_ERR_NONE
+              && text == gensym("text"),
+          "@dictionary values");
+    check(dictionary_getdictionary(d, gensym("b"), (t_object**)&child)
+                  == MAX_ERR_NONE
+              && dictionary_getatoms(child, gensym("c"), &ac, &av)
+                     == MAX_ERR_NONE
+              && ac == 2 && atom_getfloat(av + 1) == 2.5,
+          "@dictionary nested dict and list");
+
+    // the same dictionary is cleared and refilled by the next output
+    send(x, "eval", "\"{'z': 2}\"");
+    check(cap.sel == gensym("dictionary") && atom_getsym(cap.argv) == name
+              && dictionary_getentrycount(d) == 1
+              && dictionary_getlong(d, gensym("z"), &n) == MAX_ERR_NONE
+              && n == 2,
+          "@dictionary reuses its dictionary");
+
+    // ints too large for an atom become floats instead of failing
+    send(x, "eval", "\"{'big': 2**70, 'low': -2**63}\"");
+    check(dictionary_getfloat(d, gensym("big"), &f) == MAX_ERR_NONE
+              && f == ldexp(1.0, 70)
+              && dictionary_getlong(d, gensym("low"), &n) == MAX_ERR_NONE
+              && n == INT64_MIN,
+          "@dictionary large ints");
+    check(eval_long(x, "6 * 7") == 42 && cap.sel == gensym("int"),
+          "@dictionary leaves other results alone");
+    dictobj_release(d);
+
+finally:
+    object_attr_setlong(x, gensym("dictionary"), 0);
+}
+
+static void check_atom_arena(void* outlet)
+{
+    PyGILState_STATE state = PyGILState_Ensure();
+    t_atom* levels[PY_ATOM_ARENA_LEVELS + 1];
+    t_atom* again = NULL;
+    long capacity = 0;
+    long count = 0;
+    PyObject* plist = NULL;
+    PyObject* pbad = NULL;
+
+    for (int i = 0; i <= PY_ATOM_ARENA_LEVELS; i++)
+        levels[i] = py_atom_arena_acquire(10, &capacity);
+    check(levels[0] != levels[1] && capacity >= 10, "nested arena blocks");
+    py_atom_arena_release(levels[1]);
+    again = py_atom_arena_acquire(PY_ATOM_ARENA_MAX * 2, &capacity);
+    check(capacity == PY_ATOM_ARENA_MAX, "arena block size is capped");
+    py_atom_arena_release(again);
+    again = py_atom_arena_acquire(3, &capacity);
+    check(again != NULL && capacity == PY_ATOM_ARENA_MAX,
+          "arena block is kept between calls");
+    py_atom_arena_release(again);
+    for (int i = PY_ATOM_ARENA_LEVELS; i >= 0; i--) {
+        if (i != 1)
+            py_atom_arena_release(levels[i]);
+    }
+
+    plist = Py_BuildValue("[idsN]", 7, 0.5, "x",
+                          PyLong_FromString("1180591620717411303424", NULL,
+                                            10)); // 2**70
+    again = py_atom_arena_acquire(4, &capacity);
+    check(py_items_to_atoms(plist, 0, 4, again) == 4
+              && atom_getlong(again) == 7 && atom_getfloat(again + 1) == 0.5
+              && atom_getsym(again + 2) == gensym("x")
+              && atom_gettype(again + 3) == A_FLOAT
+              && atom_getfloat(again + 3) == ldexp(1.0, 70),
+          "items to atoms");
+    pbad = Py_BuildValue("[i[i]]", 1, 2);
+    check(py_items_to_atoms(pbad, 0, 2, again) < 0
+              && PyErr_ExceptionMatches(PyExc_TypeError),
+          "nested list is not an atom");
+    PyErr_Clear();
+    py_atom_arena_release(again);
+    Py_DECREF(plist);
+    Py_DECREF(pbad);
+
+    plist = PyList_New(0);
+    for (long i = 0; i < PY_ATOM_ARENA_MAX + 5; i++) {
+        PyObject* item = PyLong_FromLong(i);
+        PyList_Append(plist, item);
+        Py_DECREF(item);
+    }
+    cap.count = 0;
+    count = py_outlet_items(outlet, plist);
+    check(count == 2 && cap.count == 2 && cap.argc == 5
+              && atom_getlong(cap.argv) == PY_ATOM_ARENA_MAX,
+          "long output is chunked");
+    Py_DECREF(plist);
+    PyGILState_Release(state);
+}
+
+int main(void)
+{
+    t_atom_long count = 0;
+    t_dictionary* d = NULL;
+    t_dictionary* call = NULL;
+    void* x = NULL;
+
+    check_kernels();
+
+    ext_main(NULL);
+    x = object_new_typed(CLASS_BOX, gensym("py"), 0, NULL);
+    check(x != NULL, "py object created");
+    if (x == NULL)
+        return 1;
+    cap.left = maxstub_outlet(x, 0);
+    cap.middle = maxstub_outlet(x, 1);
+    maxstub_set_outlet_hook(capture, NULL);
+
+    send(x, "eval", "\"6 * 7\"");
+    check(cap.sel == gensym("int") && atom_getlong(cap.argv) == 42, "eval");
+
+    send(x, "exec", "\"f = lambda *a: sum(a)\"");
+    send(x, "call", "f 1 2 3.5");
+    check(cap.sel == gensym("float") && atom_getfloat(cap.argv) == 6.5,
+          "call");
+
+    send(x, "eval", "\"list(range(3))\"");
+    check(cap.sel == gensym("list") && cap.argc == 3
+              && atom_getlong(cap.argv + 2) == 2,
+          "list output");
+
+    cap.count = 0;
+    send(x, "sched", "100 f 1 2");
+    maxstub_advance(50);
+    check(cap.count == 0, "sched does not fire early");
+    maxstub_advance(60);
+    check(cap.count == 1 && atom_getlong(cap.argv) == 3, "sched fires");
+
+    send(x, "stats", "");
+    d = dictobj_findregistered_retain(maxstub_last_dictionary_name());
+    check(d != NULL, "stats dictionary");
+    if (d) {
+        dictionary_getdictionary(d, gensym("call"), (t_object**)&call);
+        dictionary_getlong(call, gensym("count"), &count);
+        check(count == 2, "stats counts calls");
+        dictobj_release(d);
+    }
+
+    check_sched(x);
+    check_code_cache(x);
+    check_call_cache(x);
+    check_pipe(x);
+    check_reentrant_output(x);
+    check_strings(x);
+    check_numbers(x);
+    check_async(x);
+    check_pythonpath(x);
+#if PY_VERSION_HEX >= 0x030C0000
+    check_interpreter(x);
+#endif
+    check_tables((t_py*)x);
+    check_dictionaries((t_py*)x);
+    check_dictionary_output(x);
+    check_atom_arena(cap.left);
+    check_registry(x);
+    check_threaded(x);
+
+    // record a few messages for the replay test (see CMakeLists.txt)
+    send(x, "record", "headless.pyrec");
+    send(x, "exec", "\"g = lambda a, b: a * b\"");
+    send(x, "call", "g 6 7");
+    maxstub_advance(10);
+    send(x, "sched", "5 g 2 3");
+    maxstub_advance(10);
+    send(x, "=", "h 1.5 word");
+    send(x, "import", "math");
+    send(x, "stop", "");
+    check(cap.sel == gensym("int") && atom_getlong(cap.argv) == 6,
+          "scheduled call is not recorded twice");
+
+    maxstub_set_outlet_hook(NULL, NULL);
+    object_free(x);
+    if (failures == 0)
+        printf("test_headless: ok\n");
+    return failures ? 1 : 0;
+}